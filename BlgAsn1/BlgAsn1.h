@@ -46,6 +46,8 @@ See License.txt in the project root for license information.
 #define ERROR_BLGASN1_CONSTRAINT   BLGASN1_MAKE_ERROR(104L)
 #define ERROR_BLGASN1_BADTAG       BLGASN1_MAKE_ERROR(105L)
 #define ERROR_BLGASN1_PRIMITIVE    BLGASN1_MAKE_ERROR(106L)
+#define ERROR_BLGASN1_DUPLICATE    BLGASN1_MAKE_ERROR(107L)
+#define ERROR_BLGASN1_MISSING      BLGASN1_MAKE_ERROR(108L)
 
 // ASN.1 DER classes.
 #define BLG_DER_CLASS_UNIVERSAL     0x00
@@ -56,21 +58,48 @@ See License.txt in the project root for license information.
 // ASN.1 DER UNIVERSAL class tags.
 #define BLG_DER_TAG_BOOLEAN            0x01
 #define BLG_DER_TAG_INTEGER            0x02
-#define BLG_DER_TAG_OCTET_STRING       0x03
+#define BLG_DER_TAG_OCTET_STRING       0x04
 #define BLG_DER_TAG_NULL               0x05
+#define BLG_DER_TAG_OBJECT_IDENTIFIER  0x06
 #define BLG_DER_TAG_UTF8_STRING        0x0C
 #define BLG_DER_TAG_SEQUENCE           0x10
 #define BLG_DER_TAG_SEQUENCE_OF        0x10
 #define BLG_DER_TAG_SET                0x11
 #define BLG_DER_TAG_SET_OF             0x11
+#define BLG_DER_TAG_NUMERIC_STRING     0x12
 #define BLG_DER_TAG_PRINTABLE_STRING   0x13
 #define BLG_DER_TAG_IA5_STRING         0x16
+#define BLG_DER_TAG_UTC_TIME           0x17
 #define BLG_DER_TAG_GENERALIZED_TIME   0x18
+#define BLG_DER_TAG_VISIBLE_STRING     0x1A
 #define BLG_DER_TAG_BMP_STRING         0x1E
 
 DECLARE_HANDLE(HBLG_DER_ENCODER);
 DECLARE_HANDLE(HBLG_DER_DECODER);
 
+// Identifier octets of an ASN.1 DER tag encoded by BlgDerPrepareTag. Any tag that fits in a
+// DWORD is encoded in at most six octets.
+typedef struct _BLG_DER_PREPARED_TAG
+{
+    BYTE Octets[6];
+    BYTE OctetCount;
+
+} BLG_DER_PREPARED_TAG, *PBLG_DER_PREPARED_TAG;
+
+typedef CONST BLG_DER_PREPARED_TAG *PCBLG_DER_PREPARED_TAG;
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerPrepareTag(
+    IN BYTE Class,
+    IN BOOLEAN Constructed,
+    IN DWORD Tag,
+    OUT PBLG_DER_PREPARED_TAG PreparedTag
+    );
+
+// Valid values for Flags of BlgDerCreateEncoder.
+#define BLG_DER_ENC_FLAG_UNCHECKED 0x0001 // Skip the buffer size checks; the buffer is known to be large enough.
 
 BLGASN1API
 HBLG_DER_ENCODER
@@ -112,6 +141,14 @@ BlgDerBeginConstructed(
     IN DWORD Tag
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerBeginPreparedConstructed(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -119,6 +156,88 @@ BlgDerEndConstructed(
     IN HBLG_DER_ENCODER EncoderHandle
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEndSetOf(
+    IN HBLG_DER_ENCODER EncoderHandle
+    );
+
+// Encoder state captured by BlgDerEncoderSavepoint. The members are used by the library only.
+typedef struct _BLG_DER_ENCODER_SAVEPOINT
+{
+    DWORD EncodedCb;
+    DWORD Depth;
+    PVOID Node;
+    DWORD SlotCount;
+
+} BLG_DER_ENCODER_SAVEPOINT, *PBLG_DER_ENCODER_SAVEPOINT;
+
+typedef CONST BLG_DER_ENCODER_SAVEPOINT *PCBLG_DER_ENCODER_SAVEPOINT;
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncoderSavepoint(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    OUT PBLG_DER_ENCODER_SAVEPOINT Savepoint
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncoderRollback(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN PCBLG_DER_ENCODER_SAVEPOINT Savepoint
+    );
+
+DECLARE_HANDLE(HBLG_DER_TEMPLATE);
+
+// Valid values for Flags of BlgDerMarkSlot.
+#define BLG_DER_SLOT_FLAG_FIXED    0x0001 // The content of the slot always has the recorded size.
+
+// Content octets of a template slot passed to BlgDerEncTemplate.
+typedef struct _BLG_DER_SLOT_VALUE
+{
+    CONST BYTE *Value;
+    DWORD ValueCb;
+
+} BLG_DER_SLOT_VALUE, *PBLG_DER_SLOT_VALUE;
+
+typedef CONST BLG_DER_SLOT_VALUE *PCBLG_DER_SLOT_VALUE;
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerMarkSlot(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN DWORD Flags
+    );
+
+BLGASN1API
+HBLG_DER_TEMPLATE
+BLGASN1CALL
+BlgDerCreateTemplate(
+    IN HBLG_DER_ENCODER EncoderHandle
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDestroyTemplate(
+    IN HBLG_DER_TEMPLATE TemplateHandle
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncTemplate(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN HBLG_DER_TEMPLATE TemplateHandle,
+    IN PCBLG_DER_SLOT_VALUE Values,
+    IN DWORD ValueCount
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -138,6 +257,14 @@ BlgDerEncTag(
     IN DWORD Tag
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncPreparedTag(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -176,7 +303,6 @@ BlgDerEncOctetString(
     IN INT ValueCb
     );
 
-// Not implemented yet.
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -187,6 +313,28 @@ BlgDerEncObjectIdentifier(
     IN PCWSTR Value
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncObjectIdentifierArcs(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST DWORD *Arcs,
+    IN DWORD ArcCount
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncObjectIdentifierArcs64(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST ULONGLONG *Arcs,
+    IN DWORD ArcCount
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -199,6 +347,50 @@ BlgDerEncInt(
     IN DWORD ValueCb
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncIntBigEndian(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOL Positive,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncIntLimbs(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOL Positive,
+    IN CONST ULONGLONG *Limbs,
+    IN DWORD LimbCount
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncInt64(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN LONGLONG Value
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncUInt64(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN ULONGLONG Value
+    );
+
 __inline
 BOOL
 BLGASN1INLINECALL
@@ -209,7 +401,7 @@ BlgDerEncInt16(
     IN SHORT Value
     )
 {
-    return BlgDerEncInt(EncoderHandle, Class, Tag, Value >= 0, (CONST PBYTE) &Value, sizeof(SHORT));
+    return BlgDerEncInt64(EncoderHandle, Class, Tag, Value);
 }
 
 __inline
@@ -222,7 +414,7 @@ BlgDerEncInt32(
     IN INT Value
     )
 {
-    return BlgDerEncInt(EncoderHandle, Class, Tag, Value >= 0, (CONST PBYTE) &Value, sizeof(INT));
+    return BlgDerEncInt64(EncoderHandle, Class, Tag, Value);
 }
 
 __inline
@@ -235,7 +427,7 @@ BlgDerEncUInt16(
     IN WORD Value
     )
 {
-    return BlgDerEncInt(EncoderHandle, Class, Tag, TRUE, (CONST PBYTE) &Value, sizeof(WORD));
+    return BlgDerEncUInt64(EncoderHandle, Class, Tag, Value);
 }
 
 __inline
@@ -248,7 +440,7 @@ BlgDerEncUInt32(
     IN DWORD Value
     )
 {
-    return BlgDerEncInt(EncoderHandle, Class, Tag, TRUE, (CONST PBYTE) &Value, sizeof(DWORD));
+    return BlgDerEncUInt64(EncoderHandle, Class, Tag, Value);
 }
 
 BLGASN1API
@@ -262,6 +454,83 @@ BlgDerEncIA5String(
     IN INT ValueCch
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncIA5StringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncNumericString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncNumericStringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncPrintableString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncPrintableStringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncVisibleString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncVisibleStringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -273,6 +542,21 @@ BlgDerEncUtf8String(
     IN INT ValueCch
     );
 
+// Valid values for Flags of BlgDerEncUtf8StringA and BlgDerDecUtf8StringA.
+#define BLG_DER_STRING_FLAG_VALIDATE   0x0001 // Check that the string is well-formed UTF-8.
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncUtf8StringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb,
+    IN DWORD Flags
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -294,6 +578,62 @@ BlgDerEncGeneralizedTime(
     IN CONST SYSTEMTIME *Value
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncGeneralizedTimeEpoch(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN LONGLONG Seconds,
+    IN DWORD Nanoseconds
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncSequenceOfInt32(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST INT *Values,
+    IN DWORD Count
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncSequenceOfInt64(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST LONGLONG *Values,
+    IN DWORD Count
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncSequenceOfBool(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BOOLEAN *Values,
+    IN DWORD Count
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncSequenceOfOctetString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BYTE *Values,
+    IN DWORD ValueCb,
+    IN DWORD Count
+    );
+
 // Valid values for Flag of BlgDerCreateDecoder.
 #define BLG_DER_DEC_FLAG_RELAXED   0x0001 // Use relaxed decoding rules. (BER)
 
@@ -317,6 +657,8 @@ BlgDerDestroyDecoder(
 #define BLG_DER_DEC_PARAM_ENCODED      0x01 // Return the pointer to the underlying encoded data.
 #define BLG_DER_DEC_PARAM_ENCODED_CB   0x02 // Return the size of the underlying encoded data.
 #define BLG_DER_DEC_PARAM_DECODED_CB   0x03 // Return the number of bytes decoded.
+#define BLG_DER_DEC_PARAM_VALUE        0x04 // Return the pointer to the value of the current node.
+#define BLG_DER_DEC_PARAM_VALUE_CB     0x05 // Return the size of the value of the current node.
 
 BLGASN1API
 BOOL
@@ -381,6 +723,15 @@ BlgDerCompareTag(
     OUT PBOOL IsEqual
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerComparePreparedTag(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag,
+    OUT PBOOL IsEqual
+    );
+
 __inline
 BOOL
 BLGASN1INLINECALL
@@ -417,23 +768,67 @@ BlgDerIsOctetString(
 __inline
 BOOL
 BLGASN1INLINECALL
-BlgDerIsInteger(
+BlgDerIsObjectIdentifier(
     IN HBLG_DER_DECODER DecoderHandle,
     OUT PBOOL Result
     )
 {
-    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_INTEGER, Result);
+    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_OBJECT_IDENTIFIER, Result);
 }
 
 __inline
 BOOL
 BLGASN1INLINECALL
-BlgDerIsIA5String(
+BlgDerIsInteger(
     IN HBLG_DER_DECODER DecoderHandle,
     OUT PBOOL Result
     )
 {
-    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_IA5_STRING, Result);
+    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_INTEGER, Result);
+}
+
+__inline
+BOOL
+BLGASN1INLINECALL
+BlgDerIsIA5String(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Result
+    )
+{
+    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_IA5_STRING, Result);
+}
+
+__inline
+BOOL
+BLGASN1INLINECALL
+BlgDerIsNumericString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Result
+    )
+{
+    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_NUMERIC_STRING, Result);
+}
+
+__inline
+BOOL
+BLGASN1INLINECALL
+BlgDerIsPrintableString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Result
+    )
+{
+    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_PRINTABLE_STRING, Result);
+}
+
+__inline
+BOOL
+BLGASN1INLINECALL
+BlgDerIsVisibleString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Result
+    )
+{
+    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_VISIBLE_STRING, Result);
 }
 
 __inline
@@ -469,6 +864,17 @@ BlgDerIsGeneralizedTime(
     return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_GENERALIZED_TIME, Result);
 }
 
+__inline
+BOOL
+BLGASN1INLINECALL
+BlgDerIsUtcTime(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Result
+    )
+{
+    return BlgDerCompareTag(DecoderHandle, BLG_DER_CLASS_UNIVERSAL, FALSE, BLG_DER_TAG_UTC_TIME, Result);
+}
+
 __inline
 BOOL
 BLGASN1INLINECALL
@@ -522,6 +928,121 @@ BlgDerDecOctetString(
     IN OUT PDWORD BufferCb
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecObjectIdentifier(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecObjectIdentifierArcs(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PDWORD Arcs OPTIONAL,
+    IN OUT PDWORD ArcCount
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecObjectIdentifierArcs64(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PULONGLONG Arcs OPTIONAL,
+    IN OUT PDWORD ArcCount
+    );
+
+// Content octets of an ASN.1 Object Identifier, encoded in advance so that a value can be
+// compared with a node without being decoded.
+typedef struct _BLG_DER_OID
+{
+    CONST BYTE *Value;
+    DWORD ValueCb;
+
+} BLG_DER_OID, *PBLG_DER_OID;
+
+typedef CONST BLG_DER_OID *PCBLG_DER_OID;
+
+// Initializes a BLG_DER_OID from a string literal holding the content octets, such as one of the
+// BLG_DER_OID_* constants below. The literal may contain zero octets.
+#define BLG_DER_OID_INIT(Octets) { (CONST BYTE *) (Octets), sizeof(Octets) - 1 }
+
+// Content octets of common Object Identifiers.
+#define BLG_DER_OID_RSA_ENCRYPTION           "\x2A\x86\x48\x86\xF7\x0D\x01\x01\x01" // 1.2.840.113549.1.1.1
+#define BLG_DER_OID_SHA1_WITH_RSA            "\x2A\x86\x48\x86\xF7\x0D\x01\x01\x05" // 1.2.840.113549.1.1.5
+#define BLG_DER_OID_RSASSA_PSS               "\x2A\x86\x48\x86\xF7\x0D\x01\x01\x0A" // 1.2.840.113549.1.1.10
+#define BLG_DER_OID_SHA256_WITH_RSA          "\x2A\x86\x48\x86\xF7\x0D\x01\x01\x0B" // 1.2.840.113549.1.1.11
+#define BLG_DER_OID_SHA384_WITH_RSA          "\x2A\x86\x48\x86\xF7\x0D\x01\x01\x0C" // 1.2.840.113549.1.1.12
+#define BLG_DER_OID_SHA512_WITH_RSA          "\x2A\x86\x48\x86\xF7\x0D\x01\x01\x0D" // 1.2.840.113549.1.1.13
+#define BLG_DER_OID_PKCS7_DATA               "\x2A\x86\x48\x86\xF7\x0D\x01\x07\x01" // 1.2.840.113549.1.7.1
+#define BLG_DER_OID_PKCS7_SIGNED_DATA        "\x2A\x86\x48\x86\xF7\x0D\x01\x07\x02" // 1.2.840.113549.1.7.2
+#define BLG_DER_OID_EC_PUBLIC_KEY            "\x2A\x86\x48\xCE\x3D\x02\x01"         // 1.2.840.10045.2.1
+#define BLG_DER_OID_PRIME256V1               "\x2A\x86\x48\xCE\x3D\x03\x01\x07"     // 1.2.840.10045.3.1.7
+#define BLG_DER_OID_SECP384R1                "\x2B\x81\x04\x00\x22"                 // 1.3.132.0.34
+#define BLG_DER_OID_ECDSA_WITH_SHA256        "\x2A\x86\x48\xCE\x3D\x04\x03\x02"     // 1.2.840.10045.4.3.2
+#define BLG_DER_OID_ECDSA_WITH_SHA384        "\x2A\x86\x48\xCE\x3D\x04\x03\x03"     // 1.2.840.10045.4.3.3
+#define BLG_DER_OID_ED25519                  "\x2B\x65\x70"                         // 1.3.101.112
+#define BLG_DER_OID_SHA1                     "\x2B\x0E\x03\x02\x1A"                 // 1.3.14.3.2.26
+#define BLG_DER_OID_SHA256                   "\x60\x86\x48\x01\x65\x03\x04\x02\x01" // 2.16.840.1.101.3.4.2.1
+#define BLG_DER_OID_SHA384                   "\x60\x86\x48\x01\x65\x03\x04\x02\x02" // 2.16.840.1.101.3.4.2.2
+#define BLG_DER_OID_SHA512                   "\x60\x86\x48\x01\x65\x03\x04\x02\x03" // 2.16.840.1.101.3.4.2.3
+#define BLG_DER_OID_COMMON_NAME              "\x55\x04\x03"                         // 2.5.4.3
+#define BLG_DER_OID_COUNTRY_NAME             "\x55\x04\x06"                         // 2.5.4.6
+#define BLG_DER_OID_LOCALITY_NAME            "\x55\x04\x07"                         // 2.5.4.7
+#define BLG_DER_OID_STATE_OR_PROVINCE_NAME   "\x55\x04\x08"                         // 2.5.4.8
+#define BLG_DER_OID_ORGANIZATION_NAME        "\x55\x04\x0A"                         // 2.5.4.10
+#define BLG_DER_OID_ORGANIZATIONAL_UNIT_NAME "\x55\x04\x0B"                         // 2.5.4.11
+#define BLG_DER_OID_SUBJECT_KEY_IDENTIFIER   "\x55\x1D\x0E"                         // 2.5.29.14
+#define BLG_DER_OID_KEY_USAGE                "\x55\x1D\x0F"                         // 2.5.29.15
+#define BLG_DER_OID_SUBJECT_ALT_NAME         "\x55\x1D\x11"                         // 2.5.29.17
+#define BLG_DER_OID_BASIC_CONSTRAINTS        "\x55\x1D\x13"                         // 2.5.29.19
+#define BLG_DER_OID_CRL_DISTRIBUTION_POINTS  "\x55\x1D\x1F"                         // 2.5.29.31
+#define BLG_DER_OID_CERTIFICATE_POLICIES     "\x55\x1D\x20"                         // 2.5.29.32
+#define BLG_DER_OID_AUTHORITY_KEY_IDENTIFIER "\x55\x1D\x23"                         // 2.5.29.35
+#define BLG_DER_OID_EXT_KEY_USAGE            "\x55\x1D\x25"                         // 2.5.29.37
+#define BLG_DER_OID_AUTHORITY_INFO_ACCESS    "\x2B\x06\x01\x05\x05\x07\x01\x01"     // 1.3.6.1.5.5.7.1.1
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerCompareObjectIdentifier(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_OID Oid,
+    OUT PBOOL IsEqual
+    );
+
+DECLARE_HANDLE(HBLG_DER_OID_REGISTRY);
+
+// Returned by BlgDerLookupObjectIdentifier for a value that is not in the registry.
+#define BLG_DER_OID_NOT_FOUND   0xFFFFFFFF
+
+BLGASN1API
+HBLG_DER_OID_REGISTRY
+BLGASN1CALL
+BlgDerCreateOidRegistry(
+    IN PCBLG_DER_OID Oids,
+    IN DWORD OidCount
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDestroyOidRegistry(
+    IN HBLG_DER_OID_REGISTRY RegistryHandle
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerLookupObjectIdentifier(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN HBLG_DER_OID_REGISTRY RegistryHandle,
+    OUT PDWORD Index
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -532,6 +1053,26 @@ BlgDerDecInt(
     IN OUT PDWORD BufferCb
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecIntBigEndian(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Positive OPTIONAL,
+    OUT PBYTE Buffer OPTIONAL,
+    IN OUT PDWORD BufferCb
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecIntLimbs(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Positive OPTIONAL,
+    OUT PULONGLONG Limbs OPTIONAL,
+    IN OUT PDWORD LimbCount
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -564,6 +1105,22 @@ BlgDerDecUInt32(
     OUT PDWORD Value
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecInt64(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PLONGLONG Value
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecUInt64(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PULONGLONG Value
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -573,6 +1130,69 @@ BlgDerDecIA5String(
     IN OUT PDWORD BufferCch
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecIA5StringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecNumericString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecNumericStringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecPrintableString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecPrintableStringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecVisibleString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecVisibleStringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -582,6 +1202,16 @@ BlgDerDecUtf8String(
     IN OUT PDWORD BufferCch
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecUtf8StringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb,
+    IN DWORD Flags
+    );
+
 BLGASN1API
 BOOL
 BLGASN1CALL
@@ -599,6 +1229,31 @@ BlgDerDecGeneralizedTime(
     OUT PSYSTEMTIME Value
     );
 
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecGeneralizedTimeEpoch(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PLONGLONG Seconds,
+    OUT PDWORD Nanoseconds OPTIONAL
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecUtcTime(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PSYSTEMTIME Value
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecUtcTimeEpoch(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PLONGLONG Seconds
+    );
+
 typedef struct _BLG_DER_CHILD_NODE
 {
     BYTE  Class;
@@ -632,4 +1287,214 @@ BlgDerDecSequence(
     IN PVOID Context
     );
 
+// Receives the location of a child node matched by BlgDerDecSequenceSpans. Both spans point
+// into the encoded data; Encoded covers the identifier, length and content octets.
+typedef struct _BLG_DER_SPAN
+{
+    BOOL Present;
+    CONST BYTE *Value;
+    DWORD ValueCb;
+    CONST BYTE *Encoded;
+    DWORD EncodedCb;
+
+} BLG_DER_SPAN, *PBLG_DER_SPAN;
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceSpans(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_CHILD_NODE Nodes,
+    IN DWORD NodeCount,
+    OUT PBLG_DER_SPAN Spans,
+    OUT PULONGLONG PresentMask OPTIONAL
+    );
+
+DECLARE_HANDLE(HBLG_DER_CHOICE);
+
+BLGASN1API
+HBLG_DER_CHOICE
+BLGASN1CALL
+BlgDerCreateChoice(
+    IN PCBLG_DER_CHILD_NODE Nodes,
+    IN DWORD NodeCount
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDestroyChoice(
+    IN HBLG_DER_CHOICE ChoiceHandle
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecChoice(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN HBLG_DER_CHOICE ChoiceHandle,
+    OUT PDWORD Index,
+    IN PBLG_DER_DECODE_NODE_ROUTINE DecodeRoutine OPTIONAL,
+    IN PVOID Context
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecSet(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_CHILD_NODE Nodes,
+    IN DWORD NodeCount,
+    OUT PBLG_DER_SPAN Spans,
+    OUT PULONGLONG PresentMask OPTIONAL
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecSetEx(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN HBLG_DER_CHOICE ChoiceHandle,
+    OUT PBLG_DER_SPAN Spans,
+    OUT PULONGLONG PresentMask OPTIONAL
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceOfInt32(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PINT Values OPTIONAL,
+    IN OUT PDWORD Count
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceOfInt64(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PLONGLONG Values OPTIONAL,
+    IN OUT PDWORD Count
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceOfBool(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOLEAN Values OPTIONAL,
+    IN OUT PDWORD Count
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceOfOctetString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBYTE Values OPTIONAL,
+    IN DWORD ValueCb,
+    IN OUT PDWORD Count
+    );
+
+// Valid values for Type of BLG_DER_FIELD. The comment names the C type of the member at Offset.
+#define BLG_DER_FIELD_BOOL          0x01 // BOOLEAN
+#define BLG_DER_FIELD_INT32         0x02 // INT
+#define BLG_DER_FIELD_UINT32        0x03 // DWORD
+#define BLG_DER_FIELD_INT64         0x04 // LONGLONG
+#define BLG_DER_FIELD_UINT64        0x05 // ULONGLONG
+#define BLG_DER_FIELD_NULL          0x06 // None.
+#define BLG_DER_FIELD_OCTET_STRING  0x07 // CONST BYTE *, with the DWORD size at CountOffset.
+#define BLG_DER_FIELD_SEQUENCE      0x08 // Embedded structure described by Struct.
+#define BLG_DER_FIELD_SEQUENCE_OF   0x09 // CONST VOID *, with the DWORD element count at CountOffset.
+
+// Valid values for Flags of BLG_DER_FIELD.
+#define BLG_DER_FIELD_FLAG_DEFAULT  0x0001 // The field is omitted if it equals Default.
+
+typedef struct _BLG_DER_STRUCT BLG_DER_STRUCT, *PBLG_DER_STRUCT;
+
+typedef CONST BLG_DER_STRUCT *PCBLG_DER_STRUCT;
+
+// Describes a member of a C structure and the ASN.1 node it is encoded as. If Node.Class is
+// BLG_DER_CLASS_UNIVERSAL and Node.Tag is zero, the universal tag of Type is used. If
+// Node.Optional is TRUE, the field is present only if the BOOLEAN at PresentOffset is TRUE.
+// Node.Constructed must be TRUE for SEQUENCE and SEQUENCE OF fields and FALSE for all other
+// types; otherwise the descriptor is rejected with ERROR_INVALID_PARAMETER.
+//
+// The elements of a SEQUENCE OF field are described by the single field of Struct, with
+// offsets relative to the element, and are StructCb bytes apart. When decoding, the caller
+// provides the array and stores its capacity at CountOffset. Decoded OCTET STRING members
+// point into the encoded data.
+typedef struct _BLG_DER_FIELD
+{
+    BLG_DER_CHILD_NODE Node;
+    DWORD Type;
+    DWORD Flags;
+    DWORD Offset;
+    DWORD CountOffset;
+    DWORD PresentOffset;
+    LONGLONG Default;
+    PCBLG_DER_STRUCT Struct;
+
+} BLG_DER_FIELD, *PBLG_DER_FIELD;
+
+typedef CONST BLG_DER_FIELD *PCBLG_DER_FIELD;
+
+// Describes a C structure that is encoded as an ASN.1 SEQUENCE.
+struct _BLG_DER_STRUCT
+{
+    PCBLG_DER_FIELD Fields;
+    DWORD FieldCount;
+    DWORD StructCb;
+};
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerEncodeStruct(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCBLG_DER_STRUCT Struct,
+    IN CONST VOID *Value
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerDecodeStruct(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_STRUCT Struct,
+    OUT PVOID Value
+    );
+
+// Valid values for Flags of BlgDerSearch.
+#define BLG_DER_SEARCH_FLAG_UNVERIFIED 0x0001 // Report every occurrence, whether or not it starts a node.
+
+// Receives a match of BlgDerSearch: the offset of the node within the encoded data and its
+// nesting depth, zero for a top level node.
+typedef
+BOOL
+(BLGASN1CALL *PBLG_DER_SEARCH_ROUTINE)(
+    IN DWORD Offset,
+    IN DWORD Depth,
+    IN PVOID Context
+    );
+
+BLGASN1API
+BOOL
+BLGASN1CALL
+BlgDerSearch(
+    IN CONST BYTE *Encoded,
+    IN DWORD EncodedCb,
+    IN BYTE Class,
+    IN BOOLEAN Constructed,
+    IN DWORD Tag,
+    IN CONST BYTE *Value OPTIONAL,
+    IN DWORD ValueCb,
+    IN DWORD Flags,
+    IN PBLG_DER_SEARCH_ROUTINE SearchRoutine OPTIONAL,
+    IN PVOID Context,
+    OUT PDWORD MatchCount OPTIONAL
+    );
+
 #endif
\ No newline at end of file
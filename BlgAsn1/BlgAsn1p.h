@@ -12,22 +12,335 @@ See License.txt in the project root for license information.
 #define BLGASN1P_H
 
 #include <windows.h>
+#include <stdlib.h>
+#include <intrin.h>
 
 #include "BlgAsn1.h"
 
+// Byte order of the target machine. All architectures supported by Windows are little-endian;
+// define BLGP_LITTLE_ENDIAN as 0 when building for a big-endian target.
+#ifndef BLGP_LITTLE_ENDIAN
+#define BLGP_LITTLE_ENDIAN 1
+#endif
+
+// SSE2 is always available on x64. On x86 it is only used if the compiler targets it (/arch:SSE2).
+#if !defined(_M_CEE_PURE) && (defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define BLGP_SSE2
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+// Instruction sets beyond SSE2 are only used after BlgpGetCpuFeatures reports them.
+#define BLGP_CPU_FEATURE_SSSE3   0x01
+#define BLGP_CPU_FEATURE_AVX2    0x02
+
 extern HANDLE g_Heap;
 
 #define BLGASN1_FLAGON(x, Flag) (((x) & (Flag)) > 0)
 
 __inline
-BOOL
+WORD
 BLGASN1INLINECALL
-BlgpIsLittleEndian(
-    VOID
+BlgpByteSwap16(
+    IN WORD Value
+    )
+{
+    return _byteswap_ushort(Value);
+}
+
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpByteSwap32(
+    IN DWORD Value
+    )
+{
+    return _byteswap_ulong(Value);
+}
+
+__inline
+ULONGLONG
+BLGASN1INLINECALL
+BlgpByteSwap64(
+    IN ULONGLONG Value
+    )
+{
+    return _byteswap_uint64(Value);
+}
+
+// Reads a big-endian value from a possibly unaligned address. The compiler turns the load and
+// the swap into a single MOVBE or a MOV/BSWAP pair.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpLoadBigEndian32(
+    IN CONST BYTE *Ptr
+    )
+{
+#if BLGP_LITTLE_ENDIAN
+    return BlgpByteSwap32(*(CONST DWORD UNALIGNED *) Ptr);
+#else
+    return *(CONST DWORD UNALIGNED *) Ptr;
+#endif
+}
+
+__inline
+ULONGLONG
+BLGASN1INLINECALL
+BlgpLoadBigEndian64(
+    IN CONST BYTE *Ptr
+    )
+{
+#if BLGP_LITTLE_ENDIAN
+    return BlgpByteSwap64(*(CONST ULONGLONG UNALIGNED *) Ptr);
+#else
+    return *(CONST ULONGLONG UNALIGNED *) Ptr;
+#endif
+}
+
+// Writes a big-endian value to a possibly unaligned address.
+__inline
+VOID
+BLGASN1INLINECALL
+BlgpStoreBigEndian32(
+    OUT PBYTE Ptr,
+    IN DWORD Value
+    )
+{
+#if BLGP_LITTLE_ENDIAN
+    *(DWORD UNALIGNED *) Ptr = BlgpByteSwap32(Value);
+#else
+    *(DWORD UNALIGNED *) Ptr = Value;
+#endif
+}
+
+__inline
+VOID
+BLGASN1INLINECALL
+BlgpStoreBigEndian64(
+    OUT PBYTE Ptr,
+    IN ULONGLONG Value
+    )
+{
+#if BLGP_LITTLE_ENDIAN
+    *(ULONGLONG UNALIGNED *) Ptr = BlgpByteSwap64(Value);
+#else
+    *(ULONGLONG UNALIGNED *) Ptr = Value;
+#endif
+}
+
+// Returns the number of octets required to hold the specified value, excluding the leading
+// octets with the value zero. A zero value requires a single octet.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpOctetCount32(
+    IN DWORD Value
+    )
+{
+    unsigned long Index;
+
+    if (!_BitScanReverse(&Index, Value))
+    {
+        return 1;
+    }
+
+    return (Index >> 3) + 1;
+}
+
+// Returns the index of the most significant bit set in the specified value, which must not be
+// zero.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpHighestBit64(
+    IN ULONGLONG Value
+    )
+{
+    unsigned long Index;
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(_M_ARM64)
+    _BitScanReverse64(&Index, Value);
+#else
+    if (_BitScanReverse(&Index, (DWORD) (Value >> 32)))
+    {
+        Index += 32;
+    }
+    else
+    {
+        _BitScanReverse(&Index, (DWORD) Value);
+    }
+#endif
+
+    return Index;
+}
+
+// Returns the number of content octets of the ASN.1 DER encoding of a signed integer. For a
+// negative value the bits are inverted first, so the leading 0xFF octets are discarded the same
+// way as the leading zero octets of a positive value. The extra bit makes room for the sign.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpIntOctetCount64(
+    IN LONGLONG Value
+    )
+{
+    return (BlgpHighestBit64((((ULONGLONG) (Value ^ (Value >> 63))) << 1) | 1) >> 3) + 1;
+}
+
+// Returns the number of content octets of the ASN.1 DER encoding of an unsigned integer,
+// including the leading zero octet required when the most significant bit is one.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpUIntOctetCount64(
+    IN ULONGLONG Value
+    )
+{
+    return ((BlgpHighestBit64(Value | 1) + 1) >> 3) + 1;
+}
+
+// Writes the content octets of an ASN.1 DER integer. OctetCount must be the value returned by
+// BlgpIntOctetCount64 or BlgpUIntOctetCount64. If at least eight octets are available before
+// End, the octets are written with a single unaligned big-endian store.
+__inline
+VOID
+BLGASN1INLINECALL
+BlgpWriteInt64(
+    OUT PBYTE Ptr,
+    IN CONST BYTE *End,
+    IN ULONGLONG Value,
+    IN DWORD OctetCount
+    )
+{
+    if (OctetCount > 8)
+    {
+        *Ptr++ = 0; OctetCount--;
+    }
+
+    if (End - Ptr >= 8)
+    {
+        BlgpStoreBigEndian64(Ptr, Value << ((8 - OctetCount) * 8));
+    }
+    else
+    {
+        while (OctetCount-- > 0)
+        {
+            *Ptr++ = (BYTE) (Value >> (OctetCount * 8));
+        }
+    }
+}
+
+// Returns the number of octets required to encode the specified ASN.1 DER length.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpLenOctetCount(
+    IN DWORD Len
+    )
+{
+    return Len <= 127 ? 1 : BlgpOctetCount32(Len) + 1;
+}
+
+// Writes the specified ASN.1 DER length and returns the number of octets written. The caller
+// must make sure that the buffer can hold BlgpLenOctetCount(Len) octets.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpWriteLen(
+    OUT PBYTE Ptr,
+    IN DWORD Len
+    )
+{
+    DWORD OctetCount;
+
+    if (Len <= 127)
+    {
+        *Ptr = (BYTE) Len;
+
+        return 1;
+    }
+
+    OctetCount = BlgpOctetCount32(Len);
+
+    *Ptr++ = (BYTE) OctetCount | 0x80;
+
+    switch (OctetCount)
+    {
+    case 4:
+        *Ptr++ = (BYTE) (Len >> 24);
+    case 3:
+        *Ptr++ = (BYTE) (Len >> 16);
+    case 2:
+        *Ptr++ = (BYTE) (Len >> 8);
+    default:
+        *Ptr = (BYTE) Len;
+    }
+
+    return OctetCount + 1;
+}
+
+// Returns the number of identifier octets of the ASN.1 DER encoding of the specified tag.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpTagOctetCount(
+    IN DWORD Tag
+    )
+{
+    unsigned long Index;
+
+    if (Tag <= 30)
+    {
+        return 1;
+    }
+
+    _BitScanReverse(&Index, Tag);
+
+    return (Index / 7) + 2;
+}
+
+// Writes the identifier octets of the specified tag and returns the number of octets written.
+// The caller must make sure that the buffer can hold BlgpTagOctetCount(Tag) octets.
+__inline
+DWORD
+BLGASN1INLINECALL
+BlgpWriteTag(
+    OUT PBYTE Ptr,
+    IN BYTE Class,
+    IN BOOLEAN Constructed,
+    IN DWORD Tag
     )
 {
-    WORD t = 1;
-    return *(PBYTE) &t;
+    DWORD OctetCount = BlgpTagOctetCount(Tag), i;
+
+    Ptr[0] = (BYTE) (Class << 6);
+
+    if (Constructed)
+    {
+        Ptr[0] |= 0x20;
+    }
+
+    if (OctetCount == 1)
+    {
+        Ptr[0] |= (BYTE) Tag;
+
+        return 1;
+    }
+
+    Ptr[0] |= 0x1F;
+
+    // Subsequent octets carry seven bits each; all but the last have bit 8 set.
+    Ptr[OctetCount - 1] = (BYTE) (Tag & 0x7F);
+
+    for (i = OctetCount - 2; i > 0; i--)
+    {
+        Tag >>= 7;
+
+        Ptr[i] = (BYTE) (Tag & 0x7F) | 0x80;
+    }
+
+    return OctetCount;
 }
 
 __inline
@@ -59,15 +372,43 @@ BlgPushEntryList(
     ListHead->Next = Entry;
 }
 
-typedef struct _BLGP_DER_ENCODER
+// Modes of an encoder, selected when the encoder is created. The modes index the instance tables
+// defined by BLGP_DER_ENC_INSTANCES.
+#define BLGP_DER_ENC_MODE_MEASURE     0x00 // There is no buffer; only the encoded size is calculated.
+#define BLGP_DER_ENC_MODE_CHECKED     0x01 // Every write is checked against the size of the buffer.
+#define BLGP_DER_ENC_MODE_UNCHECKED   0x02 // The caller guarantees that the buffer is large enough.
+
+// Template slot marked by BlgDerMarkSlot.
+typedef struct _BLGP_DER_ENCODER_SLOT
+{
+    DWORD Offset;
+    DWORD Flags;
+
+} BLGP_DER_ENCODER_SLOT, *PBLGP_DER_ENCODER_SLOT;
+
+typedef struct _BLGP_DER_ENCODER BLGP_DER_ENCODER, *PBLGP_DER_ENCODER;
+
+struct _BLGP_DER_ENCODER
 {
     PBYTE Buffer;
     DWORD BufferCb;
     PBYTE Ptr;
     DWORD Flags;
+    DWORD Mode;
     SINGLE_LIST_ENTRY Stack;
+    DWORD Depth;
+    PBLGP_DER_ENCODER_SLOT Slots;
+    DWORD SlotCount;
+    DWORD SlotCapacity;
+};
 
-} BLGP_DER_ENCODER, *PBLGP_DER_ENCODER;
+// Constructed node whose length octets are written when the node is ended.
+typedef struct _BLGP_DER_ENCODER_NODE
+{
+    SINGLE_LIST_ENTRY Link;
+    PBYTE ValueOffset;
+
+} BLGP_DER_ENCODER_NODE, *PBLGP_DER_ENCODER_NODE;
 
 typedef struct _BLGP_DER_DECODER_NODE
 {
@@ -87,22 +428,242 @@ typedef struct _BLGP_DER_DECODER
 
 } BLGP_DER_DECODER, *PBLGP_DER_DECODER;
 
+// Restricted character sets of the string types.
+#define BLGP_CHARSET_IA5         0x00
+#define BLGP_CHARSET_NUMERIC     0x01
+#define BLGP_CHARSET_PRINTABLE   0x02
+#define BLGP_CHARSET_VISIBLE     0x03
+
+typedef struct _BLGP_CHARSET_RANGE
+{
+    BYTE First;
+    BYTE Last;
+
+} BLGP_CHARSET_RANGE, *PBLGP_CHARSET_RANGE;
+
+typedef struct _BLGP_CHARSET
+{
+    DWORD RangeCount;
+    BLGP_CHARSET_RANGE Ranges[7];
+
+    // Bit n of entry i is set if the octet with the high nibble n and the low nibble i belongs
+    // to the set.
+    BYTE Nibbles[16];
+
+} BLGP_CHARSET, *PBLGP_CHARSET;
+
 // Calculates the number of encoded bytes.
 #define BLGP_DER_ENCODED_CB(Encoder) ((DWORD) ((Encoder)->Ptr - (Encoder)->Buffer))
 
+// Advances the encoder by the specified number of octets and returns the position at which they
+// are to be written, or NULL if the encoder only measures. Only an encoder in the checked mode
+// compares the size with the space left in the buffer. Mode must be a constant: the routine is
+// inlined into the instance of an encoding routine for that mode, which keeps only the code of
+// the mode. Routines reserve the identifier, length and content octets of a node at once, so a
+// node costs a single check.
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpReserve(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN ULONGLONG Cb,
+    OUT PBYTE *Ptr
+    )
+{
+    if (Mode == BLGP_DER_ENC_MODE_CHECKED && Cb > Encoder->BufferCb - BLGP_DER_ENCODED_CB(Encoder))
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+        return FALSE;
+    }
+
+    *Ptr = Mode == BLGP_DER_ENC_MODE_MEASURE ? NULL : Encoder->Ptr;
+
+    Encoder->Ptr += (SIZE_T) Cb;
+
+    return TRUE;
+}
+
+// Reserves a whole node like BlgpReserve and writes its identifier and length octets. The
+// position of the content octets is returned.
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpReserveNode(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN BOOLEAN Constructed,
+    IN DWORD Tag,
+    IN DWORD ValueCb,
+    OUT PBYTE *Ptr
+    )
+{
+    DWORD LenOctetCount = BlgpLenOctetCount(ValueCb);
+    PBYTE Position;
+
+    if (!BlgpReserve(Mode, Encoder, (ULONGLONG) BlgpTagOctetCount(Tag) + LenOctetCount + ValueCb, &Position))
+    {
+        return FALSE;
+    }
+
+    if (Mode == BLGP_DER_ENC_MODE_MEASURE)
+    {
+        *Ptr = NULL;
+
+        return TRUE;
+    }
+
+    Position += BlgpWriteTag(Position, Class, Constructed, Tag);
+
+    BlgpWriteLen(Position, ValueCb);
+
+    *Ptr = Position + LenOctetCount;
+
+    return TRUE;
+}
+
+// Returns the end of the memory an encoder may write to after a reservation. A checked encoder
+// may write up to the end of its buffer; the size of the buffer of an unchecked encoder is not
+// trusted, so it may only write the octets it has reserved.
+__forceinline
+CONST BYTE *
+BLGASN1INLINECALL
+BlgpWritableEnd(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder
+    )
+{
+    return Mode == BLGP_DER_ENC_MODE_CHECKED ? Encoder->Buffer + Encoder->BufferCb : Encoder->Ptr;
+}
+
+#define BLGP_ARGUMENTS(...) __VA_ARGS__
+
+// Defines the measure, checked and unchecked instances of an encoding routine, and a table of
+// the instances indexed by the mode of an encoder. Routine takes the mode as its first parameter
+// and must be declared __forceinline; every instance inlines it with a constant mode, so the
+// instance contains only the code of its mode. Parameters and Arguments are the parenthesized
+// remaining parameters of the routine and their names.
+#define BLGP_DER_ENC_INSTANCES(Routine, Parameters, Arguments) \
+    static BOOL BLGASN1CALL Routine##Measure Parameters \
+    { \
+        return Routine(BLGP_DER_ENC_MODE_MEASURE, BLGP_ARGUMENTS Arguments); \
+    } \
+    static BOOL BLGASN1CALL Routine##Checked Parameters \
+    { \
+        return Routine(BLGP_DER_ENC_MODE_CHECKED, BLGP_ARGUMENTS Arguments); \
+    } \
+    static BOOL BLGASN1CALL Routine##Unchecked Parameters \
+    { \
+        return Routine(BLGP_DER_ENC_MODE_UNCHECKED, BLGP_ARGUMENTS Arguments); \
+    } \
+    static BOOL (BLGASN1CALL * CONST Routine##Instances[]) Parameters = \
+    { \
+        Routine##Measure, Routine##Checked, Routine##Unchecked \
+    }
+
+DWORD
+BLGASN1CALL
+BlgpGetCpuFeatures(
+    VOID
+    );
+
 VOID
 BLGASN1CALL
-BlgpCopyMemory(
+BlgpReverseMemory(
     IN PBYTE Destination,
     IN CONST BYTE *Source,
     IN DWORD Cb
     );
 
+BOOL
+BLGASN1CALL
+BlgpIsValidUtf8(
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb
+    );
+
+BOOL
+BLGASN1CALL
+BlgpUtf8ToUtf16(
+    OUT PWSTR Destination OPTIONAL,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    OUT PDWORD DestinationCch
+    );
+
+ULONGLONG
+BLGASN1CALL
+BlgpUtf16ToUtf8Cb(
+    IN PCWSTR Value,
+    IN size_t Cch
+    );
+
+VOID
+BLGASN1CALL
+BlgpUtf16ToUtf8(
+    OUT PBYTE Destination,
+    IN PCWSTR Value,
+    IN size_t Cch
+    );
+
+BOOL
+BLGASN1CALL
+BlgpIsInCharset(
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN DWORD Charset
+    );
+
+BOOL
+BLGASN1CALL
+BlgpWidenCharset(
+    OUT PWSTR Destination,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN DWORD Charset
+    );
+
+BOOL
+BLGASN1CALL
+BlgpNarrowCharset(
+    OUT PBYTE Destination OPTIONAL,
+    IN PCWSTR Value,
+    IN size_t Cch,
+    IN DWORD Charset
+    );
+BOOL
+BLGASN1CALL
+BlgpMoveToNode(
+    IN CONST BYTE *Encoded,
+    IN DWORD EncodedCb,
+    IN CONST BYTE *Offset,
+    OUT PBLGP_DER_DECODER_NODE Node
+    );
+
+BOOL
+BLGASN1CALL
+BlgpReadInteger(
+    IN CONST BYTE *Base,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN BOOL Signed,
+    OUT PULONGLONG Result
+    );
+
 DWORD
 BLGASN1CALL
-BlgpNonZeroByteLength(
-    IN CONST BYTE *Buffer,
-    IN DWORD BufferCb
+BlgpLookupChoice(
+    IN HBLG_DER_CHOICE ChoiceHandle,
+    IN CONST BLGP_DER_DECODER_NODE *Node
+    );
+
+PCBLG_DER_CHILD_NODE
+BLGASN1CALL
+BlgpGetChoiceNodes(
+    IN HBLG_DER_CHOICE ChoiceHandle,
+    OUT PDWORD NodeCount
     );
 
 BOOL
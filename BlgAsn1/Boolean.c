@@ -11,6 +11,22 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncBool(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOLEAN Value
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncBool,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, BOOLEAN Value),
+    (Encoder, Class, Tag, Value));
+
 BOOL
 BLGASN1CALL
 BlgDerEncBool(
@@ -44,6 +60,7 @@ Return Value:
 
 {
     PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
     if (!Encoder)
     {
         SetLastError(ERROR_INVALID_PARAMETER);
@@ -51,32 +68,7 @@ Return Value:
         return FALSE;
     }
 
-    if (!BlgDerEncTag(EncoderHandle, Class, FALSE,
-            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_BOOLEAN : Tag))
-    {
-        return FALSE;
-    }
-
-    if (!BlgDerEncLen(EncoderHandle, 1))
-    {
-        return FALSE;
-    }
-
-    if (Encoder->Buffer)
-    {
-        if (BLGP_DER_ENCODED_CB(Encoder) + 1 > Encoder->BufferCb)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
-
-            return FALSE;
-        }
-
-        *Encoder->Ptr = Value ? 0xFF : 0x00;
-    }
-
-    Encoder->Ptr++;
-
-    return TRUE;
+    return BlgpEncBoolInstances[Encoder->Mode](Encoder, Class, Tag, Value);
 }
 
 BOOL
@@ -145,4 +137,41 @@ Return Value:
     SetLastError(ERROR_BLGASN1_CORRUPT);
 
     return FALSE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncBool(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOLEAN Value
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 BOOLEAN value in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE,
+            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_BOOLEAN : Tag, 1, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        *Ptr = Value ? 0xFF : 0x00;
+    }
+
+    return TRUE;
 }
\ No newline at end of file
@@ -0,0 +1,418 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+--*/
+
+#include <windows.h>
+
+#include "BlgAsn1.h"
+#include "BlgAsn1p.h"
+
+// Marks an entry of the first octet table whose identifier octets continue with a high tag
+// number; such tags are looked up in the hash table.
+#define BLGP_CHOICE_HIGH_TAG   0xFFFF
+
+// The first octet table stores alternative indexes plus one in a WORD.
+#define BLGP_CHOICE_MAX_NODES  0xFFFE
+
+typedef struct _BLGP_DER_CHOICE_ENTRY
+{
+    ULONGLONG Key;
+    DWORD Index;
+
+} BLGP_DER_CHOICE_ENTRY, *PBLGP_DER_CHOICE_ENTRY;
+
+typedef struct _BLGP_DER_CHOICE
+{
+    // Index plus one of the alternative whose identifier is the single octet used as the index,
+    // zero if there is none, or BLGP_CHOICE_HIGH_TAG.
+    WORD FirstOctet[256];
+
+    // Open addressing table of the alternatives with high tag numbers. The key of an entry holds
+    // the identifier octets in ascending order of significance; an empty entry has a zero key.
+    PBLGP_DER_CHOICE_ENTRY Entries;
+    DWORD EntryMask;
+
+    PBLG_DER_CHILD_NODE Nodes;
+    DWORD NodeCount;
+
+} BLGP_DER_CHOICE, *PBLGP_DER_CHOICE;
+
+static
+ULONGLONG
+BLGASN1CALL
+BlgpChoiceKey(
+    IN CONST BYTE *Octets,
+    IN DWORD OctetCount
+    );
+
+static
+DWORD
+BLGASN1CALL
+BlgpChoiceHash(
+    IN ULONGLONG Key
+    );
+
+HBLG_DER_CHOICE
+BLGASN1CALL
+BlgDerCreateChoice(
+    IN PCBLG_DER_CHILD_NODE Nodes,
+    IN DWORD NodeCount
+    )
+
+/*++
+
+Routine Description:
+
+    Creates a dispatcher for the alternatives of an ASN.1 CHOICE. The identifier octets of each
+    alternative are built once; alternatives with a tag number below 31 are found through a table
+    indexed by the single identifier octet, the others through a hash table keyed on all of their
+    identifier octets, so the alternative of a node is found in constant time.
+
+Arguments:
+
+    Nodes - Array of the alternatives. The Optional member of the elements is ignored.
+
+    NodeCount - Number of alternatives in the Nodes parameter.
+
+Return Value:
+
+    Handle to the dispatcher if the routine succeeds; otherwise, NULL. The routine fails with
+    ERROR_INVALID_PARAMETER if two alternatives have the same tag.
+
+--*/
+
+{
+    PBLGP_DER_CHOICE Choice;
+    PBLGP_DER_CHOICE_ENTRY Entry;
+    BYTE Octets[6];
+    SIZE_T HeaderCb, EntriesCb;
+    DWORD EntryCount, OctetCount, Slot, i;
+    ULONGLONG Key;
+
+    if (!Nodes || NodeCount == 0 || NodeCount > BLGP_CHOICE_MAX_NODES)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return NULL;
+    }
+
+    // Keep the hash table at most half full.
+    for (EntryCount = 4; EntryCount < NodeCount * 2; EntryCount <<= 1);
+
+    HeaderCb = (sizeof(BLGP_DER_CHOICE) + sizeof(ULONGLONG) - 1) & ~(sizeof(ULONGLONG) - 1);
+    EntriesCb = EntryCount * sizeof(BLGP_DER_CHOICE_ENTRY);
+
+    Choice = HeapAlloc(g_Heap, HEAP_ZERO_MEMORY, HeaderCb + EntriesCb + NodeCount * sizeof(BLG_DER_CHILD_NODE));
+    if (!Choice)
+    {
+        SetLastError(ERROR_OUTOFMEMORY);
+
+        return NULL;
+    }
+
+    Choice->Entries = (PBLGP_DER_CHOICE_ENTRY) ((PBYTE) Choice + HeaderCb);
+    Choice->EntryMask = EntryCount - 1;
+    Choice->Nodes = (PBLG_DER_CHILD_NODE) ((PBYTE) Choice->Entries + EntriesCb);
+    Choice->NodeCount = NodeCount;
+
+    CopyMemory(Choice->Nodes, Nodes, NodeCount * sizeof(BLG_DER_CHILD_NODE));
+
+    for (i = 0; i < NodeCount; i++)
+    {
+        if (Nodes[i].Class > BLG_DER_CLASS_PRIVATE)
+        {
+            goto Invalid;
+        }
+
+        OctetCount = BlgpWriteTag(Octets, Nodes[i].Class, (BOOLEAN) Nodes[i].Constructed, Nodes[i].Tag);
+
+        if (OctetCount == 1)
+        {
+            if (Choice->FirstOctet[Octets[0]] != 0)
+            {
+                goto Invalid;
+            }
+
+            Choice->FirstOctet[Octets[0]] = (WORD) (i + 1);
+
+            continue;
+        }
+
+        Choice->FirstOctet[Octets[0]] = BLGP_CHOICE_HIGH_TAG;
+
+        Key = BlgpChoiceKey(Octets, OctetCount);
+
+        for (Slot = BlgpChoiceHash(Key) & Choice->EntryMask; ; Slot = (Slot + 1) & Choice->EntryMask)
+        {
+            Entry = Choice->Entries + Slot;
+
+            if (Entry->Key == 0)
+            {
+                Entry->Key = Key;
+                Entry->Index = i;
+
+                break;
+            }
+
+            if (Entry->Key == Key)
+            {
+                goto Invalid;
+            }
+        }
+    }
+
+    return (HBLG_DER_CHOICE) Choice;
+
+Invalid:
+    HeapFree(g_Heap, 0, Choice);
+
+    SetLastError(ERROR_INVALID_PARAMETER);
+
+    return NULL;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDestroyChoice(
+    IN HBLG_DER_CHOICE ChoiceHandle
+    )
+
+/*++
+
+Routine Description:
+
+    Destroys the specified CHOICE dispatcher.
+
+Arguments:
+
+    ChoiceHandle - Handle to the dispatcher to be destroyed.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    if (!ChoiceHandle)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return HeapFree(g_Heap, 0, ChoiceHandle);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecChoice(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN HBLG_DER_CHOICE ChoiceHandle,
+    OUT PDWORD Index,
+    IN PBLG_DER_DECODE_NODE_ROUTINE DecodeRoutine OPTIONAL,
+    IN PVOID Context
+    )
+
+/*++
+
+Routine Description:
+
+    Determines the alternative of an ASN.1 CHOICE that the current node carries and optionally
+    calls a routine to decode it. The identifier octets of the node are looked up directly; the
+    tag is not decoded.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    ChoiceHandle - Handle to the dispatcher created by BlgDerCreateChoice.
+
+    Index - Pointer to a variable that receives the index of the alternative.
+
+    DecodeRoutine - Optional routine to be called for decoding the alternative. The routine
+        receives the index and the element of the alternative.
+
+    Context - Pointer to the caller defined context value to be passed to the decoding routine.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_BLGASN1_BADTAG
+    if the node does not carry the tag of an alternative.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    PBLGP_DER_CHOICE Choice = (PBLGP_DER_CHOICE) ChoiceHandle;
+    DWORD Found;
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    if (!Choice || !Index)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    Found = BlgpLookupChoice(ChoiceHandle, &Decoder->CurrentNode);
+
+    if (Found == 0)
+    {
+        SetLastError(ERROR_BLGASN1_BADTAG);
+
+        return FALSE;
+    }
+
+    *Index = Found - 1;
+
+    if (DecodeRoutine)
+    {
+        return DecodeRoutine(DecoderHandle, Found - 1, Choice->Nodes + Found - 1, Context);
+    }
+
+    return TRUE;
+}
+
+DWORD
+BLGASN1CALL
+BlgpLookupChoice(
+    IN HBLG_DER_CHOICE ChoiceHandle,
+    IN CONST BLGP_DER_DECODER_NODE *Node
+    )
+
+/*++
+
+Routine Description:
+
+    Looks up the alternative carrying the identifier octets of a node.
+
+Arguments:
+
+    ChoiceHandle - Handle to the dispatcher created by BlgDerCreateChoice.
+
+    Node - Pointer to the node whose identifier octets are looked up.
+
+Return Value:
+
+    Index of the alternative plus one, or zero if the node does not carry the tag of an
+    alternative.
+
+--*/
+
+{
+    PBLGP_DER_CHOICE Choice = (PBLGP_DER_CHOICE) ChoiceHandle;
+    PBLGP_DER_CHOICE_ENTRY Entry;
+    CONST BYTE *Tag = Node->Tag;
+    DWORD Found, OctetCount, MaxOctetCount, Slot;
+    ULONGLONG Key;
+
+    Found = Choice->FirstOctet[Tag[0]];
+
+    if (Found != BLGP_CHOICE_HIGH_TAG)
+    {
+        return Found;
+    }
+
+    // The identifier octets end with the first octet whose bit 8 is zero. The length octets
+    // follow, so the scan cannot leave the node.
+    MaxOctetCount = (DWORD) (Node->Value - Tag) - 1;
+
+    if (MaxOctetCount > sizeof(((PCBLG_DER_PREPARED_TAG) NULL)->Octets))
+    {
+        MaxOctetCount = sizeof(((PCBLG_DER_PREPARED_TAG) NULL)->Octets);
+    }
+
+    for (OctetCount = 2; OctetCount <= MaxOctetCount && BLGASN1_FLAGON(Tag[OctetCount - 1], 0x80); OctetCount++);
+
+    if (OctetCount > MaxOctetCount)
+    {
+        return 0;
+    }
+
+    Key = BlgpChoiceKey(Tag, OctetCount);
+
+    for (Slot = BlgpChoiceHash(Key) & Choice->EntryMask; ; Slot = (Slot + 1) & Choice->EntryMask)
+    {
+        Entry = Choice->Entries + Slot;
+
+        if (Entry->Key == Key)
+        {
+            return Entry->Index + 1;
+        }
+
+        if (Entry->Key == 0)
+        {
+            return 0;
+        }
+    }
+}
+
+PCBLG_DER_CHILD_NODE
+BLGASN1CALL
+BlgpGetChoiceNodes(
+    IN HBLG_DER_CHOICE ChoiceHandle,
+    OUT PDWORD NodeCount
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the alternatives of a dispatcher in the order they were passed to BlgDerCreateChoice.
+
+--*/
+
+{
+    PBLGP_DER_CHOICE Choice = (PBLGP_DER_CHOICE) ChoiceHandle;
+
+    *NodeCount = Choice->NodeCount;
+
+    return Choice->Nodes;
+}
+
+static
+ULONGLONG
+BLGASN1CALL
+BlgpChoiceKey(
+    IN CONST BYTE *Octets,
+    IN DWORD OctetCount
+    )
+{
+    ULONGLONG Key = 0;
+
+    while (OctetCount-- > 0)
+    {
+        Key = (Key << 8) | Octets[OctetCount];
+    }
+
+    return Key;
+}
+
+static
+DWORD
+BLGASN1CALL
+BlgpChoiceHash(
+    IN ULONGLONG Key
+    )
+
+/*++
+
+Routine Description:
+
+    Hashes the key of a high tag number with a multiplicative hash, taking the high bits of the
+    product so that all identifier octets contribute to the slot.
+
+--*/
+
+{
+    return (DWORD) ((Key * 0x9E3779B97F4A7C15ULL) >> 32);
+}
\ No newline at end of file
@@ -11,7 +11,6 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
-static
 BOOL
 BLGASN1CALL
 BlgpMoveToNode(
@@ -182,6 +181,16 @@ Return Value:
 
         break;
 
+    case BLG_DER_DEC_PARAM_VALUE:
+        *(CONST BYTE **) Value = Decoder->CurrentNode.Value;
+
+        break;
+
+    case BLG_DER_DEC_PARAM_VALUE_CB:
+        *(PDWORD) Value = Decoder->CurrentNode.ValueCb;
+
+        break;
+
     default:
         return FALSE;
     }
@@ -11,12 +11,50 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
-typedef struct _BLGP_DER_ENCODER_NODE
-{
-    SINGLE_LIST_ENTRY Link;
-    PBYTE ValueOffset;
+static
+BOOL
+BLGASN1CALL
+BlgpPushConstructed(
+    IN PBLGP_DER_ENCODER Encoder
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpBeginConstructed(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpBeginPreparedConstructed(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEndConstructed(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpBeginConstructed,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag), (Encoder, Class, Tag));
+
+BLGP_DER_ENC_INSTANCES(BlgpBeginPreparedConstructed,
+    (PBLGP_DER_ENCODER Encoder, PCBLG_DER_PREPARED_TAG PreparedTag), (Encoder, PreparedTag));
 
-} BLGP_DER_ENCODER_NODE, *PBLGP_DER_ENCODER_NODE;
+BLGP_DER_ENC_INSTANCES(BlgpEndConstructed, (PBLGP_DER_ENCODER Encoder), (Encoder));
 
 HBLG_DER_ENCODER
 BLGASN1CALL
@@ -38,7 +76,16 @@ Arguments:
 
     BufferCb - Size, in bytes, of the buffer pointed to by the Buffer parameter.
 
-    Flags - Additional settings for the encoder to be created.
+    Flags - Additional settings for the encoder to be created. The following flags are defined:
+
+        BLG_DER_ENC_FLAG_UNCHECKED - The buffer is not checked for sufficient space before data is
+            written. The caller must ensure that the buffer is large enough for the entire
+            encoding, typically by measuring it first with an encoder created without a buffer.
+
+    If the Buffer parameter is NULL, nothing is written and the encoder only calculates the size of
+    the encoding. The mode of the encoder is selected once here. Every encoding routine has an
+    instance for each mode, compiled with the code of that mode only, and calls the instance of
+    the mode of the encoder through a table; the instances do not test the buffer or the mode.
 
 Return Value:
 
@@ -60,6 +107,19 @@ Return Value:
     Encoder->Ptr = Buffer;
     Encoder->Flags = Flags;
 
+    if (!Buffer)
+    {
+        Encoder->Mode = BLGP_DER_ENC_MODE_MEASURE;
+    }
+    else if (BLGASN1_FLAGON(Flags, BLG_DER_ENC_FLAG_UNCHECKED))
+    {
+        Encoder->Mode = BLGP_DER_ENC_MODE_UNCHECKED;
+    }
+    else
+    {
+        Encoder->Mode = BLGP_DER_ENC_MODE_CHECKED;
+    }
+
     return (HBLG_DER_ENCODER) Encoder;
 }
 
@@ -101,6 +161,11 @@ Return Value:
         HeapFree(g_Heap, 0, CONTAINING_RECORD(Link, BLGP_DER_ENCODER_NODE, Link));
     }
 
+    if (Encoder->Slots)
+    {
+        HeapFree(g_Heap, 0, Encoder->Slots);
+    }
+
     return HeapFree(g_Heap, 0, Encoder);
 }
 
@@ -196,7 +261,6 @@ Return Value:
 
 {
     PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
-    PBLGP_DER_ENCODER_NODE Node;
 
     if (!Encoder)
     {
@@ -205,66 +269,343 @@ Return Value:
         return FALSE;
     }
 
-    if (!BlgDerEncTag(EncoderHandle, Class, TRUE, Tag))
+    return BlgpBeginConstructedInstances[Encoder->Mode](Encoder, Class, Tag);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerBeginPreparedConstructed(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag
+    )
+
+/*++
+
+Routine Description:
+
+    Begins the encoding of a constructed node whose tag was prepared by BlgDerPrepareTag.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    PreparedTag - Pointer to the prepared tag of the constructed node. The tag must have been
+        prepared as constructed.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || !PreparedTag || !BLGASN1_FLAGON(PreparedTag->Octets[0], 0x20))
     {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
         return FALSE;
     }
 
-    if (!BlgDerEncLen(EncoderHandle, 0))
+    return BlgpBeginPreparedConstructedInstances[Encoder->Mode](Encoder, PreparedTag);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEndConstructed(
+    IN HBLG_DER_ENCODER EncoderHandle
+    )
+
+/*++
+
+Routine Description:
+
+    Ends the encoding of a constructed node.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder)
     {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
         return FALSE;
     }
 
-    Node = HeapAlloc(g_Heap, 0, sizeof(BLGP_DER_ENCODER_NODE));
-    if (!Node)
+    return BlgpEndConstructedInstances[Encoder->Mode](Encoder);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncoderSavepoint(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    OUT PBLG_DER_ENCODER_SAVEPOINT Savepoint
+    )
+
+/*++
+
+Routine Description:
+
+    Captures the state of an encoder, so that the data encoded afterwards can be discarded by
+    BlgDerEncoderRollback. Capturing the state does not allocate memory.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Savepoint - Pointer to a structure that receives the state of the encoder.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || !Savepoint)
     {
-        SetLastError(ERROR_OUTOFMEMORY);
+        SetLastError(ERROR_INVALID_PARAMETER);
 
         return FALSE;
     }
 
-    Node->ValueOffset = Encoder->Ptr;
-
-    BlgPushEntryList(&Encoder->Stack, &Node->Link);
+    Savepoint->EncodedCb = BLGP_DER_ENCODED_CB(Encoder);
+    Savepoint->Depth = Encoder->Depth;
+    Savepoint->Node = Encoder->Stack.Next;
+    Savepoint->SlotCount = Encoder->SlotCount;
 
     return TRUE;
 }
 
 BOOL
 BLGASN1CALL
-BlgDerEndConstructed(
-    IN HBLG_DER_ENCODER EncoderHandle
+BlgDerEncoderRollback(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN PCBLG_DER_ENCODER_SAVEPOINT Savepoint
     )
 
 /*++
 
 Routine Description:
 
-    Ends the encoding of a constructed node.
+    Restores the state of an encoder captured by BlgDerEncoderSavepoint. The data encoded after
+    the savepoint is discarded and the constructed nodes begun after it are closed without being
+    written. Template slots marked after the savepoint are discarded as well. The buffer octets
+    beyond the restored position are left unchanged.
+
+    The constructed nodes that were open at the savepoint must not have been ended, and the
+    encoder must not have been rolled back to an earlier savepoint in the meantime.
 
 Arguments:
 
     EncoderHandle - Handle to the encoder to be used.
 
+    Savepoint - Pointer to the captured state.
+
 Return Value:
 
-    TRUE if the routine succeeds; otherwise, FALSE.
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_INVALID_STATE if
+    the state cannot be restored; the encoder is not changed in that case.
 
 --*/
 
 {
     PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
-    PBLGP_DER_ENCODER_NODE Node;
     PSINGLE_LIST_ENTRY Link;
-    DWORD Len;
+    DWORD i;
 
-    if (!Encoder)
+    if (!Encoder || !Savepoint)
     {
         SetLastError(ERROR_INVALID_PARAMETER);
 
         return FALSE;
     }
 
+    if (Savepoint->EncodedCb > BLGP_DER_ENCODED_CB(Encoder) || Savepoint->Depth > Encoder->Depth ||
+        Savepoint->SlotCount > Encoder->SlotCount)
+    {
+        SetLastError(ERROR_INVALID_STATE);
+
+        return FALSE;
+    }
+
+    // Validate the stack before changing it. The node at the savepoint depth must be the one that
+    // was on top of the stack, and it must not have been begun after the savepoint.
+    for (Link = Encoder->Stack.Next, i = Encoder->Depth; i > Savepoint->Depth; i--)
+    {
+        Link = Link->Next;
+    }
+
+    if (Link != Savepoint->Node ||
+        (Link && CONTAINING_RECORD(Link, BLGP_DER_ENCODER_NODE, Link)->ValueOffset > Encoder->Buffer + Savepoint->EncodedCb))
+    {
+        SetLastError(ERROR_INVALID_STATE);
+
+        return FALSE;
+    }
+
+    while (Encoder->Depth > Savepoint->Depth)
+    {
+        Link = BlgPopEntryList(&Encoder->Stack);
+
+        HeapFree(g_Heap, 0, CONTAINING_RECORD(Link, BLGP_DER_ENCODER_NODE, Link));
+
+        Encoder->Depth--;
+    }
+
+    Encoder->Ptr = Encoder->Buffer + Savepoint->EncodedCb;
+    Encoder->SlotCount = Savepoint->SlotCount;
+
+    return TRUE;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpPushConstructed(
+    IN PBLGP_DER_ENCODER Encoder
+    )
+
+/*++
+
+Routine Description:
+
+    Pushes a constructed node whose tag and length octet have just been reserved onto the stack
+    of the encoder.
+
+Arguments:
+
+    Encoder - Pointer to the encoder to be used.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER_NODE Node;
+
+    Node = HeapAlloc(g_Heap, 0, sizeof(BLGP_DER_ENCODER_NODE));
+    if (!Node)
+    {
+        SetLastError(ERROR_OUTOFMEMORY);
+
+        return FALSE;
+    }
+
+    Node->ValueOffset = Encoder->Ptr;
+
+    BlgPushEntryList(&Encoder->Stack, &Node->Link);
+
+    Encoder->Depth++;
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpBeginConstructed(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag
+    )
+
+/*++
+
+Routine Description:
+
+    Begins the encoding of a constructed node in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    // Reserve the tag and a single length octet; the length is written when the node is ended.
+    if (!BlgpReserveNode(Mode, Encoder, Class, TRUE, Tag, 0, &Ptr))
+    {
+        return FALSE;
+    }
+
+    return BlgpPushConstructed(Encoder);
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpBeginPreparedConstructed(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag
+    )
+
+/*++
+
+Routine Description:
+
+    Begins the encoding of a constructed node with a prepared tag in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    if (!BlgpReserve(Mode, Encoder, PreparedTag->OctetCount + 1, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        CopyMemory(Ptr, PreparedTag->Octets, PreparedTag->OctetCount);
+
+        Ptr[PreparedTag->OctetCount] = 0;
+    }
+
+    return BlgpPushConstructed(Encoder);
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEndConstructed(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder
+    )
+
+/*++
+
+Routine Description:
+
+    Ends the encoding of a constructed node in the specified mode.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER_NODE Node;
+    PSINGLE_LIST_ENTRY Link;
+    PBYTE Ptr;
+    DWORD Len, i;
+
     Link = BlgPopEntryList(&Encoder->Stack);
     if (!Link)
     {
@@ -273,41 +614,39 @@ Return Value:
         return FALSE;
     }
 
+    Encoder->Depth--;
+
     Node = CONTAINING_RECORD(Link, BLGP_DER_ENCODER_NODE, Link);
 
     Len = (DWORD) (Encoder->Ptr - Node->ValueOffset);
 
     if (Len > 127)
     {
-        PBYTE Bits = (PBYTE) &Len;
-
-        DWORD OctetCount = BlgpNonZeroByteLength(Bits, sizeof(DWORD));
+        DWORD OctetCount = BlgpOctetCount32(Len);
 
-        if (Encoder->Buffer)
+        if (!BlgpReserve(Mode, Encoder, OctetCount, &Ptr))
         {
-            PBYTE LengthPtr = Node->ValueOffset - 1;
+            HeapFree(g_Heap, 0, Node);
 
-            if (BLGP_DER_ENCODED_CB(Encoder) + OctetCount > Encoder->BufferCb)
-            {
-                HeapFree(g_Heap, 0, Node);
-
-                SetLastError(ERROR_INSUFFICIENT_BUFFER);
-
-                return FALSE;
-            }
+            return FALSE;
+        }
 
+        if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+        {
             MoveMemory(Node->ValueOffset + OctetCount, Node->ValueOffset, Len);
 
-            *LengthPtr++ = (BYTE) OctetCount | 0x80;
-
-            BlgpCopyMemory(LengthPtr, Bits, OctetCount);
+            BlgpWriteLen(Node->ValueOffset - 1, Len);
         }
 
-        Encoder->Ptr += OctetCount;
+        // The template slots marked inside the node move with its content.
+        for (i = Encoder->SlotCount; i > 0 && Encoder->Slots[i - 1].Offset >= (DWORD) (Node->ValueOffset - Encoder->Buffer); i--)
+        {
+            Encoder->Slots[i - 1].Offset += OctetCount;
+        }
     }
     else
     {
-        if (Encoder->Buffer)
+        if (Mode != BLGP_DER_ENC_MODE_MEASURE)
         {
             *(Node->ValueOffset - 1) = (BYTE) Len;
         }
@@ -7,11 +7,15 @@ See License.txt in the project root for license information.
 --*/
 
 #include <windows.h>
-#include <strsafe.h>
 
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+// Seconds from 1970-01-01 00:00:00 to 0000-01-01 00:00:00 and to 9999-12-31 23:59:59, the range of
+// four-digit years.
+#define BLGP_EPOCH_MIN   (-62167219200LL)
+#define BLGP_EPOCH_MAX   253402300799LL
+
 static
 BOOL
 BLGASN1CALL
@@ -21,6 +25,112 @@ BlgpParseComponent(
     OUT PWORD Value
     );
 
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncGeneralizedTime(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN DWORD Year,
+    IN DWORD Month,
+    IN DWORD Day,
+    IN DWORD Hour,
+    IN DWORD Minute,
+    IN DWORD Second,
+    IN DWORD Nanoseconds
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncGeneralizedTime,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, DWORD Year, DWORD Month, DWORD Day, DWORD Hour,
+        DWORD Minute, DWORD Second, DWORD Nanoseconds),
+    (Encoder, Class, Tag, Year, Month, Day, Hour, Minute, Second, Nanoseconds));
+
+static
+BOOL
+BLGASN1CALL
+BlgpIsValidTime(
+    IN DWORD Year,
+    IN DWORD Month,
+    IN DWORD Day,
+    IN DWORD Hour,
+    IN DWORD Minute,
+    IN DWORD Second
+    );
+
+static
+VOID
+BLGASN1CALL
+BlgpCivilFromDays(
+    IN DWORD Days,
+    OUT PDWORD Year,
+    OUT PDWORD Month,
+    OUT PDWORD Day
+    );
+
+static
+DWORD
+BLGASN1CALL
+BlgpDaysFromCivil(
+    IN DWORD Year,
+    IN DWORD Month,
+    IN DWORD Day
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpParseTime(
+    IN CONST BYTE *Value,
+    IN BOOLEAN FourDigitYear,
+    OUT PSYSTEMTIME Time
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpDecUtcTime(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PSYSTEMTIME Value
+    );
+
+static __inline
+LONGLONG
+BLGASN1CALL
+BlgpEpochFromTime(
+    IN CONST SYSTEMTIME *Time
+    )
+{
+    return BLGP_EPOCH_MIN + (LONGLONG) BlgpDaysFromCivil(Time->wYear, Time->wMonth, Time->wDay) * 86400 +
+        Time->wHour * 3600 + Time->wMinute * 60 + Time->wSecond;
+}
+
+static __inline
+WORD
+BLGASN1CALL
+BlgpDayOfWeek(
+    IN CONST SYSTEMTIME *Time
+    )
+{
+    // 0000-01-01 was a Saturday.
+    return (WORD) ((BlgpDaysFromCivil(Time->wYear, Time->wMonth, Time->wDay) + 6) % 7);
+}
+
+// Decimal digits of 0 to 99, two characters each.
+static CONST CHAR BlgpDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
 BOOL
 BLGASN1CALL
 BlgDerEncGeneralizedTime(
@@ -55,50 +165,73 @@ Return Value:
 {
     PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
 
-    if (!Encoder || !Value)
+    if (!Encoder || !Value || !BlgpIsValidTime(Value->wYear, Value->wMonth, Value->wDay,
+            Value->wHour, Value->wMinute, Value->wSecond))
     {
         SetLastError(ERROR_INVALID_PARAMETER);
 
         return FALSE;
     }
 
-    if (GetDateFormat(LOCALE_INVARIANT, 0, Value, NULL, NULL, 0) == 0 ||
-        GetTimeFormat(LOCALE_INVARIANT, 0, Value, NULL, NULL, 0) == 0)
-    {
-        return FALSE;
-    }
+    return BlgpEncGeneralizedTimeInstances[Encoder->Mode](Encoder, Class, Tag,
+        Value->wYear, Value->wMonth, Value->wDay, Value->wHour, Value->wMinute, Value->wSecond, 0);
+}
 
-    if (!BlgDerEncTag(EncoderHandle, Class, FALSE,
-            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_GENERALIZED_TIME : Tag))
-    {
-        return FALSE;
-    }
+BOOL
+BLGASN1CALL
+BlgDerEncGeneralizedTimeEpoch(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN LONGLONG Seconds,
+    IN DWORD Nanoseconds
+    )
 
-    if (!BlgDerEncLen(EncoderHandle, 15))
-    {
-        return FALSE;
-    }
+/*++
 
-    if (Encoder->Buffer != NULL)
-    {
-        CHAR Buffer[16];
+Routine Description:
 
-        if (BLGP_DER_ENCODED_CB(Encoder) + 15 > Encoder->BufferCb)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+    Encodes an ASN.1 GeneralizedTime value from a Unix time. A fraction is appended to the
+    seconds only if it is not zero, without trailing zeros.
 
-            return FALSE;
-        }
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Seconds - Number of seconds elapsed since 1970-01-01 00:00:00 UTC, not counting leap seconds.
+        The value must fall between the years 0000 and 9999.
+
+    Nanoseconds - Fraction of the second, in nanoseconds, or zero.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
 
-        StringCchPrintfA(Buffer, 16, "%d%02d%02d%02d%02d%02dZ",
-            Value->wYear, Value->wMonth, Value->wDay, Value->wHour, Value->wMinute, Value->wSecond);
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+    DWORD Days, SecondOfDay, Year, Month, Day;
+
+    if (!Encoder || Seconds < BLGP_EPOCH_MIN || Seconds > BLGP_EPOCH_MAX || Nanoseconds > 999999999)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
 
-        CopyMemory(Encoder->Ptr, Buffer, 15);
+        return FALSE;
     }
 
-    Encoder->Ptr += 15;
+    // Count from 0000-01-01, so that the division does not have to deal with negative values.
+    Days = (DWORD) ((Seconds - BLGP_EPOCH_MIN) / 86400);
+    SecondOfDay = (DWORD) ((Seconds - BLGP_EPOCH_MIN) % 86400);
 
-    return TRUE;
+    BlgpCivilFromDays(Days, &Year, &Month, &Day);
+
+    return BlgpEncGeneralizedTimeInstances[Encoder->Mode](Encoder, Class, Tag,
+        Year, Month, Day, SecondOfDay / 3600, SecondOfDay / 60 % 60, SecondOfDay % 60, Nanoseconds);
 }
 
 BOOL
@@ -152,6 +285,18 @@ Return Value:
         return FALSE;
     }
 
+    // Most values have the canonical form YYYYMMDDHHMMSSZ, which is parsed in one step. Any other
+    // form, or a year that SYSTEMTIME cannot hold, is left to the general parser.
+    if (End - Ptr == 15 && Ptr[14] == 'Z' &&
+        BlgpParseTime((CONST BYTE *) Ptr, TRUE, Value) && Value->wYear >= 1601)
+    {
+        Value->wDayOfWeek = BlgpDayOfWeek(Value);
+
+        return TRUE;
+    }
+
+    ZeroMemory(Value, sizeof(SYSTEMTIME));
+
     if (End - Ptr < 10 || End - Ptr > 24)
     {
         SetLastError(ERROR_BLGASN1_CORRUPT);
@@ -244,6 +389,12 @@ Return Value:
         {
             BlgpParseComponent(&Ptr, Cch > 3 ? 3 : Cch, &SysTime.wMilliseconds);
 
+            // Fractions with fewer than three digits are scaled to milliseconds.
+            if (Cch < 3)
+            {
+                SysTime.wMilliseconds *= Cch == 1 ? 100 : 10;
+            }
+
             // According to the DER specification a non-zero fraction must be specified if a
             // decimal dot exists.
             if (SysTime.wMilliseconds == 0 && !BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED))
@@ -420,6 +571,251 @@ DoneParsing:
     return TRUE;
 }
 
+BOOL
+BLGASN1CALL
+BlgDerDecGeneralizedTimeEpoch(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PLONGLONG Seconds,
+    OUT PDWORD Nanoseconds OPTIONAL
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 GeneralizedTime value as a Unix time. The DER forms, with or without a
+    fraction of a second, are parsed directly; other forms accepted by BlgDerDecGeneralizedTime
+    are converted from its result.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Seconds - Pointer to a variable that receives the number of seconds elapsed since
+        1970-01-01 00:00:00 UTC, not counting leap seconds.
+
+    Nanoseconds - Optional pointer to a variable that receives the fraction of the second, in
+        nanoseconds. Digits beyond the ninth are ignored.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    CONST BYTE *Ptr, *End;
+    SYSTEMTIME Time;
+    DWORD Fraction = 0, Scale = 1000000000;
+
+    if (!Seconds)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    *Seconds = 0;
+
+    if (Nanoseconds)
+    {
+        *Nanoseconds = 0;
+    }
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    Ptr = Decoder->CurrentNode.Value;
+    End = Ptr + Decoder->CurrentNode.ValueCb;
+
+    if (End - Ptr >= 15 && End[-1] == 'Z' && (End - Ptr == 15 || (End - Ptr > 16 && Ptr[14] == '.')) &&
+        BlgpParseTime(Ptr, TRUE, &Time))
+    {
+        if (End - Ptr > 15)
+        {
+            // According to the DER specification the fraction must not end with a zero.
+            if (End[-2] == '0' && !BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED))
+            {
+                SetLastError(ERROR_BLGASN1_CORRUPT);
+
+                return FALSE;
+            }
+
+            for (Ptr += 15; Ptr < End - 1; Ptr++)
+            {
+                if (*Ptr < '0' || *Ptr > '9')
+                {
+                    SetLastError(ERROR_BLGASN1_CORRUPT);
+
+                    return FALSE;
+                }
+
+                if (Scale > 1)
+                {
+                    Scale /= 10;
+                    Fraction += (*Ptr - '0') * Scale;
+                }
+            }
+        }
+    }
+    else
+    {
+        if (!BlgDerDecGeneralizedTime(DecoderHandle, &Time))
+        {
+            return FALSE;
+        }
+
+        // SYSTEMTIME holds milliseconds only, so the fraction is read again from the content,
+        // which has been validated above. The fraction may follow the hour or the minute and
+        // may start with a comma.
+        for (Ptr += 10; Ptr < End && *Ptr != '.' && *Ptr != ','; Ptr++);
+
+        if (Ptr < End)
+        {
+            for (Ptr++; Ptr < End && *Ptr >= '0' && *Ptr <= '9'; Ptr++)
+            {
+                if (Scale > 1)
+                {
+                    Scale /= 10;
+                    Fraction += (*Ptr - '0') * Scale;
+                }
+            }
+        }
+    }
+
+    *Seconds = BlgpEpochFromTime(&Time);
+
+    if (Nanoseconds)
+    {
+        *Nanoseconds = Fraction;
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecUtcTime(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PSYSTEMTIME Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 UTCTime value. Only the DER form YYMMDDHHMMSSZ is accepted. Two-digit years
+    from 50 to 99 are taken as 1950 to 1999 and the others as 2000 to 2049, as RFC 5280 specifies.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a SYSTEMTIME structure that receives the decoded date and time value.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    if (!Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    if (!BlgpDecUtcTime(DecoderHandle, Value))
+    {
+        ZeroMemory(Value, sizeof(SYSTEMTIME));
+
+        return FALSE;
+    }
+
+    Value->wDayOfWeek = BlgpDayOfWeek(Value);
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecUtcTimeEpoch(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PLONGLONG Seconds
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 UTCTime value as a Unix time. The value must have the form accepted by
+    BlgDerDecUtcTime.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Seconds - Pointer to a variable that receives the number of seconds elapsed since
+        1970-01-01 00:00:00 UTC, not counting leap seconds.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    SYSTEMTIME Time;
+
+    if (!Seconds)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    *Seconds = 0;
+
+    if (!BlgpDecUtcTime(DecoderHandle, &Time))
+    {
+        return FALSE;
+    }
+
+    *Seconds = BlgpEpochFromTime(&Time);
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpDecUtcTime(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PSYSTEMTIME Value
+    )
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    if (Decoder->CurrentNode.ValueCb != 13 || Decoder->CurrentNode.Value[12] != 'Z' ||
+        !BlgpParseTime(Decoder->CurrentNode.Value, FALSE, Value))
+    {
+        SetLastError(ERROR_BLGASN1_CORRUPT);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 static
 BOOL
 BLGASN1CALL
@@ -486,4 +882,268 @@ Return Value:
     }
 
     return TRUE;
+}
+
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncGeneralizedTime(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN DWORD Year,
+    IN DWORD Month,
+    IN DWORD Day,
+    IN DWORD Hour,
+    IN DWORD Minute,
+    IN DWORD Second,
+    IN DWORD Nanoseconds
+    )
+
+/*++
+
+Routine Description:
+
+    Writes a validated date and time in the DER form of GeneralizedTime in the specified mode. The
+    digits are written in pairs straight into the encoder.
+
+--*/
+
+{
+    PBYTE Ptr;
+    DWORD FractionCch = 0;
+    DWORD i;
+
+    // DER forbids trailing zeros in the fraction, and the decimal point if the fraction is zero.
+    if (Nanoseconds != 0)
+    {
+        for (FractionCch = 9; Nanoseconds % 10 == 0; FractionCch--)
+        {
+            Nanoseconds /= 10;
+        }
+    }
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE,
+            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_GENERALIZED_TIME : Tag,
+            FractionCch != 0 ? 16 + FractionCch : 15, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        CopyMemory(Ptr, BlgpDigitPairs + Year / 100 * 2, 2);
+        CopyMemory(Ptr + 2, BlgpDigitPairs + Year % 100 * 2, 2);
+        CopyMemory(Ptr + 4, BlgpDigitPairs + Month * 2, 2);
+        CopyMemory(Ptr + 6, BlgpDigitPairs + Day * 2, 2);
+        CopyMemory(Ptr + 8, BlgpDigitPairs + Hour * 2, 2);
+        CopyMemory(Ptr + 10, BlgpDigitPairs + Minute * 2, 2);
+        CopyMemory(Ptr + 12, BlgpDigitPairs + Second * 2, 2);
+        Ptr += 14;
+
+        if (FractionCch != 0)
+        {
+            *Ptr++ = '.';
+
+            for (i = FractionCch; i > 0; i--)
+            {
+                Ptr[i - 1] = (BYTE) ('0' + Nanoseconds % 10);
+                Nanoseconds /= 10;
+            }
+
+            Ptr += FractionCch;
+        }
+
+        *Ptr = 'Z';
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpIsValidTime(
+    IN DWORD Year,
+    IN DWORD Month,
+    IN DWORD Day,
+    IN DWORD Hour,
+    IN DWORD Minute,
+    IN DWORD Second
+    )
+
+/*++
+
+Routine Description:
+
+    Checks whether the specified date and time exist and the year has four digits.
+
+--*/
+
+{
+    static CONST BYTE DaysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    if (Year > 9999 || Month < 1 || Month > 12 || Day < 1 || Hour > 23 || Minute > 59 || Second > 59)
+    {
+        return FALSE;
+    }
+
+    if (Month == 2 && Day == 29)
+    {
+        return Year % 4 == 0 && (Year % 100 != 0 || Year % 400 == 0);
+    }
+
+    return Day <= DaysInMonth[Month - 1];
+}
+
+VOID
+BLGASN1CALL
+BlgpCivilFromDays(
+    IN DWORD Days,
+    OUT PDWORD Year,
+    OUT PDWORD Month,
+    OUT PDWORD Day
+    )
+
+/*++
+
+Routine Description:
+
+    Converts a number of days elapsed since 0000-01-01 to a date of the proleptic Gregorian
+    calendar. The calculation counts years from March, so that the leap day falls at the end of
+    the year, and splits the days into 400-year eras of 146097 days.
+
+--*/
+
+{
+    DWORD Era, DayOfEra, YearOfEra, DayOfYear, ShiftedMonth;
+
+    // Shift the origin to -0400-03-01, one era before 0000-03-01, so that it precedes every day.
+    Days += 146097 - 60;
+
+    Era = Days / 146097;
+    DayOfEra = Days % 146097;
+    YearOfEra = (DayOfEra - DayOfEra / 1460 + DayOfEra / 36524 - DayOfEra / 146096) / 365;
+    DayOfYear = DayOfEra - (365 * YearOfEra + YearOfEra / 4 - YearOfEra / 100);
+    ShiftedMonth = (5 * DayOfYear + 2) / 153;
+
+    *Day = DayOfYear - (153 * ShiftedMonth + 2) / 5 + 1;
+    *Month = ShiftedMonth < 10 ? ShiftedMonth + 3 : ShiftedMonth - 9;
+    *Year = Era * 400 + YearOfEra + (*Month <= 2 ? 1 : 0) - 400;
+}
+
+DWORD
+BLGASN1CALL
+BlgpDaysFromCivil(
+    IN DWORD Year,
+    IN DWORD Month,
+    IN DWORD Day
+    )
+
+/*++
+
+Routine Description:
+
+    Converts a date of the proleptic Gregorian calendar to the number of days elapsed since
+    0000-01-01. This is the inverse of BlgpCivilFromDays and uses the same March-based eras.
+
+--*/
+
+{
+    DWORD Era, YearOfEra, DayOfYear, DayOfEra;
+
+    // Count the years from -0400, so that January and February of 0000 do not need a negative year.
+    Year += 400 - (Month <= 2 ? 1 : 0);
+
+    Era = Year / 400;
+    YearOfEra = Year % 400;
+    DayOfYear = (153 * (Month > 2 ? Month - 3 : Month + 9) + 2) / 5 + Day - 1;
+    DayOfEra = YearOfEra * 365 + YearOfEra / 4 - YearOfEra / 100 + DayOfYear;
+
+    return Era * 146097 + DayOfEra - 146097 + 60;
+}
+
+BOOL
+BLGASN1CALL
+BlgpParseTime(
+    IN CONST BYTE *Value,
+    IN BOOLEAN FourDigitYear,
+    OUT PSYSTEMTIME Time
+    )
+
+/*++
+
+Routine Description:
+
+    Parses the digits of a time in the form YYYYMMDDHHMMSS or YYMMDDHHMMSS and validates the
+    date and time. Only the fields from the year to the second are set.
+
+    The twelve digits after the century are read as two overlapping 8-octet words. Each word is
+    checked to hold only digits, and its neighbouring digits are combined into two-digit values,
+    with a few integer operations.
+
+Return Value:
+
+    TRUE if the digits form a valid date and time; otherwise, FALSE.
+
+--*/
+
+{
+    ULONGLONG Words[2], Word;
+    DWORD Century = 0, Year, i;
+
+    if (FourDigitYear)
+    {
+        if (Value[0] < '0' || Value[0] > '9' || Value[1] < '0' || Value[1] > '9')
+        {
+            return FALSE;
+        }
+
+        Century = (Value[0] - '0') * 10 + (Value[1] - '0');
+        Value += 2;
+    }
+
+    for (i = 0; i < 2; i++)
+    {
+        Word = *(CONST ULONGLONG UNALIGNED *) (Value + i * 4);
+
+#if !BLGP_LITTLE_ENDIAN
+        Word = BlgpByteSwap64(Word);
+#endif
+
+        // An octet is a digit if its high nibble is 3 and adding 6 to its low nibble does not
+        // carry into the high nibble.
+        if ((Word & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL ||
+            (((Word & 0x0F0F0F0F0F0F0F0FULL) + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) != 0)
+        {
+            return FALSE;
+        }
+
+        // The first digit of each pair is in the lower octet. Each 16-bit lane receives the value
+        // of its pair.
+        Word &= 0x0F0F0F0F0F0F0F0FULL;
+        Words[i] = (Word & 0x00FF00FF00FF00FFULL) * 10 + ((Word >> 8) & 0x00FF00FF00FF00FFULL);
+    }
+
+    Year = (DWORD) (Words[0] & 0xFF);
+
+    if (FourDigitYear)
+    {
+        Year += Century * 100;
+    }
+    else
+    {
+        Year += Year < 50 ? 2000 : 1900;
+    }
+
+    Time->wYear = (WORD) Year;
+    Time->wMonth = (WORD) ((Words[0] >> 16) & 0xFF);
+    Time->wDay = (WORD) ((Words[0] >> 32) & 0xFF);
+    Time->wHour = (WORD) ((Words[0] >> 48) & 0xFF);
+    Time->wMinute = (WORD) ((Words[1] >> 32) & 0xFF);
+    Time->wSecond = (WORD) ((Words[1] >> 48) & 0xFF);
+    Time->wMilliseconds = 0;
+    Time->wDayOfWeek = 0;
+
+    return BlgpIsValidTime(Time->wYear, Time->wMonth, Time->wDay, Time->wHour, Time->wMinute, Time->wSecond);
 }
\ No newline at end of file
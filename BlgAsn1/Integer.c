@@ -11,16 +11,87 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+static
+BOOL
+BLGASN1CALL
+BlgpEncodeIntBytes(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOL Positive,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN BOOL LittleEndian
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpDecodeIntBytes(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Positive OPTIONAL,
+    OUT PBYTE Buffer OPTIONAL,
+    IN OUT PDWORD BufferCb,
+    IN BOOL LittleEndian
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpEncodeInteger(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN ULONGLONG Value,
+    IN DWORD OctetCount
+    );
+
 static
 BOOL
 BLGASN1CALL
 BlgpDecodeInteger(
     IN  HBLG_DER_DECODER DecoderHandle,
     IN  BOOL Signed,
-    OUT PBYTE Buffer,
-    IN  DWORD BufferCb
+    OUT PULONGLONG Value
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncIntBytes(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOL Positive,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN BOOL LittleEndian
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncInteger(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN ULONGLONG Value,
+    IN DWORD OctetCount
     );
 
+BLGP_DER_ENC_INSTANCES(BlgpEncIntBytes,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, BOOL Positive, CONST BYTE *Value, DWORD ValueCb,
+     BOOL LittleEndian),
+    (Encoder, Class, Tag, Positive, Value, ValueCb, LittleEndian));
+
+BLGP_DER_ENC_INSTANCES(BlgpEncInteger,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, ULONGLONG Value, DWORD OctetCount),
+    (Encoder, Class, Tag, Value, OctetCount));
+
 BOOL
 BLGASN1CALL
 BlgDerEncInt(
@@ -59,122 +130,82 @@ Return Value:
 --*/
 
 {
-    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
-    DWORD Shift = 0;
-    DWORD OctetCount;
+    return BlgpEncodeIntBytes(EncoderHandle, Class, Tag, Positive, Value, ValueCb, BLGP_LITTLE_ENDIAN);
+}
 
-    if (!Encoder || !Value)
-    {
-        SetLastError(ERROR_INVALID_PARAMETER);
+BOOL
+BLGASN1CALL
+BlgDerEncIntBigEndian(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOL Positive,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb
+    )
 
-        return FALSE;
-    }
+/*++
 
-    if (Positive)
-    {
-        OctetCount = BlgpNonZeroByteLength(Value, ValueCb);
+Routine Description:
 
-        // If the value is positive and the most significant bit is one, an empty octet must be
-        // appended to the beginning of the encoded value.
-        if (BlgpIsLittleEndian())
-        {
-            if ((CHAR) Value[OctetCount - 1] < 0)
-            {
-                OctetCount++; Shift++;
-            }
-        }
-        else
-        {
-            if ((CHAR) Value[0] < 0)
-            {
-                OctetCount++; Shift++;
-            }
-        }
-    }
-    else
-    {
-        // If the value is negative, discard the leading bytes with the value 0xFF. They have no
-        // significance for the decoding process.
-        if (BlgpIsLittleEndian())
-        {
-            for (OctetCount = ValueCb; OctetCount > 1; OctetCount--)
-            {
-                if (Value[OctetCount - 1] != 0xFF)
-                {
-                    break;
-                }
-            }
-        }
-        else
-        {
-            for (OctetCount = ValueCb; OctetCount > 1; OctetCount--)
-            {
-                if (Value[ValueCb - OctetCount] != 0xFF)
-                {
-                    break;
-                }
-            }
-        }
-    }
+    Encodes an ASN.1 INTEGER value stored in network byte order. The content octets are copied
+    as they are, apart from the leading octets that have no significance.
 
-    if (!BlgDerEncTag(EncoderHandle, Class, FALSE,
-            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_INTEGER : Tag))
-    {
-        return FALSE;
-    }
+Arguments:
 
-    if (!BlgDerEncLen(EncoderHandle, OctetCount))
-    {
-        return FALSE;
-    }
+    EncoderHandle - Handle to the encoder to be used.
 
-    if (Encoder->Buffer != NULL)
-    {
-        if (BLGP_DER_ENCODED_CB(Encoder) + OctetCount > Encoder->BufferCb)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+    Class - Class of the node.
 
-            return FALSE;
-        }
+    Tag - Tag of the node.
 
-        if (Shift > 0)
-        {
-            *Encoder->Ptr = 0;
-        }
+    Positive - Boolean value indicating whether the value is positive.
 
-        BlgpCopyMemory(Encoder->Ptr + Shift, Value, OctetCount - Shift);
-    }
+    Value - Pointer to a buffer containing the big-endian integer to be encoded.
 
-    Encoder->Ptr += OctetCount;
+    ValueCb - Size, in bytes, of the value pointed to by the Value parameter.
 
-    return TRUE;
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    return BlgpEncodeIntBytes(EncoderHandle, Class, Tag, Positive, Value, ValueCb, FALSE);
 }
 
 BOOL
 BLGASN1CALL
-BlgDerDecInt(
-    IN HBLG_DER_DECODER DecoderHandle,
-    OUT PBOOL Positive OPTIONAL,
-    OUT PBYTE Buffer OPTIONAL,
-    IN OUT PDWORD BufferCb
+BlgDerEncIntLimbs(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOL Positive,
+    IN CONST ULONGLONG *Limbs,
+    IN DWORD LimbCount
     )
 
 /*++
 
 Routine Description:
 
-    Decodes an ASN.1 INTEGER value.
+    Encodes an ASN.1 INTEGER value stored as an array of 64 bit limbs.
 
 Arguments:
 
-    DecoderHandle - Handle to the decoder to be used.
+    EncoderHandle - Handle to the encoder to be used.
 
-    Positive - Pointer to a variable that receives whether the integer is positive.
+    Class - Class of the node.
 
-    Buffer - Pointer to a buffer that receives the decoded integer.
+    Tag - Tag of the node.
 
-    BufferCb - Pointer to a variable specifying the size of the buffer, in bytes. When the
-        routine returns, the variable contains the number of bytes stored in the buffer.
+    Positive - Boolean value indicating whether the value is positive. Negative values are
+        stored in two's complement form.
+
+    Limbs - Pointer to an array of native-endian limbs, the least significant limb first.
+
+    LimbCount - Number of limbs in the array pointed to by the Limbs parameter.
 
 Return Value:
 
@@ -183,82 +214,75 @@ Return Value:
 --*/
 
 {
-    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
-    DWORD ValueCb, LocalBufferCb;
-    CONST BYTE *Value;
-
-    if (Positive)
-    {
-        *Positive = FALSE;
-    }
-
-    if (!BufferCb)
+#if BLGP_LITTLE_ENDIAN
+    if (LimbCount > MAXDWORD / sizeof(ULONGLONG))
     {
         SetLastError(ERROR_INVALID_PARAMETER);
 
         return FALSE;
     }
-    else
-    {
-        LocalBufferCb = *BufferCb; *BufferCb = 0;
-    }
 
-    if (!BlgpValidateState(Decoder))
+    // On a little-endian machine the limb array is already a little-endian integer.
+    return BlgpEncodeIntBytes(EncoderHandle, Class, Tag, Positive,
+        (CONST BYTE *) Limbs, LimbCount * sizeof(ULONGLONG), TRUE);
+#else
+    PULONGLONG Swapped;
+    DWORD i;
+    BOOL IsOk;
+
+    if (!Limbs || LimbCount > MAXDWORD / sizeof(ULONGLONG))
     {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
         return FALSE;
     }
 
-    Value = Decoder->CurrentNode.Value;
-    ValueCb = Decoder->CurrentNode.ValueCb;
-
-    if ((CHAR) *Value >= 0)
+    Swapped = HeapAlloc(g_Heap, 0, LimbCount * sizeof(ULONGLONG));
+    if (!Swapped)
     {
-        if (Positive)
-        {
-            *Positive = TRUE;
-        }
+        SetLastError(ERROR_OUTOFMEMORY);
 
-        if (*Value == 0)
-        {
-            Value++; ValueCb--;
-        }
+        return FALSE;
     }
 
-    *BufferCb = ValueCb;
-
-    if (Buffer)
+    for (i = 0; i < LimbCount; i++)
     {
-        if (ValueCb > LocalBufferCb)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+        Swapped[i] = BlgpByteSwap64(Limbs[i]);
+    }
 
-            return FALSE;
-        }
+    IsOk = BlgpEncodeIntBytes(EncoderHandle, Class, Tag, Positive,
+        (CONST BYTE *) Swapped, LimbCount * sizeof(ULONGLONG), TRUE);
 
-        BlgpCopyMemory(Buffer, Value, ValueCb);
-    }
+    HeapFree(g_Heap, 0, Swapped);
 
-    return TRUE;
+    return IsOk;
+#endif
 }
 
 BOOL
 BLGASN1CALL
-BlgDerDecInt16(
-    IN HBLG_DER_DECODER DecoderHandle,
-    OUT PSHORT Value
+BlgDerEncInt64(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN LONGLONG Value
     )
 
 /*++
 
 Routine Description:
 
-    Decodes an 16 bit signed ASN.1 INTEGER value.
+    Encodes a 64 bit signed ASN.1 INTEGER value.
 
 Arguments:
 
-    DecoderHandle - Handle to the decoder to be used.
+    EncoderHandle - Handle to the encoder to be used.
 
-    Value - Pointer to a variable that receives the decoded integer.
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Value - Integer to be encoded.
 
 Return Value:
 
@@ -267,27 +291,33 @@ Return Value:
 --*/
 
 {
-    return BlgpDecodeInteger(DecoderHandle, TRUE, (PBYTE) Value, sizeof(SHORT));
+    return BlgpEncodeInteger(EncoderHandle, Class, Tag, (ULONGLONG) Value, BlgpIntOctetCount64(Value));
 }
 
 BOOL
 BLGASN1CALL
-BlgDerDecInt32(
-    IN HBLG_DER_DECODER DecoderHandle,
-    OUT PINT Value
+BlgDerEncUInt64(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN ULONGLONG Value
     )
 
 /*++
 
 Routine Description:
 
-    Decodes an 32 bit signed ASN.1 INTEGER value.
+    Encodes a 64 bit unsigned ASN.1 INTEGER value.
 
 Arguments:
 
-    DecoderHandle - Handle to the decoder to be used.
+    EncoderHandle - Handle to the encoder to be used.
 
-    Value - Pointer to a variable that receives the decoded integer.
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Value - Integer to be encoded.
 
 Return Value:
 
@@ -296,27 +326,34 @@ Return Value:
 --*/
 
 {
-    return BlgpDecodeInteger(DecoderHandle, TRUE, (PBYTE) Value, sizeof(INT));
+    return BlgpEncodeInteger(EncoderHandle, Class, Tag, Value, BlgpUIntOctetCount64(Value));
 }
 
 BOOL
 BLGASN1CALL
-BlgDerDecUInt16(
+BlgDerDecInt(
     IN HBLG_DER_DECODER DecoderHandle,
-    OUT PWORD Value
+    OUT PBOOL Positive OPTIONAL,
+    OUT PBYTE Buffer OPTIONAL,
+    IN OUT PDWORD BufferCb
     )
 
 /*++
 
 Routine Description:
 
-    Decodes an 16 bit unsigned ASN.1 INTEGER value.
+    Decodes an ASN.1 INTEGER value.
 
 Arguments:
 
     DecoderHandle - Handle to the decoder to be used.
 
-    Value - Pointer to a variable that receives the decoded integer.
+    Positive - Pointer to a variable that receives whether the integer is positive.
+
+    Buffer - Pointer to a buffer that receives the decoded integer.
+
+    BufferCb - Pointer to a variable specifying the size of the buffer, in bytes. When the
+        routine returns, the variable contains the number of bytes stored in the buffer.
 
 Return Value:
 
@@ -325,27 +362,35 @@ Return Value:
 --*/
 
 {
-    return BlgpDecodeInteger(DecoderHandle, FALSE, (PBYTE) Value, sizeof(WORD));
+    return BlgpDecodeIntBytes(DecoderHandle, Positive, Buffer, BufferCb, BLGP_LITTLE_ENDIAN);
 }
 
 BOOL
 BLGASN1CALL
-BlgDerDecUInt32(
+BlgDerDecIntBigEndian(
     IN HBLG_DER_DECODER DecoderHandle,
-    OUT PDWORD Value
+    OUT PBOOL Positive OPTIONAL,
+    OUT PBYTE Buffer OPTIONAL,
+    IN OUT PDWORD BufferCb
     )
 
 /*++
 
 Routine Description:
 
-    Decodes an 32 bit unsigned ASN.1 INTEGER value.
+    Decodes an ASN.1 INTEGER value in network byte order. The content octets are copied as
+    they are.
 
 Arguments:
 
     DecoderHandle - Handle to the decoder to be used.
 
-    Value - Pointer to a variable that receives the decoded integer.
+    Positive - Pointer to a variable that receives whether the integer is positive.
+
+    Buffer - Pointer to a buffer that receives the decoded big-endian integer.
+
+    BufferCb - Pointer to a variable specifying the size of the buffer, in bytes. When the
+        routine returns, the variable contains the number of bytes stored in the buffer.
 
 Return Value:
 
@@ -354,109 +399,863 @@ Return Value:
 --*/
 
 {
-    return BlgpDecodeInteger(DecoderHandle, FALSE, (PBYTE) Value, sizeof(DWORD));
+    return BlgpDecodeIntBytes(DecoderHandle, Positive, Buffer, BufferCb, FALSE);
 }
 
-static
 BOOL
 BLGASN1CALL
-BlgpDecodeInteger(
+BlgDerDecIntLimbs(
     IN HBLG_DER_DECODER DecoderHandle,
-    IN BOOL Signed,
-    OUT PBYTE Buffer,
-    IN DWORD BufferCb
+    OUT PBOOL Positive OPTIONAL,
+    OUT PULONGLONG Limbs OPTIONAL,
+    IN OUT PDWORD LimbCount
     )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 INTEGER value into an array of 64 bit limbs.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Positive - Pointer to a variable that receives whether the integer is positive.
+
+    Limbs - Pointer to an array that receives the native-endian limbs, the least significant
+        limb first. Negative values are sign-extended to the most significant limb.
+
+    LimbCount - Pointer to a variable specifying the number of limbs in the array. When the
+        routine returns, the variable contains the number of limbs stored in the array.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
 {
-    DWORD ValueCb = BufferCb;
-    BOOL Positive;
+    DWORD LocalLimbCount, ValueCb;
+    BOOL IsPositive;
 
-    if (!Buffer)
+    if (!LimbCount)
     {
         SetLastError(ERROR_INVALID_PARAMETER);
 
         return FALSE;
     }
+    else
+    {
+        LocalLimbCount = *LimbCount; *LimbCount = 0;
+    }
+
+    if (Positive)
+    {
+        *Positive = FALSE;
+    }
+
+    ValueCb = LocalLimbCount > MAXDWORD / sizeof(ULONGLONG) ?
+        MAXDWORD / sizeof(ULONGLONG) * sizeof(ULONGLONG) : LocalLimbCount * sizeof(ULONGLONG);
+
+    if (!BlgpDecodeIntBytes(DecoderHandle, &IsPositive, (PBYTE) Limbs, &ValueCb, TRUE))
+    {
+        if (GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+        {
+            *LimbCount = (ValueCb + sizeof(ULONGLONG) - 1) / sizeof(ULONGLONG);
+        }
+
+        return FALSE;
+    }
+
+    // A zero value may be encoded without any significant octet; it still takes one limb.
+    *LimbCount = ValueCb == 0 ? 1 : (ValueCb + sizeof(ULONGLONG) - 1) / sizeof(ULONGLONG);
+
+    if (Limbs)
+    {
+        if (*LimbCount > LocalLimbCount)
+        {
+            *LimbCount = 1;
+
+            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+            return FALSE;
+        }
+
+        // Extend the most significant limb with the sign.
+        FillMemory((PBYTE) Limbs + ValueCb, *LimbCount * sizeof(ULONGLONG) - ValueCb, IsPositive ? 0x00 : 0xFF);
+
+#if !BLGP_LITTLE_ENDIAN
+        {
+            DWORD i;
+
+            for (i = 0; i < *LimbCount; i++)
+            {
+                Limbs[i] = BlgpByteSwap64(Limbs[i]);
+            }
+        }
+#endif
+    }
+
+    if (Positive)
+    {
+        *Positive = IsPositive;
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecInt16(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PSHORT Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an 16 bit signed ASN.1 INTEGER value.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a variable that receives the decoded integer.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    LONGLONG Decoded;
+
+    if (!Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        *Value = 0;
+    }
+
+    if (!BlgpDecodeInteger(DecoderHandle, TRUE, (PULONGLONG) &Decoded))
+    {
+        return FALSE;
+    }
+
+    if (Decoded < MINSHORT || Decoded > MAXSHORT)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return FALSE;
+    }
+
+    *Value = (SHORT) Decoded;
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecInt32(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PINT Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an 32 bit signed ASN.1 INTEGER value.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a variable that receives the decoded integer.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    LONGLONG Decoded;
+
+    if (!Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        *Value = 0;
+    }
+
+    if (!BlgpDecodeInteger(DecoderHandle, TRUE, (PULONGLONG) &Decoded))
+    {
+        return FALSE;
+    }
+
+    if (Decoded < MININT || Decoded > MAXINT)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return FALSE;
+    }
+
+    *Value = (INT) Decoded;
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecInt64(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PLONGLONG Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes a 64 bit signed ASN.1 INTEGER value.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a variable that receives the decoded integer.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    if (!Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpDecodeInteger(DecoderHandle, TRUE, (PULONGLONG) Value);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecUInt16(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWORD Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an 16 bit unsigned ASN.1 INTEGER value.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a variable that receives the decoded integer.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    ULONGLONG Decoded;
+
+    if (!Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        *Value = 0;
+    }
+
+    if (!BlgpDecodeInteger(DecoderHandle, FALSE, &Decoded))
+    {
+        return FALSE;
+    }
+
+    if (Decoded > MAXWORD)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return FALSE;
+    }
+
+    *Value = (WORD) Decoded;
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecUInt32(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PDWORD Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an 32 bit unsigned ASN.1 INTEGER value.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a variable that receives the decoded integer.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    ULONGLONG Decoded;
+
+    if (!Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        *Value = 0;
+    }
+
+    if (!BlgpDecodeInteger(DecoderHandle, FALSE, &Decoded))
+    {
+        return FALSE;
+    }
+
+    if (Decoded > MAXDWORD)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return FALSE;
+    }
+
+    *Value = (DWORD) Decoded;
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecUInt64(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PULONGLONG Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes a 64 bit unsigned ASN.1 INTEGER value.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a variable that receives the decoded integer.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    if (!Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpDecodeInteger(DecoderHandle, FALSE, Value);
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpEncodeIntBytes(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOL Positive,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN BOOL LittleEndian
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 INTEGER value of arbitrary size.
+
+Arguments:
+
+    LittleEndian - Boolean value indicating whether the value is stored in little-endian or in
+        big-endian byte order.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || !Value || ValueCb == 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncIntBytesInstances[Encoder->Mode](Encoder, Class, Tag, Positive, Value, ValueCb,
+        LittleEndian);
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpDecodeIntBytes(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOL Positive OPTIONAL,
+    OUT PBYTE Buffer OPTIONAL,
+    IN OUT PDWORD BufferCb,
+    IN BOOL LittleEndian
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 INTEGER value of arbitrary size.
+
+Arguments:
+
+    LittleEndian - Boolean value indicating whether the value is stored in little-endian or in
+        big-endian byte order.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    DWORD ValueCb, LocalBufferCb;
+    CONST BYTE *Value;
+
+    if (Positive)
+    {
+        *Positive = FALSE;
+    }
+
+    if (!BufferCb)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
 
-    ZeroMemory(Buffer, BufferCb);
+        return FALSE;
+    }
+    else
+    {
+        LocalBufferCb = *BufferCb; *BufferCb = 0;
+    }
 
-    if (!BlgDerDecInt(DecoderHandle, &Positive, Buffer, &ValueCb))
+    if (!BlgpValidateState(Decoder))
     {
-        if (GetLastError() == ERROR_INSUFFICIENT_BUFFER)
+        return FALSE;
+    }
+
+    Value = Decoder->CurrentNode.Value;
+    ValueCb = Decoder->CurrentNode.ValueCb;
+
+    if (ValueCb == 0)
+    {
+        SetLastError(ERROR_BLGASN1_CORRUPT);
+
+        return FALSE;
+    }
+
+    if ((CHAR) *Value >= 0)
+    {
+        if (Positive)
         {
-            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+            *Positive = TRUE;
         }
 
-        return FALSE;
+        if (*Value == 0)
+        {
+            Value++; ValueCb--;
+        }
     }
 
-    if (BufferCb > ValueCb)
+    *BufferCb = ValueCb;
+
+    if (Buffer)
     {
-        if (BlgpIsLittleEndian())
+        if (ValueCb > LocalBufferCb)
         {
-            // If the value is negative, the leading zero octets must be filled with the value
-            // 0xFF to generate the two's complement of the original value.
-            if (!Positive)
-            {
-                FillMemory(Buffer + ValueCb, BufferCb - ValueCb, 0xFF);
-            }
+            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+            return FALSE;
+        }
+
+        if (LittleEndian)
+        {
+            BlgpReverseMemory(Buffer, Value, ValueCb);
         }
         else
         {
-            MoveMemory(Buffer + BufferCb - ValueCb, Buffer, ValueCb);
-
-            // If the value is positive, clear the shifted bytes; otherwise fill with the value
-            // 0xFF to generate the two's complement of the original value.
-            if (Positive)
-            {
-                ZeroMemory(Buffer, BufferCb - ValueCb);
-            }
-            else
-            {
-                FillMemory(Buffer, BufferCb - ValueCb, 0xFF);
-            }
+            CopyMemory(Buffer, Value, ValueCb);
         }
     }
 
-    if (Signed)
+    return TRUE;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpEncodeInteger(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN ULONGLONG Value,
+    IN DWORD OctetCount
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 INTEGER value of at most 64 bits.
+
+Arguments:
+
+    OctetCount - Number of content octets as returned by BlgpIntOctetCount64 or
+        BlgpUIntOctetCount64.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncIntegerInstances[Encoder->Mode](Encoder, Class, Tag, Value, OctetCount);
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpDecodeInteger(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN BOOL Signed,
+    OUT PULONGLONG Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 INTEGER value of at most 64 bits.
+
+Arguments:
+
+    Signed - Boolean value indicating whether the value is decoded as a signed integer.
+
+    Value - Pointer to a variable that receives the decoded integer. If Signed is TRUE, the
+        variable receives the two's complement of negative values.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+
+    *Value = 0;
+
+    if (!BlgpValidateState(Decoder))
     {
-        // If the buffer represents a signed integer and the value is positive, check the most
-        // significant bit. If it is one, it means that we have an overflow.
-        if (Positive)
+        return FALSE;
+    }
+
+    return BlgpReadInteger(Decoder->Encoded, Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb, Signed, Value);
+}
+
+BOOL
+BLGASN1CALL
+BlgpReadInteger(
+    IN CONST BYTE *Base,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN BOOL Signed,
+    OUT PULONGLONG Result
+    )
+
+/*++
+
+Routine Description:
+
+    Reads the content octets of an ASN.1 INTEGER value of at most 64 bits.
+
+Arguments:
+
+    Base - Pointer to the beginning of the readable memory containing the value. The octets
+        between Base and Value may be read but do not affect the result.
+
+    Value - Pointer to the content octets.
+
+    ValueCb - Number of content octets.
+
+    Signed - Boolean value indicating whether the value is decoded as a signed integer.
+
+    Result - Pointer to a variable that receives the decoded integer.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    DWORD Shift;
+    ULONGLONG Raw;
+    BOOL Positive;
+
+    *Result = 0;
+
+    if (ValueCb == 0)
+    {
+        SetLastError(ERROR_BLGASN1_CORRUPT);
+
+        return FALSE;
+    }
+
+    Positive = (CHAR) *Value >= 0;
+
+    if (!Positive && !Signed)
+    {
+        SetLastError(ERROR_BLGASN1_CORRUPT);
+
+        return FALSE;
+    }
+
+    if (*Value == 0 && ValueCb > 1)
+    {
+        Value++; ValueCb--;
+    }
+
+    // A positive signed value must leave the most significant bit clear.
+    if (ValueCb > 8 || (Signed && Positive && ValueCb == 8 && (CHAR) *Value < 0))
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return FALSE;
+    }
+
+    Shift = (8 - ValueCb) * 8;
+
+    // Load the eight octets ending at the last content octet. The octets preceding the value
+    // are shifted out below.
+    if ((DWORD) (Value - Base) + ValueCb >= 8)
+    {
+        Raw = BlgpLoadBigEndian64(Value + ValueCb - 8) << Shift;
+    }
+    else
+    {
+        DWORD i;
+
+        for (i = 0, Raw = 0; i < ValueCb; i++)
         {
-            if (BlgpIsLittleEndian())
-            {
-                if ((CHAR) Buffer[BufferCb - 1] < 0)
-                {
-                    ZeroMemory(Buffer, BufferCb);
+            Raw = (Raw << 8) | Value[i];
+        }
 
-                    SetLastError(ERROR_BLGASN1_TOO_LARGE);
+        Raw <<= Shift;
+    }
 
-                    return FALSE;
-                }
-            }
-            else
-            {
-                if ((CHAR) Buffer[0] < 0)
-                {
-                    ZeroMemory(Buffer, BufferCb);
+    if (Shift == 0)
+    {
+        *Result = Raw;
+    }
+    else if (Positive)
+    {
+        *Result = Raw >> Shift;
+    }
+    else
+    {
+        *Result = (ULONGLONG) (((LONGLONG) Raw) >> Shift);
+    }
 
-                    SetLastError(ERROR_BLGASN1_TOO_LARGE);
+    return TRUE;
+}
 
-                    return FALSE;
-                }
-            }
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncIntBytes(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN BOOL Positive,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN BOOL LittleEndian
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 INTEGER value of arbitrary size in the specified mode.
+
+--*/
+
+{
+    CONST BYTE *Msb;
+    PBYTE Ptr;
+    DWORD Shift = 0;
+    DWORD OctetCount;
+    ULONGLONG PadQuad;
+    BYTE Pad;
+
+    // If the value is positive, discard the leading bytes with the value zero. If the value is
+    // negative, discard the leading bytes with the value 0xFF as long as the most significant bit
+    // of the remaining value stays one. They have no significance for the decoding process. The
+    // quadword loops skip large runs of padding, e.g. the unused limbs of a big integer.
+    Pad = Positive ? 0x00 : 0xFF;
+    PadQuad = Positive ? 0 : ~(ULONGLONG) 0;
+
+    OctetCount = ValueCb;
+
+    if (LittleEndian)
+    {
+        while (OctetCount > 8 && *(CONST ULONGLONG UNALIGNED *) (Value + OctetCount - 8) == PadQuad &&
+               (Positive || (CHAR) Value[OctetCount - 9] < 0))
+        {
+            OctetCount -= 8;
+        }
+
+        while (OctetCount > 1 && Value[OctetCount - 1] == Pad && (Positive || (CHAR) Value[OctetCount - 2] < 0))
+        {
+            OctetCount--;
         }
+
+        Msb = Value + OctetCount - 1;
     }
     else
     {
-        if (!Positive)
+        while (OctetCount > 8 && *(CONST ULONGLONG UNALIGNED *) (Value + ValueCb - OctetCount) == PadQuad &&
+               (Positive || (CHAR) Value[ValueCb - OctetCount + 8] < 0))
+        {
+            OctetCount -= 8;
+        }
+
+        while (OctetCount > 1 && Value[ValueCb - OctetCount] == Pad && (Positive || (CHAR) Value[ValueCb - OctetCount + 1] < 0))
         {
-            ZeroMemory(Buffer, BufferCb);
+            OctetCount--;
+        }
 
-            SetLastError(ERROR_BLGASN1_CORRUPT);
+        Msb = Value + ValueCb - OctetCount;
+    }
 
-            return FALSE;
+    // If the value is positive and the most significant bit is one, an empty octet must be
+    // appended to the beginning of the encoded value.
+    if (Positive && (CHAR) *Msb < 0)
+    {
+        OctetCount++; Shift++;
+    }
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE,
+            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_INTEGER : Tag, OctetCount, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        if (Shift > 0)
+        {
+            *Ptr = 0;
+        }
+
+        if (LittleEndian)
+        {
+            BlgpReverseMemory(Ptr + Shift, Value, OctetCount - Shift);
         }
+        else
+        {
+            CopyMemory(Ptr + Shift, Msb, OctetCount - Shift);
+        }
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncInteger(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN ULONGLONG Value,
+    IN DWORD OctetCount
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 INTEGER value of at most 64 bits in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE,
+            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_INTEGER : Tag, OctetCount, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        BlgpWriteInt64(Ptr, BlgpWritableEnd(Mode, Encoder), Value, OctetCount);
     }
 
     return TRUE;
@@ -11,6 +11,18 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncLen(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN DWORD Len
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncLen, (PBLGP_DER_ENCODER Encoder, DWORD Len), (Encoder, Len));
+
 BOOL
 BLGASN1CALL
 BlgDerEncLen(
@@ -38,8 +50,6 @@ Return Value:
 
 {
     PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
-    PBYTE Bits = (PBYTE) &Len;
-    DWORD OctetCount;
 
     if (!Encoder)
     {
@@ -48,37 +58,39 @@ Return Value:
         return FALSE;
     }
 
-    if (Len <= 127)
-    {
-        OctetCount = 1;
-    }
-    else
+    return BlgpEncLenInstances[Encoder->Mode](Encoder, Len);
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncLen(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN DWORD Len
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 DER length in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    if (!BlgpReserve(Mode, Encoder, BlgpLenOctetCount(Len), &Ptr))
     {
-        OctetCount = BlgpNonZeroByteLength(Bits, sizeof(DWORD)) + 1;
+        return FALSE;
     }
 
-    if (Encoder->Buffer != NULL)
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
     {
-        if (BLGP_DER_ENCODED_CB(Encoder) + OctetCount > Encoder->BufferCb)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
-
-            return FALSE;
-        }
-
-        if (OctetCount == 1)
-        {
-            *Encoder->Ptr = (BYTE) Len;
-        }
-        else
-        {
-            *Encoder->Ptr = (BYTE) (OctetCount - 1) | 0x80;
-
-            BlgpCopyMemory(Encoder->Ptr + 1, Bits, OctetCount - 1);
-        }
+        BlgpWriteLen(Ptr, Len);
     }
 
-    Encoder->Ptr += OctetCount;
-
     return TRUE;
 }
\ No newline at end of file
@@ -11,6 +11,21 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncNull(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncNull,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag),
+    (Encoder, Class, Tag));
+
 BOOL
 BLGASN1CALL
 BlgDerEncNull(
@@ -49,16 +64,31 @@ Return Value:
         return FALSE;
     }
 
-    if (!BlgDerEncTag(EncoderHandle, Class, FALSE,
-            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_NULL : Tag))
-    {
-        return FALSE;
-    }
+    return BlgpEncNullInstances[Encoder->Mode](Encoder, Class, Tag);
+}
 
-    if (!BlgDerEncLen(EncoderHandle, 0))
-    {
-        return FALSE;
-    }
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncNull(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 NULL value in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
 
-    return TRUE;
+    return BlgpReserveNode(Mode, Encoder, Class, FALSE,
+        (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_NULL : Tag, 0, &Ptr);
 }
\ No newline at end of file
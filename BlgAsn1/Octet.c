@@ -11,6 +11,23 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncOctetString(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BYTE *Value,
+    IN INT ValueCb
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncOctetString,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, CONST BYTE *Value, INT ValueCb),
+    (Encoder, Class, Tag, Value, ValueCb));
+
 BOOL
 BLGASN1CALL
 BlgDerEncOctetString(
@@ -55,32 +72,7 @@ Return Value:
         return FALSE;
     }
 
-    if (!BlgDerEncTag(EncoderHandle, Class, FALSE,
-            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_OCTET_STRING : Tag))
-    {
-        return FALSE;
-    }
-
-    if (!BlgDerEncLen(EncoderHandle, ValueCb))
-    {
-        return FALSE;
-    }
-
-    if (Encoder->Buffer != NULL)
-    {
-        if (BLGP_DER_ENCODED_CB(Encoder) + ValueCb > Encoder->BufferCb)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
-
-            return FALSE;
-        }
-
-        CopyMemory(Encoder->Ptr, Value, ValueCb);
-    }
-
-    Encoder->Ptr += ValueCb;
-
-    return TRUE;
+    return BlgpEncOctetStringInstances[Encoder->Mode](Encoder, Class, Tag, Value, ValueCb);
 }
 
 BOOL
@@ -148,5 +140,43 @@ Return Value:
         CopyMemory(Buffer, CurrentNode->Value, CurrentNode->ValueCb);
     }
 
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncOctetString(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BYTE *Value,
+    IN INT ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 Octet String value in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE,
+            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_OCTET_STRING : Tag, ValueCb, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        CopyMemory(Ptr, Value, ValueCb);
+    }
+
     return TRUE;
 }
\ No newline at end of file
@@ -7,12 +7,212 @@ See License.txt in the project root for license information.
 --*/
 
 #include <windows.h>
-#include <strsafe.h>
 
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
-// TODO: Implement!
+// The number of displacements tried for a bucket of the registry before another seed is chosen.
+#define BLGP_OID_MAX_DISPLACEMENT   4096
+
+// The number of seeds tried for a slot table size before the table is doubled.
+#define BLGP_OID_SEEDS_PER_SIZE     8
+
+typedef struct _BLGP_DER_OID_REGISTRY
+{
+    // Seed of the hash function, chosen when the registry is created.
+    ULONGLONG Seed;
+
+    // The upper half of the hash selects a bucket. The displacement of the bucket, chosen so that
+    // the values of the bucket go to distinct free slots, is mixed into the hash to select the
+    // slot. A zero displacement marks an empty bucket.
+    PDWORD Displacements;
+    DWORD BucketMask;
+
+    // Index plus one of the value in each slot, or zero for an empty slot.
+    PDWORD Slots;
+    DWORD SlotMask;
+
+    // Copies of the registered values; their octets follow the array.
+    PBLG_DER_OID Oids;
+    DWORD OidCount;
+
+} BLGP_DER_OID_REGISTRY, *PBLGP_DER_OID_REGISTRY;
+
+static
+BOOL
+BLGASN1CALL
+BlgpEncOidText(
+    IN PCWSTR Value,
+    OUT PBYTE Ptr OPTIONAL,
+    OUT PULONGLONG ValueCb
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpEncOidArcs(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST VOID *Arcs,
+    IN DWORD ArcCount,
+    IN BOOLEAN Arcs64
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpWriteOid(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpWriteOidArcs(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST VOID *Arcs,
+    IN DWORD ArcCount,
+    IN BOOLEAN Arcs64
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpWriteOid,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, PCWSTR Value),
+    (Encoder, Class, Tag, Value));
+
+BLGP_DER_ENC_INSTANCES(BlgpWriteOidArcs,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, CONST VOID *Arcs, DWORD ArcCount, BOOLEAN Arcs64),
+    (Encoder, Class, Tag, Arcs, ArcCount, Arcs64));
+
+static
+BOOL
+BLGASN1CALL
+BlgpDecOidArcs(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PVOID Arcs OPTIONAL,
+    IN OUT PDWORD ArcCount,
+    IN BOOLEAN Arcs64
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpBuildOidRegistry(
+    IN PBLGP_DER_OID_REGISTRY Registry,
+    IN PULONGLONG Hashes,
+    IN PDWORD Next,
+    IN PDWORD Heads
+    );
+
+static
+ULONGLONG
+BLGASN1CALL
+BlgpOidHash(
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN ULONGLONG Seed
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpParseArc(
+    IN OUT PCWSTR *Ptr,
+    OUT PULONGLONG Arc
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpReadSubidentifier(
+    IN OUT CONST BYTE **Ptr,
+    IN CONST BYTE *End,
+    IN BOOLEAN Relaxed,
+    OUT PULONGLONG Value
+    );
+
+// Returns the number of octets of the base-128 encoding of a subidentifier.
+static __inline
+DWORD
+BLGASN1CALL
+BlgpSubidentifierCb(
+    IN ULONGLONG Value
+    )
+{
+    return BlgpHighestBit64(Value | 1) / 7 + 1;
+}
+
+// Writes the base-128 encoding of a subidentifier, the most significant group first, and returns
+// the number of octets written.
+static __inline
+DWORD
+BLGASN1CALL
+BlgpWriteSubidentifier(
+    OUT PBYTE Ptr,
+    IN ULONGLONG Value
+    )
+{
+    DWORD Cb = BlgpSubidentifierCb(Value);
+    DWORD i = Cb - 1;
+
+    Ptr[i] = (BYTE) (Value & 0x7F);
+
+    while (i-- > 0)
+    {
+        Value >>= 7;
+
+        Ptr[i] = (BYTE) (Value | 0x80);
+    }
+
+    return Cb;
+}
+
+// Selects the slot of a hash with the displacement of its bucket.
+static __inline
+DWORD
+BLGASN1CALL
+BlgpOidSlot(
+    IN ULONGLONG Hash,
+    IN DWORD Displacement
+    )
+{
+    return (DWORD) (((Hash ^ (Displacement * 0xC2B2AE3D27D4EB4FULL)) * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+// Combines the first two arcs into the first subidentifier. The caller validates the arcs.
+static __inline
+ULONGLONG
+BLGASN1CALL
+BlgpFirstSubidentifier(
+    IN ULONGLONG Arc1,
+    IN ULONGLONG Arc2
+    )
+{
+    return Arc1 * 40 + Arc2;
+}
+
+// Checks whether the first two arcs can be combined into a subidentifier. The first arc must be
+// 0, 1 or 2, and only under the arc 2 may the second arc be 40 or larger.
+static __inline
+BOOL
+BLGASN1CALL
+BlgpIsValidRootArcs(
+    IN ULONGLONG Arc1,
+    IN ULONGLONG Arc2
+    )
+{
+    return Arc1 < 2 ? Arc2 < 40 : Arc1 == 2 && Arc2 <= MAXULONGLONG - 80;
+}
+
 BOOL
 BLGASN1CALL
 BlgDerEncObjectIdentifier(
@@ -36,19 +236,18 @@ Arguments:
 
     Tag - Tag of the node.
 
-    Value - Object Identifier value to be encoded.
+    Value - Object Identifier value to be encoded in the dotted decimal form, such as
+        "1.2.840.113549".
 
 Return Value:
 
-    TRUE if the routine succeeds; otherwise, FALSE.
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_INVALID_PARAMETER
+    if the value is not a well-formed Object Identifier.
 
 --*/
 
 {
     PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
-    //DWORD Arcs[32];
-    //DWORD ArcsCount = 0;
-    //PCWSTR Ptr;
 
     if (!Encoder || !Value)
     {
@@ -57,12 +256,1307 @@ Return Value:
         return FALSE;
     }
 
-    if (FAILED(StringCchLength(Value, STRSAFE_MAX_CCH, NULL)))
+    return BlgpWriteOidInstances[Encoder->Mode](Encoder, Class, Tag, Value);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncObjectIdentifierArcs(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST DWORD *Arcs,
+    IN DWORD ArcCount
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 Object Identifier value from an array of arcs. Unlike
+    BlgDerEncObjectIdentifier, the routine does not parse text.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Arcs - Pointer to an array of arcs, the root arc first.
+
+    ArcCount - Number of arcs in the array. An Object Identifier has at least two arcs.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    return BlgpEncOidArcs(EncoderHandle, Class, Tag, Arcs, ArcCount, FALSE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncObjectIdentifierArcs64(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST ULONGLONG *Arcs,
+    IN DWORD ArcCount
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 Object Identifier value from an array of 64 bit arcs.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Arcs - Pointer to an array of arcs, the root arc first.
+
+    ArcCount - Number of arcs in the array. An Object Identifier has at least two arcs.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    return BlgpEncOidArcs(EncoderHandle, Class, Tag, Arcs, ArcCount, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecObjectIdentifier(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 Object Identifier value into the dotted decimal form.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Buffer - Pointer to a buffer that receives the null-terminated Object Identifier.
+
+    BufferCch - Pointer to a variable specifying the size of the buffer, in characters. When the
+        routine returns, the variable contains the number of characters stored in the buffer,
+        excluding the terminating null character. If Buffer is NULL, the variable receives the
+        required size, including the terminating null character.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_BLGASN1_TOO_LARGE
+    if an arc does not fit in 64 bits.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    CONST BYTE *Ptr, *End;
+    WCHAR Digits[20];
+    ULONGLONG Arcs[2];
+    DWORD ArcCount, Cch, LocalBufferCch, DigitCount, i;
+    BOOLEAN Relaxed;
+
+    if (!BufferCch)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        LocalBufferCch = *BufferCch; *BufferCch = 0;
+    }
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    Ptr = Decoder->CurrentNode.Value;
+    End = Ptr + Decoder->CurrentNode.ValueCb;
+    Relaxed = BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED);
+
+    if (Ptr == End || (End[-1] & 0x80) != 0)
+    {
+        SetLastError(ERROR_BLGASN1_CORRUPT);
+
+        return FALSE;
+    }
+
+    // The characters are stored while they fit, but the whole value is always converted so that
+    // the required size is known.
+    Cch = 0;
+
+    for (ArcCount = 0; Ptr < End; ArcCount++)
+    {
+        if (!BlgpReadSubidentifier(&Ptr, End, Relaxed, &Arcs[0]))
+        {
+            return FALSE;
+        }
+
+        if (ArcCount == 0)
+        {
+            Arcs[1] = Arcs[0] < 80 ? Arcs[0] % 40 : Arcs[0] - 80;
+            Arcs[0] = Arcs[0] < 80 ? Arcs[0] / 40 : 2;
+        }
+
+        for (i = 0; i < (ArcCount == 0 ? 2U : 1U); i++)
+        {
+            DigitCount = 0;
+
+            do
+            {
+                Digits[DigitCount++] = (WCHAR) (L'0' + Arcs[i] % 10);
+            }
+            while ((Arcs[i] /= 10) != 0);
+
+            if (Cch != 0)
+            {
+                if (Buffer && Cch < LocalBufferCch)
+                {
+                    Buffer[Cch] = L'.';
+                }
+
+                Cch++;
+            }
+
+            while (DigitCount-- > 0)
+            {
+                if (Buffer && Cch < LocalBufferCch)
+                {
+                    Buffer[Cch] = Digits[DigitCount];
+                }
+
+                Cch++;
+            }
+        }
+    }
+
+    if (Buffer)
+    {
+        *BufferCch = Cch;
+
+        if (Cch + 1 > LocalBufferCch)
+        {
+            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+            return FALSE;
+        }
+
+        Buffer[Cch] = 0;
+    }
+    else
+    {
+        *BufferCch = Cch + 1;
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecObjectIdentifierArcs(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PDWORD Arcs OPTIONAL,
+    IN OUT PDWORD ArcCount
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 Object Identifier value into an array of arcs.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Arcs - Pointer to an array that receives the arcs, the root arc first.
+
+    ArcCount - Pointer to a variable specifying the number of arcs in the array. When the routine
+        returns, the variable contains the number of arcs of the value.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_BLGASN1_TOO_LARGE
+    if an arc does not fit in 32 bits.
+
+--*/
+
+{
+    return BlgpDecOidArcs(DecoderHandle, Arcs, ArcCount, FALSE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecObjectIdentifierArcs64(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PULONGLONG Arcs OPTIONAL,
+    IN OUT PDWORD ArcCount
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 Object Identifier value into an array of 64 bit arcs.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Arcs - Pointer to an array that receives the arcs, the root arc first.
+
+    ArcCount - Pointer to a variable specifying the number of arcs in the array. When the routine
+        returns, the variable contains the number of arcs of the value.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_BLGASN1_TOO_LARGE
+    if an arc does not fit in 64 bits.
+
+--*/
+
+{
+    return BlgpDecOidArcs(DecoderHandle, Arcs, ArcCount, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerCompareObjectIdentifier(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_OID Oid,
+    OUT PBOOL IsEqual
+    )
+
+/*++
+
+Routine Description:
+
+    Compares the value of the current node with an Object Identifier whose content octets were
+    encoded in advance. The value is not decoded; the octets are compared as they are. The tag
+    of the node is not checked, so the routine works with implicitly tagged values as well.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Oid - Pointer to the content octets of the Object Identifier, such as one initialized with
+        BLG_DER_OID_INIT.
+
+    IsEqual - Pointer to a variable that receives whether the value equals the Object
+        Identifier.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+
+    if (!Oid || !IsEqual)
     {
         SetLastError(ERROR_INVALID_PARAMETER);
 
         return FALSE;
     }
 
+    *IsEqual = FALSE;
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    *IsEqual = Decoder->CurrentNode.ValueCb == Oid->ValueCb &&
+        RtlEqualMemory(Decoder->CurrentNode.Value, Oid->Value, Oid->ValueCb);
+
+    return TRUE;
+}
+
+HBLG_DER_OID_REGISTRY
+BLGASN1CALL
+BlgDerCreateOidRegistry(
+    IN PCBLG_DER_OID Oids,
+    IN DWORD OidCount
+    )
+
+/*++
+
+Routine Description:
+
+    Creates a registry that maps the content octets of Object Identifiers to their indexes, so a
+    decoded value can be dispatched on with a switch statement.
+
+    A perfect hash function is built for the values once. The values are distributed into
+    buckets by the hash, and every bucket receives a displacement that sends its values to slots
+    no other value occupies. Looking a value up costs one hash of its octets and one comparison,
+    however many values are registered.
+
+Arguments:
+
+    Oids - Array of the Object Identifiers. The content octets are copied into the registry.
+
+    OidCount - Number of Object Identifiers in the Oids parameter.
+
+Return Value:
+
+    Handle to the registry if the routine succeeds; otherwise, NULL. The routine fails with
+    ERROR_INVALID_PARAMETER if a value is empty or two values are the same.
+
+--*/
+
+{
+    PBLGP_DER_OID_REGISTRY Registry = NULL;
+    PULONGLONG Hashes;
+    PDWORD Next, Heads;
+    PBYTE Octets;
+    ULONGLONG OctetsCb;
+    SIZE_T HeaderCb, TablesCb;
+    DWORD BucketCount, SlotCount, Attempt, i;
+
+    if (!Oids || OidCount == 0 || OidCount > MAXDWORD / 8)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return NULL;
+    }
+
+    for (i = 0, OctetsCb = 0; i < OidCount; i++)
+    {
+        if (!Oids[i].Value || Oids[i].ValueCb == 0)
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return NULL;
+        }
+
+        OctetsCb += Oids[i].ValueCb;
+    }
+
+    if (OctetsCb > MAXDWORD)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return NULL;
+    }
+
+    // Two values per bucket on average; the slot table is kept at most 80 percent full.
+    for (BucketCount = 1; BucketCount < (OidCount + 1) / 2; BucketCount <<= 1);
+    for (SlotCount = 4; SlotCount < OidCount + OidCount / 4; SlotCount <<= 1);
+
+    Hashes = HeapAlloc(g_Heap, 0,
+        OidCount * (sizeof(ULONGLONG) + sizeof(DWORD)) + BucketCount * sizeof(DWORD));
+    if (!Hashes)
+    {
+        SetLastError(ERROR_OUTOFMEMORY);
+
+        return NULL;
+    }
+
+    Next = (PDWORD) (Hashes + OidCount);
+    Heads = Next + OidCount;
+
+    HeaderCb = (sizeof(BLGP_DER_OID_REGISTRY) + sizeof(ULONGLONG) - 1) & ~(sizeof(ULONGLONG) - 1);
+
+    for (Attempt = 0; ; Attempt++)
+    {
+        // A few seeds are tried for each size of the slot table before it is doubled.
+        if (Attempt % BLGP_OID_SEEDS_PER_SIZE == 0)
+        {
+            if (Registry)
+            {
+                HeapFree(g_Heap, 0, Registry);
+
+                SlotCount <<= 1;
+            }
+
+            TablesCb = (BucketCount + SlotCount) * sizeof(DWORD);
+            TablesCb = (TablesCb + sizeof(ULONGLONG) - 1) & ~(sizeof(ULONGLONG) - 1);
+
+            Registry = HeapAlloc(g_Heap, 0,
+                HeaderCb + TablesCb + OidCount * sizeof(BLG_DER_OID) + (SIZE_T) OctetsCb);
+            if (!Registry)
+            {
+                HeapFree(g_Heap, 0, Hashes);
+
+                SetLastError(ERROR_OUTOFMEMORY);
+
+                return NULL;
+            }
+
+            Registry->Displacements = (PDWORD) ((PBYTE) Registry + HeaderCb);
+            Registry->BucketMask = BucketCount - 1;
+            Registry->Slots = Registry->Displacements + BucketCount;
+            Registry->SlotMask = SlotCount - 1;
+            Registry->Oids = (PBLG_DER_OID) ((PBYTE) Registry->Displacements + TablesCb);
+            Registry->OidCount = OidCount;
+
+            Octets = (PBYTE) (Registry->Oids + OidCount);
+
+            for (i = 0; i < OidCount; i++)
+            {
+                CopyMemory(Octets, Oids[i].Value, Oids[i].ValueCb);
+
+                Registry->Oids[i].Value = Octets;
+                Registry->Oids[i].ValueCb = Oids[i].ValueCb;
+
+                Octets += Oids[i].ValueCb;
+            }
+        }
+
+        Registry->Seed = (Attempt + 1) * 0x9E3779B97F4A7C15ULL;
+
+        if (BlgpBuildOidRegistry(Registry, Hashes, Next, Heads))
+        {
+            break;
+        }
+
+        if (GetLastError() == ERROR_INVALID_PARAMETER)
+        {
+            HeapFree(g_Heap, 0, Registry);
+            HeapFree(g_Heap, 0, Hashes);
+
+            return NULL;
+        }
+    }
+
+    HeapFree(g_Heap, 0, Hashes);
+
+    return (HBLG_DER_OID_REGISTRY) Registry;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDestroyOidRegistry(
+    IN HBLG_DER_OID_REGISTRY RegistryHandle
+    )
+
+/*++
+
+Routine Description:
+
+    Destroys the specified Object Identifier registry.
+
+Arguments:
+
+    RegistryHandle - Handle to the registry to be destroyed.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    if (!RegistryHandle)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return HeapFree(g_Heap, 0, RegistryHandle);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerLookupObjectIdentifier(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN HBLG_DER_OID_REGISTRY RegistryHandle,
+    OUT PDWORD Index
+    )
+
+/*++
+
+Routine Description:
+
+    Looks up the value of the current node in an Object Identifier registry. The value is not
+    decoded, and the tag of the node is not checked.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    RegistryHandle - Handle to the registry created by BlgDerCreateOidRegistry.
+
+    Index - Pointer to a variable that receives the index of the value in the array passed to
+        BlgDerCreateOidRegistry, or BLG_DER_OID_NOT_FOUND if the value is not registered.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. A value that is not registered is not an
+    error.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    PBLGP_DER_OID_REGISTRY Registry = (PBLGP_DER_OID_REGISTRY) RegistryHandle;
+    CONST BYTE *Value;
+    ULONGLONG Hash;
+    DWORD ValueCb, Displacement, Found;
+
+    if (!Registry || !Index)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    *Index = BLG_DER_OID_NOT_FOUND;
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    Value = Decoder->CurrentNode.Value;
+    ValueCb = Decoder->CurrentNode.ValueCb;
+
+    if (ValueCb == 0)
+    {
+        return TRUE;
+    }
+
+    Hash = BlgpOidHash(Value, ValueCb, Registry->Seed);
+
+    Displacement = Registry->Displacements[(DWORD) (Hash >> 32) & Registry->BucketMask];
+
+    if (Displacement == 0)
+    {
+        return TRUE;
+    }
+
+    Found = Registry->Slots[BlgpOidSlot(Hash, Displacement) & Registry->SlotMask];
+
+    if (Found != 0 && Registry->Oids[Found - 1].ValueCb == ValueCb &&
+        RtlEqualMemory(Registry->Oids[Found - 1].Value, Value, ValueCb))
+    {
+        *Index = Found - 1;
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpEncOidText(
+    IN PCWSTR Value,
+    OUT PBYTE Ptr OPTIONAL,
+    OUT PULONGLONG ValueCb
+    )
+{
+    ULONGLONG Arc1, Arc2, Cb;
+
+    if (!BlgpParseArc(&Value, &Arc1) || *Value++ != L'.' || !BlgpParseArc(&Value, &Arc2) ||
+        !BlgpIsValidRootArcs(Arc1, Arc2))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    Arc1 = BlgpFirstSubidentifier(Arc1, Arc2);
+
+    Cb = Ptr ? BlgpWriteSubidentifier(Ptr, Arc1) : BlgpSubidentifierCb(Arc1);
+
+    while (*Value != 0)
+    {
+        if (*Value++ != L'.' || !BlgpParseArc(&Value, &Arc1))
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        Cb += Ptr ? BlgpWriteSubidentifier(Ptr + Cb, Arc1) : BlgpSubidentifierCb(Arc1);
+
+        if (Cb > MAXDWORD)
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+    }
+
+    *ValueCb = Cb;
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpEncOidArcs(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST VOID *Arcs,
+    IN DWORD ArcCount,
+    IN BOOLEAN Arcs64
+    )
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || !Arcs || ArcCount < 2)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpWriteOidArcsInstances[Encoder->Mode](Encoder, Class, Tag, Arcs, ArcCount, Arcs64);
+}
+
+BOOL
+BLGASN1CALL
+BlgpDecOidArcs(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PVOID Arcs OPTIONAL,
+    IN OUT PDWORD ArcCount,
+    IN BOOLEAN Arcs64
+    )
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    CONST BYTE *Ptr, *End;
+    ULONGLONG Arc, Root[2];
+    DWORD LocalArcCount, Count, i;
+    BOOLEAN Relaxed;
+
+    if (!ArcCount)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        LocalArcCount = Arcs ? *ArcCount : 0; *ArcCount = 0;
+    }
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    Ptr = Decoder->CurrentNode.Value;
+    End = Ptr + Decoder->CurrentNode.ValueCb;
+    Relaxed = BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED);
+
+    // The last octet must end a subidentifier, so the readers below never need to check for the
+    // end of the value in the middle of one.
+    if (Ptr == End || (End[-1] & 0x80) != 0)
+    {
+        SetLastError(ERROR_BLGASN1_CORRUPT);
+
+        return FALSE;
+    }
+
+    if (!BlgpReadSubidentifier(&Ptr, End, Relaxed, &Arc))
+    {
+        return FALSE;
+    }
+
+    Root[0] = Arc < 80 ? Arc / 40 : 2;
+    Root[1] = Arc < 80 ? Arc % 40 : Arc - 80;
+
+    if (!Arcs64 && Root[1] > MAXDWORD)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return FALSE;
+    }
+
+    for (Count = 0; Count < 2; Count++)
+    {
+        if (Count < LocalArcCount)
+        {
+            if (Arcs64)
+            {
+                ((PULONGLONG) Arcs)[Count] = Root[Count];
+            }
+            else
+            {
+                ((PDWORD) Arcs)[Count] = (DWORD) Root[Count];
+            }
+        }
+    }
+
+    while (Ptr < End)
+    {
+        // Arcs below 128 are by far the most common. If none of the next eight octets has the
+        // continuation bit set, each of them is a complete arc.
+        if (End - Ptr >= 8 && (BlgpLoadBigEndian64(Ptr) & 0x8080808080808080ULL) == 0)
+        {
+            for (i = 0; i < 8 && Count + i < LocalArcCount; i++)
+            {
+                if (Arcs64)
+                {
+                    ((PULONGLONG) Arcs)[Count + i] = Ptr[i];
+                }
+                else
+                {
+                    ((PDWORD) Arcs)[Count + i] = Ptr[i];
+                }
+            }
+
+            Ptr += 8; Count += 8;
+
+            continue;
+        }
+
+        if (!BlgpReadSubidentifier(&Ptr, End, Relaxed, &Arc))
+        {
+            return FALSE;
+        }
+
+        if (!Arcs64 && Arc > MAXDWORD)
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+
+        if (Count < LocalArcCount)
+        {
+            if (Arcs64)
+            {
+                ((PULONGLONG) Arcs)[Count] = Arc;
+            }
+            else
+            {
+                ((PDWORD) Arcs)[Count] = (DWORD) Arc;
+            }
+        }
+
+        Count++;
+    }
+
+    *ArcCount = Count;
+
+    if (Arcs && Count > LocalArcCount)
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpBuildOidRegistry(
+    IN PBLGP_DER_OID_REGISTRY Registry,
+    IN PULONGLONG Hashes,
+    IN PDWORD Next,
+    IN PDWORD Heads
+    )
+
+/*++
+
+Routine Description:
+
+    Tries to build the perfect hash tables of a registry with the seed stored in it. The buckets
+    are placed from the largest to the smallest, since the large ones are the hardest to place
+    once slots are taken.
+
+Arguments:
+
+    Registry - Pointer to the registry. The values, the seed and the table sizes are set.
+
+    Hashes - Array that receives the hash of each value.
+
+    Next - Array that receives the index plus one of the next value in the same bucket.
+
+    Heads - Array that receives the index plus one of the first value of each bucket.
+
+Return Value:
+
+    TRUE if the tables are built; otherwise, FALSE. If another seed may succeed, the last error
+    is ERROR_RETRY; if two values are the same, it is ERROR_INVALID_PARAMETER.
+
+--*/
+
+{
+    PBLG_DER_OID Oids = Registry->Oids;
+    DWORD BucketCount = Registry->BucketMask + 1;
+    DWORD Size, MaxSize, Bucket, Displacement, Slot, i, j;
+
+    ZeroMemory(Heads, BucketCount * sizeof(DWORD));
+    ZeroMemory(Registry->Displacements, BucketCount * sizeof(DWORD));
+    ZeroMemory(Registry->Slots, (Registry->SlotMask + 1) * sizeof(DWORD));
+
+    for (i = 0; i < Registry->OidCount; i++)
+    {
+        Hashes[i] = BlgpOidHash(Oids[i].Value, Oids[i].ValueCb, Registry->Seed);
+
+        Bucket = (DWORD) (Hashes[i] >> 32) & Registry->BucketMask;
+
+        // Values with the same hash can never be separated; they are either the same value or
+        // need another seed.
+        for (j = Heads[Bucket]; j != 0; j = Next[j - 1])
+        {
+            if (Hashes[j - 1] == Hashes[i])
+            {
+                if (Oids[j - 1].ValueCb == Oids[i].ValueCb &&
+                    RtlEqualMemory(Oids[j - 1].Value, Oids[i].Value, Oids[i].ValueCb))
+                {
+                    SetLastError(ERROR_INVALID_PARAMETER);
+                }
+                else
+                {
+                    SetLastError(ERROR_RETRY);
+                }
+
+                return FALSE;
+            }
+        }
+
+        Next[i] = Heads[Bucket];
+        Heads[Bucket] = i + 1;
+    }
+
+    for (MaxSize = 0, Bucket = 0; Bucket < BucketCount; Bucket++)
+    {
+        for (Size = 0, j = Heads[Bucket]; j != 0; j = Next[j - 1], Size++);
+
+        MaxSize = Size > MaxSize ? Size : MaxSize;
+    }
+
+    for (; MaxSize > 0; MaxSize--)
+    {
+        for (Bucket = 0; Bucket < BucketCount; Bucket++)
+        {
+            for (Size = 0, j = Heads[Bucket]; j != 0; j = Next[j - 1], Size++);
+
+            if (Size != MaxSize)
+            {
+                continue;
+            }
+
+            for (Displacement = 1; Displacement <= BLGP_OID_MAX_DISPLACEMENT; Displacement++)
+            {
+                // Claim the slots one by one and release them if one of them is taken.
+                for (j = Heads[Bucket]; j != 0; j = Next[j - 1])
+                {
+                    Slot = BlgpOidSlot(Hashes[j - 1], Displacement) & Registry->SlotMask;
+
+                    if (Registry->Slots[Slot] != 0)
+                    {
+                        break;
+                    }
+
+                    Registry->Slots[Slot] = j;
+                }
+
+                if (j == 0)
+                {
+                    break;
+                }
+
+                for (i = Heads[Bucket]; i != j; i = Next[i - 1])
+                {
+                    Registry->Slots[BlgpOidSlot(Hashes[i - 1], Displacement) & Registry->SlotMask] = 0;
+                }
+            }
+
+            if (Displacement > BLGP_OID_MAX_DISPLACEMENT)
+            {
+                SetLastError(ERROR_RETRY);
+
+                return FALSE;
+            }
+
+            Registry->Displacements[Bucket] = Displacement;
+        }
+    }
+
+    return TRUE;
+}
+
+ULONGLONG
+BLGASN1CALL
+BlgpOidHash(
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN ULONGLONG Seed
+    )
+
+/*++
+
+Routine Description:
+
+    Hashes the content octets of an Object Identifier. Values of up to eight octets, which are
+    the vast majority, are read with at most two loads and hashed with one multiplication. The
+    octets are never read past the end of the value.
+
+Arguments:
+
+    Value - Pointer to the content octets. ValueCb must not be zero.
+
+    ValueCb - Number of content octets.
+
+    Seed - Seed of the hash.
+
+Return Value:
+
+    The hash of the value.
+
+--*/
+
+{
+    ULONGLONG Hash = Seed ^ (ValueCb * 0x9E3779B97F4A7C15ULL);
+    ULONGLONG Word;
+
+    while (ValueCb > 8)
+    {
+        Hash = (Hash ^ *(CONST ULONGLONG UNALIGNED *) Value) * 0xFF51AFD7ED558CCDULL;
+        Hash ^= Hash >> 32;
+
+        Value += 8; ValueCb -= 8;
+    }
+
+    // The remaining one to eight octets are read with overlapping loads. Together with the
+    // length, which is mixed into the hash first, the word identifies them.
+    if (ValueCb >= 4)
+    {
+        Word = ((ULONGLONG) *(CONST DWORD UNALIGNED *) Value << 32) |
+            *(CONST DWORD UNALIGNED *) (Value + ValueCb - 4);
+    }
+    else
+    {
+        Word = ((ULONGLONG) Value[0] << 16) | ((ULONGLONG) Value[ValueCb >> 1] << 8) | Value[ValueCb - 1];
+    }
+
+    Hash = (Hash ^ Word) * 0xFF51AFD7ED558CCDULL;
+    Hash ^= Hash >> 29;
+
+    return Hash;
+}
+
+BOOL
+BLGASN1CALL
+BlgpParseArc(
+    IN OUT PCWSTR *Ptr,
+    OUT PULONGLONG Arc
+    )
+
+/*++
+
+Routine Description:
+
+    Parses a decimal arc and advances the pointer past its last digit.
+
+Arguments:
+
+    Ptr - Pointer to a variable that points to the first digit of the arc.
+
+    Arc - Pointer to a variable that receives the arc.
+
+Return Value:
+
+    TRUE if the arc is well-formed; otherwise, FALSE. Arcs with leading zeros or without digits,
+    and arcs that do not fit in 64 bits are rejected.
+
+--*/
+
+{
+    PCWSTR Start = *Ptr, Current = *Ptr;
+    ULONGLONG Value = 0;
+
+    while (*Current >= L'0' && *Current <= L'9')
+    {
+        if (Value > (MAXULONGLONG - (*Current - L'0')) / 10)
+        {
+            return FALSE;
+        }
+
+        Value = Value * 10 + (*Current++ - L'0');
+    }
+
+    if (Current == Start || (*Start == L'0' && Current - Start > 1))
+    {
+        return FALSE;
+    }
+
+    *Ptr = Current;
+    *Arc = Value;
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpReadSubidentifier(
+    IN OUT CONST BYTE **Ptr,
+    IN CONST BYTE *End,
+    IN BOOLEAN Relaxed,
+    OUT PULONGLONG Value
+    )
+
+/*++
+
+Routine Description:
+
+    Reads a base-128 subidentifier and advances the pointer past it. The caller guarantees that
+    the last octet before End does not have the continuation bit set.
+
+    If at least eight octets are available, they are loaded at once. The position of the first
+    octet without the continuation bit gives the size of the subidentifier, and its 7 bit groups
+    are packed together with three mask and shift steps instead of one step per octet.
+
+Arguments:
+
+    Ptr - Pointer to a variable that points to the first octet of the subidentifier.
+
+    End - Pointer to the end of the value.
+
+    Relaxed - Whether to accept subidentifiers with leading 0x80 octets.
+
+    Value - Pointer to a variable that receives the subidentifier.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    CONST BYTE *Current = *Ptr;
+    ULONGLONG Word, Result;
+    DWORD Cb;
+
+    if (*Current < 0x80)
+    {
+        *Value = *Current;
+        *Ptr = Current + 1;
+
+        return TRUE;
+    }
+
+    // DER requires the minimal number of octets.
+    if (*Current == 0x80 && !Relaxed)
+    {
+        SetLastError(ERROR_BLGASN1_CORRUPT);
+
+        return FALSE;
+    }
+
+    if (End - Current >= 8)
+    {
+        Word = BlgpLoadBigEndian64(Current);
+
+        if ((~Word & 0x8080808080808080ULL) != 0)
+        {
+            // The first octet is the most significant one; the highest clear continuation bit
+            // marks the last octet of the subidentifier.
+            Cb = 8 - BlgpHighestBit64(~Word & 0x8080808080808080ULL) / 8;
+
+            Word = (Word >> ((8 - Cb) * 8)) & 0x7F7F7F7F7F7F7F7FULL;
+            Word = (Word & 0x007F007F007F007FULL) | ((Word & 0x7F007F007F007F00ULL) >> 1);
+            Word = (Word & 0x00003FFF00003FFFULL) | ((Word & 0x3FFF00003FFF0000ULL) >> 2);
+            Word = (Word & 0x000000000FFFFFFFULL) | ((Word & 0x0FFFFFFF00000000ULL) >> 4);
+
+            *Value = Word;
+            *Ptr = Current + Cb;
+
+            return TRUE;
+        }
+    }
+
+    Result = 0;
+
+    do
+    {
+        if ((Result >> 57) != 0)
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+
+        Result = (Result << 7) | (*Current & 0x7F);
+    }
+    while (*Current++ & 0x80);
+
+    *Value = Result;
+    *Ptr = Current;
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpWriteOid(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 Object Identifier value in the dotted decimal form in the specified mode.
+
+--*/
+
+{
+    ULONGLONG ValueCb;
+    PBYTE Ptr;
+
+    // The text is parsed twice; the first pass validates it and measures the content octets.
+    if (!BlgpEncOidText(Value, NULL, &ValueCb))
+    {
+        return FALSE;
+    }
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE,
+            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_OBJECT_IDENTIFIER : Tag,
+            (DWORD) ValueCb, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        BlgpEncOidText(Value, Ptr, &ValueCb);
+    }
+
+    return TRUE;
+}
+
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpWriteOidArcs(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST VOID *Arcs,
+    IN DWORD ArcCount,
+    IN BOOLEAN Arcs64
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 Object Identifier value from an array of arcs in the specified mode.
+
+--*/
+
+{
+    CONST ULONGLONG *Arcs64Ptr = (CONST ULONGLONG *) Arcs;
+    CONST DWORD *Arcs32Ptr = (CONST DWORD *) Arcs;
+    ULONGLONG First, ValueCb;
+    PBYTE Ptr;
+    DWORD i;
+
+    if (Arcs64)
+    {
+        if (!BlgpIsValidRootArcs(Arcs64Ptr[0], Arcs64Ptr[1]))
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        First = BlgpFirstSubidentifier(Arcs64Ptr[0], Arcs64Ptr[1]);
+        ValueCb = BlgpSubidentifierCb(First);
+
+        for (i = 2; i < ArcCount; i++)
+        {
+            ValueCb += BlgpSubidentifierCb(Arcs64Ptr[i]);
+        }
+    }
+    else
+    {
+        if (!BlgpIsValidRootArcs(Arcs32Ptr[0], Arcs32Ptr[1]))
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        First = BlgpFirstSubidentifier(Arcs32Ptr[0], Arcs32Ptr[1]);
+        ValueCb = BlgpSubidentifierCb(First);
+
+        for (i = 2; i < ArcCount; i++)
+        {
+            ValueCb += BlgpSubidentifierCb(Arcs32Ptr[i]);
+        }
+    }
+
+    if (ValueCb > MAXDWORD)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return FALSE;
+    }
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE,
+            (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_OBJECT_IDENTIFIER : Tag,
+            (DWORD) ValueCb, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        Ptr += BlgpWriteSubidentifier(Ptr, First);
+
+        if (Arcs64)
+        {
+            for (i = 2; i < ArcCount; i++)
+            {
+                Ptr += BlgpWriteSubidentifier(Ptr, Arcs64Ptr[i]);
+            }
+        }
+        else
+        {
+            for (i = 2; i < ArcCount; i++)
+            {
+                // Most arcs are below 128 and take a single octet.
+                if (Arcs32Ptr[i] < 0x80)
+                {
+                    *Ptr++ = (BYTE) Arcs32Ptr[i];
+                }
+                else
+                {
+                    Ptr += BlgpWriteSubidentifier(Ptr, Arcs32Ptr[i]);
+                }
+            }
+        }
+    }
+
     return TRUE;
 }
\ No newline at end of file
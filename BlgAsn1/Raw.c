@@ -11,6 +11,21 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpWriteRaw(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpWriteRaw,
+    (PBLGP_DER_ENCODER Encoder, CONST BYTE *Value, DWORD ValueCb),
+    (Encoder, Value, ValueCb));
+
 BOOL
 BLGASN1CALL
 BlgDerWriteRaw(
@@ -49,19 +64,40 @@ Return Value:
         return FALSE;
     }
 
-    if (Encoder->Buffer)
-    {
-        if (BLGP_DER_ENCODED_CB(Encoder) + ValueCb > Encoder->BufferCb)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+    return BlgpWriteRawInstances[Encoder->Mode](Encoder, Value, ValueCb);
+}
 
-            return FALSE;
-        }
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpWriteRaw(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb
+    )
+
+/*++
 
-        CopyMemory(Encoder->Ptr, Value, ValueCb);
+Routine Description:
+
+    Writes a raw byte stream in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    if (!BlgpReserve(Mode, Encoder, ValueCb, &Ptr))
+    {
+        return FALSE;
     }
 
-    Encoder->Ptr += ValueCb;
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        CopyMemory(Ptr, Value, ValueCb);
+    }
 
     return TRUE;
 }
\ No newline at end of file
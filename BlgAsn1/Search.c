@@ -0,0 +1,366 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+--*/
+
+#include <windows.h>
+
+#include "BlgAsn1.h"
+#include "BlgAsn1p.h"
+
+// The deepest nesting at which a match is confirmed.
+#define BLGP_SEARCH_MAX_DEPTH   64
+
+// Tracks the position of the structural check. Candidates are checked in ascending order, so the
+// walk through the encoded data resumes where the previous candidate left it; every node is
+// parsed at most once however many candidates there are.
+typedef struct _BLGP_DER_SEARCH_CURSOR
+{
+    CONST BYTE *Encoded;
+    DWORD EncodedCb;
+
+    // Start of the next node at the current depth.
+    CONST BYTE *Next;
+
+    // End of the content octets of each node enclosing the current depth.
+    CONST BYTE *Ends[BLGP_SEARCH_MAX_DEPTH];
+    DWORD Depth;
+
+    // Set when a malformed node is met; no later candidate can be confirmed.
+    BOOL Malformed;
+
+} BLGP_DER_SEARCH_CURSOR, *PBLGP_DER_SEARCH_CURSOR;
+
+typedef struct _BLGP_DER_SEARCH
+{
+    // Identifier and length octets of the node searched for.
+    BYTE Header[11];
+    DWORD HeaderCb;
+
+    CONST BYTE *Value;
+    DWORD ValueCb;
+
+    DWORD Flags;
+    PBLG_DER_SEARCH_ROUTINE SearchRoutine;
+    PVOID Context;
+    DWORD MatchCount;
+
+    BLGP_DER_SEARCH_CURSOR Cursor;
+
+} BLGP_DER_SEARCH, *PBLGP_DER_SEARCH;
+
+static
+BOOL
+BLGASN1CALL
+BlgpSearchCandidate(
+    IN PBLGP_DER_SEARCH Search,
+    IN CONST BYTE *Candidate
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpLocateNode(
+    IN PBLGP_DER_SEARCH_CURSOR Cursor,
+    IN CONST BYTE *Candidate
+    );
+
+BOOL
+BLGASN1CALL
+BlgDerSearch(
+    IN CONST BYTE *Encoded,
+    IN DWORD EncodedCb,
+    IN BYTE Class,
+    IN BOOLEAN Constructed,
+    IN DWORD Tag,
+    IN CONST BYTE *Value OPTIONAL,
+    IN DWORD ValueCb,
+    IN DWORD Flags,
+    IN PBLG_DER_SEARCH_ROUTINE SearchRoutine OPTIONAL,
+    IN PVOID Context,
+    OUT PDWORD MatchCount OPTIONAL
+    )
+
+/*++
+
+Routine Description:
+
+    Searches encoded data for a node with the specified tag and content octets without decoding
+    the data.
+
+    The data is first scanned for the encoded node as a plain byte string. Sixteen positions
+    are tested at once for the first identifier octet and, at the proper distance, the last
+    octet of the node; only the positions that pass both tests are compared in full. Each such
+    candidate is then checked to start a node of the encoded data and not to lie within the
+    content octets of a primitive node or within identifier or length octets. The data may hold
+    any number of consecutive top level nodes.
+
+Arguments:
+
+    Encoded - Pointer to a buffer containing the encoded data.
+
+    EncodedCb - Size, in bytes, of the encoded data pointed to by the Encoded parameter.
+
+    Class - Class of the node searched for.
+
+    Constructed - Whether the node searched for is constructed.
+
+    Tag - Tag of the node searched for.
+
+    Value - Pointer to the content octets of the node searched for.
+
+    ValueCb - Size, in bytes, of the content octets pointed to by the Value parameter.
+
+    Flags - Additional settings for the search. BLG_DER_SEARCH_FLAG_UNVERIFIED skips the
+        structural check and reports every occurrence of the encoded node.
+
+    SearchRoutine - Optional routine to be called for each match, in ascending order of offset.
+        If the routine returns FALSE, the search stops and fails.
+
+    Context - Pointer to the caller defined context value to be passed to the search routine.
+
+    MatchCount - Pointer to a variable that receives the number of matches reported.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The search does not fail on malformed data,
+    but candidates after the first malformed node met by the structural check are not reported.
+
+--*/
+
+{
+    BLGP_DER_SEARCH Search;
+    CONST BYTE *Ptr, *End;
+    DWORD NodeCb, Last;
+    BYTE FirstOctet, LastOctet;
+
+    if (MatchCount)
+    {
+        *MatchCount = 0;
+    }
+
+    if ((!Encoded && EncodedCb != 0) || (!Value && ValueCb != 0) || Class > BLG_DER_CLASS_PRIVATE ||
+        (Flags & ~BLG_DER_SEARCH_FLAG_UNVERIFIED) != 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    Search.HeaderCb = BlgpWriteTag(Search.Header, Class, Constructed, Tag);
+    Search.HeaderCb += BlgpWriteLen(Search.Header + Search.HeaderCb, ValueCb);
+    Search.Value = Value;
+    Search.ValueCb = ValueCb;
+    Search.Flags = Flags;
+    Search.SearchRoutine = SearchRoutine;
+    Search.Context = Context;
+    Search.MatchCount = 0;
+
+    Search.Cursor.Encoded = Encoded;
+    Search.Cursor.EncodedCb = EncodedCb;
+    Search.Cursor.Next = Encoded;
+    Search.Cursor.Depth = 0;
+    Search.Cursor.Malformed = FALSE;
+
+    if ((ULONGLONG) Search.HeaderCb + ValueCb > EncodedCb)
+    {
+        return TRUE;
+    }
+
+    NodeCb = Search.HeaderCb + ValueCb;
+    Last = NodeCb - 1;
+
+    FirstOctet = Search.Header[0];
+    LastOctet = ValueCb != 0 ? Value[ValueCb - 1] : Search.Header[Search.HeaderCb - 1];
+
+    // Candidates start at or before End.
+    Ptr = Encoded;
+    End = Encoded + (EncodedCb - NodeCb);
+
+#ifdef BLGP_SSE2
+    {
+        __m128i First = _mm_set1_epi8((CHAR) FirstOctet);
+        __m128i LastBlock = _mm_set1_epi8((CHAR) LastOctet);
+        unsigned long Index;
+        DWORD Mask;
+
+        for (; End - Ptr >= 16; Ptr += 16)
+        {
+            Mask = _mm_movemask_epi8(_mm_and_si128(
+                _mm_cmpeq_epi8(_mm_loadu_si128((CONST __m128i *) Ptr), First),
+                _mm_cmpeq_epi8(_mm_loadu_si128((CONST __m128i *) (Ptr + Last)), LastBlock)));
+
+            while (Mask != 0)
+            {
+                _BitScanForward(&Index, Mask);
+
+                if (!BlgpSearchCandidate(&Search, Ptr + Index))
+                {
+                    return FALSE;
+                }
+
+                Mask &= Mask - 1;
+            }
+        }
+    }
+#endif
+
+    for (; Ptr <= End; Ptr++)
+    {
+        if (*Ptr == FirstOctet && Ptr[Last] == LastOctet && !BlgpSearchCandidate(&Search, Ptr))
+        {
+            return FALSE;
+        }
+    }
+
+    if (MatchCount)
+    {
+        *MatchCount = Search.MatchCount;
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpSearchCandidate(
+    IN PBLGP_DER_SEARCH Search,
+    IN CONST BYTE *Candidate
+    )
+
+/*++
+
+Routine Description:
+
+    Compares a candidate of the prefilter with the node searched for, checks that it starts a
+    node and reports it.
+
+Arguments:
+
+    Search - Pointer to the state of the search.
+
+    Candidate - Pointer to the candidate. The whole node fits in the encoded data.
+
+Return Value:
+
+    FALSE if the search routine stopped the search; otherwise, TRUE.
+
+--*/
+
+{
+    if (!RtlEqualMemory(Candidate, Search->Header, Search->HeaderCb) ||
+        !RtlEqualMemory(Candidate + Search->HeaderCb, Search->Value, Search->ValueCb))
+    {
+        return TRUE;
+    }
+
+    if (!BLGASN1_FLAGON(Search->Flags, BLG_DER_SEARCH_FLAG_UNVERIFIED) &&
+        !BlgpLocateNode(&Search->Cursor, Candidate))
+    {
+        return TRUE;
+    }
+
+    Search->MatchCount++;
+
+    if (Search->SearchRoutine)
+    {
+        return Search->SearchRoutine((DWORD) (Candidate - Search->Cursor.Encoded),
+            BLGASN1_FLAGON(Search->Flags, BLG_DER_SEARCH_FLAG_UNVERIFIED) ? 0 : Search->Cursor.Depth,
+            Search->Context);
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpLocateNode(
+    IN PBLGP_DER_SEARCH_CURSOR Cursor,
+    IN CONST BYTE *Candidate
+    )
+
+/*++
+
+Routine Description:
+
+    Walks the encoded data up to a candidate and determines whether a node starts there. Nodes
+    that end before the candidate are skipped as a whole; constructed nodes containing it are
+    entered.
+
+Arguments:
+
+    Cursor - Pointer to the position of the walk. The candidate must not precede the candidate
+        of the previous call.
+
+    Candidate - Pointer to the candidate.
+
+Return Value:
+
+    TRUE if a node starts at the candidate; otherwise, FALSE. When the routine returns TRUE, the
+    depth of the cursor is the depth of the node.
+
+--*/
+
+{
+    BLGP_DER_DECODER_NODE Node;
+    CONST BYTE *End, *Limit;
+
+    if (Cursor->Malformed)
+    {
+        return FALSE;
+    }
+
+    for (;;)
+    {
+        // Leave the nodes that end at or before the candidate; the next node after each of them
+        // is its next sibling.
+        while (Cursor->Depth > 0 && Candidate >= Cursor->Ends[Cursor->Depth - 1])
+        {
+            Cursor->Next = Cursor->Ends[--Cursor->Depth];
+        }
+
+        if (Candidate <= Cursor->Next)
+        {
+            return Candidate == Cursor->Next;
+        }
+
+        if (!BlgpMoveToNode(Cursor->Encoded, Cursor->EncodedCb, Cursor->Next, &Node))
+        {
+            Cursor->Malformed = TRUE;
+
+            return FALSE;
+        }
+
+        End = Node.Value + Node.ValueCb;
+        Limit = Cursor->Depth > 0 ? Cursor->Ends[Cursor->Depth - 1] : Cursor->Encoded + Cursor->EncodedCb;
+
+        // A node must not extend past the node enclosing it.
+        if (End > Limit)
+        {
+            Cursor->Malformed = TRUE;
+
+            return FALSE;
+        }
+
+        if (Candidate >= End)
+        {
+            Cursor->Next = End;
+
+            continue;
+        }
+
+        // The candidate lies within this node. Only the content octets of a constructed node
+        // may hold another node.
+        if (!BLGASN1_FLAGON(*Node.Tag, 0x20) || Candidate < Node.Value ||
+            Cursor->Depth == BLGP_SEARCH_MAX_DEPTH)
+        {
+            return FALSE;
+        }
+
+        Cursor->Ends[Cursor->Depth++] = End;
+        Cursor->Next = Node.Value;
+    }
+}
\ No newline at end of file
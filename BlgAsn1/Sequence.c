@@ -142,4 +142,160 @@ Leave:
     BlgDerMoveToParent(Decoder);
 
     return IsOk;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceSpans(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_CHILD_NODE Nodes,
+    IN DWORD NodeCount,
+    OUT PBLG_DER_SPAN Spans,
+    OUT PULONGLONG PresentMask OPTIONAL
+    )
+
+/*++
+
+Routine Description:
+
+    Locates the child nodes of an ASN.1 SEQUENCE node in a single pass. Unlike BlgDerDecSequence,
+    the routine does not call back for the matched nodes; it records the content and the complete
+    encoding of each of them, so the caller can decode just the fields it needs. The identifier
+    octets of a child are compared with those built from the matching entry of the Nodes
+    parameter and are never decoded. The current node of the decoder is not changed.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder whose current node is the SEQUENCE node.
+
+    Nodes - Array of nodes allowed to appear in the sequence, in the order of their appearance.
+
+    NodeCount - Number of nodes in the Nodes parameter.
+
+    Spans - Pointer to an array of NodeCount elements that receives the location of each node.
+        The Present member of an element is FALSE and its spans are empty if an OPTIONAL node
+        is absent.
+
+    PresentMask - Optional pointer to a variable that receives a bit mask of the present nodes;
+        bit i is set if the node at index i is present. If this parameter is not NULL, NodeCount
+        must not exceed 64.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    CONST BYTE *Content, *Ptr, *End;
+    BLGP_DER_DECODER_NODE Node;
+    BOOL HasNode = FALSE;
+    ULONGLONG Mask = 0;
+    BYTE Octets[6];
+    DWORD ContentCb, OctetCount, i;
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    if ((!Nodes && NodeCount > 0) || !Spans || (PresentMask && NodeCount > 64))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    if (!BLGASN1_FLAGON(*Decoder->CurrentNode.Tag, 0x20))
+    {
+        SetLastError(ERROR_BLGASN1_PRIMITIVE);
+
+        return FALSE;
+    }
+
+    Content = Ptr = Decoder->CurrentNode.Value;
+    ContentCb = Decoder->CurrentNode.ValueCb;
+
+    End = Content + ContentCb;
+
+    for (i = 0; i < NodeCount; i++)
+    {
+        ZeroMemory(Spans + i, sizeof(BLG_DER_SPAN));
+
+        if (Nodes[i].Class > BLG_DER_CLASS_PRIVATE)
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        if (!HasNode && Ptr < End)
+        {
+            if (!BlgpMoveToNode(Content, ContentCb, Ptr, &Node))
+            {
+                return FALSE;
+            }
+
+            HasNode = TRUE;
+        }
+
+        if (HasNode)
+        {
+            OctetCount = BlgpWriteTag(Octets, Nodes[i].Class, (BOOLEAN) Nodes[i].Constructed, Nodes[i].Tag);
+
+            if ((DWORD) (Node.Value - Node.Tag) <= OctetCount || !RtlEqualMemory(Node.Tag, Octets, OctetCount))
+            {
+                if (!Nodes[i].Optional)
+                {
+                    SetLastError(ERROR_BLGASN1_CONSTRAINT);
+
+                    return FALSE;
+                }
+
+                // The node is compared with the next entry.
+                continue;
+            }
+        }
+        else
+        {
+            if (!Nodes[i].Optional)
+            {
+                SetLastError(ERROR_BLGASN1_UNEXP_EOD);
+
+                return FALSE;
+            }
+
+            continue;
+        }
+
+        Spans[i].Present = TRUE;
+        Spans[i].Value = Node.Value;
+        Spans[i].ValueCb = Node.ValueCb;
+        Spans[i].Encoded = Node.Tag;
+        Spans[i].EncodedCb = (DWORD) (Node.Value - Node.Tag) + Node.ValueCb;
+
+        if (i < 64)
+        {
+            Mask |= 1ULL << i;
+        }
+
+        Ptr = Node.Value + Node.ValueCb;
+
+        HasNode = FALSE;
+    }
+
+    if (Ptr < End)
+    {
+        SetLastError(ERROR_BLGASN1_BADTAG);
+
+        return FALSE;
+    }
+
+    if (PresentMask)
+    {
+        *PresentMask = Mask;
+    }
+
+    return TRUE;
 }
\ No newline at end of file
@@ -0,0 +1,1076 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+--*/
+
+#include <windows.h>
+
+#include "BlgAsn1.h"
+#include "BlgAsn1p.h"
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpBeginSequenceOf(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN ULONGLONG ContentCb,
+    OUT PBYTE *Ptr
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpGetSequenceOf(
+    IN PBLGP_DER_DECODER Decoder,
+    OUT CONST BYTE **Ptr,
+    OUT CONST BYTE **End
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpDecodeSequenceOfInteger(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN DWORD ValueCb,
+    OUT PVOID Values OPTIONAL,
+    IN OUT PDWORD Count
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncSequenceOfInt32(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST INT *Values,
+    IN DWORD Count
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncSequenceOfInt64(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST LONGLONG *Values,
+    IN DWORD Count
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncSequenceOfBool(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BOOLEAN *Values,
+    IN DWORD Count
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncSequenceOfOctetString(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BYTE *Values,
+    IN DWORD ValueCb,
+    IN DWORD Count
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncSequenceOfInt32,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, CONST INT *Values, DWORD Count),
+    (Encoder, Class, Tag, Values, Count));
+
+BLGP_DER_ENC_INSTANCES(BlgpEncSequenceOfInt64,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, CONST LONGLONG *Values, DWORD Count),
+    (Encoder, Class, Tag, Values, Count));
+
+BLGP_DER_ENC_INSTANCES(BlgpEncSequenceOfBool,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, CONST BOOLEAN *Values, DWORD Count),
+    (Encoder, Class, Tag, Values, Count));
+
+BLGP_DER_ENC_INSTANCES(BlgpEncSequenceOfOctetString,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, CONST BYTE *Values, DWORD ValueCb, DWORD Count),
+    (Encoder, Class, Tag, Values, ValueCb, Count));
+
+BOOL
+BLGASN1CALL
+BlgDerEncSequenceOfInt32(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST INT *Values,
+    IN DWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an array of 32 bit signed integers as an ASN.1 SEQUENCE OF INTEGER node.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Values - Pointer to the array of integers to be encoded.
+
+    Count - Number of integers in the array pointed to by the Values parameter.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || (!Values && Count > 0))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncSequenceOfInt32Instances[Encoder->Mode](Encoder, Class, Tag, Values, Count);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncSequenceOfInt64(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST LONGLONG *Values,
+    IN DWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an array of 64 bit signed integers as an ASN.1 SEQUENCE OF INTEGER node.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Values - Pointer to the array of integers to be encoded.
+
+    Count - Number of integers in the array pointed to by the Values parameter.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || (!Values && Count > 0))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncSequenceOfInt64Instances[Encoder->Mode](Encoder, Class, Tag, Values, Count);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncSequenceOfBool(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BOOLEAN *Values,
+    IN DWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an array of boolean values as an ASN.1 SEQUENCE OF BOOLEAN node.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Values - Pointer to the array of boolean values to be encoded.
+
+    Count - Number of values in the array pointed to by the Values parameter.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || (!Values && Count > 0))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncSequenceOfBoolInstances[Encoder->Mode](Encoder, Class, Tag, Values, Count);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncSequenceOfOctetString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BYTE *Values,
+    IN DWORD ValueCb,
+    IN DWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an array of fixed-size byte buffers as an ASN.1 SEQUENCE OF OCTET STRING node.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Values - Pointer to the contiguous array of buffers to be encoded.
+
+    ValueCb - Size, in bytes, of each buffer in the array pointed to by the Values parameter.
+
+    Count - Number of buffers in the array pointed to by the Values parameter.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || (!Values && Count > 0 && ValueCb > 0))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncSequenceOfOctetStringInstances[Encoder->Mode](Encoder, Class, Tag, Values, ValueCb, Count);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceOfInt32(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PINT Values OPTIONAL,
+    IN OUT PDWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 SEQUENCE OF INTEGER node into an array of 32 bit signed integers.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Values - Pointer to an array that receives the decoded integers.
+
+    Count - Pointer to a variable specifying the number of elements in the array. When the
+        routine returns, the variable contains the number of decoded integers.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    return BlgpDecodeSequenceOfInteger(DecoderHandle, sizeof(INT), Values, Count);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceOfInt64(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PLONGLONG Values OPTIONAL,
+    IN OUT PDWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 SEQUENCE OF INTEGER node into an array of 64 bit signed integers.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Values - Pointer to an array that receives the decoded integers.
+
+    Count - Pointer to a variable specifying the number of elements in the array. When the
+        routine returns, the variable contains the number of decoded integers.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    return BlgpDecodeSequenceOfInteger(DecoderHandle, sizeof(LONGLONG), Values, Count);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceOfBool(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBOOLEAN Values OPTIONAL,
+    IN OUT PDWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 SEQUENCE OF BOOLEAN node into an array of boolean values.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Values - Pointer to an array that receives the decoded boolean values.
+
+    Count - Pointer to a variable specifying the number of elements in the array. When the
+        routine returns, the variable contains the number of decoded values.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    BOOL Relaxed;
+    DWORD LocalCount, i;
+    CONST BYTE *Ptr, *End;
+
+    if (!Count)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        LocalCount = *Count; *Count = 0;
+    }
+
+    if (!BlgpGetSequenceOf(Decoder, &Ptr, &End))
+    {
+        return FALSE;
+    }
+
+    Relaxed = BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED);
+
+    // In DER every element is encoded in exactly three octets, so the element count is known
+    // before any element is examined. Relaxed encodings may use the long form for the length and
+    // are counted as they are parsed.
+    if (!Relaxed)
+    {
+        if ((End - Ptr) % 3 != 0)
+        {
+            SetLastError(ERROR_BLGASN1_CORRUPT);
+
+            return FALSE;
+        }
+
+        if (!Values)
+        {
+            *Count = (DWORD) ((End - Ptr) / 3);
+
+            return TRUE;
+        }
+
+        if ((DWORD) ((End - Ptr) / 3) > LocalCount)
+        {
+            *Count = (DWORD) ((End - Ptr) / 3);
+
+            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+            return FALSE;
+        }
+    }
+
+    for (i = 0; Ptr < End; i++)
+    {
+        BYTE Value;
+
+        if (End - Ptr >= 3 && Ptr[0] == BLG_DER_TAG_BOOLEAN && Ptr[1] == 1)
+        {
+            Value = Ptr[2];
+
+            Ptr += 3;
+        }
+        else if (Relaxed)
+        {
+            BLGP_DER_DECODER_NODE Node;
+
+            if (!BlgpMoveToNode(Ptr, (DWORD) (End - Ptr), Ptr, &Node))
+            {
+                return FALSE;
+            }
+
+            if (*Ptr != BLG_DER_TAG_BOOLEAN)
+            {
+                SetLastError(ERROR_BLGASN1_BADTAG);
+
+                return FALSE;
+            }
+
+            if (Node.ValueCb != 1)
+            {
+                SetLastError(ERROR_BLGASN1_CORRUPT);
+
+                return FALSE;
+            }
+
+            Value = *Node.Value;
+
+            Ptr = Node.Value + 1;
+        }
+        else
+        {
+            SetLastError(ERROR_BLGASN1_BADTAG);
+
+            return FALSE;
+        }
+
+        // If the BLG_DER_DEC_FLAG_RELAXED flag is not set, the value must be either 0 or 255.
+        if (Value != 0x00 && Value != 0xFF && !Relaxed)
+        {
+            SetLastError(ERROR_BLGASN1_CORRUPT);
+
+            return FALSE;
+        }
+
+        if (Values && i < LocalCount)
+        {
+            Values[i] = Value != 0x00;
+        }
+    }
+
+    *Count = i;
+
+    if (Values && i > LocalCount)
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecSequenceOfOctetString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PBYTE Values OPTIONAL,
+    IN DWORD ValueCb,
+    IN OUT PDWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 SEQUENCE OF OCTET STRING node whose elements all have the same size into
+    a contiguous array of buffers.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Values - Pointer to an array that receives the decoded buffers.
+
+    ValueCb - Size, in bytes, of each buffer in the array pointed to by the Values parameter.
+        An element with a different size is considered a constraint violation.
+
+    Count - Pointer to a variable specifying the number of buffers in the array. When the
+        routine returns, the variable contains the number of decoded buffers.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    BYTE Header[8];
+    DWORD HeaderCb, ElementCb, LocalCount, i;
+    CONST BYTE *Ptr, *End;
+
+    if (!Count)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        LocalCount = *Count; *Count = 0;
+    }
+
+    if (!BlgpGetSequenceOf(Decoder, &Ptr, &End))
+    {
+        return FALSE;
+    }
+
+    // In DER every element has the same identifier and length octets, so each element can be
+    // matched with a single comparison. Relaxed encodings fall back to the generic node parser.
+    Header[0] = BLG_DER_TAG_OCTET_STRING;
+
+    HeaderCb = BlgpWriteLen(Header + 1, ValueCb) + 1;
+    ElementCb = HeaderCb + ValueCb;
+
+    for (i = 0; Ptr < End; i++)
+    {
+        CONST BYTE *Value;
+
+        if ((DWORD) (End - Ptr) >= ElementCb && RtlEqualMemory(Ptr, Header, HeaderCb))
+        {
+            Value = Ptr + HeaderCb;
+        }
+        else
+        {
+            BLGP_DER_DECODER_NODE Node;
+
+            if (!BlgpMoveToNode(Ptr, (DWORD) (End - Ptr), Ptr, &Node))
+            {
+                return FALSE;
+            }
+
+            if (*Ptr != BLG_DER_TAG_OCTET_STRING)
+            {
+                SetLastError(ERROR_BLGASN1_BADTAG);
+
+                return FALSE;
+            }
+
+            if (Node.ValueCb != ValueCb || !BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED))
+            {
+                SetLastError(Node.ValueCb != ValueCb ? ERROR_BLGASN1_CONSTRAINT : ERROR_BLGASN1_CORRUPT);
+
+                return FALSE;
+            }
+
+            Value = Node.Value;
+        }
+
+        if (Values && i < LocalCount)
+        {
+            CopyMemory(Values + (SIZE_T) i * ValueCb, Value, ValueCb);
+        }
+
+        Ptr = Value + ValueCb;
+    }
+
+    *Count = i;
+
+    if (Values && i > LocalCount)
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpBeginSequenceOf(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN ULONGLONG ContentCb,
+    OUT PBYTE *Ptr
+    )
+
+/*++
+
+Routine Description:
+
+    Reserves a SEQUENCE OF node with its whole content and encodes the identifier and length
+    octets of the node.
+
+Arguments:
+
+    Mode - Mode of the encoder.
+
+    ContentCb - Size, in bytes, of the content of the node.
+
+    Ptr - Pointer to a variable that receives the position of the content in the buffer, or
+        NULL if the encoder only calculates the encoded size.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    *Ptr = NULL;
+
+    if (ContentCb > MAXDWORD)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        return FALSE;
+    }
+
+    return BlgpReserveNode(Mode, Encoder, Class, TRUE,
+        (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0) ? BLG_DER_TAG_SEQUENCE_OF : Tag, (DWORD) ContentCb, Ptr);
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpGetSequenceOf(
+    IN PBLGP_DER_DECODER Decoder,
+    OUT CONST BYTE **Ptr,
+    OUT CONST BYTE **End
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the content of the current node, which must be constructed.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    if (!BLGASN1_FLAGON(*Decoder->CurrentNode.Tag, 0x20))
+    {
+        SetLastError(ERROR_BLGASN1_PRIMITIVE);
+
+        return FALSE;
+    }
+
+    *Ptr = Decoder->CurrentNode.Value;
+    *End = Decoder->CurrentNode.Value + Decoder->CurrentNode.ValueCb;
+
+    return TRUE;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpDecodeSequenceOfInteger(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN DWORD ValueCb,
+    OUT PVOID Values OPTIONAL,
+    IN OUT PDWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 SEQUENCE OF INTEGER node into an array of signed integers.
+
+Arguments:
+
+    ValueCb - Size, in bytes, of the array elements. Must be either 4 or 8.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    DWORD LocalCount, i;
+    CONST BYTE *Ptr, *End;
+
+    if (!Count)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        LocalCount = *Count; *Count = 0;
+    }
+
+    if (!BlgpGetSequenceOf(Decoder, &Ptr, &End))
+    {
+        return FALSE;
+    }
+
+    for (i = 0; Ptr < End; i++)
+    {
+        ULONGLONG Value;
+        CONST BYTE *Content;
+        DWORD ContentCb;
+
+        if (End - Ptr >= 2 && (CHAR) Ptr[1] < 0 && BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED))
+        {
+            BLGP_DER_DECODER_NODE Node;
+
+            // Relaxed encodings may use the long form for the length, so the element is parsed
+            // as a whole.
+            if (!BlgpMoveToNode(Ptr, (DWORD) (End - Ptr), Ptr, &Node))
+            {
+                return FALSE;
+            }
+
+            Content = Node.Value;
+            ContentCb = Node.ValueCb;
+        }
+        else
+        {
+            // The content of an integer fitting into 64 bits is at most nine octets long, so in
+            // DER the length is always encoded in the short form.
+            if (End - Ptr < 2 || (DWORD) (End - Ptr - 2) < Ptr[1])
+            {
+                SetLastError(ERROR_BLGASN1_UNEXP_EOD);
+
+                return FALSE;
+            }
+
+            if ((CHAR) Ptr[1] < 0)
+            {
+                SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+                return FALSE;
+            }
+
+            Content = Ptr + 2;
+            ContentCb = Ptr[1];
+        }
+
+        if (Ptr[0] != BLG_DER_TAG_INTEGER)
+        {
+            SetLastError(ERROR_BLGASN1_BADTAG);
+
+            return FALSE;
+        }
+
+        if (Values && i < LocalCount)
+        {
+            if (!BlgpReadInteger(Decoder->Encoded, Content, ContentCb, TRUE, &Value))
+            {
+                return FALSE;
+            }
+
+            if (ValueCb == sizeof(INT))
+            {
+                if ((LONGLONG) Value < MININT || (LONGLONG) Value > MAXINT)
+                {
+                    SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+                    return FALSE;
+                }
+
+                ((PINT) Values)[i] = (INT) (LONGLONG) Value;
+            }
+            else
+            {
+                ((PLONGLONG) Values)[i] = (LONGLONG) Value;
+            }
+        }
+
+        Ptr = Content + ContentCb;
+    }
+
+    *Count = i;
+
+    if (Values && i > LocalCount)
+    {
+        SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncSequenceOfInt32(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST INT *Values,
+    IN DWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an array of 32 bit signed integers as an ASN.1 SEQUENCE OF node in the specified mode.
+
+--*/
+
+{
+    ULONGLONG ContentCb = 0;
+    CONST BYTE *End;
+    PBYTE Ptr;
+    DWORD i;
+
+    for (i = 0; i < Count; i++)
+    {
+        ContentCb += BlgpIntOctetCount64(Values[i]) + 2;
+    }
+
+    if (!BlgpBeginSequenceOf(Mode, Encoder, Class, Tag, ContentCb, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        End = BlgpWritableEnd(Mode, Encoder);
+
+        for (i = 0; i < Count; i++)
+        {
+            DWORD OctetCount = BlgpIntOctetCount64(Values[i]);
+
+            Ptr[0] = BLG_DER_TAG_INTEGER;
+            Ptr[1] = (BYTE) OctetCount;
+
+            BlgpWriteInt64(Ptr + 2, End, (ULONGLONG) (LONGLONG) Values[i], OctetCount);
+
+            Ptr += OctetCount + 2;
+        }
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncSequenceOfInt64(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST LONGLONG *Values,
+    IN DWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an array of 64 bit signed integers as an ASN.1 SEQUENCE OF node in the specified mode.
+
+--*/
+
+{
+    ULONGLONG ContentCb = 0;
+    CONST BYTE *End;
+    PBYTE Ptr;
+    DWORD i;
+
+    for (i = 0; i < Count; i++)
+    {
+        ContentCb += BlgpIntOctetCount64(Values[i]) + 2;
+    }
+
+    if (!BlgpBeginSequenceOf(Mode, Encoder, Class, Tag, ContentCb, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        End = BlgpWritableEnd(Mode, Encoder);
+
+        for (i = 0; i < Count; i++)
+        {
+            DWORD OctetCount = BlgpIntOctetCount64(Values[i]);
+
+            Ptr[0] = BLG_DER_TAG_INTEGER;
+            Ptr[1] = (BYTE) OctetCount;
+
+            BlgpWriteInt64(Ptr + 2, End, (ULONGLONG) Values[i], OctetCount);
+
+            Ptr += OctetCount + 2;
+        }
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncSequenceOfBool(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BOOLEAN *Values,
+    IN DWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an array of boolean values as an ASN.1 SEQUENCE OF node in the specified mode.
+
+--*/
+
+{
+    ULONGLONG ContentCb = (ULONGLONG) Count * 3;
+    PBYTE Ptr;
+    DWORD i;
+
+    if (!BlgpBeginSequenceOf(Mode, Encoder, Class, Tag, ContentCb, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        for (i = 0; i < Count; i++, Ptr += 3)
+        {
+            Ptr[0] = BLG_DER_TAG_BOOLEAN;
+            Ptr[1] = 1;
+            Ptr[2] = Values[i] ? 0xFF : 0x00;
+        }
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncSequenceOfOctetString(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN CONST BYTE *Values,
+    IN DWORD ValueCb,
+    IN DWORD Count
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an array of fixed-size byte buffers as an ASN.1 SEQUENCE OF node in the specified mode.
+
+--*/
+
+{
+    BYTE Header[8];
+    DWORD HeaderCb, i;
+    ULONGLONG ContentCb;
+    PBYTE Ptr;
+
+    // Every element has the same identifier and length octets, so they are built only once.
+    Header[0] = BLG_DER_TAG_OCTET_STRING;
+
+    HeaderCb = BlgpWriteLen(Header + 1, ValueCb) + 1;
+
+    ContentCb = (ULONGLONG) Count * ((ULONGLONG) HeaderCb + ValueCb);
+
+    if (!BlgpBeginSequenceOf(Mode, Encoder, Class, Tag, ContentCb, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        for (i = 0; i < Count; i++)
+        {
+            CopyMemory(Ptr, Header, HeaderCb);
+            CopyMemory(Ptr + HeaderCb, Values, ValueCb);
+
+            Ptr += HeaderCb + ValueCb;
+            Values += ValueCb;
+        }
+    }
+
+    return TRUE;
+}
\ No newline at end of file
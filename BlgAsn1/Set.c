@@ -0,0 +1,384 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+--*/
+
+#include <windows.h>
+
+#include "BlgAsn1.h"
+#include "BlgAsn1p.h"
+
+// Number of members whose identifier octets BlgDerDecSet builds on the stack.
+#define BLGP_SET_INLINE_MEMBERS 16
+
+// Finds the member of a set that carries the identifier octets of a node.
+typedef struct _BLGP_SET_MEMBERS
+{
+    PCBLG_DER_CHILD_NODE Nodes;
+    DWORD NodeCount;
+
+    // Dispatcher holding the members, or NULL if the identifier octets below are used.
+    HBLG_DER_CHOICE Choice;
+
+    BYTE Octets[BLGP_SET_INLINE_MEMBERS][6];
+    BYTE OctetCounts[BLGP_SET_INLINE_MEMBERS];
+
+} BLGP_SET_MEMBERS, *PBLGP_SET_MEMBERS;
+
+static
+BOOL
+BLGASN1CALL
+BlgpDecodeSet(
+    IN PBLGP_DER_DECODER Decoder,
+    IN CONST BLGP_SET_MEMBERS *Members,
+    OUT PBLG_DER_SPAN Spans,
+    OUT PULONGLONG PresentMask OPTIONAL
+    );
+
+static
+DWORD
+BLGASN1CALL
+BlgpFindSetMember(
+    IN CONST BLGP_SET_MEMBERS *Members,
+    IN CONST BLGP_DER_DECODER_NODE *Node
+    );
+
+BOOL
+BLGASN1CALL
+BlgDerDecSet(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_CHILD_NODE Nodes,
+    IN DWORD NodeCount,
+    OUT PBLG_DER_SPAN Spans,
+    OUT PULONGLONG PresentMask OPTIONAL
+    )
+
+/*++
+
+Routine Description:
+
+    Locates the members of an ASN.1 SET node in a single pass. Every child node is assigned to
+    the member carrying its identifier octets regardless of its position. The identifier octets
+    of up to 16 members are built on the stack; larger sets are placed in a
+    temporary dispatcher. Sets decoded repeatedly should use BlgDerDecSetEx with a dispatcher
+    created once.
+
+    DER requires the members to appear in ascending order of their tags. Unless the decoder was
+    created with the BLG_DER_DEC_FLAG_RELAXED flag, members in a different order are rejected
+    with ERROR_BLGASN1_CORRUPT. The current node of the decoder is not changed.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder whose current node is the SET node.
+
+    Nodes - Array of the members of the set. The array does not need to be sorted.
+
+    NodeCount - Number of members in the Nodes parameter.
+
+    Spans - Pointer to an array of NodeCount elements that receives the location of each member.
+        The Present member of an element is FALSE and its spans are empty if an OPTIONAL member
+        is absent.
+
+    PresentMask - Optional pointer to a variable that receives a bit mask of the present members;
+        bit i is set if the member at index i is present. If this parameter is not NULL, NodeCount
+        must not exceed 64.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_BLGASN1_BADTAG
+    if a child node is not a member of the set, with ERROR_BLGASN1_DUPLICATE if a member appears
+    more than once and with ERROR_BLGASN1_MISSING if a member that is not OPTIONAL is absent.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    BLGP_SET_MEMBERS Members;
+    BOOL IsOk;
+    DWORD i, j;
+
+    if ((!Nodes && NodeCount > 0) || (PresentMask && NodeCount > 64))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    Members.Nodes = Nodes;
+    Members.NodeCount = NodeCount;
+    Members.Choice = NULL;
+
+    if (NodeCount > BLGP_SET_INLINE_MEMBERS)
+    {
+        Members.Choice = BlgDerCreateChoice(Nodes, NodeCount);
+        if (!Members.Choice)
+        {
+            return FALSE;
+        }
+    }
+    else
+    {
+        for (i = 0; i < NodeCount; i++)
+        {
+            if (Nodes[i].Class > BLG_DER_CLASS_PRIVATE)
+            {
+                SetLastError(ERROR_INVALID_PARAMETER);
+
+                return FALSE;
+            }
+
+            Members.OctetCounts[i] = (BYTE) BlgpWriteTag(Members.Octets[i], Nodes[i].Class,
+                (BOOLEAN) Nodes[i].Constructed, Nodes[i].Tag);
+
+            // As with BlgDerCreateChoice, two members must not have the same tag.
+            for (j = 0; j < i; j++)
+            {
+                if (Members.OctetCounts[j] == Members.OctetCounts[i] &&
+                    RtlEqualMemory(Members.Octets[j], Members.Octets[i], Members.OctetCounts[i]))
+                {
+                    SetLastError(ERROR_INVALID_PARAMETER);
+
+                    return FALSE;
+                }
+            }
+        }
+    }
+
+    IsOk = BlgpDecodeSet(Decoder, &Members, Spans, PresentMask);
+
+    if (Members.Choice)
+    {
+        BlgDerDestroyChoice(Members.Choice);
+    }
+
+    return IsOk;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecSetEx(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN HBLG_DER_CHOICE ChoiceHandle,
+    OUT PBLG_DER_SPAN Spans,
+    OUT PULONGLONG PresentMask OPTIONAL
+    )
+
+/*++
+
+Routine Description:
+
+    Locates the members of an ASN.1 SET node in a single pass, looking up the members in a
+    dispatcher created once by BlgDerCreateChoice. Apart from that the routine behaves like
+    BlgDerDecSet; the Optional member of the elements passed to BlgDerCreateChoice marks the
+    OPTIONAL members of the set.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder whose current node is the SET node.
+
+    ChoiceHandle - Handle to the dispatcher created by BlgDerCreateChoice for the members of the
+        set.
+
+    Spans - Pointer to an array that receives the location of each member, with as many elements
+        as there are members in the dispatcher.
+
+    PresentMask - Optional pointer to a variable that receives a bit mask of the present members;
+        bit i is set if the member at index i is present. If this parameter is not NULL, the set
+        must not have more than 64 members.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The errors are those of BlgDerDecSet.
+
+--*/
+
+{
+    BLGP_SET_MEMBERS Members;
+
+    if (!ChoiceHandle)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    Members.Nodes = BlgpGetChoiceNodes(ChoiceHandle, &Members.NodeCount);
+    Members.Choice = ChoiceHandle;
+
+    if (PresentMask && Members.NodeCount > 64)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpDecodeSet((PBLGP_DER_DECODER) DecoderHandle, &Members, Spans, PresentMask);
+}
+
+BOOL
+BLGASN1CALL
+BlgpDecodeSet(
+    IN PBLGP_DER_DECODER Decoder,
+    IN CONST BLGP_SET_MEMBERS *Members,
+    OUT PBLG_DER_SPAN Spans,
+    OUT PULONGLONG PresentMask OPTIONAL
+    )
+
+/*++
+
+Routine Description:
+
+    Assigns the child nodes of the current node of a decoder to the members of a set.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    CONST BYTE *Content, *Ptr, *End;
+    BLGP_DER_DECODER_NODE Node;
+    PCBLG_DER_CHILD_NODE Previous = NULL, Member;
+    BOOL Relaxed;
+    ULONGLONG Mask = 0;
+    DWORD ContentCb, Found, i;
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    if (!Spans)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    if (!BLGASN1_FLAGON(*Decoder->CurrentNode.Tag, 0x20))
+    {
+        SetLastError(ERROR_BLGASN1_PRIMITIVE);
+
+        return FALSE;
+    }
+
+    ZeroMemory(Spans, Members->NodeCount * sizeof(BLG_DER_SPAN));
+
+    Content = Ptr = Decoder->CurrentNode.Value;
+    ContentCb = Decoder->CurrentNode.ValueCb;
+
+    End = Content + ContentCb;
+
+    Relaxed = BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED);
+
+    while (Ptr < End)
+    {
+        if (!BlgpMoveToNode(Content, ContentCb, Ptr, &Node))
+        {
+            return FALSE;
+        }
+
+        if ((Found = BlgpFindSetMember(Members, &Node)) == 0)
+        {
+            SetLastError(ERROR_BLGASN1_BADTAG);
+
+            return FALSE;
+        }
+
+        i = Found - 1;
+        Member = Members->Nodes + i;
+
+        if (Spans[i].Present)
+        {
+            SetLastError(ERROR_BLGASN1_DUPLICATE);
+
+            return FALSE;
+        }
+
+        // The members are ordered by class first and then by tag number.
+        if (!Relaxed && Previous &&
+            (Member->Class < Previous->Class || (Member->Class == Previous->Class && Member->Tag < Previous->Tag)))
+        {
+            SetLastError(ERROR_BLGASN1_CORRUPT);
+
+            return FALSE;
+        }
+
+        Previous = Member;
+
+        Spans[i].Present = TRUE;
+        Spans[i].Value = Node.Value;
+        Spans[i].ValueCb = Node.ValueCb;
+        Spans[i].Encoded = Node.Tag;
+        Spans[i].EncodedCb = (DWORD) (Node.Value - Node.Tag) + Node.ValueCb;
+
+        if (i < 64)
+        {
+            Mask |= 1ULL << i;
+        }
+
+        Ptr = Node.Value + Node.ValueCb;
+    }
+
+    for (i = 0; i < Members->NodeCount; i++)
+    {
+        if (!Spans[i].Present && !Members->Nodes[i].Optional)
+        {
+            SetLastError(ERROR_BLGASN1_MISSING);
+
+            return FALSE;
+        }
+    }
+
+    if (PresentMask)
+    {
+        *PresentMask = Mask;
+    }
+
+    return TRUE;
+}
+
+DWORD
+BLGASN1CALL
+BlgpFindSetMember(
+    IN CONST BLGP_SET_MEMBERS *Members,
+    IN CONST BLGP_DER_DECODER_NODE *Node
+    )
+
+/*++
+
+Routine Description:
+
+    Finds the member of a set that carries the identifier octets of a node. Identifier octets
+    are never a prefix of other identifier octets, so comparing the octets of a member with the
+    start of the node is enough.
+
+Return Value:
+
+    Index of the member plus one, or zero if the node does not carry the tag of a member.
+
+--*/
+
+{
+    DWORD HeaderCb = (DWORD) (Node->Value - Node->Tag), i;
+
+    if (Members->Choice)
+    {
+        return BlgpLookupChoice(Members->Choice, Node);
+    }
+
+    for (i = 0; i < Members->NodeCount; i++)
+    {
+        if (Members->Octets[i][0] == Node->Tag[0] && Members->OctetCounts[i] < HeaderCb &&
+            RtlEqualMemory(Members->Octets[i], Node->Tag, Members->OctetCounts[i]))
+        {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
\ No newline at end of file
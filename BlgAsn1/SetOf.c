@@ -0,0 +1,423 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+--*/
+
+#include <windows.h>
+
+#include "BlgAsn1.h"
+#include "BlgAsn1p.h"
+
+// Partitions with fewer elements are sorted by insertion.
+#define BLGP_SORT_THRESHOLD 16
+
+typedef struct _BLGP_DER_ELEMENT
+{
+    DWORD Offset;
+    DWORD Cb;
+
+} BLGP_DER_ELEMENT, *PBLGP_DER_ELEMENT;
+
+static
+INT
+BLGASN1CALL
+BlgpCompareElements(
+    IN CONST BYTE *Base,
+    IN CONST BLGP_DER_ELEMENT *First,
+    IN CONST BLGP_DER_ELEMENT *Second
+    );
+
+static
+VOID
+BLGASN1CALL
+BlgpSortElements(
+    IN CONST BYTE *Base,
+    IN OUT PBLGP_DER_ELEMENT Elements,
+    IN DWORD Count,
+    IN DWORD DepthLimit
+    );
+
+static
+VOID
+BLGASN1CALL
+BlgpHeapSortElements(
+    IN CONST BYTE *Base,
+    IN OUT PBLGP_DER_ELEMENT Elements,
+    IN DWORD Count
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEndSetOf(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEndSetOf, (PBLGP_DER_ENCODER Encoder), (Encoder));
+
+BOOL
+BLGASN1CALL
+BlgDerEndSetOf(
+    IN HBLG_DER_ENCODER EncoderHandle
+    )
+
+/*++
+
+Routine Description:
+
+    Ends the encoding of a constructed node holding the elements of an ASN.1 SET OF. DER requires
+    the elements to appear in ascending order of their encodings, so the elements encoded since
+    the node was begun are sorted in place before the node is ended as by BlgDerEndConstructed.
+
+    Already sorted elements are detected in a single pass and left untouched. Otherwise an array
+    of element offsets is sorted by introsort and the elements are rearranged through a copy of
+    the content octets. With a checked encoder, the free part of the buffer beyond the encoded
+    data serves as scratch space and memory is only allocated if it is too small; an unchecked
+    encoder always allocates the scratch space.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_INVALID_STATE if
+    a template slot was marked inside the node.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEndSetOfInstances[Encoder->Mode](Encoder);
+}
+
+static
+INT
+BLGASN1CALL
+BlgpCompareElements(
+    IN CONST BYTE *Base,
+    IN CONST BLGP_DER_ELEMENT *First,
+    IN CONST BLGP_DER_ELEMENT *Second
+    )
+
+/*++
+
+Routine Description:
+
+    Compares the encodings of two elements as octet strings. A shorter encoding is treated as if
+    it were padded with zero octets, so it never sorts after a longer one with the same prefix.
+
+--*/
+
+{
+    INT Result = memcmp(Base + First->Offset, Base + Second->Offset, First->Cb < Second->Cb ? First->Cb : Second->Cb);
+
+    if (Result != 0)
+    {
+        return Result;
+    }
+
+    return First->Cb < Second->Cb ? -1 : (First->Cb > Second->Cb ? 1 : 0);
+}
+
+static
+VOID
+BLGASN1CALL
+BlgpSortElements(
+    IN CONST BYTE *Base,
+    IN OUT PBLGP_DER_ELEMENT Elements,
+    IN DWORD Count,
+    IN DWORD DepthLimit
+    )
+
+/*++
+
+Routine Description:
+
+    Sorts elements by introsort. Partitions are split around the median of three elements; the
+    smaller partition is sorted recursively and the larger one iteratively, which bounds the
+    recursion depth. If partitioning degrades, the rest is sorted by heapsort.
+
+--*/
+
+{
+    BLGP_DER_ELEMENT Pivot, Temp;
+    DWORD Low, High, Middle, i, j;
+
+    while (Count > BLGP_SORT_THRESHOLD)
+    {
+        if (DepthLimit-- == 0)
+        {
+            BlgpHeapSortElements(Base, Elements, Count);
+
+            return;
+        }
+
+        Low = 0;
+        High = Count - 1;
+        Middle = Count / 2;
+
+        // Order the first, middle and last elements; the median becomes the pivot.
+        if (BlgpCompareElements(Base, Elements + Middle, Elements + Low) < 0)
+        {
+            Temp = Elements[Middle]; Elements[Middle] = Elements[Low]; Elements[Low] = Temp;
+        }
+
+        if (BlgpCompareElements(Base, Elements + High, Elements + Middle) < 0)
+        {
+            Temp = Elements[High]; Elements[High] = Elements[Middle]; Elements[Middle] = Temp;
+
+            if (BlgpCompareElements(Base, Elements + Middle, Elements + Low) < 0)
+            {
+                Temp = Elements[Middle]; Elements[Middle] = Elements[Low]; Elements[Low] = Temp;
+            }
+        }
+
+        Pivot = Elements[Middle];
+
+        i = Low;
+        j = High;
+
+        // Hoare partitioning; the first and last elements act as sentinels.
+        for (;;)
+        {
+            while (BlgpCompareElements(Base, Elements + ++i, &Pivot) < 0);
+            while (BlgpCompareElements(Base, &Pivot, Elements + --j) < 0);
+
+            if (i >= j)
+            {
+                break;
+            }
+
+            Temp = Elements[i]; Elements[i] = Elements[j]; Elements[j] = Temp;
+        }
+
+        // Elements [0, j] are not greater and elements [j + 1, Count) are not less than the pivot.
+        if (j + 1 < Count - j - 1)
+        {
+            BlgpSortElements(Base, Elements, j + 1, DepthLimit);
+
+            Elements += j + 1;
+            Count -= j + 1;
+        }
+        else
+        {
+            BlgpSortElements(Base, Elements + j + 1, Count - j - 1, DepthLimit);
+
+            Count = j + 1;
+        }
+    }
+
+    for (i = 1; i < Count; i++)
+    {
+        Temp = Elements[i];
+
+        for (j = i; j > 0 && BlgpCompareElements(Base, &Temp, Elements + j - 1) < 0; j--)
+        {
+            Elements[j] = Elements[j - 1];
+        }
+
+        Elements[j] = Temp;
+    }
+}
+
+static
+VOID
+BLGASN1CALL
+BlgpHeapSortElements(
+    IN CONST BYTE *Base,
+    IN OUT PBLGP_DER_ELEMENT Elements,
+    IN DWORD Count
+    )
+{
+    BLGP_DER_ELEMENT Temp;
+    DWORD Start, End, Root, Child;
+
+    for (Start = Count / 2, End = Count; End > 1; )
+    {
+        if (Start > 0)
+        {
+            Start--;
+        }
+        else
+        {
+            End--;
+
+            Temp = Elements[End]; Elements[End] = Elements[0]; Elements[0] = Temp;
+        }
+
+        // Sift the root of the heap down.
+        for (Root = Start; (Child = Root * 2 + 1) < End; Root = Child)
+        {
+            if (Child + 1 < End && BlgpCompareElements(Base, Elements + Child, Elements + Child + 1) < 0)
+            {
+                Child++;
+            }
+
+            if (BlgpCompareElements(Base, Elements + Root, Elements + Child) >= 0)
+            {
+                break;
+            }
+
+            Temp = Elements[Root]; Elements[Root] = Elements[Child]; Elements[Child] = Temp;
+        }
+    }
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEndSetOf(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder
+    )
+
+/*++
+
+Routine Description:
+
+    Ends the encoding of a SET OF node in the specified mode.
+
+--*/
+
+{
+    PBLGP_DER_ELEMENT Elements;
+    BLGP_DER_ELEMENT Previous, Current;
+    BLGP_DER_DECODER_NODE Node;
+    CONST BYTE *Ptr, *End;
+    PBYTE Content, Scratch, Copy, Allocated = NULL;
+    SIZE_T ScratchCb, RequiredCb, FreeCb;
+    DWORD ContentCb, Count = 0, DepthLimit, i;
+    BOOL IsSorted = TRUE;
+
+    if (!Encoder->Stack.Next)
+    {
+        SetLastError(ERROR_INVALID_STATE);
+
+        return FALSE;
+    }
+
+    Content = CONTAINING_RECORD(Encoder->Stack.Next, BLGP_DER_ENCODER_NODE, Link)->ValueOffset;
+    ContentCb = (DWORD) (Encoder->Ptr - Content);
+
+    // The elements are reordered by value, so they cannot hold the slots of a template.
+    if (Encoder->SlotCount > 0 && Encoder->Slots[Encoder->SlotCount - 1].Offset >= (DWORD) (Content - Encoder->Buffer))
+    {
+        SetLastError(ERROR_INVALID_STATE);
+
+        return FALSE;
+    }
+
+    // Nothing is written while the size of the encoding is measured.
+    if (Mode == BLGP_DER_ENC_MODE_MEASURE)
+    {
+        return BlgDerEndConstructed((HBLG_DER_ENCODER) Encoder);
+    }
+
+    End = Content + ContentCb;
+
+    for (Ptr = Content; Ptr < End; Ptr = Node.Value + Node.ValueCb)
+    {
+        if (!BlgpMoveToNode(Content, ContentCb, Ptr, &Node))
+        {
+            return FALSE;
+        }
+
+        Current.Offset = (DWORD) (Ptr - Content);
+        Current.Cb = (DWORD) (Node.Value + Node.ValueCb - Ptr);
+
+        if (Count > 0 && IsSorted && BlgpCompareElements(Content, &Previous, &Current) > 0)
+        {
+            IsSorted = FALSE;
+        }
+
+        Previous = Current;
+
+        Count++;
+    }
+
+    if (IsSorted)
+    {
+        return BlgDerEndConstructed((HBLG_DER_ENCODER) Encoder);
+    }
+
+    RequiredCb = Count * sizeof(BLGP_DER_ELEMENT) + ContentCb;
+
+    // Only a checked encoder keeps its data within the buffer size, so an unchecked one has no known
+    // free space and the scratch space is always allocated. The scratch space is aligned for the
+    // element array.
+    Scratch = (PBYTE) (((ULONG_PTR) Encoder->Ptr + sizeof(DWORD) - 1) & ~(ULONG_PTR) (sizeof(DWORD) - 1));
+    ScratchCb = 0;
+
+    if (Mode == BLGP_DER_ENC_MODE_CHECKED && Encoder->Ptr <= Encoder->Buffer + Encoder->BufferCb)
+    {
+        FreeCb = Encoder->Buffer + Encoder->BufferCb - Encoder->Ptr;
+
+        if (FreeCb >= (SIZE_T) (Scratch - Encoder->Ptr))
+        {
+            ScratchCb = FreeCb - (SIZE_T) (Scratch - Encoder->Ptr);
+        }
+    }
+
+    if (ScratchCb < RequiredCb)
+    {
+        Scratch = Allocated = HeapAlloc(g_Heap, 0, RequiredCb);
+        if (!Allocated)
+        {
+            SetLastError(ERROR_OUTOFMEMORY);
+
+            return FALSE;
+        }
+    }
+
+    Elements = (PBLGP_DER_ELEMENT) Scratch;
+    Copy = Scratch + Count * sizeof(BLGP_DER_ELEMENT);
+
+    CopyMemory(Copy, Content, ContentCb);
+
+    for (Ptr = Copy, i = 0; i < Count; i++)
+    {
+        BlgpMoveToNode(Copy, ContentCb, Ptr, &Node);
+
+        Elements[i].Offset = (DWORD) (Ptr - Copy);
+        Elements[i].Cb = (DWORD) (Node.Value + Node.ValueCb - Ptr);
+
+        Ptr = Node.Value + Node.ValueCb;
+    }
+
+    // Switch to heapsort after 2 * log2(Count) levels of partitioning.
+    for (DepthLimit = 0, i = Count; i > 0; i >>= 1)
+    {
+        DepthLimit += 2;
+    }
+
+    BlgpSortElements(Copy, Elements, Count, DepthLimit);
+
+    for (i = 0; i < Count; i++)
+    {
+        CopyMemory(Content, Copy + Elements[i].Offset, Elements[i].Cb);
+
+        Content += Elements[i].Cb;
+    }
+
+    if (Allocated)
+    {
+        HeapFree(g_Heap, 0, Allocated);
+    }
+
+    return BlgDerEndConstructed((HBLG_DER_ENCODER) Encoder);
+}
\ No newline at end of file
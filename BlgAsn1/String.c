@@ -21,7 +21,7 @@ BlgpDerEncString(
     IN DWORD Tag,
     IN PCWSTR Value,
     IN INT ValueCch,
-    IN UINT CodePage
+    IN DWORD StringTag
     );
 
 static
@@ -31,7 +31,76 @@ BlgpDerDecString(
     IN HBLG_DER_DECODER DecoderHandle,
     OUT PWSTR Buffer OPTIONAL,
     IN OUT PDWORD BufferCch,
-    IN UINT CodePage
+    IN DWORD StringTag
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpDerEncStringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb,
+    IN DWORD StringTag,
+    IN BOOLEAN Validate
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpDerDecStringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb,
+    IN DWORD StringTag,
+    IN BOOLEAN Validate
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpWriteString(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch,
+    IN DWORD StringTag
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpWriteStringA(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb,
+    IN DWORD StringTag,
+    IN BOOLEAN Validate
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpWriteString,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, PCWSTR Value, INT ValueCch, DWORD StringTag),
+    (Encoder, Class, Tag, Value, ValueCch, StringTag));
+
+BLGP_DER_ENC_INSTANCES(BlgpWriteStringA,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, PCSTR Value, INT ValueCb, DWORD StringTag,
+     BOOLEAN Validate),
+    (Encoder, Class, Tag, Value, ValueCb, StringTag, Validate));
+
+static __inline
+DWORD
+BLGASN1CALL
+BlgpGetCharset(
+    IN DWORD StringTag
     );
 
 static __inline
@@ -43,99 +112,810 @@ BlgpChangeEndiannes(
     IN size_t Cch
     );
 
-BOOL
-BLGASN1CALL
-BlgDerEncIA5String(
-    IN HBLG_DER_ENCODER EncoderHandle,
-    IN BYTE Class,
-    IN DWORD Tag,
-    IN PCWSTR Value,
-    IN INT ValueCch
-    )
-{
-    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, 1250);
-}
+BOOL
+BLGASN1CALL
+BlgDerEncIA5String(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    )
+{
+    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, BLG_DER_TAG_IA5_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncIA5StringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 IA5String value from an ASCII string. The octets are checked to be 7-bit
+    and copied as they are.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Value - Pointer to the string to be encoded.
+
+    ValueCb - Size, in bytes, of the string, or -1 if the string is null-terminated.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with
+    ERROR_NO_UNICODE_TRANSLATION if the string contains octets above 0x7F.
+
+--*/
+
+{
+    return BlgpDerEncStringA(EncoderHandle, Class, Tag, Value, ValueCb, BLG_DER_TAG_IA5_STRING, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncNumericString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    )
+{
+    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, BLG_DER_TAG_NUMERIC_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncNumericStringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 NumericString value from an ASCII string. The routine fails with
+    ERROR_NO_UNICODE_TRANSLATION if the string contains anything but digits and spaces.
+
+--*/
+
+{
+    return BlgpDerEncStringA(EncoderHandle, Class, Tag, Value, ValueCb, BLG_DER_TAG_NUMERIC_STRING, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncPrintableString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    )
+{
+    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, BLG_DER_TAG_PRINTABLE_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncPrintableStringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 PrintableString value from an ASCII string. The routine fails with
+    ERROR_NO_UNICODE_TRANSLATION if the string contains anything but the PrintableString character set.
+
+--*/
+
+{
+    return BlgpDerEncStringA(EncoderHandle, Class, Tag, Value, ValueCb, BLG_DER_TAG_PRINTABLE_STRING, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncVisibleString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    )
+{
+    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, BLG_DER_TAG_VISIBLE_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncVisibleStringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 VisibleString value from an ASCII string. The routine fails with
+    ERROR_NO_UNICODE_TRANSLATION if the string contains anything but printing characters and spaces.
+
+--*/
+
+{
+    return BlgpDerEncStringA(EncoderHandle, Class, Tag, Value, ValueCb, BLG_DER_TAG_VISIBLE_STRING, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncUtf8String(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    )
+{
+    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, BLG_DER_TAG_UTF8_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncUtf8StringA(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb,
+    IN DWORD Flags
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 UTF8String value from a string that is already UTF-8 encoded. The octets
+    are copied as they are, without being converted to UTF-16 and back.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Value - Pointer to the UTF-8 string to be encoded.
+
+    ValueCb - Size, in bytes, of the string, or -1 if the string is null-terminated.
+
+    Flags - Additional settings for the encoding. The following flags are defined:
+
+        BLG_DER_STRING_FLAG_VALIDATE - Check that the string is well-formed UTF-8.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with
+    ERROR_NO_UNICODE_TRANSLATION if the string is validated and is not well-formed.
+
+--*/
+
+{
+    if ((Flags & ~BLG_DER_STRING_FLAG_VALIDATE) != 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpDerEncStringA(EncoderHandle, Class, Tag, Value, ValueCb, BLG_DER_TAG_UTF8_STRING,
+        BLGASN1_FLAGON(Flags, BLG_DER_STRING_FLAG_VALIDATE));
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncBmpString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch
+    )
+{
+    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, BLG_DER_TAG_BMP_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecIA5String(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    )
+{
+    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, BLG_DER_TAG_IA5_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecIA5StringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 IA5String value without copying or converting it. The octets are checked
+    to be 7-bit and the routine returns their location within the encoded data.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a variable that receives the pointer to the string. The string is not
+        null-terminated and remains valid as long as the encoded data.
+
+    ValueCb - Pointer to a variable that receives the size, in bytes, of the string.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_BLGASN1_CORRUPT
+    if the string contains octets above 0x7F.
+
+--*/
+
+{
+    return BlgpDerDecStringA(DecoderHandle, Value, ValueCb, BLG_DER_TAG_IA5_STRING, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecNumericString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    )
+{
+    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, BLG_DER_TAG_NUMERIC_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecNumericStringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 NumericString value without copying it. The routine fails with
+    ERROR_BLGASN1_CORRUPT if the value contains anything but digits and spaces.
+
+--*/
+
+{
+    return BlgpDerDecStringA(DecoderHandle, Value, ValueCb, BLG_DER_TAG_NUMERIC_STRING, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecPrintableString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    )
+{
+    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, BLG_DER_TAG_PRINTABLE_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecPrintableStringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 PrintableString value without copying it. The routine fails with
+    ERROR_BLGASN1_CORRUPT if the value contains anything but the PrintableString character set.
+
+--*/
+
+{
+    return BlgpDerDecStringA(DecoderHandle, Value, ValueCb, BLG_DER_TAG_PRINTABLE_STRING, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecVisibleString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    )
+{
+    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, BLG_DER_TAG_VISIBLE_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecVisibleStringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 VisibleString value without copying it. The routine fails with
+    ERROR_BLGASN1_CORRUPT if the value contains anything but printing characters and spaces.
+
+--*/
+
+{
+    return BlgpDerDecStringA(DecoderHandle, Value, ValueCb, BLG_DER_TAG_VISIBLE_STRING, TRUE);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecUtf8String(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    )
+{
+    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, BLG_DER_TAG_UTF8_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecUtf8StringA(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb,
+    IN DWORD Flags
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes an ASN.1 UTF8String value without copying or converting it. The routine returns the
+    location of the UTF-8 octets within the encoded data.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Value - Pointer to a variable that receives the pointer to the string. The string is not
+        null-terminated and remains valid as long as the encoded data.
+
+    ValueCb - Pointer to a variable that receives the size, in bytes, of the string.
+
+    Flags - Additional settings for the decoding. The following flags are defined:
+
+        BLG_DER_STRING_FLAG_VALIDATE - Check that the string is well-formed UTF-8.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with ERROR_BLGASN1_CORRUPT
+    if the string is validated and is not well-formed.
+
+--*/
+
+{
+    if ((Flags & ~BLG_DER_STRING_FLAG_VALIDATE) != 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpDerDecStringA(DecoderHandle, Value, ValueCb, BLG_DER_TAG_UTF8_STRING,
+        BLGASN1_FLAGON(Flags, BLG_DER_STRING_FLAG_VALIDATE));
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecBmpString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch
+    )
+{
+    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, BLG_DER_TAG_BMP_STRING);
+}
+
+BOOL
+BLGASN1CALL
+BlgpDerEncString(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCWSTR Value,
+    IN INT ValueCch,
+    IN DWORD StringTag
+    )
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || !Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpWriteStringInstances[Encoder->Mode](Encoder, Class, Tag, Value, ValueCch, StringTag);
+}
+
+BOOL
+BLGASN1CALL
+BlgpDerDecString(
+    IN HBLG_DER_DECODER DecoderHandle,
+    OUT PWSTR Buffer OPTIONAL,
+    IN OUT PDWORD BufferCch,
+    IN DWORD StringTag
+    )
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    DWORD ValueCch, LocalBufferCch;
+
+    if (!BufferCch)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        LocalBufferCch = *BufferCch; *BufferCch = 0;
+    }
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    switch (StringTag)
+    {
+    case BLG_DER_TAG_UTF8_STRING:
+        // The UTF-16 form never has more code units than the UTF-8 form has octets. If the buffer
+        // is known to be large enough, the value is converted without being measured first.
+        if (Buffer && Decoder->CurrentNode.ValueCb < LocalBufferCch)
+        {
+            if (!BlgpUtf8ToUtf16(Buffer, Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb, &ValueCch))
+            {
+                SetLastError(ERROR_BLGASN1_CORRUPT);
+
+                return FALSE;
+            }
+
+            Buffer[ValueCch] = 0;
+            *BufferCch = ValueCch;
+
+            return TRUE;
+        }
+
+        if (!BlgpUtf8ToUtf16(NULL, Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb, &ValueCch))
+        {
+            SetLastError(ERROR_BLGASN1_CORRUPT);
+
+            return FALSE;
+        }
+
+        break;
+
+    case BLG_DER_TAG_BMP_STRING:
+        ValueCch = Decoder->CurrentNode.ValueCb / sizeof(WCHAR);
+
+        break;
+
+    default:
+        // Every octet becomes one character, so the value is checked while it is widened.
+        ValueCch = Decoder->CurrentNode.ValueCb;
+
+        if (Buffer && ValueCch < LocalBufferCch)
+        {
+            if (!BlgpWidenCharset(Buffer, Decoder->CurrentNode.Value, ValueCch, BlgpGetCharset(StringTag)))
+            {
+                SetLastError(ERROR_BLGASN1_CORRUPT);
+
+                return FALSE;
+            }
+
+            Buffer[ValueCch] = 0;
+            *BufferCch = ValueCch;
+
+            return TRUE;
+        }
+
+        if (!BlgpIsInCharset(Decoder->CurrentNode.Value, ValueCch, BlgpGetCharset(StringTag)))
+        {
+            SetLastError(ERROR_BLGASN1_CORRUPT);
+
+            return FALSE;
+        }
+    }
+
+    if (Buffer)
+    {
+        *BufferCch = ValueCch;
+
+        if (++ValueCch > LocalBufferCch)
+        {
+            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+            return FALSE;
+        }
+
+        if (StringTag == BLG_DER_TAG_UTF8_STRING)
+        {
+            BlgpUtf8ToUtf16(Buffer, Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb, BufferCch);
+        }
+        else
+        {
+            BlgpChangeEndiannes((PBYTE) Buffer, Decoder->CurrentNode.Value, ValueCch - 1);
+        }
+
+        Buffer[ValueCch - 1] = 0;
+    }
+    else
+    {
+        *BufferCch = ValueCch + 1;
+    }
 
-BOOL
-BLGASN1CALL
-BlgDerEncUtf8String(
-    IN HBLG_DER_ENCODER EncoderHandle,
-    IN BYTE Class,
-    IN DWORD Tag,
-    IN PCWSTR Value,
-    IN INT ValueCch
-    )
-{
-    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, CP_UTF8);
+    return TRUE;
 }
 
 BOOL
 BLGASN1CALL
-BlgDerEncBmpString(
+BlgpDerEncStringA(
     IN HBLG_DER_ENCODER EncoderHandle,
     IN BYTE Class,
     IN DWORD Tag,
-    IN PCWSTR Value,
-    IN INT ValueCch
+    IN PCSTR Value,
+    IN INT ValueCb,
+    IN DWORD StringTag,
+    IN BOOLEAN Validate
     )
 {
-    return BlgpDerEncString(EncoderHandle, Class, Tag, Value, ValueCch, 1201);
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || !Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpWriteStringAInstances[Encoder->Mode](Encoder, Class, Tag, Value, ValueCb, StringTag, Validate);
 }
 
 BOOL
 BLGASN1CALL
-BlgDerDecIA5String(
+BlgpDerDecStringA(
     IN HBLG_DER_DECODER DecoderHandle,
-    OUT PWSTR Buffer OPTIONAL,
-    IN OUT PDWORD BufferCch
+    OUT PCSTR *Value,
+    OUT PDWORD ValueCb,
+    IN DWORD StringTag,
+    IN BOOLEAN Validate
     )
 {
-    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, 20105);
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+
+    if (!Value || !ValueCb)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    *Value = NULL;
+    *ValueCb = 0;
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    if (Validate && (StringTag == BLG_DER_TAG_UTF8_STRING ?
+            !BlgpIsValidUtf8(Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb) :
+            !BlgpIsInCharset(Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb,
+                BlgpGetCharset(StringTag))))
+    {
+        SetLastError(ERROR_BLGASN1_CORRUPT);
+
+        return FALSE;
+    }
+
+    *Value = (PCSTR) Decoder->CurrentNode.Value;
+    *ValueCb = Decoder->CurrentNode.ValueCb;
+
+    return TRUE;
 }
 
-BOOL
+static __inline
+DWORD
 BLGASN1CALL
-BlgDerDecUtf8String(
-    IN HBLG_DER_DECODER DecoderHandle,
-    OUT PWSTR Buffer OPTIONAL,
-    IN OUT PDWORD BufferCch
+BlgpGetCharset(
+    IN DWORD StringTag
     )
 {
-    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, CP_UTF8);
+    switch (StringTag)
+    {
+    case BLG_DER_TAG_NUMERIC_STRING:
+        return BLGP_CHARSET_NUMERIC;
+
+    case BLG_DER_TAG_PRINTABLE_STRING:
+        return BLGP_CHARSET_PRINTABLE;
+
+    case BLG_DER_TAG_VISIBLE_STRING:
+        return BLGP_CHARSET_VISIBLE;
+
+    default:
+        return BLGP_CHARSET_IA5;
+    }
 }
 
-BOOL
+static __inline
+VOID
 BLGASN1CALL
-BlgDerDecBmpString(
-    IN HBLG_DER_DECODER DecoderHandle,
-    OUT PWSTR Buffer OPTIONAL,
-    IN OUT PDWORD BufferCch
+BlgpChangeEndiannes(
+    IN PBYTE Destination,
+    IN CONST BYTE *Source,
+    IN size_t Cch
     )
+
+/*++
+
+Routine Description:
+
+    Converts UTF-16 code units between the byte order of the machine and big-endian byte order.
+    The destination may be the same buffer as the source, in which case the code units are
+    converted in place; otherwise the buffers must not overlap.
+
+--*/
+
 {
-    return BlgpDerDecString(DecoderHandle, Buffer, BufferCch, 1201);
+    size_t i = 0;
+#if BLGP_LITTLE_ENDIAN && defined(BLGP_SSE2)
+    DWORD Features = BlgpGetCpuFeatures();
+#endif
+
+#if BLGP_LITTLE_ENDIAN
+#ifdef BLGP_SSE2
+    // Swap the octets of 32 or 16 code units at a time, by a shuffle if the processor supports
+    // AVX2 or SSSE3 and by shifts otherwise. Both blocks are loaded before either is stored so
+    // that the conversion also works in place.
+    if (Features & BLGP_CPU_FEATURE_AVX2)
+    {
+        __m256i Swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+            1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+        for (; i + 32 <= Cch; i += 32)
+        {
+            __m256i Low = _mm256_loadu_si256((CONST __m256i *) (Source + i * 2));
+            __m256i High = _mm256_loadu_si256((CONST __m256i *) (Source + i * 2 + 32));
+
+            _mm256_storeu_si256((__m256i *) (Destination + i * 2), _mm256_shuffle_epi8(Low, Swap));
+            _mm256_storeu_si256((__m256i *) (Destination + i * 2 + 32), _mm256_shuffle_epi8(High, Swap));
+        }
+
+        _mm256_zeroupper();
+    }
+
+    if (Features & BLGP_CPU_FEATURE_SSSE3)
+    {
+        __m128i Swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+        for (; i + 16 <= Cch; i += 16)
+        {
+            __m128i Low = _mm_loadu_si128((CONST __m128i *) (Source + i * 2));
+            __m128i High = _mm_loadu_si128((CONST __m128i *) (Source + i * 2 + 16));
+
+            _mm_storeu_si128((__m128i *) (Destination + i * 2), _mm_shuffle_epi8(Low, Swap));
+            _mm_storeu_si128((__m128i *) (Destination + i * 2 + 16), _mm_shuffle_epi8(High, Swap));
+        }
+    }
+
+    for (; i + 16 <= Cch; i += 16)
+    {
+        __m128i Low = _mm_loadu_si128((CONST __m128i *) (Source + i * 2));
+        __m128i High = _mm_loadu_si128((CONST __m128i *) (Source + i * 2 + 16));
+
+        Low = _mm_or_si128(_mm_slli_epi16(Low, 8), _mm_srli_epi16(Low, 8));
+        High = _mm_or_si128(_mm_slli_epi16(High, 8), _mm_srli_epi16(High, 8));
+
+        _mm_storeu_si128((__m128i *) (Destination + i * 2), Low);
+        _mm_storeu_si128((__m128i *) (Destination + i * 2 + 16), High);
+    }
+#endif
+
+    for (; i + 4 <= Cch; i += 4)
+    {
+        ULONGLONG Block = *(CONST ULONGLONG UNALIGNED *) (Source + i * 2);
+
+        *(ULONGLONG UNALIGNED *) (Destination + i * 2) =
+            ((Block & 0x00FF00FF00FF00FFULL) << 8) | ((Block >> 8) & 0x00FF00FF00FF00FFULL);
+    }
+
+    for (; i < Cch; i++)
+    {
+        *(WORD UNALIGNED *) (Destination + i * 2) =
+            BlgpByteSwap16(*(CONST WORD UNALIGNED *) (Source + i * 2));
+    }
+#else
+    if (Destination != Source)
+    {
+        CopyMemory(Destination, Source, Cch * sizeof(WCHAR));
+    }
+#endif
 }
 
+__forceinline
 BOOL
-BLGASN1CALL
-BlgpDerEncString(
-    IN HBLG_DER_ENCODER EncoderHandle,
+BLGASN1INLINECALL
+BlgpWriteString(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
     IN BYTE Class,
     IN DWORD Tag,
     IN PCWSTR Value,
     IN INT ValueCch,
-    IN UINT CodePage
+    IN DWORD StringTag
     )
-{
-    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
-    size_t Cch;
-    size_t OctetCount;
 
-    if (!Encoder || !Value)
-    {
-        SetLastError(ERROR_INVALID_PARAMETER);
+/*++
 
-        return FALSE;
-    }
+Routine Description:
+
+    Encodes a string from UTF-16 in the specified mode.
+
+--*/
+
+{
+    PBYTE Start, Ptr;
+    size_t Cch;
+    ULONGLONG OctetCount;
 
     if (ValueCch == -1)
     {
@@ -146,6 +926,12 @@ BlgpDerEncString(
             return FALSE;
         }
     }
+    else if (ValueCch < 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
     else
     {
         Cch = ValueCch;
@@ -153,88 +939,110 @@ BlgpDerEncString(
 
     if (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0)
     {
-        switch (CodePage)
-        {
-        case 1250:
-            Tag = BLG_DER_TAG_IA5_STRING;
+        Tag = StringTag;
+    }
 
-            break;
+    switch (StringTag)
+    {
+    case BLG_DER_TAG_UTF8_STRING:
+        OctetCount = BlgpUtf16ToUtf8Cb(Value, Cch);
 
-        case CP_UTF8:
-            Tag = BLG_DER_TAG_UTF8_STRING;
+        break;
 
-            break;
+    case BLG_DER_TAG_BMP_STRING:
+        OctetCount = (ULONGLONG) Cch * sizeof(WCHAR);
 
-        case 1201:
-            Tag = BLG_DER_TAG_BMP_STRING;
+        break;
 
-            break;
-        }
+    default:
+        OctetCount = Cch;
     }
 
-    if (CodePage != 1201)
-    {
-        OctetCount = WideCharToMultiByte(CodePage, 0, Value, (INT) Cch, NULL, 0, NULL, NULL);
-        if (OctetCount == 0)
-        {
-            return FALSE;
-        }
-    }
-    else
+    // The size of the content octets is passed on as a DWORD; it is never truncated.
+    if (OctetCount > MAXDWORD)
     {
-        OctetCount = Cch * sizeof(WCHAR);
-    }
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
 
-    if (!BlgDerEncTag(EncoderHandle, Class, FALSE, Tag))
-    {
         return FALSE;
     }
 
-    if (!BlgDerEncLen(EncoderHandle, (DWORD) OctetCount))
+    Start = Encoder->Ptr;
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE, Tag, (DWORD) OctetCount, &Ptr))
     {
         return FALSE;
     }
 
-    if (Encoder->Buffer)
+    switch (StringTag)
     {
-        if (BLGP_DER_ENCODED_CB(Encoder) + OctetCount > Encoder->BufferCb)
+    case BLG_DER_TAG_UTF8_STRING:
+        if (Mode != BLGP_DER_ENC_MODE_MEASURE)
         {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
-
-            return FALSE;
+            BlgpUtf16ToUtf8(Ptr, Value, Cch);
         }
 
-        if (CodePage != 1201)
+        break;
+
+    case BLG_DER_TAG_BMP_STRING:
+        if (Mode != BLGP_DER_ENC_MODE_MEASURE)
         {
-            if (WideCharToMultiByte(CodePage, 0, Value, (INT) Cch, Encoder->Ptr, (INT) OctetCount, NULL, NULL) == 0)
-            {
-                return FALSE;
-            }
+            BlgpChangeEndiannes(Ptr, (CONST BYTE *) Value, Cch);
         }
-        else
+
+        break;
+
+    default:
+        // The characters are checked while they are narrowed. The node is taken back if one of
+        // them does not belong to the character set of the type.
+        if (!BlgpNarrowCharset(Ptr, Value, Cch, BlgpGetCharset(StringTag)))
         {
-            BlgpChangeEndiannes(Encoder->Ptr, (CONST BYTE *) Value, Cch);
+            Encoder->Ptr = Start;
+
+            SetLastError(ERROR_NO_UNICODE_TRANSLATION);
+
+            return FALSE;
         }
     }
 
-    Encoder->Ptr += OctetCount;
-
     return TRUE;
 }
 
+__forceinline
 BOOL
-BLGASN1CALL
-BlgpDerDecString(
-    IN HBLG_DER_DECODER DecoderHandle,
-    OUT PWSTR Buffer OPTIONAL,
-    IN OUT PDWORD BufferCch,
-    IN UINT CodePage
+BLGASN1INLINECALL
+BlgpWriteStringA(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCSTR Value,
+    IN INT ValueCb,
+    IN DWORD StringTag,
+    IN BOOLEAN Validate
     )
+
+/*++
+
+Routine Description:
+
+    Encodes a string from 8-bit characters in the specified mode.
+
+--*/
+
 {
-    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
-    DWORD ValueCch, LocalBufferCch;
+    PBYTE Ptr;
+    size_t Cb;
 
-    if (!BufferCch)
+    if (ValueCb == -1)
+    {
+        if (FAILED(StringCchLengthA(Value, MAXLONG, &Cb)))
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+    }
+    else if (ValueCb < 0)
     {
         SetLastError(ERROR_INVALID_PARAMETER);
 
@@ -242,79 +1050,32 @@ BlgpDerDecString(
     }
     else
     {
-        LocalBufferCch = *BufferCch; *BufferCch = 0;
+        Cb = ValueCb;
     }
 
-    if (!BlgpValidateState(Decoder))
+    if (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0)
     {
-        return FALSE;
+        Tag = StringTag;
     }
 
-    if (CodePage != 1201)
+    if (Validate && (StringTag == BLG_DER_TAG_UTF8_STRING ?
+            !BlgpIsValidUtf8((CONST BYTE *) Value, (DWORD) Cb) :
+            !BlgpIsInCharset((CONST BYTE *) Value, (DWORD) Cb, BlgpGetCharset(StringTag))))
     {
-        ValueCch = MultiByteToWideChar(CodePage, 0, Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb, NULL, 0);
-        if (ValueCch == 0)
-        {
-            SetLastError(ERROR_BLGASN1_CORRUPT);
+        SetLastError(ERROR_NO_UNICODE_TRANSLATION);
 
-            return FALSE;
-        }
-    }
-    else
-    {
-        ValueCch = Decoder->CurrentNode.ValueCb / sizeof(WCHAR);
+        return FALSE;
     }
 
-    if (Buffer)
+    if (!BlgpReserveNode(Mode, Encoder, Class, FALSE, Tag, (DWORD) Cb, &Ptr))
     {
-        *BufferCch = ValueCch;
-
-        if (++ValueCch > LocalBufferCch)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
-
-            return FALSE;
-        }
-
-        if (CodePage != 1201)
-        {
-            if (MultiByteToWideChar(CodePage, 0,
-                    Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb, Buffer, ValueCch) == 0)
-            {
-                SetLastError(ERROR_BLGASN1_CORRUPT);
-
-                return FALSE;
-            }
-        }
-        else
-        {
-            BlgpChangeEndiannes((PBYTE) Buffer, Decoder->CurrentNode.Value, ValueCch - 1);
-        }
-
-        Buffer[ValueCch - 1] = 0;
+        return FALSE;
     }
-    else
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
     {
-        *BufferCch = ValueCch + 1;
+        CopyMemory(Ptr, Value, Cb);
     }
 
     return TRUE;
-}
-
-static __inline
-VOID
-BLGASN1CALL
-BlgpChangeEndiannes(
-    IN PBYTE Destination,
-    IN CONST BYTE *Source,
-    IN size_t Cch
-    )
-{
-    DWORD i;
-
-    for (i = 0; i < Cch * 2; i += 2)
-    {
-        Destination[i] = Source[i + 1];
-        Destination[i + 1] = Source[i];
-    }
 }
\ No newline at end of file
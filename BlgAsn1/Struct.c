@@ -0,0 +1,1155 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+--*/
+
+#include <windows.h>
+
+#include "BlgAsn1.h"
+#include "BlgAsn1p.h"
+
+// Number of constructed node sizes that are cached without allocating memory.
+#define BLGP_STRUCT_INLINE_SIZES 32
+
+// Determines whether fields of the specified type are encoded as constructed nodes.
+#define BLGP_FIELD_CONSTRUCTED(Type) ((Type) >= BLG_DER_FIELD_SEQUENCE)
+
+// Determines whether a field has a valid type and class, and a Node.Constructed member that
+// agrees with its type.
+#define BLGP_IS_VALID_FIELD(Field) \
+    ((Field)->Type >= BLG_DER_FIELD_BOOL && (Field)->Type <= BLG_DER_FIELD_SEQUENCE_OF && \
+     (Field)->Node.Class <= BLG_DER_CLASS_PRIVATE && \
+     !(Field)->Node.Constructed == !BLGP_FIELD_CONSTRUCTED((Field)->Type))
+
+// Returns a pointer to the member at the specified offset of a structure.
+#define BLGP_FIELD_PTR(Base, Offset) ((CONST BYTE *) (Base) + (Offset))
+
+typedef struct _BLGP_STRUCT_ENCODER
+{
+    PDWORD Sizes;
+    DWORD SizeCount;
+    DWORD SizeCapacity;
+    DWORD NextSize;
+    CONST BYTE *End;
+    DWORD InlineSizes[BLGP_STRUCT_INLINE_SIZES];
+
+} BLGP_STRUCT_ENCODER, *PBLGP_STRUCT_ENCODER;
+
+// Universal tags of the field types, indexed by type.
+static CONST BYTE BlgpFieldTags[] =
+{
+    0,
+    BLG_DER_TAG_BOOLEAN,
+    BLG_DER_TAG_INTEGER,
+    BLG_DER_TAG_INTEGER,
+    BLG_DER_TAG_INTEGER,
+    BLG_DER_TAG_INTEGER,
+    BLG_DER_TAG_NULL,
+    BLG_DER_TAG_OCTET_STRING,
+    BLG_DER_TAG_SEQUENCE,
+    BLG_DER_TAG_SEQUENCE_OF
+};
+
+static
+BOOL
+BLGASN1CALL
+BlgpMeasureStruct(
+    IN PBLGP_STRUCT_ENCODER Encoder,
+    IN PCBLG_DER_STRUCT Struct,
+    IN CONST VOID *Base,
+    OUT PULONGLONG ContentCb
+    );
+
+static
+PBYTE
+BLGASN1CALL
+BlgpWriteStruct(
+    IN PBLGP_STRUCT_ENCODER Encoder,
+    IN PCBLG_DER_STRUCT Struct,
+    IN CONST VOID *Base,
+    OUT PBYTE Ptr
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpReadStruct(
+    IN PBLGP_DER_DECODER Decoder,
+    IN PCBLG_DER_STRUCT Struct,
+    OUT PVOID Base,
+    IN CONST BYTE *Ptr,
+    IN DWORD Cb
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncodeStruct(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCBLG_DER_STRUCT Struct,
+    IN CONST VOID *Value
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncodeStruct,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, DWORD Tag, PCBLG_DER_STRUCT Struct, CONST VOID *Value),
+    (Encoder, Class, Tag, Struct, Value));
+
+BOOL
+BLGASN1CALL
+BlgDerEncodeStruct(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCBLG_DER_STRUCT Struct,
+    IN CONST VOID *Value
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes a C structure as an ASN.1 SEQUENCE node as described by a field descriptor table.
+
+    The size of every constructed node is calculated and cached before any octet is written, so
+    the whole node is checked against the buffer once and written front to back without moving
+    the encoded content.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Class - Class of the node.
+
+    Tag - Tag of the node.
+
+    Struct - Pointer to the descriptor of the structure.
+
+    Value - Pointer to the structure to be encoded.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || !Struct || !Value || Class > BLG_DER_CLASS_PRIVATE)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncodeStructInstances[Encoder->Mode](Encoder, Class, Tag, Struct, Value);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDecodeStruct(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_STRUCT Struct,
+    OUT PVOID Value
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes the current node, which must be an ASN.1 SEQUENCE, into a C structure as described
+    by a field descriptor table. The children are matched against the descriptors in a single
+    pass over the encoded data; the position of the decoder does not change.
+
+    OCTET STRING members receive pointers into the encoded data. SEQUENCE OF members are
+    decoded into the arrays provided by the caller.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    Struct - Pointer to the descriptor of the structure.
+
+    Value - Pointer to the structure that receives the decoded fields.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+
+    if (!Struct || !Value)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    if (!BLGASN1_FLAGON(*Decoder->CurrentNode.Tag, 0x20))
+    {
+        SetLastError(ERROR_BLGASN1_PRIMITIVE);
+
+        return FALSE;
+    }
+
+    return BlgpReadStruct(Decoder, Struct, Value, Decoder->CurrentNode.Value, Decoder->CurrentNode.ValueCb);
+}
+
+static
+DWORD
+BLGASN1CALL
+BlgpFieldTag(
+    IN PCBLG_DER_FIELD Field
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the tag of the node a field is encoded as.
+
+--*/
+
+{
+    if (Field->Node.Class == BLG_DER_CLASS_UNIVERSAL && Field->Node.Tag == 0)
+    {
+        return BlgpFieldTags[Field->Type];
+    }
+
+    return Field->Node.Tag;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpIsFieldOmitted(
+    IN PCBLG_DER_FIELD Field,
+    IN CONST VOID *Base
+    )
+
+/*++
+
+Routine Description:
+
+    Determines whether a field is left out of the encoding, either because it is an absent
+    OPTIONAL field or because it equals its DEFAULT value.
+
+--*/
+
+{
+    CONST BYTE *Member = BLGP_FIELD_PTR(Base, Field->Offset);
+
+    if (Field->Node.Optional && !*BLGP_FIELD_PTR(Base, Field->PresentOffset))
+    {
+        return TRUE;
+    }
+
+    if (!BLGASN1_FLAGON(Field->Flags, BLG_DER_FIELD_FLAG_DEFAULT))
+    {
+        return FALSE;
+    }
+
+    switch (Field->Type)
+    {
+    case BLG_DER_FIELD_BOOL:
+        return (*(CONST BOOLEAN *) Member != 0) == (Field->Default != 0);
+
+    case BLG_DER_FIELD_INT32:
+        return *(CONST INT *) Member == Field->Default;
+
+    case BLG_DER_FIELD_UINT32:
+        return *(CONST DWORD *) Member == Field->Default;
+
+    case BLG_DER_FIELD_INT64:
+    case BLG_DER_FIELD_UINT64:
+        return *(CONST LONGLONG *) Member == Field->Default;
+    }
+
+    return FALSE;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpReserveSize(
+    IN PBLGP_STRUCT_ENCODER Encoder,
+    OUT PDWORD Index
+    )
+
+/*++
+
+Routine Description:
+
+    Reserves the next entry of the size cache. The entries are reserved in the order in which
+    the write pass consumes them.
+
+--*/
+
+{
+    PDWORD Sizes;
+
+    if (Encoder->SizeCount == Encoder->SizeCapacity)
+    {
+        if (Encoder->SizeCapacity > MAXDWORD / (2 * sizeof(DWORD)))
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+
+        if (Encoder->Sizes == Encoder->InlineSizes)
+        {
+            Sizes = HeapAlloc(g_Heap, 0, Encoder->SizeCapacity * 2 * sizeof(DWORD));
+            if (Sizes)
+            {
+                CopyMemory(Sizes, Encoder->InlineSizes, sizeof(Encoder->InlineSizes));
+            }
+        }
+        else
+        {
+            Sizes = HeapReAlloc(g_Heap, 0, Encoder->Sizes, Encoder->SizeCapacity * 2 * sizeof(DWORD));
+        }
+
+        if (!Sizes)
+        {
+            SetLastError(ERROR_OUTOFMEMORY);
+
+            return FALSE;
+        }
+
+        Encoder->Sizes = Sizes;
+        Encoder->SizeCapacity *= 2;
+    }
+
+    *Index = Encoder->SizeCount++;
+
+    return TRUE;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpMeasureField(
+    IN PBLGP_STRUCT_ENCODER Encoder,
+    IN PCBLG_DER_FIELD Field,
+    IN CONST VOID *Base,
+    OUT PULONGLONG Cb
+    )
+
+/*++
+
+Routine Description:
+
+    Calculates the number of octets a field is encoded in, including the identifier and length
+    octets, and caches the content size of every constructed node.
+
+Arguments:
+
+    Encoder - Pointer to the structure encoder.
+
+    Field - Pointer to the descriptor of the field.
+
+    Base - Pointer to the structure that contains the field.
+
+    Cb - Pointer to a variable that receives the size of the encoded field. Zero if the field
+        is omitted.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    CONST BYTE *Member = BLGP_FIELD_PTR(Base, Field->Offset);
+    CONST BYTE *Array;
+    ULONGLONG ContentCb, ElementCb;
+    DWORD Index, Count, i;
+
+    *Cb = 0;
+
+    if (!BLGP_IS_VALID_FIELD(Field))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    if (BlgpIsFieldOmitted(Field, Base))
+    {
+        return TRUE;
+    }
+
+    switch (Field->Type)
+    {
+    case BLG_DER_FIELD_BOOL:
+        ContentCb = 1;
+        break;
+
+    case BLG_DER_FIELD_INT32:
+        ContentCb = BlgpIntOctetCount64(*(CONST INT *) Member);
+        break;
+
+    case BLG_DER_FIELD_UINT32:
+        ContentCb = BlgpUIntOctetCount64(*(CONST DWORD *) Member);
+        break;
+
+    case BLG_DER_FIELD_INT64:
+        ContentCb = BlgpIntOctetCount64(*(CONST LONGLONG *) Member);
+        break;
+
+    case BLG_DER_FIELD_UINT64:
+        ContentCb = BlgpUIntOctetCount64(*(CONST ULONGLONG *) Member);
+        break;
+
+    case BLG_DER_FIELD_NULL:
+        ContentCb = 0;
+        break;
+
+    case BLG_DER_FIELD_OCTET_STRING:
+        ContentCb = *(CONST DWORD *) BLGP_FIELD_PTR(Base, Field->CountOffset);
+
+        if (ContentCb > 0 && !*(CONST BYTE * CONST *) Member)
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+        break;
+
+    case BLG_DER_FIELD_SEQUENCE:
+        if (!Field->Struct)
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        if (!BlgpReserveSize(Encoder, &Index))
+        {
+            return FALSE;
+        }
+
+        if (!BlgpMeasureStruct(Encoder, Field->Struct, Member, &ContentCb))
+        {
+            return FALSE;
+        }
+
+        Encoder->Sizes[Index] = (DWORD) ContentCb;
+        break;
+
+    default:
+        Array = *(CONST BYTE * CONST *) Member;
+        Count = *(CONST DWORD *) BLGP_FIELD_PTR(Base, Field->CountOffset);
+
+        if (!Field->Struct || Field->Struct->FieldCount != 1 || (!Array && Count > 0))
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        if (!BlgpReserveSize(Encoder, &Index))
+        {
+            return FALSE;
+        }
+
+        ContentCb = 0;
+
+        for (i = 0; i < Count; i++)
+        {
+            if (!BlgpMeasureField(Encoder, Field->Struct->Fields,
+                    Array + (SIZE_T) i * Field->Struct->StructCb, &ElementCb))
+            {
+                return FALSE;
+            }
+
+            ContentCb += ElementCb;
+
+            if (ContentCb > MAXDWORD)
+            {
+                SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+                return FALSE;
+            }
+        }
+
+        Encoder->Sizes[Index] = (DWORD) ContentCb;
+        break;
+    }
+
+    *Cb = BlgpTagOctetCount(BlgpFieldTag(Field)) + BlgpLenOctetCount((DWORD) ContentCb) + ContentCb;
+
+    return TRUE;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpMeasureStruct(
+    IN PBLGP_STRUCT_ENCODER Encoder,
+    IN PCBLG_DER_STRUCT Struct,
+    IN CONST VOID *Base,
+    OUT PULONGLONG ContentCb
+    )
+
+/*++
+
+Routine Description:
+
+    Calculates the number of content octets of a structure encoded as an ASN.1 SEQUENCE.
+
+--*/
+
+{
+    ULONGLONG FieldCb;
+    DWORD i;
+
+    *ContentCb = 0;
+
+    if (!Struct->Fields && Struct->FieldCount > 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    for (i = 0; i < Struct->FieldCount; i++)
+    {
+        if (!BlgpMeasureField(Encoder, Struct->Fields + i, Base, &FieldCb))
+        {
+            return FALSE;
+        }
+
+        *ContentCb += FieldCb;
+
+        if (*ContentCb > MAXDWORD)
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static
+PBYTE
+BLGASN1CALL
+BlgpWriteField(
+    IN PBLGP_STRUCT_ENCODER Encoder,
+    IN PCBLG_DER_FIELD Field,
+    IN CONST VOID *Base,
+    OUT PBYTE Ptr
+    )
+
+/*++
+
+Routine Description:
+
+    Writes a field that has been measured by BlgpMeasureField. The buffer is known to be large
+    enough, so no bounds are checked.
+
+Return Value:
+
+    Pointer to the octet following the encoded field.
+
+--*/
+
+{
+    CONST BYTE *Member = BLGP_FIELD_PTR(Base, Field->Offset);
+    CONST BYTE *Array;
+    ULONGLONG Value = 0;
+    DWORD ContentCb, Count, i;
+    PBYTE Content;
+
+    if (BlgpIsFieldOmitted(Field, Base))
+    {
+        return Ptr;
+    }
+
+    switch (Field->Type)
+    {
+    case BLG_DER_FIELD_BOOL:
+        ContentCb = 1;
+        break;
+
+    case BLG_DER_FIELD_INT32:
+        Value = (ULONGLONG) (LONGLONG) *(CONST INT *) Member;
+        ContentCb = BlgpIntOctetCount64((LONGLONG) Value);
+        break;
+
+    case BLG_DER_FIELD_UINT32:
+        Value = *(CONST DWORD *) Member;
+        ContentCb = BlgpUIntOctetCount64(Value);
+        break;
+
+    case BLG_DER_FIELD_INT64:
+        Value = *(CONST ULONGLONG *) Member;
+        ContentCb = BlgpIntOctetCount64((LONGLONG) Value);
+        break;
+
+    case BLG_DER_FIELD_UINT64:
+        Value = *(CONST ULONGLONG *) Member;
+        ContentCb = BlgpUIntOctetCount64(Value);
+        break;
+
+    case BLG_DER_FIELD_NULL:
+        ContentCb = 0;
+        break;
+
+    case BLG_DER_FIELD_OCTET_STRING:
+        ContentCb = *(CONST DWORD *) BLGP_FIELD_PTR(Base, Field->CountOffset);
+        break;
+
+    default:
+        ContentCb = Encoder->Sizes[Encoder->NextSize++];
+        break;
+    }
+
+    Ptr += BlgpWriteTag(Ptr, Field->Node.Class, BLGP_FIELD_CONSTRUCTED(Field->Type), BlgpFieldTag(Field));
+    Ptr += BlgpWriteLen(Ptr, ContentCb);
+
+    switch (Field->Type)
+    {
+    case BLG_DER_FIELD_BOOL:
+        *Ptr = *(CONST BOOLEAN *) Member ? 0xFF : 0x00;
+        break;
+
+    case BLG_DER_FIELD_INT32:
+    case BLG_DER_FIELD_UINT32:
+    case BLG_DER_FIELD_INT64:
+    case BLG_DER_FIELD_UINT64:
+        BlgpWriteInt64(Ptr, Encoder->End, Value, ContentCb);
+        break;
+
+    case BLG_DER_FIELD_OCTET_STRING:
+        if (ContentCb > 0)
+        {
+            CopyMemory(Ptr, *(CONST BYTE * CONST *) Member, ContentCb);
+        }
+        break;
+
+    case BLG_DER_FIELD_SEQUENCE:
+        BlgpWriteStruct(Encoder, Field->Struct, Member, Ptr);
+        break;
+
+    case BLG_DER_FIELD_SEQUENCE_OF:
+        Array = *(CONST BYTE * CONST *) Member;
+        Count = *(CONST DWORD *) BLGP_FIELD_PTR(Base, Field->CountOffset);
+
+        Content = Ptr;
+
+        for (i = 0; i < Count; i++)
+        {
+            Content = BlgpWriteField(Encoder, Field->Struct->Fields,
+                Array + (SIZE_T) i * Field->Struct->StructCb, Content);
+        }
+        break;
+    }
+
+    return Ptr + ContentCb;
+}
+
+static
+PBYTE
+BLGASN1CALL
+BlgpWriteStruct(
+    IN PBLGP_STRUCT_ENCODER Encoder,
+    IN PCBLG_DER_STRUCT Struct,
+    IN CONST VOID *Base,
+    OUT PBYTE Ptr
+    )
+
+/*++
+
+Routine Description:
+
+    Writes the content octets of a structure that has been measured by BlgpMeasureStruct.
+
+Return Value:
+
+    Pointer to the octet following the encoded content.
+
+--*/
+
+{
+    DWORD i;
+
+    for (i = 0; i < Struct->FieldCount; i++)
+    {
+        Ptr = BlgpWriteField(Encoder, Struct->Fields + i, Base, Ptr);
+    }
+
+    return Ptr;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpIsFieldNode(
+    IN PCBLG_DER_FIELD Field,
+    IN CONST BLGP_DER_DECODER_NODE *Node
+    )
+
+/*++
+
+Routine Description:
+
+    Determines whether a node carries the tag of a field. The identifier octets of the field
+    are built and compared with those of the node; the tag of the node is not decoded.
+
+--*/
+
+{
+    BYTE Octets[6];
+    DWORD OctetCount;
+
+    if (!BLGP_IS_VALID_FIELD(Field))
+    {
+        return FALSE;
+    }
+
+    OctetCount = BlgpWriteTag(Octets, Field->Node.Class, BLGP_FIELD_CONSTRUCTED(Field->Type), BlgpFieldTag(Field));
+
+    return (DWORD) (Node->Value - Node->Tag) > OctetCount && RtlEqualMemory(Node->Tag, Octets, OctetCount);
+}
+
+static
+VOID
+BLGASN1CALL
+BlgpSetFieldDefault(
+    IN PCBLG_DER_FIELD Field,
+    OUT PVOID Base
+    )
+
+/*++
+
+Routine Description:
+
+    Stores the DEFAULT value of an absent field.
+
+--*/
+
+{
+    PBYTE Member = (PBYTE) Base + Field->Offset;
+
+    switch (Field->Type)
+    {
+    case BLG_DER_FIELD_BOOL:
+        *(PBOOLEAN) Member = Field->Default != 0;
+        break;
+
+    case BLG_DER_FIELD_INT32:
+        *(PINT) Member = (INT) Field->Default;
+        break;
+
+    case BLG_DER_FIELD_UINT32:
+        *(PDWORD) Member = (DWORD) Field->Default;
+        break;
+
+    case BLG_DER_FIELD_INT64:
+    case BLG_DER_FIELD_UINT64:
+        *(PLONGLONG) Member = Field->Default;
+        break;
+    }
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpReadField(
+    IN PBLGP_DER_DECODER Decoder,
+    IN PCBLG_DER_FIELD Field,
+    OUT PVOID Base,
+    IN CONST BLGP_DER_DECODER_NODE *Node
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes a node whose tag matches the specified field into the member of the structure.
+
+Arguments:
+
+    Decoder - Pointer to the decoder.
+
+    Field - Pointer to the descriptor of the field.
+
+    Base - Pointer to the structure that contains the field.
+
+    Node - Pointer to the node to be decoded.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBYTE Member = (PBYTE) Base + Field->Offset;
+    PBYTE Array;
+    ULONGLONG Decoded;
+    BLGP_DER_DECODER_NODE Element;
+    CONST BYTE *Ptr, *End;
+    DWORD Capacity, Count;
+
+    switch (Field->Type)
+    {
+    case BLG_DER_FIELD_BOOL:
+        // If the BLG_DER_DEC_FLAG_RELAXED flag is not set, the value must be either 0 or 255.
+        if (Node->ValueCb != 1 || (*Node->Value != 0x00 && *Node->Value != 0xFF &&
+                !BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED)))
+        {
+            SetLastError(ERROR_BLGASN1_CORRUPT);
+
+            return FALSE;
+        }
+
+        *(PBOOLEAN) Member = *Node->Value != 0x00;
+        break;
+
+    case BLG_DER_FIELD_INT32:
+    case BLG_DER_FIELD_INT64:
+        if (!BlgpReadInteger(Decoder->Encoded, Node->Value, Node->ValueCb, TRUE, &Decoded))
+        {
+            return FALSE;
+        }
+
+        if (Field->Type == BLG_DER_FIELD_INT64)
+        {
+            *(PLONGLONG) Member = (LONGLONG) Decoded;
+        }
+        else if ((LONGLONG) Decoded < MININT || (LONGLONG) Decoded > MAXINT)
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+        else
+        {
+            *(PINT) Member = (INT) Decoded;
+        }
+        break;
+
+    case BLG_DER_FIELD_UINT32:
+    case BLG_DER_FIELD_UINT64:
+        if (!BlgpReadInteger(Decoder->Encoded, Node->Value, Node->ValueCb, FALSE, &Decoded))
+        {
+            return FALSE;
+        }
+
+        if (Field->Type == BLG_DER_FIELD_UINT64)
+        {
+            *(PULONGLONG) Member = Decoded;
+        }
+        else if (Decoded > MAXDWORD)
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+        else
+        {
+            *(PDWORD) Member = (DWORD) Decoded;
+        }
+        break;
+
+    case BLG_DER_FIELD_NULL:
+        if (Node->ValueCb != 0)
+        {
+            SetLastError(ERROR_BLGASN1_CORRUPT);
+
+            return FALSE;
+        }
+        break;
+
+    case BLG_DER_FIELD_OCTET_STRING:
+        *(CONST BYTE **) Member = Node->Value;
+        *(PDWORD) ((PBYTE) Base + Field->CountOffset) = Node->ValueCb;
+        break;
+
+    case BLG_DER_FIELD_SEQUENCE:
+        if (!Field->Struct)
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        return BlgpReadStruct(Decoder, Field->Struct, Member, Node->Value, Node->ValueCb);
+
+    case BLG_DER_FIELD_SEQUENCE_OF:
+        Array = *(PBYTE *) Member;
+        Capacity = *(PDWORD) ((PBYTE) Base + Field->CountOffset);
+
+        if (!Field->Struct || Field->Struct->FieldCount != 1 || !Field->Struct->Fields ||
+            !BLGP_IS_VALID_FIELD(Field->Struct->Fields) || (!Array && Capacity > 0))
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        Ptr = Node->Value;
+        End = Node->Value + Node->ValueCb;
+
+        // Elements that do not fit in the array are still parsed so that the required capacity
+        // can be reported.
+        for (Count = 0; Ptr < End; Count++)
+        {
+            if (!BlgpMoveToNode(Node->Value, Node->ValueCb, Ptr, &Element))
+            {
+                return FALSE;
+            }
+
+            if (!BlgpIsFieldNode(Field->Struct->Fields, &Element))
+            {
+                SetLastError(ERROR_BLGASN1_BADTAG);
+
+                return FALSE;
+            }
+
+            if (Count < Capacity &&
+                !BlgpReadField(Decoder, Field->Struct->Fields, Array + (SIZE_T) Count * Field->Struct->StructCb, &Element))
+            {
+                return FALSE;
+            }
+
+            Ptr = Element.Value + Element.ValueCb;
+        }
+
+        *(PDWORD) ((PBYTE) Base + Field->CountOffset) = Count;
+
+        if (Count > Capacity)
+        {
+            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+
+            return FALSE;
+        }
+        break;
+
+    default:
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpReadStruct(
+    IN PBLGP_DER_DECODER Decoder,
+    IN PCBLG_DER_STRUCT Struct,
+    OUT PVOID Base,
+    IN CONST BYTE *Ptr,
+    IN DWORD Cb
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes the content octets of an ASN.1 SEQUENCE into a structure. Absent OPTIONAL fields
+    are marked as not present and absent DEFAULT fields receive their default values.
+
+Arguments:
+
+    Decoder - Pointer to the decoder.
+
+    Struct - Pointer to the descriptor of the structure.
+
+    Base - Pointer to the structure that receives the decoded fields.
+
+    Ptr - Pointer to the content octets of the SEQUENCE.
+
+    Cb - Number of content octets.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    CONST BYTE *Content = Ptr, *End = Ptr + Cb;
+    BLGP_DER_DECODER_NODE Node;
+    BOOL HasNode = FALSE;
+    PCBLG_DER_FIELD Field;
+    DWORD i;
+
+    if (!Struct->Fields && Struct->FieldCount > 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    for (i = 0; i < Struct->FieldCount; i++)
+    {
+        Field = Struct->Fields + i;
+
+        if (!BLGP_IS_VALID_FIELD(Field))
+        {
+            SetLastError(ERROR_INVALID_PARAMETER);
+
+            return FALSE;
+        }
+
+        if (!HasNode && Ptr < End)
+        {
+            if (!BlgpMoveToNode(Content, Cb, Ptr, &Node))
+            {
+                return FALSE;
+            }
+
+            HasNode = TRUE;
+        }
+
+        if (!HasNode || !BlgpIsFieldNode(Field, &Node))
+        {
+            if (Field->Node.Optional)
+            {
+                *((PBYTE) Base + Field->PresentOffset) = FALSE;
+            }
+            else if (BLGASN1_FLAGON(Field->Flags, BLG_DER_FIELD_FLAG_DEFAULT))
+            {
+                BlgpSetFieldDefault(Field, Base);
+            }
+            else
+            {
+                SetLastError(HasNode ? ERROR_BLGASN1_CONSTRAINT : ERROR_BLGASN1_UNEXP_EOD);
+
+                return FALSE;
+            }
+
+            continue;
+        }
+
+        if (Field->Node.Optional)
+        {
+            *((PBYTE) Base + Field->PresentOffset) = TRUE;
+        }
+
+        if (!BlgpReadField(Decoder, Field, Base, &Node))
+        {
+            return FALSE;
+        }
+
+        // DER does not allow a field to be encoded with its DEFAULT value.
+        if (BLGASN1_FLAGON(Field->Flags, BLG_DER_FIELD_FLAG_DEFAULT) &&
+            !BLGASN1_FLAGON(Decoder->Flags, BLG_DER_DEC_FLAG_RELAXED) && BlgpIsFieldOmitted(Field, Base))
+        {
+            SetLastError(ERROR_BLGASN1_CORRUPT);
+
+            return FALSE;
+        }
+
+        Ptr = Node.Value + Node.ValueCb;
+
+        HasNode = FALSE;
+    }
+
+    if (Ptr < End)
+    {
+        SetLastError(ERROR_BLGASN1_BADTAG);
+
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncodeStruct(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN DWORD Tag,
+    IN PCBLG_DER_STRUCT Struct,
+    IN CONST VOID *Value
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes a C structure as an ASN.1 SEQUENCE node in the specified mode.
+
+--*/
+
+{
+    BLGP_STRUCT_ENCODER StructEncoder;
+    ULONGLONG ContentCb, TotalCb;
+    BOOL IsOk = FALSE;
+    PBYTE Ptr;
+
+    if (Class == BLG_DER_CLASS_UNIVERSAL && Tag == 0)
+    {
+        Tag = BLG_DER_TAG_SEQUENCE;
+    }
+
+    StructEncoder.Sizes = StructEncoder.InlineSizes;
+    StructEncoder.SizeCount = 0;
+    StructEncoder.SizeCapacity = BLGP_STRUCT_INLINE_SIZES;
+    StructEncoder.NextSize = 0;
+
+    if (!BlgpMeasureStruct(&StructEncoder, Struct, Value, &ContentCb))
+    {
+        goto Leave;
+    }
+
+    TotalCb = BlgpTagOctetCount(Tag) + BlgpLenOctetCount((DWORD) ContentCb) + ContentCb;
+
+    if (ContentCb > MAXDWORD || TotalCb > MAXDWORD)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        goto Leave;
+    }
+
+    if (!BlgpReserveNode(Mode, Encoder, Class, TRUE, Tag, (DWORD) ContentCb, &Ptr))
+    {
+        goto Leave;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        StructEncoder.End = BlgpWritableEnd(Mode, Encoder);
+
+        BlgpWriteStruct(&StructEncoder, Struct, Value, Ptr);
+    }
+
+    IsOk = TRUE;
+
+Leave:
+    if (StructEncoder.Sizes != StructEncoder.InlineSizes)
+    {
+        HeapFree(g_Heap, 0, StructEncoder.Sizes);
+    }
+
+    return IsOk;
+}
\ No newline at end of file
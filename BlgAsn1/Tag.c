@@ -11,6 +11,36 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncTag(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN BOOLEAN Constructed,
+    IN DWORD Tag
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncPreparedTag(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncTag,
+    (PBLGP_DER_ENCODER Encoder, BYTE Class, BOOLEAN Constructed, DWORD Tag),
+    (Encoder, Class, Constructed, Tag));
+
+BLGP_DER_ENC_INSTANCES(BlgpEncPreparedTag,
+    (PBLGP_DER_ENCODER Encoder, PCBLG_DER_PREPARED_TAG PreparedTag),
+    (Encoder, PreparedTag));
+
 BOOL
 BLGASN1CALL
 BlgDerEncTag(
@@ -44,7 +74,6 @@ Return Value:
 
 {
     PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
-    BYTE OctetCount, i;
 
     if (!Encoder)
     {
@@ -53,71 +82,92 @@ Return Value:
         return FALSE;
     }
 
-    if (Tag <= 30)
-    {
-        OctetCount = 1;
-    }
-    else
-    {
-        for (i = 0; i < 28; i++)
-        {
-            if (Tag & (0x80000000 >> i))
-            {
-                OctetCount = ((32 - i) / 7) + (((32 - i) % 7) > 0 ? 1 : 0) + 1;
+    return BlgpEncTagInstances[Encoder->Mode](Encoder, Class, Constructed, Tag);
+}
 
-                break;
-            }
-        }
-    }
+BOOL
+BLGASN1CALL
+BlgDerPrepareTag(
+    IN BYTE Class,
+    IN BOOLEAN Constructed,
+    IN DWORD Tag,
+    OUT PBLG_DER_PREPARED_TAG PreparedTag
+    )
 
-    if (Encoder->Buffer)
-    {
-        if (BLGP_DER_ENCODED_CB(Encoder) + OctetCount > Encoder->BufferCb)
-        {
-            SetLastError(ERROR_INSUFFICIENT_BUFFER);
+/*++
 
-            return FALSE;
-        }
+Routine Description:
 
-        if (OctetCount == 1)
-        {
-            Encoder->Ptr[0] = (BYTE) Tag;
-        }
-        else
-        {
-            Encoder->Ptr[0] = (BYTE) 0x1F;
+    Encodes the identifier octets of an ASN.1 DER tag in advance so that they can be written by
+    BlgDerEncPreparedTag and matched by BlgDerComparePreparedTag without being encoded again.
 
-            OctetCount--;
+Arguments:
 
-            for (i = 0; i < OctetCount; i++)
-            {
-                Encoder->Ptr[OctetCount - i] = (BYTE) ((Tag & (0x7F << (i * 7))) >> (i * 7));
+    Class - Class.
 
-                if (i)
-                {
-                    Encoder->Ptr[OctetCount - i] |= 0x80;
-                }
-            }
+    Constructed - Boolean value indicating whether the node is constructed.
 
-            OctetCount++;
-        }
+    Tag - Tag.
 
-        if (Constructed)
-        {
-            Encoder->Ptr[0] |= 0x20;
-        }
+    PreparedTag - Pointer to a structure that receives the encoded identifier octets.
 
-        if (Class != BLG_DER_CLASS_UNIVERSAL)
-        {
-            Encoder->Ptr[0] |= (Class << 6);
-        }
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    if (!PreparedTag || Class > BLG_DER_CLASS_PRIVATE)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
     }
 
-    Encoder->Ptr += OctetCount;
+    PreparedTag->OctetCount = (BYTE) BlgpWriteTag(PreparedTag->Octets, Class, Constructed, Tag);
 
     return TRUE;
 }
 
+BOOL
+BLGASN1CALL
+BlgDerEncPreparedTag(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag
+    )
+
+/*++
+
+Routine Description:
+
+    Writes the identifier octets of a tag prepared by BlgDerPrepareTag.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    PreparedTag - Pointer to the prepared tag.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+
+    if (!Encoder || !PreparedTag)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncPreparedTagInstances[Encoder->Mode](Encoder, PreparedTag);
+}
+
 BOOL
 BLGASN1CALL
 BlgDerDecTag(
@@ -283,5 +333,138 @@ Return Value:
         *IsEqual = TRUE;
     }
 
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerComparePreparedTag(
+    IN HBLG_DER_DECODER DecoderHandle,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag,
+    OUT PBOOL IsEqual
+    )
+
+/*++
+
+Routine Description:
+
+    Compares the tag of the current node with a tag prepared by BlgDerPrepareTag. The identifier
+    octets of the node are compared directly; the tag is not decoded.
+
+Arguments:
+
+    DecoderHandle - Handle to the decoder to be used.
+
+    PreparedTag - Pointer to the prepared tag to be compared.
+
+    IsEqual - Pointer to a variable that receives whether the current tag equals the specified tag.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_DECODER Decoder = (PBLGP_DER_DECODER) DecoderHandle;
+    CONST BYTE *Ptr;
+
+    if (!PreparedTag || !IsEqual)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+    else
+    {
+        *IsEqual = FALSE;
+    }
+
+    if (!BlgpValidateState(Decoder))
+    {
+        return FALSE;
+    }
+
+    Ptr = Decoder->CurrentNode.Tag;
+
+    // A node header shorter than the prepared identifier cannot match; checking it first keeps
+    // the comparison within the encoded data.
+    if (*Ptr == PreparedTag->Octets[0] &&
+        (DWORD) (Decoder->CurrentNode.Value - Ptr) >= PreparedTag->OctetCount &&
+        RtlEqualMemory(Ptr + 1, PreparedTag->Octets + 1, PreparedTag->OctetCount - 1))
+    {
+        *IsEqual = TRUE;
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncTag(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN BYTE Class,
+    IN BOOLEAN Constructed,
+    IN DWORD Tag
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an ASN.1 DER tag in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    if (!BlgpReserve(Mode, Encoder, BlgpTagOctetCount(Tag), &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        BlgpWriteTag(Ptr, Class, Constructed, Tag);
+    }
+
+    return TRUE;
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncPreparedTag(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN PCBLG_DER_PREPARED_TAG PreparedTag
+    )
+
+/*++
+
+Routine Description:
+
+    Writes the identifier octets of a prepared tag in the specified mode.
+
+--*/
+
+{
+    PBYTE Ptr;
+
+    if (!BlgpReserve(Mode, Encoder, PreparedTag->OctetCount, &Ptr))
+    {
+        return FALSE;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        CopyMemory(Ptr, PreparedTag->Octets, PreparedTag->OctetCount);
+    }
+
     return TRUE;
 }
\ No newline at end of file
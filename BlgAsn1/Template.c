@@ -0,0 +1,742 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+--*/
+
+#include <windows.h>
+
+#include "BlgAsn1.h"
+#include "BlgAsn1p.h"
+
+// Marks a patch that is not a slot or that has no enclosing patch.
+#define BLGP_TEMPLATE_NONE 0xFFFFFFFF
+
+// Templates with at most this many patches are instantiated without allocating memory.
+#define BLGP_TEMPLATE_INLINE_LENGTHS 32
+
+// Node of a template whose octets change when the template is instantiated. A slot patch
+// replaces the length and content octets of a slot; a node patch rewrites the length octets
+// of a node enclosing slots whose size may change.
+typedef struct _BLGP_DER_PATCH
+{
+    DWORD Offset;   // Offset of the length octets in the recorded encoding.
+    DWORD LenCb;    // Number of recorded length octets.
+    DWORD ValueCb;  // Number of recorded content octets.
+    DWORD Slot;     // Index of the slot, or BLGP_TEMPLATE_NONE for a node patch.
+    DWORD Parent;   // Index of the enclosing node patch, or BLGP_TEMPLATE_NONE.
+
+} BLGP_DER_PATCH, *PBLGP_DER_PATCH;
+
+typedef CONST BLGP_DER_PATCH *PCBLGP_DER_PATCH;
+
+typedef struct _BLGP_DER_TEMPLATE
+{
+    // Patches in ascending order of their offsets, so that every node patch precedes the
+    // patches it encloses.
+    PBLGP_DER_PATCH Patches;
+    DWORD PatchCount;
+
+    PDWORD SlotFlags;
+    DWORD SlotCount;
+
+    PBYTE Encoded;
+    DWORD EncodedCb;
+
+} BLGP_DER_TEMPLATE, *PBLGP_DER_TEMPLATE;
+
+typedef struct _BLGP_TEMPLATE_BUILDER
+{
+    PBLGP_DER_PATCH Patches;
+    DWORD PatchCount;
+    DWORD PatchCapacity;
+
+} BLGP_TEMPLATE_BUILDER, *PBLGP_TEMPLATE_BUILDER;
+
+static
+BOOL
+BLGASN1CALL
+BlgpAddPatch(
+    IN OUT PBLGP_TEMPLATE_BUILDER Builder,
+    IN CONST BLGP_DER_PATCH *Patch
+    );
+
+static
+BOOL
+BLGASN1CALL
+BlgpAddSlotPatches(
+    IN OUT PBLGP_TEMPLATE_BUILDER Builder,
+    IN CONST BYTE *Encoded,
+    IN DWORD EncodedCb,
+    IN DWORD SlotOffset,
+    IN DWORD Slot,
+    IN BOOL Fixed,
+    OUT PDWORD SlotEnd
+    );
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncTemplate(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN PBLGP_DER_TEMPLATE Template,
+    IN PCBLG_DER_SLOT_VALUE Values
+    );
+
+BLGP_DER_ENC_INSTANCES(BlgpEncTemplate,
+    (PBLGP_DER_ENCODER Encoder, PBLGP_DER_TEMPLATE Template, PCBLG_DER_SLOT_VALUE Values),
+    (Encoder, Template, Values));
+
+BOOL
+BLGASN1CALL
+BlgDerMarkSlot(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN DWORD Flags
+    )
+
+/*++
+
+Routine Description:
+
+    Marks the node encoded next as a slot of a template to be created by BlgDerCreateTemplate.
+    The slots are numbered in the order in which they are marked.
+
+    A slot must not enclose another slot and must not be an element of a SET OF node ended by
+    BlgDerEndSetOf, whose elements are ordered by value.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    Flags - Additional settings for the slot. The following flags are defined:
+
+        BLG_DER_SLOT_FLAG_FIXED - The content of the slot always has the size of the recorded
+            content. The length octets of the enclosing nodes are then copied as recorded.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+    PBLGP_DER_ENCODER_SLOT Slots;
+
+    if (!Encoder || (Flags & ~BLG_DER_SLOT_FLAG_FIXED) != 0)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    if (Encoder->SlotCount == Encoder->SlotCapacity)
+    {
+        if (Encoder->SlotCapacity > MAXDWORD / (2 * sizeof(BLGP_DER_ENCODER_SLOT)))
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+
+        if (!Encoder->Slots)
+        {
+            Slots = HeapAlloc(g_Heap, 0, 8 * sizeof(BLGP_DER_ENCODER_SLOT));
+        }
+        else
+        {
+            Slots = HeapReAlloc(g_Heap, 0, Encoder->Slots, Encoder->SlotCapacity * 2 * sizeof(BLGP_DER_ENCODER_SLOT));
+        }
+
+        if (!Slots)
+        {
+            SetLastError(ERROR_OUTOFMEMORY);
+
+            return FALSE;
+        }
+
+        Encoder->Slots = Slots;
+        Encoder->SlotCapacity = Encoder->SlotCapacity ? Encoder->SlotCapacity * 2 : 8;
+    }
+
+    Encoder->Slots[Encoder->SlotCount].Offset = BLGP_DER_ENCODED_CB(Encoder);
+    Encoder->Slots[Encoder->SlotCount].Flags = Flags;
+
+    Encoder->SlotCount++;
+
+    return TRUE;
+}
+
+HBLG_DER_TEMPLATE
+BLGASN1CALL
+BlgDerCreateTemplate(
+    IN HBLG_DER_ENCODER EncoderHandle
+    )
+
+/*++
+
+Routine Description:
+
+    Creates a template from the data encoded so far and the slots marked by BlgDerMarkSlot. The
+    encoded data becomes the constant part of the template. For every slot, and for every node
+    enclosing a slot that is not fixed, the template records the position of the length octets,
+    so that BlgDerEncTemplate only rewrites those and copies everything else.
+
+    The encoder is not changed and may be destroyed once the template is created.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder holding the recorded data. All constructed nodes must
+        have been ended.
+
+Return Value:
+
+    Handle to the template if the routine succeeds; otherwise, NULL. The routine fails with
+    ERROR_INVALID_STATE if the encoder only measures, if a constructed node is still open or if a
+    slot does not mark a node that can be replaced.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+    PBLGP_DER_TEMPLATE Template = NULL;
+    BLGP_TEMPLATE_BUILDER Builder;
+    BLGP_DER_PATCH Patch;
+    PDWORD Order = NULL, Stack;
+    DWORD EncodedCb, SlotEnd, MaxSlotEnd = 0, StackCount = 0, Slot, i, j;
+    SIZE_T PatchesCb, FlagsCb;
+
+    if (!Encoder)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return NULL;
+    }
+
+    if (Encoder->Mode == BLGP_DER_ENC_MODE_MEASURE || Encoder->Stack.Next)
+    {
+        SetLastError(ERROR_INVALID_STATE);
+
+        return NULL;
+    }
+
+    EncodedCb = BLGP_DER_ENCODED_CB(Encoder);
+
+    ZeroMemory(&Builder, sizeof(Builder));
+
+    if (Encoder->SlotCount > 0)
+    {
+        Order = HeapAlloc(g_Heap, 0, Encoder->SlotCount * sizeof(DWORD));
+        if (!Order)
+        {
+            SetLastError(ERROR_OUTOFMEMORY);
+
+            return NULL;
+        }
+    }
+
+    // Visit the slots in ascending order of their offsets. The slots are usually marked in that
+    // order already.
+    for (i = 0; i < Encoder->SlotCount; i++)
+    {
+        for (j = i; j > 0 && Encoder->Slots[Order[j - 1]].Offset > Encoder->Slots[i].Offset; j--)
+        {
+            Order[j] = Order[j - 1];
+        }
+
+        Order[j] = i;
+    }
+
+    for (i = 0; i < Encoder->SlotCount; i++)
+    {
+        Slot = Order[i];
+
+        // A slot starting inside the previous one is nested in it or marks the same node.
+        if (i > 0 && Encoder->Slots[Slot].Offset < MaxSlotEnd)
+        {
+            SetLastError(ERROR_INVALID_STATE);
+
+            goto Leave;
+        }
+
+        if (!BlgpAddSlotPatches(&Builder, Encoder->Buffer, EncodedCb, Encoder->Slots[Slot].Offset, Slot,
+                BLGASN1_FLAGON(Encoder->Slots[Slot].Flags, BLG_DER_SLOT_FLAG_FIXED), &SlotEnd))
+        {
+            goto Leave;
+        }
+
+        MaxSlotEnd = SlotEnd;
+    }
+
+    // Node patches are added in ascending order of their offsets, but the patches of fixed slots
+    // may precede the nodes added for later slots that enclose them.
+    for (i = 1; i < Builder.PatchCount; i++)
+    {
+        Patch = Builder.Patches[i];
+
+        for (j = i; j > 0 && Builder.Patches[j - 1].Offset > Patch.Offset; j--)
+        {
+            Builder.Patches[j] = Builder.Patches[j - 1];
+        }
+
+        Builder.Patches[j] = Patch;
+    }
+
+    PatchesCb = Builder.PatchCount * sizeof(BLGP_DER_PATCH);
+    FlagsCb = Encoder->SlotCount * sizeof(DWORD);
+
+    Template = HeapAlloc(g_Heap, 0, sizeof(BLGP_DER_TEMPLATE) + PatchesCb + FlagsCb + EncodedCb);
+    if (!Template)
+    {
+        SetLastError(ERROR_OUTOFMEMORY);
+
+        goto Leave;
+    }
+
+    Template->Patches = (PBLGP_DER_PATCH) (Template + 1);
+    Template->PatchCount = Builder.PatchCount;
+    Template->SlotFlags = (PDWORD) ((PBYTE) Template->Patches + PatchesCb);
+    Template->SlotCount = Encoder->SlotCount;
+    Template->Encoded = (PBYTE) Template->SlotFlags + FlagsCb;
+    Template->EncodedCb = EncodedCb;
+
+    if (Builder.PatchCount > 0)
+    {
+        CopyMemory(Template->Patches, Builder.Patches, PatchesCb);
+    }
+
+    for (i = 0; i < Encoder->SlotCount; i++)
+    {
+        Template->SlotFlags[i] = Encoder->Slots[i].Flags;
+    }
+
+    CopyMemory(Template->Encoded, Encoder->Buffer, EncodedCb);
+
+    // Link every patch to the innermost node patch enclosing it. The open node patches are kept
+    // on a stack in the memory of the builder, whose patches have been copied.
+    Stack = (PDWORD) Builder.Patches;
+
+    for (i = 0; i < Template->PatchCount; i++)
+    {
+        PBLGP_DER_PATCH Current = Template->Patches + i;
+
+        while (StackCount > 0)
+        {
+            PCBLGP_DER_PATCH Top = Template->Patches + Stack[StackCount - 1];
+
+            if (Current->Offset < Top->Offset + Top->LenCb + Top->ValueCb)
+            {
+                break;
+            }
+
+            StackCount--;
+        }
+
+        if (Current->Slot != BLGP_TEMPLATE_NONE && BLGASN1_FLAGON(Template->SlotFlags[Current->Slot], BLG_DER_SLOT_FLAG_FIXED))
+        {
+            Current->Parent = BLGP_TEMPLATE_NONE;
+        }
+        else
+        {
+            Current->Parent = StackCount > 0 ? Stack[StackCount - 1] : BLGP_TEMPLATE_NONE;
+        }
+
+        if (Current->Slot == BLGP_TEMPLATE_NONE)
+        {
+            Stack[StackCount++] = i;
+        }
+    }
+
+Leave:
+    if (Builder.Patches)
+    {
+        HeapFree(g_Heap, 0, Builder.Patches);
+    }
+
+    if (Order)
+    {
+        HeapFree(g_Heap, 0, Order);
+    }
+
+    return (HBLG_DER_TEMPLATE) Template;
+}
+
+BOOL
+BLGASN1CALL
+BlgDerDestroyTemplate(
+    IN HBLG_DER_TEMPLATE TemplateHandle
+    )
+
+/*++
+
+Routine Description:
+
+    Destroys the specified template.
+
+Arguments:
+
+    TemplateHandle - Handle to the template to be destroyed.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    if (!TemplateHandle)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return HeapFree(g_Heap, 0, TemplateHandle);
+}
+
+BOOL
+BLGASN1CALL
+BlgDerEncTemplate(
+    IN HBLG_DER_ENCODER EncoderHandle,
+    IN HBLG_DER_TEMPLATE TemplateHandle,
+    IN PCBLG_DER_SLOT_VALUE Values,
+    IN DWORD ValueCount
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an instance of a template. The constant octets of the template are copied, the
+    content octets of every slot are replaced by the specified value and the length octets of
+    the slots and the enclosing nodes are rewritten for the new sizes. No tag is encoded.
+
+Arguments:
+
+    EncoderHandle - Handle to the encoder to be used.
+
+    TemplateHandle - Handle to the template created by BlgDerCreateTemplate.
+
+    Values - Array of the content octets of the slots, in the order in which the slots were
+        marked. The values must be valid content octets for the type of their nodes. If the Value
+        member of an element is NULL, the recorded content of the slot is kept.
+
+    ValueCount - Number of elements in the Values parameter. It must equal the number of slots
+        of the template.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE. The routine fails with
+    ERROR_INVALID_PARAMETER if the value of a fixed slot does not have the recorded size.
+
+--*/
+
+{
+    PBLGP_DER_ENCODER Encoder = (PBLGP_DER_ENCODER) EncoderHandle;
+    PBLGP_DER_TEMPLATE Template = (PBLGP_DER_TEMPLATE) TemplateHandle;
+
+    if (!Encoder || !Template || ValueCount != Template->SlotCount || (!Values && ValueCount > 0))
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+
+        return FALSE;
+    }
+
+    return BlgpEncTemplateInstances[Encoder->Mode](Encoder, Template, Values);
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpAddPatch(
+    IN OUT PBLGP_TEMPLATE_BUILDER Builder,
+    IN CONST BLGP_DER_PATCH *Patch
+    )
+{
+    PBLGP_DER_PATCH Patches;
+
+    if (Builder->PatchCount == Builder->PatchCapacity)
+    {
+        if (Builder->PatchCapacity > MAXDWORD / (2 * sizeof(BLGP_DER_PATCH)))
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            return FALSE;
+        }
+
+        if (!Builder->Patches)
+        {
+            Patches = HeapAlloc(g_Heap, 0, 16 * sizeof(BLGP_DER_PATCH));
+        }
+        else
+        {
+            Patches = HeapReAlloc(g_Heap, 0, Builder->Patches, Builder->PatchCapacity * 2 * sizeof(BLGP_DER_PATCH));
+        }
+
+        if (!Patches)
+        {
+            SetLastError(ERROR_OUTOFMEMORY);
+
+            return FALSE;
+        }
+
+        Builder->Patches = Patches;
+        Builder->PatchCapacity = Builder->PatchCapacity ? Builder->PatchCapacity * 2 : 16;
+    }
+
+    Builder->Patches[Builder->PatchCount++] = *Patch;
+
+    return TRUE;
+}
+
+static
+BOOL
+BLGASN1CALL
+BlgpAddSlotPatches(
+    IN OUT PBLGP_TEMPLATE_BUILDER Builder,
+    IN CONST BYTE *Encoded,
+    IN DWORD EncodedCb,
+    IN DWORD SlotOffset,
+    IN DWORD Slot,
+    IN BOOL Fixed,
+    OUT PDWORD SlotEnd
+    )
+
+/*++
+
+Routine Description:
+
+    Locates the node of a slot by descending from the top level of the recorded data and adds the
+    patch of the slot. Unless the slot is fixed, a node patch is added for every enclosing node
+    that does not have one yet.
+
+Arguments:
+
+    SlotOffset - Offset of the identifier octets of the slot node.
+
+    Slot - Index of the slot.
+
+    Fixed - TRUE if the slot has the BLG_DER_SLOT_FLAG_FIXED flag.
+
+    SlotEnd - Pointer to a variable that receives the offset following the slot node.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    CONST BYTE *Ptr = Encoded, *End = Encoded + EncodedCb, *Target = Encoded + SlotOffset;
+    BLGP_DER_DECODER_NODE Node;
+    BLGP_DER_PATCH Patch;
+    DWORD i;
+
+    for (;;)
+    {
+        if (Ptr >= End || Ptr > Target)
+        {
+            SetLastError(ERROR_INVALID_STATE);
+
+            return FALSE;
+        }
+
+        if (!BlgpMoveToNode(Encoded, EncodedCb, Ptr, &Node))
+        {
+            return FALSE;
+        }
+
+        Patch.Offset = (DWORD) (Node.Value - Encoded) - BlgpLenOctetCount(Node.ValueCb);
+        Patch.LenCb = BlgpLenOctetCount(Node.ValueCb);
+        Patch.ValueCb = Node.ValueCb;
+        Patch.Parent = BLGP_TEMPLATE_NONE;
+
+        if (Ptr == Target)
+        {
+            break;
+        }
+
+        Ptr = Node.Value + Node.ValueCb;
+
+        if (Target >= Ptr)
+        {
+            continue;
+        }
+
+        // The slot lies inside the node, which must be constructed.
+        if (Target < Node.Value || !BLGASN1_FLAGON(*Node.Tag, 0x20))
+        {
+            SetLastError(ERROR_INVALID_STATE);
+
+            return FALSE;
+        }
+
+        if (!Fixed)
+        {
+            Patch.Slot = BLGP_TEMPLATE_NONE;
+
+            // Node patches are added in ascending order of their offsets, so an existing patch
+            // for the node is found before any node patch with a lower offset.
+            for (i = Builder->PatchCount; i > 0; i--)
+            {
+                if (Builder->Patches[i - 1].Slot == BLGP_TEMPLATE_NONE && Builder->Patches[i - 1].Offset <= Patch.Offset)
+                {
+                    break;
+                }
+            }
+
+            if (i == 0 || Builder->Patches[i - 1].Offset != Patch.Offset)
+            {
+                if (!BlgpAddPatch(Builder, &Patch))
+                {
+                    return FALSE;
+                }
+            }
+        }
+
+        Ptr = Node.Value;
+    }
+
+    Patch.Slot = Slot;
+
+    *SlotEnd = (DWORD) (Node.Value - Encoded) + Node.ValueCb;
+
+    return BlgpAddPatch(Builder, &Patch);
+}
+
+static
+__forceinline
+BOOL
+BLGASN1INLINECALL
+BlgpEncTemplate(
+    IN DWORD Mode,
+    IN PBLGP_DER_ENCODER Encoder,
+    IN PBLGP_DER_TEMPLATE Template,
+    IN PCBLG_DER_SLOT_VALUE Values
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes an instance of a template in the specified mode.
+
+--*/
+
+{
+    ULONGLONG InlineLengths[BLGP_TEMPLATE_INLINE_LENGTHS];
+    PULONGLONG Lengths = InlineLengths;
+    PCBLGP_DER_PATCH Patch;
+    PCBLG_DER_SLOT_VALUE Value;
+    ULONGLONG TotalCb;
+    PBYTE Ptr;
+    DWORD Offset, i;
+    BOOL IsOk = FALSE;
+
+    if (Template->PatchCount > BLGP_TEMPLATE_INLINE_LENGTHS)
+    {
+        Lengths = HeapAlloc(g_Heap, 0, Template->PatchCount * sizeof(ULONGLONG));
+        if (!Lengths)
+        {
+            SetLastError(ERROR_OUTOFMEMORY);
+
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < Template->PatchCount; i++)
+    {
+        Patch = Template->Patches + i;
+
+        Lengths[i] = Patch->ValueCb;
+
+        if (Patch->Slot != BLGP_TEMPLATE_NONE && Values[Patch->Slot].Value)
+        {
+            Lengths[i] = Values[Patch->Slot].ValueCb;
+
+            if (BLGASN1_FLAGON(Template->SlotFlags[Patch->Slot], BLG_DER_SLOT_FLAG_FIXED) && Lengths[i] != Patch->ValueCb)
+            {
+                SetLastError(ERROR_INVALID_PARAMETER);
+
+                goto Leave;
+            }
+        }
+    }
+
+    TotalCb = Template->EncodedCb;
+
+    // Enclosed patches follow their node patches, so the sizes are final when they are reached
+    // from the end. The change in size of every patch is added to the enclosing node patch.
+    for (i = Template->PatchCount; i > 0; i--)
+    {
+        Patch = Template->Patches + i - 1;
+
+        if (Lengths[i - 1] > MAXDWORD)
+        {
+            SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+            goto Leave;
+        }
+
+        if (Patch->Parent != BLGP_TEMPLATE_NONE)
+        {
+            Lengths[Patch->Parent] += BlgpLenOctetCount((DWORD) Lengths[i - 1]) + Lengths[i - 1] - Patch->LenCb - Patch->ValueCb;
+        }
+        else
+        {
+            TotalCb += BlgpLenOctetCount((DWORD) Lengths[i - 1]) + Lengths[i - 1] - Patch->LenCb - Patch->ValueCb;
+        }
+    }
+
+    if (TotalCb > MAXDWORD)
+    {
+        SetLastError(ERROR_BLGASN1_TOO_LARGE);
+
+        goto Leave;
+    }
+
+    if (!BlgpReserve(Mode, Encoder, TotalCb, &Ptr))
+    {
+        goto Leave;
+    }
+
+    if (Mode != BLGP_DER_ENC_MODE_MEASURE)
+    {
+        for (Offset = 0, i = 0; i < Template->PatchCount; i++)
+        {
+            Patch = Template->Patches + i;
+
+            CopyMemory(Ptr, Template->Encoded + Offset, Patch->Offset - Offset);
+            Ptr += Patch->Offset - Offset;
+
+            Ptr += BlgpWriteLen(Ptr, (DWORD) Lengths[i]);
+            Offset = Patch->Offset + Patch->LenCb;
+
+            if (Patch->Slot != BLGP_TEMPLATE_NONE)
+            {
+                Value = Values + Patch->Slot;
+
+                CopyMemory(Ptr, Value->Value ? Value->Value : Template->Encoded + Offset, (DWORD) Lengths[i]);
+                Ptr += (DWORD) Lengths[i];
+
+                Offset += Patch->ValueCb;
+            }
+        }
+
+        CopyMemory(Ptr, Template->Encoded + Offset, Template->EncodedCb - Offset);
+    }
+
+    IsOk = TRUE;
+
+Leave:
+    if (Lengths != InlineLengths)
+    {
+        HeapFree(g_Heap, 0, Lengths);
+    }
+
+    return IsOk;
+}
\ No newline at end of file
@@ -11,67 +11,1125 @@ See License.txt in the project root for license information.
 #include "BlgAsn1.h"
 #include "BlgAsn1p.h"
 
+// Instruction sets reported by the processor, or -1 until they are queried.
+static volatile LONG BlgpCpuFeatures = -1;
+
+DWORD
+BLGASN1CALL
+BlgpGetCpuFeatures(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the instruction sets beyond SSE2 that the processor and the operating system
+    support, as BLGP_CPU_FEATURE_* flags. The processor is queried on the first call only;
+    concurrent first calls store the same value.
+
+--*/
+
+{
+    LONG Features = BlgpCpuFeatures;
+#ifdef BLGP_SSE2
+    INT Info[4];
+    INT MaxLeaf;
+#endif
+
+    if (Features >= 0)
+    {
+        return (DWORD) Features;
+    }
+
+    Features = 0;
+
+#ifdef BLGP_SSE2
+    __cpuid(Info, 0);
+    MaxLeaf = Info[0];
+
+    __cpuid(Info, 1);
+
+    if (Info[2] & (1 << 9))
+    {
+        Features |= BLGP_CPU_FEATURE_SSSE3;
+    }
+
+    // AVX2 also requires the operating system to save the YMM registers (OSXSAVE, AVX and the
+    // SSE and AVX state bits of XCR0).
+    if (MaxLeaf >= 7 && (Info[2] & (1 << 27)) && (Info[2] & (1 << 28)) && (_xgetbv(0) & 0x06) == 0x06)
+    {
+        __cpuidex(Info, 7, 0);
+
+        if (Info[1] & (1 << 5))
+        {
+            Features |= BLGP_CPU_FEATURE_AVX2;
+        }
+    }
+#endif
+
+    BlgpCpuFeatures = Features;
+
+    return (DWORD) Features;
+}
+
 VOID
 BLGASN1CALL
-BlgpCopyMemory(
+BlgpReverseMemory(
     IN PBYTE Destination,
     IN CONST BYTE *Source,
     IN DWORD Cb
     )
+
+/*++
+
+Routine Description:
+
+    This routine copies the specified buffer in reverse byte order. The buffers must not overlap.
+
+--*/
+
+{
+    DWORD i = 0;
+
+    switch (Cb)
+    {
+    case 2:
+        *(WORD UNALIGNED *) Destination = BlgpByteSwap16(*(CONST WORD UNALIGNED *) Source);
+
+        return;
+
+    case 4:
+        *(DWORD UNALIGNED *) Destination = BlgpByteSwap32(*(CONST DWORD UNALIGNED *) Source);
+
+        return;
+
+    case 8:
+        *(ULONGLONG UNALIGNED *) Destination = BlgpByteSwap64(*(CONST ULONGLONG UNALIGNED *) Source);
+
+        return;
+    }
+
+#ifdef BLGP_SSE2
+    // Reverse 16 octets at a time. The octets are swapped within each word first, then the words
+    // within each quadword and finally the two quadwords.
+    for (; i + 16 <= Cb; i += 16)
+    {
+        __m128i Block = _mm_loadu_si128((CONST __m128i *) (Source + Cb - i - 16));
+
+        Block = _mm_or_si128(_mm_slli_epi16(Block, 8), _mm_srli_epi16(Block, 8));
+        Block = _mm_shufflelo_epi16(Block, _MM_SHUFFLE(0, 1, 2, 3));
+        Block = _mm_shufflehi_epi16(Block, _MM_SHUFFLE(0, 1, 2, 3));
+        Block = _mm_shuffle_epi32(Block, _MM_SHUFFLE(1, 0, 3, 2));
+
+        _mm_storeu_si128((__m128i *) (Destination + i), Block);
+    }
+#endif
+
+    for (; i + 8 <= Cb; i += 8)
+    {
+        *(ULONGLONG UNALIGNED *) (Destination + i) =
+            BlgpByteSwap64(*(CONST ULONGLONG UNALIGNED *) (Source + Cb - i - 8));
+    }
+
+    for (; i < Cb; i++)
+    {
+        Destination[i] = Source[Cb - 1 - i];
+    }
+}
+
+#ifdef BLGP_SSE2
+
+// Error classes of two consecutive octets for the validation of UTF-8 by lookup tables. The high
+// and the low nibble of the first octet and the high nibble of the second octet each select a set
+// of classes; the octets are in error if all three sets share a class.
+#define BLGP_UTF8_TOO_SHORT         0x01 // A lead octet is followed by an ASCII or lead octet.
+#define BLGP_UTF8_TOO_LONG          0x02 // An ASCII octet is followed by a continuation octet.
+#define BLGP_UTF8_OVERLONG_3        0x04 // 11100000 100xxxxx
+#define BLGP_UTF8_TOO_LARGE         0x08 // 11110100 1001xxxx, 11110100 101xxxxx and larger leads
+#define BLGP_UTF8_SURROGATE         0x10 // 11101101 101xxxxx
+#define BLGP_UTF8_OVERLONG_2        0x20 // 1100000x 10xxxxxx
+#define BLGP_UTF8_TOO_LARGE_1000    0x40 // 11110101 1000xxxx and larger leads; 11110000 1000xxxx
+#define BLGP_UTF8_TWO_CONTS         0x80 // Two continuation octets, valid only inside a sequence.
+
+#define BLGP_UTF8_CARRY (BLGP_UTF8_TOO_SHORT | BLGP_UTF8_TOO_LONG | BLGP_UTF8_TWO_CONTS)
+
+// Classes selected by the high nibble of the first octet.
+static CONST BYTE BlgpUtf8FirstHigh[16] =
+{
+    BLGP_UTF8_TOO_LONG, BLGP_UTF8_TOO_LONG, BLGP_UTF8_TOO_LONG, BLGP_UTF8_TOO_LONG,
+    BLGP_UTF8_TOO_LONG, BLGP_UTF8_TOO_LONG, BLGP_UTF8_TOO_LONG, BLGP_UTF8_TOO_LONG,
+    BLGP_UTF8_TWO_CONTS, BLGP_UTF8_TWO_CONTS, BLGP_UTF8_TWO_CONTS, BLGP_UTF8_TWO_CONTS,
+    BLGP_UTF8_TOO_SHORT | BLGP_UTF8_OVERLONG_2,
+    BLGP_UTF8_TOO_SHORT,
+    BLGP_UTF8_TOO_SHORT | BLGP_UTF8_OVERLONG_3 | BLGP_UTF8_SURROGATE,
+    BLGP_UTF8_TOO_SHORT | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000
+};
+
+// Classes selected by the low nibble of the first octet.
+static CONST BYTE BlgpUtf8FirstLow[16] =
+{
+    BLGP_UTF8_CARRY | BLGP_UTF8_OVERLONG_3 | BLGP_UTF8_OVERLONG_2 | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_OVERLONG_2,
+    BLGP_UTF8_CARRY,
+    BLGP_UTF8_CARRY,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000 | BLGP_UTF8_SURROGATE,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_CARRY | BLGP_UTF8_TOO_LARGE | BLGP_UTF8_TOO_LARGE_1000
+};
+
+// Classes selected by the high nibble of the second octet.
+static CONST BYTE BlgpUtf8SecondHigh[16] =
+{
+    BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT,
+    BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT,
+    BLGP_UTF8_TOO_LONG | BLGP_UTF8_OVERLONG_2 | BLGP_UTF8_TWO_CONTS | BLGP_UTF8_OVERLONG_3 |
+        BLGP_UTF8_TOO_LARGE_1000,
+    BLGP_UTF8_TOO_LONG | BLGP_UTF8_OVERLONG_2 | BLGP_UTF8_TWO_CONTS | BLGP_UTF8_OVERLONG_3 |
+        BLGP_UTF8_TOO_LARGE,
+    BLGP_UTF8_TOO_LONG | BLGP_UTF8_OVERLONG_2 | BLGP_UTF8_TWO_CONTS | BLGP_UTF8_SURROGATE |
+        BLGP_UTF8_TOO_LARGE,
+    BLGP_UTF8_TOO_LONG | BLGP_UTF8_OVERLONG_2 | BLGP_UTF8_TWO_CONTS | BLGP_UTF8_SURROGATE |
+        BLGP_UTF8_TOO_LARGE,
+    BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT, BLGP_UTF8_TOO_SHORT
+};
+
+static
+BOOL
+BLGASN1CALL
+BlgpMeasureUtf8Ssse3(
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    OUT PDWORD DestinationCch
+    )
+
+/*++
+
+Routine Description:
+
+    Validates UTF-8 and counts the code units of its UTF-16 form 16 octets at a time with SSSE3.
+
+    Every octet is classified together with the octet before it by three table lookups, one for
+    each nibble involved; this finds every error except a missing third or fourth octet of a
+    sequence. Those are found by requiring a continuation octet exactly where an octet two or
+    three positions before is a three or four octet lead, which the lookups do not flag as an
+    error on their own. The last block is padded with zero octets, so a sequence cut off by the
+    end of the value is followed by an ASCII octet and found as well.
+
+    Each octet other than a continuation octet starts a character, and four octet sequences
+    become surrogate pairs.
+
+Arguments:
+
+    Value - Pointer to the octets to be validated.
+
+    ValueCb - Size, in bytes, of the octets.
+
+    DestinationCch - Pointer to a variable that receives the number of UTF-16 code units.
+
+Return Value:
+
+    TRUE if the octets are well-formed; otherwise, FALSE.
+
+--*/
+
 {
-    if (BlgpIsLittleEndian())
+    __m128i FirstHigh = _mm_loadu_si128((CONST __m128i *) BlgpUtf8FirstHigh);
+    __m128i FirstLow = _mm_loadu_si128((CONST __m128i *) BlgpUtf8FirstLow);
+    __m128i SecondHigh = _mm_loadu_si128((CONST __m128i *) BlgpUtf8SecondHigh);
+    __m128i Nibble = _mm_set1_epi8(0x0F);
+    __m128i Previous = _mm_setzero_si128(), Error = _mm_setzero_si128(), Cch = _mm_setzero_si128();
+    __m128i Block, First, Classes, Required, Units;
+    BYTE Tail[16];
+    DWORD i = 0;
+
+    for (;;)
     {
-        DWORD i;
-        for (i = 0; i < Cb; i++)
+        if (ValueCb - i >= 16)
+        {
+            Block = _mm_loadu_si128((CONST __m128i *) (Value + i));
+        }
+        else
+        {
+            ZeroMemory(Tail, sizeof(Tail));
+            CopyMemory(Tail, Value + i, ValueCb - i);
+
+            Block = _mm_loadu_si128((CONST __m128i *) Tail);
+        }
+
+        // Blocks of ASCII octets that follow ASCII octets cannot be in error.
+        if (_mm_movemask_epi8(_mm_or_si128(Previous, Block)) != 0)
+        {
+            First = _mm_alignr_epi8(Block, Previous, 15);
+
+            Classes = _mm_and_si128(
+                _mm_and_si128(
+                    _mm_shuffle_epi8(FirstHigh, _mm_and_si128(_mm_srli_epi16(First, 4), Nibble)),
+                    _mm_shuffle_epi8(FirstLow, _mm_and_si128(First, Nibble))),
+                _mm_shuffle_epi8(SecondHigh, _mm_and_si128(_mm_srli_epi16(Block, 4), Nibble)));
+
+            // The high bit is set where the octet two positions before is at least 0xE0 or the
+            // octet three positions before is at least 0xF0.
+            Required = _mm_and_si128(
+                _mm_or_si128(
+                    _mm_subs_epu8(_mm_alignr_epi8(Block, Previous, 14), _mm_set1_epi8(0xE0 - 0x80)),
+                    _mm_subs_epu8(_mm_alignr_epi8(Block, Previous, 13), _mm_set1_epi8(0xF0 - 0x80))),
+                _mm_set1_epi8((CHAR) 0x80));
+
+            Error = _mm_or_si128(Error, _mm_xor_si128(Classes, Required));
+        }
+
+        // One code unit for every octet, less the continuation octets, plus the four octet leads.
+        Units = _mm_add_epi8(_mm_set1_epi8(1), _mm_cmplt_epi8(Block, _mm_set1_epi8((CHAR) 0xC0)));
+        Units = _mm_sub_epi8(Units, _mm_cmpeq_epi8(_mm_max_epu8(Block, _mm_set1_epi8((CHAR) 0xF0)), Block));
+        Cch = _mm_add_epi64(Cch, _mm_sad_epu8(Units, _mm_setzero_si128()));
+
+        Previous = Block;
+
+        if (ValueCb - i < 16)
         {
-            Destination[i] = Source[Cb - 1 - i];
+            break;
         }
+
+        i += 16;
     }
-    else
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(Error, _mm_setzero_si128())) != 0xFFFF)
     {
-        CopyMemory(Destination, Source, Cb);
+        return FALSE;
     }
+
+    // The zero octets that pad the last block were counted as characters.
+    *DestinationCch = _mm_cvtsi128_si32(Cch) + _mm_cvtsi128_si32(_mm_srli_si128(Cch, 8)) -
+        (16 - (ValueCb - i));
+
+    return TRUE;
 }
 
-DWORD
+static
+BOOL
+BLGASN1CALL
+BlgpMeasureUtf8Avx2(
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    OUT PDWORD DestinationCch
+    )
+
+/*++
+
+Routine Description:
+
+    Validates UTF-8 and counts the code units of its UTF-16 form 32 octets at a time with AVX2,
+    as BlgpMeasureUtf8Ssse3 does. The octets before each half of a block are taken from the
+    other half or the previous block, since AVX2 shifts octets within halves only.
+
+--*/
+
+{
+    __m256i FirstHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128((CONST __m128i *) BlgpUtf8FirstHigh));
+    __m256i FirstLow = _mm256_broadcastsi128_si256(_mm_loadu_si128((CONST __m128i *) BlgpUtf8FirstLow));
+    __m256i SecondHigh = _mm256_broadcastsi128_si256(_mm_loadu_si128((CONST __m128i *) BlgpUtf8SecondHigh));
+    __m256i Nibble = _mm256_set1_epi8(0x0F);
+    __m256i Previous = _mm256_setzero_si256(), Error = _mm256_setzero_si256(), Cch = _mm256_setzero_si256();
+    __m256i Block, Before, First, Classes, Required, Units;
+    __m128i Sum;
+    BYTE Tail[32];
+    DWORD i = 0;
+    BOOL Valid;
+
+    for (;;)
+    {
+        if (ValueCb - i >= 32)
+        {
+            Block = _mm256_loadu_si256((CONST __m256i *) (Value + i));
+        }
+        else
+        {
+            ZeroMemory(Tail, sizeof(Tail));
+            CopyMemory(Tail, Value + i, ValueCb - i);
+
+            Block = _mm256_loadu_si256((CONST __m256i *) Tail);
+        }
+
+        if (_mm256_movemask_epi8(_mm256_or_si256(Previous, Block)) != 0)
+        {
+            // The high half of the previous block and the low half of this block.
+            Before = _mm256_permute2x128_si256(Previous, Block, 0x21);
+            First = _mm256_alignr_epi8(Block, Before, 15);
+
+            Classes = _mm256_and_si256(
+                _mm256_and_si256(
+                    _mm256_shuffle_epi8(FirstHigh, _mm256_and_si256(_mm256_srli_epi16(First, 4), Nibble)),
+                    _mm256_shuffle_epi8(FirstLow, _mm256_and_si256(First, Nibble))),
+                _mm256_shuffle_epi8(SecondHigh, _mm256_and_si256(_mm256_srli_epi16(Block, 4), Nibble)));
+
+            Required = _mm256_and_si256(
+                _mm256_or_si256(
+                    _mm256_subs_epu8(_mm256_alignr_epi8(Block, Before, 14), _mm256_set1_epi8(0xE0 - 0x80)),
+                    _mm256_subs_epu8(_mm256_alignr_epi8(Block, Before, 13), _mm256_set1_epi8(0xF0 - 0x80))),
+                _mm256_set1_epi8((CHAR) 0x80));
+
+            Error = _mm256_or_si256(Error, _mm256_xor_si256(Classes, Required));
+        }
+
+        Units = _mm256_add_epi8(_mm256_set1_epi8(1), _mm256_cmpgt_epi8(_mm256_set1_epi8((CHAR) 0xC0), Block));
+        Units = _mm256_sub_epi8(Units,
+            _mm256_cmpeq_epi8(_mm256_max_epu8(Block, _mm256_set1_epi8((CHAR) 0xF0)), Block));
+        Cch = _mm256_add_epi64(Cch, _mm256_sad_epu8(Units, _mm256_setzero_si256()));
+
+        Previous = Block;
+
+        if (ValueCb - i < 32)
+        {
+            break;
+        }
+
+        i += 32;
+    }
+
+    Valid = _mm256_testz_si256(Error, Error);
+
+    Sum = _mm_add_epi64(_mm256_castsi256_si128(Cch), _mm256_extracti128_si256(Cch, 1));
+
+    if (Valid)
+    {
+        *DestinationCch = _mm_cvtsi128_si32(Sum) + _mm_cvtsi128_si32(_mm_srli_si128(Sum, 8)) -
+            (32 - (ValueCb - i));
+    }
+
+    // Avoid the penalty of SSE code running with dirty upper halves of the YMM registers.
+    _mm256_zeroupper();
+
+    return Valid;
+}
+
+#endif
+
+BOOL
+BLGASN1CALL
+BlgpIsValidUtf8(
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb
+    )
+
+/*++
+
+Routine Description:
+
+    Checks whether the specified octets are well-formed UTF-8 as defined by RFC 3629.
+
+--*/
+
+{
+    DWORD Cch;
+
+    return BlgpUtf8ToUtf16(NULL, Value, ValueCb, &Cch);
+}
+
+BOOL
+BLGASN1CALL
+BlgpUtf8ToUtf16(
+    OUT PWSTR Destination OPTIONAL,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    OUT PDWORD DestinationCch
+    )
+
+/*++
+
+Routine Description:
+
+    Converts well-formed UTF-8, as defined by RFC 3629, to UTF-16. Overlong forms, surrogates and
+    code points above U+10FFFF are rejected rather than replaced. Runs of ASCII characters, of
+    which most strings consist, are converted a block at a time; only the multibyte sequences are
+    decoded octet by octet.
+
+    If the octets are only validated and the processor supports AVX2 or SSSE3, they are validated
+    and counted a block at a time by BlgpMeasureUtf8Avx2 or BlgpMeasureUtf8Ssse3 instead.
+
+Arguments:
+
+    Destination - Pointer to a buffer that receives the converted string. The buffer must be large
+        enough to hold the string, which never has more code units than the UTF-8 form has
+        octets. The string is not null-terminated. If this parameter is NULL, the octets are
+        only validated.
+
+    Value - Pointer to the octets to be converted.
+
+    ValueCb - Size, in bytes, of the octets.
+
+    DestinationCch - Pointer to a variable that receives the number of UTF-16 code units.
+
+Return Value:
+
+    TRUE if the octets are well-formed; otherwise, FALSE.
+
+--*/
+
+{
+    CONST BYTE *Ptr = Value, *End = Value + ValueCb;
+    DWORD Cch = 0, Count, CodePoint, i;
+    BYTE Lead, Low, High;
+
+#ifdef BLGP_SSE2
+    if (!Destination)
+    {
+        if (BlgpGetCpuFeatures() & BLGP_CPU_FEATURE_AVX2)
+        {
+            return BlgpMeasureUtf8Avx2(Value, ValueCb, DestinationCch);
+        }
+
+        if (BlgpGetCpuFeatures() & BLGP_CPU_FEATURE_SSSE3)
+        {
+            return BlgpMeasureUtf8Ssse3(Value, ValueCb, DestinationCch);
+        }
+    }
+#endif
+
+    for (;;)
+    {
+#ifdef BLGP_SSE2
+        while (End - Ptr >= 16)
+        {
+            __m128i Block = _mm_loadu_si128((CONST __m128i *) Ptr);
+
+            if (_mm_movemask_epi8(Block) != 0)
+            {
+                break;
+            }
+
+            if (Destination)
+            {
+                _mm_storeu_si128((__m128i *) (Destination + Cch),
+                    _mm_unpacklo_epi8(Block, _mm_setzero_si128()));
+                _mm_storeu_si128((__m128i *) (Destination + Cch + 8),
+                    _mm_unpackhi_epi8(Block, _mm_setzero_si128()));
+            }
+
+            Ptr += 16;
+            Cch += 16;
+        }
+#endif
+
+        while (End - Ptr >= 8 && (*(CONST ULONGLONG UNALIGNED *) Ptr & 0x8080808080808080ULL) == 0)
+        {
+            if (Destination)
+            {
+                for (i = 0; i < 8; i++)
+                {
+                    Destination[Cch + i] = Ptr[i];
+                }
+            }
+
+            Ptr += 8;
+            Cch += 8;
+        }
+
+        for (; Ptr < End && *Ptr < 0x80; Ptr++, Cch++)
+        {
+            if (Destination)
+            {
+                Destination[Cch] = *Ptr;
+            }
+        }
+
+        if (Ptr == End)
+        {
+            *DestinationCch = Cch;
+
+            return TRUE;
+        }
+
+        // The range of the second octet is narrower than that of the other continuation octets
+        // after the leads that could start overlong forms, surrogates or too large code points.
+        Lead = *Ptr++;
+        Low = 0x80;
+        High = 0xBF;
+
+        if (Lead >= 0xC2 && Lead <= 0xDF)
+        {
+            Count = 1;
+            CodePoint = Lead & 0x1F;
+        }
+        else if (Lead >= 0xE0 && Lead <= 0xEF)
+        {
+            Count = 2;
+            CodePoint = Lead & 0x0F;
+
+            if (Lead == 0xE0)
+            {
+                Low = 0xA0;
+            }
+            else if (Lead == 0xED)
+            {
+                High = 0x9F;
+            }
+        }
+        else if (Lead >= 0xF0 && Lead <= 0xF4)
+        {
+            Count = 3;
+            CodePoint = Lead & 0x07;
+
+            if (Lead == 0xF0)
+            {
+                Low = 0x90;
+            }
+            else if (Lead == 0xF4)
+            {
+                High = 0x8F;
+            }
+        }
+        else
+        {
+            return FALSE;
+        }
+
+        if ((DWORD) (End - Ptr) < Count || *Ptr < Low || *Ptr > High)
+        {
+            return FALSE;
+        }
+
+        for (CodePoint = (CodePoint << 6) | (*Ptr++ & 0x3F); --Count > 0; Ptr++)
+        {
+            if ((*Ptr & 0xC0) != 0x80)
+            {
+                return FALSE;
+            }
+
+            CodePoint = (CodePoint << 6) | (*Ptr & 0x3F);
+        }
+
+        if (CodePoint < 0x10000)
+        {
+            if (Destination)
+            {
+                Destination[Cch] = (WCHAR) CodePoint;
+            }
+
+            Cch++;
+        }
+        else
+        {
+            if (Destination)
+            {
+                CodePoint -= 0x10000;
+
+                Destination[Cch] = (WCHAR) (HIGH_SURROGATE_START + (CodePoint >> 10));
+                Destination[Cch + 1] = (WCHAR) (LOW_SURROGATE_START + (CodePoint & 0x3FF));
+            }
+
+            Cch += 2;
+        }
+    }
+}
+
+ULONGLONG
 BLGASN1CALL
-BlgpNonZeroByteLength(
-    IN CONST BYTE *Buffer,
-    IN DWORD BufferCb
+BlgpUtf16ToUtf8Cb(
+    IN PCWSTR Value,
+    IN size_t Cch
     )
 
 /*++
 
 Routine Description:
 
-    This routine calculates the length of the specified buffer, excluding the leading bytes with
-    the value zero.
+    Calculates the size, in bytes, of the UTF-8 form of the specified UTF-16 string. Unpaired
+    surrogates are counted as U+FFFD, the character WideCharToMultiByte replaces them with.
 
 --*/
 
 {
-    DWORD OctetCount;
+    ULONGLONG Cb = 0;
+    size_t i = 0, Limit;
+    WCHAR Char;
 
-    if (BlgpIsLittleEndian())
+    while (i < Cch)
     {
-        for (OctetCount = BufferCb; OctetCount > 1; OctetCount--)
+        Limit = Cch;
+
+#ifdef BLGP_SSE2
+        // Count the extra octets of eight characters at a time by comparing them against the
+        // largest one and two octet characters. SSE2 compares signed words only, so the sign
+        // bits are flipped first. Blocks with surrogates are left to the loop below.
+        for (; i + 8 <= Cch; i += 8)
         {
-            if (Buffer[OctetCount - 1] != 0)
+            __m128i Block = _mm_loadu_si128((CONST __m128i *) (Value + i));
+            __m128i Extra;
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(Block, _mm_set1_epi16((SHORT) 0xF800)),
+                    _mm_set1_epi16((SHORT) 0xD800))) != 0)
             {
+                Limit = i + 8;
+
                 break;
             }
+
+            Block = _mm_xor_si128(Block, _mm_set1_epi16((SHORT) 0x8000));
+            Extra = _mm_add_epi16(_mm_cmpgt_epi16(Block, _mm_set1_epi16((SHORT) (0x007F ^ 0x8000))),
+                _mm_cmpgt_epi16(Block, _mm_set1_epi16((SHORT) (0x07FF ^ 0x8000))));
+            Extra = _mm_sad_epu8(_mm_sub_epi16(_mm_setzero_si128(), Extra), _mm_setzero_si128());
+
+            Cb += 8 + _mm_cvtsi128_si32(Extra) + _mm_cvtsi128_si32(_mm_srli_si128(Extra, 8));
+        }
+#endif
+
+        while (i < Limit)
+        {
+            Char = Value[i++];
+
+            if (Char < 0x80)
+            {
+                Cb += 1;
+            }
+            else if (Char < 0x800)
+            {
+                Cb += 2;
+            }
+            else if (IS_HIGH_SURROGATE(Char) && i < Cch && IS_LOW_SURROGATE(Value[i]))
+            {
+                Cb += 4;
+                i++;
+            }
+            else
+            {
+                Cb += 3;
+            }
         }
     }
-    else
+
+    return Cb;
+}
+
+VOID
+BLGASN1CALL
+BlgpUtf16ToUtf8(
+    OUT PBYTE Destination,
+    IN PCWSTR Value,
+    IN size_t Cch
+    )
+
+/*++
+
+Routine Description:
+
+    Converts the specified UTF-16 string to UTF-8. The destination buffer must be at least the
+    size returned by BlgpUtf16ToUtf8Cb. Unpaired surrogates are replaced with U+FFFD.
+
+--*/
+
+{
+    size_t i = 0, Limit;
+    DWORD CodePoint;
+
+    while (i < Cch)
     {
-        for (OctetCount = BufferCb; OctetCount > 1; OctetCount--)
+        Limit = Cch;
+
+#ifdef BLGP_SSE2
+        // Narrow sixteen ASCII characters at a time. Blocks with other characters are left to the
+        // loop below.
+        for (; i + 16 <= Cch; i += 16)
         {
-            if (Buffer[BufferCb - OctetCount] != 0)
+            __m128i Low = _mm_loadu_si128((CONST __m128i *) (Value + i));
+            __m128i High = _mm_loadu_si128((CONST __m128i *) (Value + i + 8));
+
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(Low, High),
+                    _mm_set1_epi16((SHORT) 0xFF80)), _mm_setzero_si128())) != 0xFFFF)
             {
+                Limit = i + 16;
+
                 break;
             }
+
+            _mm_storeu_si128((__m128i *) Destination, _mm_packus_epi16(Low, High));
+            Destination += 16;
+        }
+#endif
+
+        while (i < Limit)
+        {
+            CodePoint = Value[i++];
+
+            if (CodePoint < 0x80)
+            {
+                *Destination++ = (BYTE) CodePoint;
+            }
+            else if (CodePoint < 0x800)
+            {
+                Destination[0] = (BYTE) (0xC0 | (CodePoint >> 6));
+                Destination[1] = (BYTE) (0x80 | (CodePoint & 0x3F));
+                Destination += 2;
+            }
+            else if (IS_HIGH_SURROGATE(CodePoint) && i < Cch && IS_LOW_SURROGATE(Value[i]))
+            {
+                CodePoint = 0x10000 + ((CodePoint - HIGH_SURROGATE_START) << 10) +
+                    (Value[i++] - LOW_SURROGATE_START);
+
+                Destination[0] = (BYTE) (0xF0 | (CodePoint >> 18));
+                Destination[1] = (BYTE) (0x80 | ((CodePoint >> 12) & 0x3F));
+                Destination[2] = (BYTE) (0x80 | ((CodePoint >> 6) & 0x3F));
+                Destination[3] = (BYTE) (0x80 | (CodePoint & 0x3F));
+                Destination += 4;
+            }
+            else
+            {
+                if (IS_HIGH_SURROGATE(CodePoint) || IS_LOW_SURROGATE(CodePoint))
+                {
+                    CodePoint = 0xFFFD;
+                }
+
+                Destination[0] = (BYTE) (0xE0 | (CodePoint >> 12));
+                Destination[1] = (BYTE) (0x80 | ((CodePoint >> 6) & 0x3F));
+                Destination[2] = (BYTE) (0x80 | (CodePoint & 0x3F));
+                Destination += 3;
+            }
+        }
+    }
+}
+
+// Restricted character sets as ranges of octets, indexed by the BLGP_CHARSET_* values. A set
+// without ranges accepts every 7-bit octet.
+static CONST BLGP_CHARSET BlgpCharsets[] =
+{
+    // IA5String
+    {
+        0,
+        { { 0 } },
+        { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }
+    },
+
+    // NumericString: digits and space.
+    {
+        2,
+        { { '0', '9' }, { ' ', ' ' } },
+        { 0x0C, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }
+    },
+
+    // PrintableString: letters, digits, space and ' ( ) + , - . / : = ?
+    {
+        7,
+        { { 'A', 'Z' }, { 'a', 'z' }, { '+', ':' }, { ' ', ' ' }, { '\'', ')' }, { '=', '=' }, { '?', '?' } },
+        { 0xAC, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xF8, 0xFC, 0xFC, 0xFC, 0xF8, 0x54, 0x54, 0x5C, 0x54, 0x5C }
+    },
+
+    // VisibleString: printing characters and space.
+    {
+        1,
+        { { ' ', '~' } },
+        { 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0xFC, 0x7C }
+    }
+};
+
+static __inline
+BOOL
+BLGASN1CALL
+BlgpIsInCharsetChar(
+    IN CONST BLGP_CHARSET *Charset,
+    IN DWORD Char
+    )
+{
+    DWORD i;
+
+    if (Charset->RangeCount == 0)
+    {
+        return Char < 0x80;
+    }
+
+    for (i = 0; i < Charset->RangeCount; i++)
+    {
+        if (Char - Charset->Ranges[i].First <= (DWORD) (Charset->Ranges[i].Last - Charset->Ranges[i].First))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+#ifdef BLGP_SSE2
+static __inline
+BOOL
+BLGASN1CALL
+BlgpIsInCharsetBlock(
+    IN CONST BLGP_CHARSET *Charset,
+    IN BOOL Ssse3,
+    IN __m128i Block
+    )
+
+/*++
+
+Routine Description:
+
+    Checks 16 octets against the specified character set.
+
+    With SSSE3, the set is looked up by nibbles: one shuffle selects the high nibbles of the
+    set for the low nibble of each octet, another one the bit of the high nibble of the octet,
+    and the octet belongs to the set if both share the bit. Octets above 0x7F select no bits.
+
+    Otherwise an octet is within a range if its distance from the first octet of the range,
+    taken as unsigned, is not larger than the width of the range, and every range is tested.
+
+Arguments:
+
+    Charset - Character set to check the octets against.
+
+    Ssse3 - TRUE if the processor supports SSSE3.
+
+    Block - The octets to be checked.
+
+--*/
+
+{
+    __m128i Valid = _mm_setzero_si128(), Offset, Width;
+    DWORD i;
+
+    if (Charset->RangeCount == 0)
+    {
+        return _mm_movemask_epi8(Block) == 0;
+    }
+
+    if (Ssse3)
+    {
+        Valid = _mm_and_si128(
+            _mm_shuffle_epi8(_mm_loadu_si128((CONST __m128i *) Charset->Nibbles), Block),
+            _mm_shuffle_epi8(_mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (CHAR) 0x80,
+                    0, 0, 0, 0, 0, 0, 0, 0),
+                _mm_and_si128(_mm_srli_epi16(Block, 4), _mm_set1_epi8(0x0F))));
+
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(Valid, _mm_setzero_si128())) == 0;
+    }
+
+    for (i = 0; i < Charset->RangeCount; i++)
+    {
+        Offset = _mm_sub_epi8(Block, _mm_set1_epi8((CHAR) Charset->Ranges[i].First));
+        Width = _mm_set1_epi8((CHAR) (Charset->Ranges[i].Last - Charset->Ranges[i].First));
+        Valid = _mm_or_si128(Valid, _mm_cmpeq_epi8(Offset, _mm_min_epu8(Offset, Width)));
+    }
+
+    return _mm_movemask_epi8(Valid) == 0xFFFF;
+}
+#endif
+
+BOOL
+BLGASN1CALL
+BlgpIsInCharset(
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN DWORD Charset
+    )
+
+/*++
+
+Routine Description:
+
+    Checks whether all of the specified octets belong to the specified character set.
+
+--*/
+
+{
+    CONST BLGP_CHARSET *Set = &BlgpCharsets[Charset];
+    DWORD i = 0;
+    ULONGLONG Combined = 0;
+#ifdef BLGP_SSE2
+    BOOL Ssse3;
+#endif
+
+    if (Set->RangeCount == 0)
+    {
+        // Any 7-bit octet is accepted, so the octets are combined 64 at a time and only one test
+        // is made for each block.
+#ifdef BLGP_SSE2
+        for (; i + 64 <= ValueCb; i += 64)
+        {
+            __m128i Block = _mm_or_si128(
+                _mm_or_si128(_mm_loadu_si128((CONST __m128i *) (Value + i)),
+                    _mm_loadu_si128((CONST __m128i *) (Value + i + 16))),
+                _mm_or_si128(_mm_loadu_si128((CONST __m128i *) (Value + i + 32)),
+                    _mm_loadu_si128((CONST __m128i *) (Value + i + 48))));
+
+            if (_mm_movemask_epi8(Block) != 0)
+            {
+                return FALSE;
+            }
+        }
+#endif
+
+        for (; i + 8 <= ValueCb; i += 8)
+        {
+            Combined |= *(CONST ULONGLONG UNALIGNED *) (Value + i);
+        }
+
+        for (; i < ValueCb; i++)
+        {
+            Combined |= Value[i];
+        }
+
+        return (Combined & 0x8080808080808080ULL) == 0;
+    }
+
+#ifdef BLGP_SSE2
+    Ssse3 = (BlgpGetCpuFeatures() & BLGP_CPU_FEATURE_SSSE3) != 0;
+
+    for (; i + 16 <= ValueCb; i += 16)
+    {
+        if (!BlgpIsInCharsetBlock(Set, Ssse3, _mm_loadu_si128((CONST __m128i *) (Value + i))))
+        {
+            return FALSE;
+        }
+    }
+#endif
+
+    for (; i < ValueCb; i++)
+    {
+        if (!BlgpIsInCharsetChar(Set, Value[i]))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpWidenCharset(
+    OUT PWSTR Destination,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    IN DWORD Charset
+    )
+
+/*++
+
+Routine Description:
+
+    Converts the specified octets to UTF-16, checking them against the specified character set
+    at the same time. The string is not null-terminated.
+
+Return Value:
+
+    TRUE if all of the octets belong to the character set; otherwise, FALSE. The contents of
+    the destination buffer are undefined if the routine fails.
+
+--*/
+
+{
+    CONST BLGP_CHARSET *Set = &BlgpCharsets[Charset];
+    DWORD i = 0;
+#ifdef BLGP_SSE2
+    BOOL Ssse3 = (BlgpGetCpuFeatures() & BLGP_CPU_FEATURE_SSSE3) != 0;
+#endif
+
+#ifdef BLGP_SSE2
+    for (; i + 16 <= ValueCb; i += 16)
+    {
+        __m128i Block = _mm_loadu_si128((CONST __m128i *) (Value + i));
+
+        if (!BlgpIsInCharsetBlock(Set, Ssse3, Block))
+        {
+            return FALSE;
+        }
+
+        _mm_storeu_si128((__m128i *) (Destination + i), _mm_unpacklo_epi8(Block, _mm_setzero_si128()));
+        _mm_storeu_si128((__m128i *) (Destination + i + 8), _mm_unpackhi_epi8(Block, _mm_setzero_si128()));
+    }
+#endif
+
+    for (; i < ValueCb; i++)
+    {
+        if (!BlgpIsInCharsetChar(Set, Value[i]))
+        {
+            return FALSE;
+        }
+
+        Destination[i] = Value[i];
+    }
+
+    return TRUE;
+}
+
+BOOL
+BLGASN1CALL
+BlgpNarrowCharset(
+    OUT PBYTE Destination OPTIONAL,
+    IN PCWSTR Value,
+    IN size_t Cch,
+    IN DWORD Charset
+    )
+
+/*++
+
+Routine Description:
+
+    Converts the specified UTF-16 string to octets, checking the characters against the
+    specified character set at the same time. If the destination is NULL, the characters are
+    only checked.
+
+Return Value:
+
+    TRUE if all of the characters belong to the character set; otherwise, FALSE. The contents of
+    the destination buffer are undefined if the routine fails.
+
+--*/
+
+{
+    CONST BLGP_CHARSET *Set = &BlgpCharsets[Charset];
+    size_t i = 0;
+#ifdef BLGP_SSE2
+    BOOL Ssse3 = (BlgpGetCpuFeatures() & BLGP_CPU_FEATURE_SSSE3) != 0;
+#endif
+
+#ifdef BLGP_SSE2
+    // Characters above U+007F are ruled out before the words are narrowed, since narrowing
+    // saturates them.
+    for (; i + 16 <= Cch; i += 16)
+    {
+        __m128i Low = _mm_loadu_si128((CONST __m128i *) (Value + i));
+        __m128i High = _mm_loadu_si128((CONST __m128i *) (Value + i + 8));
+        __m128i Block;
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(Low, High),
+                _mm_set1_epi16((SHORT) 0xFF80)), _mm_setzero_si128())) != 0xFFFF)
+        {
+            return FALSE;
+        }
+
+        Block = _mm_packus_epi16(Low, High);
+
+        if (Set->RangeCount != 0 && !BlgpIsInCharsetBlock(Set, Ssse3, Block))
+        {
+            return FALSE;
+        }
+
+        if (Destination)
+        {
+            _mm_storeu_si128((__m128i *) (Destination + i), Block);
+        }
+    }
+#endif
+
+    for (; i < Cch; i++)
+    {
+        if (!BlgpIsInCharsetChar(Set, Value[i]))
+        {
+            return FALSE;
+        }
+
+        if (Destination)
+        {
+            Destination[i] = (BYTE) Value[i];
         }
     }
 
-    return OctetCount;
+    return TRUE;
 }
\ No newline at end of file
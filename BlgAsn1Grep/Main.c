@@ -0,0 +1,853 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+Module Description:
+
+    BlgAsn1Grep searches files of DER encoded data for a node, such as an Object Identifier or a
+    certificate serial number, without decoding the data.
+
+    Usage: BlgAsn1Grep [-c] [-u] [-j Threads] Target File...
+
+    Target is one of
+        -o Oid              OBJECT IDENTIFIER in the dotted decimal form.
+        -s Hex              INTEGER with the specified big-endian magnitude, such as a serial
+                            number.
+        -t Class:Tag -x Hex Node with the specified class (u, a, c or p), tag number and content
+                            octets; -k marks the node as constructed.
+
+    Each file may hold any number of consecutive top level nodes and may contain wildcards. Every
+    match is printed as File:Offset:Depth; with -c, the number of matches of each file is printed
+    instead. -u reports every occurrence of the encoded node, without checking that it starts a
+    node.
+
+    The files are mapped into memory and searched by one thread per processor. Large files are
+    split at top level nodes, so a single file is searched by all threads as well.
+
+--*/
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BlgAsn1.h"
+
+// The size of the parts large files are split into.
+#define GREP_CHUNK_CB   (64 * 1024 * 1024)
+
+// The size of the reads that collect the top level nodes of a large file, and the size of the
+// longest identifier and length octets GrepNodeCb examines.
+#define GREP_READ_CB    (1024 * 1024)
+#define GREP_HEADER_CB  16
+
+typedef struct _GREP_FILE
+{
+    PWSTR Path;
+    volatile LONG MatchCount;
+
+} GREP_FILE, *PGREP_FILE;
+
+// A part of a file that starts with a top level node.
+typedef struct _GREP_CHUNK
+{
+    PGREP_FILE File;
+    ULONGLONG Offset;
+    DWORD Cb;
+
+} GREP_CHUNK, *PGREP_CHUNK;
+
+static BYTE GrepClass = BLG_DER_CLASS_UNIVERSAL;
+static BOOLEAN GrepConstructed = FALSE;
+static DWORD GrepTag;
+static BYTE GrepValue[1024];
+static DWORD GrepValueCb;
+static DWORD GrepFlags;
+static BOOL GrepCountOnly;
+
+static PGREP_FILE GrepFiles;
+static DWORD GrepFileCount, GrepFileCapacity;
+
+static PGREP_CHUNK GrepChunks;
+static DWORD GrepChunkCount, GrepChunkCapacity;
+
+static volatile LONG GrepNextChunk = -1;
+static volatile LONG GrepErrors;
+static CRITICAL_SECTION GrepOutputLock;
+
+static
+BOOL
+GrepPrepareTarget(
+    IN PCWSTR Kind,
+    IN PCWSTR Argument
+    );
+
+static
+BOOL
+GrepParseHex(
+    IN PCWSTR Text,
+    OUT PBYTE Buffer,
+    IN DWORD BufferCb,
+    OUT PDWORD Cb
+    );
+
+static
+BOOL
+GrepAddFiles(
+    IN PCWSTR Pattern
+    );
+
+static
+BOOL
+GrepSplitFile(
+    IN PGREP_FILE File,
+    IN ULONGLONG FileCb
+    );
+
+static
+VOID
+GrepAddChunk(
+    IN PGREP_FILE File,
+    IN ULONGLONG Offset,
+    IN ULONGLONG Cb
+    );
+
+static
+ULONGLONG
+GrepNodeCb(
+    IN CONST BYTE *Ptr,
+    IN ULONGLONG Available
+    );
+
+static
+DWORD
+WINAPI
+GrepWorker(
+    IN PVOID Parameter
+    );
+
+static
+BOOL
+BLGASN1CALL
+GrepReportMatch(
+    IN DWORD Offset,
+    IN DWORD Depth,
+    IN PVOID Context
+    );
+
+static
+PVOID
+GrepAlloc(
+    IN PVOID Memory OPTIONAL,
+    IN SIZE_T Cb
+    );
+
+int
+__cdecl
+wmain(
+    int argc,
+    PWSTR *argv
+    )
+{
+    SYSTEM_INFO SystemInfo;
+    PHANDLE Threads;
+    PCWSTR TargetKind = NULL, TargetArgument = NULL, RawValue = NULL;
+    DWORD ThreadCount = 0, TotalCount = 0, i;
+    int Argument;
+
+    for (Argument = 1; Argument < argc && argv[Argument][0] == L'-'; Argument++)
+    {
+        if (wcscmp(argv[Argument], L"-c") == 0)
+        {
+            GrepCountOnly = TRUE;
+        }
+        else if (wcscmp(argv[Argument], L"-u") == 0)
+        {
+            GrepFlags |= BLG_DER_SEARCH_FLAG_UNVERIFIED;
+        }
+        else if (wcscmp(argv[Argument], L"-k") == 0)
+        {
+            GrepConstructed = TRUE;
+        }
+        else if (wcscmp(argv[Argument], L"-j") == 0 && Argument + 1 < argc)
+        {
+            ThreadCount = wcstoul(argv[++Argument], NULL, 10);
+        }
+        else if (wcscmp(argv[Argument], L"-x") == 0 && Argument + 1 < argc)
+        {
+            RawValue = argv[++Argument];
+        }
+        else if ((wcscmp(argv[Argument], L"-o") == 0 || wcscmp(argv[Argument], L"-s") == 0 ||
+                  wcscmp(argv[Argument], L"-t") == 0) && Argument + 1 < argc && !TargetKind)
+        {
+            TargetKind = argv[Argument];
+            TargetArgument = argv[++Argument];
+        }
+        else
+        {
+            TargetKind = NULL;
+
+            break;
+        }
+    }
+
+    if (!TargetKind || Argument == argc || (RawValue != NULL) != (wcscmp(TargetKind, L"-t") == 0))
+    {
+        fwprintf(stderr, L"Usage: BlgAsn1Grep [-c] [-u] [-j Threads] Target File...\n\n"
+            L"Target is one of\n"
+            L"    -o Oid\n"
+            L"    -s Hex\n"
+            L"    -t Class:Tag [-k] -x Hex\n");
+
+        return 2;
+    }
+
+    if (!GrepPrepareTarget(TargetKind, TargetArgument) ||
+        (RawValue && !GrepParseHex(RawValue, GrepValue, sizeof(GrepValue), &GrepValueCb)))
+    {
+        fwprintf(stderr, L"BlgAsn1Grep: invalid target\n");
+
+        return 2;
+    }
+
+    for (; Argument < argc; Argument++)
+    {
+        if (!GrepAddFiles(argv[Argument]))
+        {
+            fwprintf(stderr, L"BlgAsn1Grep: %ls: no such file\n", argv[Argument]);
+
+            GrepErrors++;
+        }
+    }
+
+    for (i = 0; i < GrepFileCount; i++)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA Attributes;
+        ULONGLONG FileCb;
+
+        if (!GetFileAttributesExW(GrepFiles[i].Path, GetFileExInfoStandard, &Attributes))
+        {
+            fwprintf(stderr, L"BlgAsn1Grep: %ls: cannot open the file (%u)\n", GrepFiles[i].Path,
+                GetLastError());
+
+            GrepErrors++;
+
+            continue;
+        }
+
+        FileCb = ((ULONGLONG) Attributes.nFileSizeHigh << 32) | Attributes.nFileSizeLow;
+
+        if (FileCb <= GREP_CHUNK_CB)
+        {
+            if (FileCb > 0)
+            {
+                GrepAddChunk(&GrepFiles[i], 0, FileCb);
+            }
+        }
+        else if (!GrepSplitFile(&GrepFiles[i], FileCb))
+        {
+            GrepErrors++;
+        }
+    }
+
+    if (ThreadCount == 0)
+    {
+        GetSystemInfo(&SystemInfo);
+
+        ThreadCount = SystemInfo.dwNumberOfProcessors;
+    }
+
+    if (ThreadCount > GrepChunkCount)
+    {
+        ThreadCount = GrepChunkCount;
+    }
+
+    InitializeCriticalSection(&GrepOutputLock);
+
+    Threads = GrepAlloc(NULL, (ThreadCount + 1) * sizeof(HANDLE));
+
+    for (i = 0; i < ThreadCount; i++)
+    {
+        Threads[i] = CreateThread(NULL, 0, GrepWorker, NULL, 0, NULL);
+
+        if (!Threads[i])
+        {
+            fwprintf(stderr, L"BlgAsn1Grep: cannot create a thread (%u)\n", GetLastError());
+
+            return 2;
+        }
+    }
+
+    for (i = 0; i < ThreadCount; i++)
+    {
+        WaitForSingleObject(Threads[i], INFINITE);
+        CloseHandle(Threads[i]);
+    }
+
+    for (i = 0; i < GrepFileCount; i++)
+    {
+        if (GrepCountOnly)
+        {
+            wprintf(L"%ls:%ld\n", GrepFiles[i].Path, GrepFiles[i].MatchCount);
+        }
+
+        TotalCount += GrepFiles[i].MatchCount;
+    }
+
+    if (GrepErrors != 0)
+    {
+        return 2;
+    }
+
+    return TotalCount != 0 ? 0 : 1;
+}
+
+BOOL
+GrepPrepareTarget(
+    IN PCWSTR Kind,
+    IN PCWSTR Argument
+    )
+
+/*++
+
+Routine Description:
+
+    Determines the tag and the content octets of the node searched for. Object Identifiers and
+    integers are encoded with the library, so their content octets are exactly those a DER
+    encoder produces.
+
+Arguments:
+
+    Kind - Option selecting the kind of the target: -o, -s or -t.
+
+    Argument - Argument of the option.
+
+Return Value:
+
+    TRUE if the target is valid; otherwise, FALSE.
+
+--*/
+
+{
+    HBLG_DER_ENCODER Encoder;
+    HBLG_DER_DECODER Decoder;
+    BYTE Encoded[sizeof(GrepValue) + 16], Magnitude[sizeof(GrepValue) - 1];
+    CONST BYTE *Value;
+    DWORD EncodedCb, MagnitudeCb;
+    BOOL Succeeded;
+    PWSTR End;
+
+    if (wcscmp(Kind, L"-t") == 0)
+    {
+        switch (Argument[0])
+        {
+        case L'u': GrepClass = BLG_DER_CLASS_UNIVERSAL; break;
+        case L'a': GrepClass = BLG_DER_CLASS_APPLICATION; break;
+        case L'c': GrepClass = BLG_DER_CLASS_CONTEXT; break;
+        case L'p': GrepClass = BLG_DER_CLASS_PRIVATE; break;
+        default: return FALSE;
+        }
+
+        if (Argument[1] != L':' || Argument[2] < L'0' || Argument[2] > L'9')
+        {
+            return FALSE;
+        }
+
+        GrepTag = wcstoul(Argument + 2, &End, 10);
+
+        return *End == 0;
+    }
+
+    Encoder = BlgDerCreateEncoder(Encoded, sizeof(Encoded), 0);
+    if (!Encoder)
+    {
+        return FALSE;
+    }
+
+    if (wcscmp(Kind, L"-o") == 0)
+    {
+        GrepTag = BLG_DER_TAG_OBJECT_IDENTIFIER;
+
+        Succeeded = BlgDerEncObjectIdentifier(Encoder, BLG_DER_CLASS_UNIVERSAL, 0, Argument);
+    }
+    else
+    {
+        GrepTag = BLG_DER_TAG_INTEGER;
+
+        Succeeded = GrepParseHex(Argument, Magnitude, sizeof(Magnitude), &MagnitudeCb) &&
+            BlgDerEncIntBigEndian(Encoder, BLG_DER_CLASS_UNIVERSAL, 0, TRUE, Magnitude, MagnitudeCb);
+    }
+
+    Succeeded = Succeeded && BlgDerGetEncoderParam(Encoder, BLG_DER_ENC_PARAM_ENCODED_CB, &EncodedCb);
+
+    BlgDerDestroyEncoder(Encoder);
+
+    if (!Succeeded)
+    {
+        return FALSE;
+    }
+
+    Decoder = BlgDerCreateDecoder(Encoded, EncodedCb, 0);
+    if (!Decoder)
+    {
+        return FALSE;
+    }
+
+    Succeeded = BlgDerMoveToFirst(Decoder) &&
+        BlgDerGetDecoderParam(Decoder, BLG_DER_DEC_PARAM_VALUE, (PVOID) &Value) &&
+        BlgDerGetDecoderParam(Decoder, BLG_DER_DEC_PARAM_VALUE_CB, &GrepValueCb) &&
+        GrepValueCb <= sizeof(GrepValue);
+
+    if (Succeeded)
+    {
+        CopyMemory(GrepValue, Value, GrepValueCb);
+    }
+
+    BlgDerDestroyDecoder(Decoder);
+
+    return Succeeded;
+}
+
+BOOL
+GrepParseHex(
+    IN PCWSTR Text,
+    OUT PBYTE Buffer,
+    IN DWORD BufferCb,
+    OUT PDWORD Cb
+    )
+
+/*++
+
+Routine Description:
+
+    Converts hexadecimal text to octets. Colons and spaces between the octets, as printed by
+    most certificate tools, are ignored.
+
+--*/
+
+{
+    DWORD Count = 0, Digit, DigitCount = 0;
+
+    for (; *Text != 0; Text++)
+    {
+        if (*Text == L':' || *Text == L' ')
+        {
+            continue;
+        }
+
+        if (*Text >= L'0' && *Text <= L'9')
+        {
+            Digit = *Text - L'0';
+        }
+        else if ((*Text | 0x20) >= L'a' && (*Text | 0x20) <= L'f')
+        {
+            Digit = (*Text | 0x20) - L'a' + 10;
+        }
+        else
+        {
+            return FALSE;
+        }
+
+        if (DigitCount % 2 == 0)
+        {
+            if (Count == BufferCb)
+            {
+                return FALSE;
+            }
+
+            Buffer[Count++] = (BYTE) (Digit << 4);
+        }
+        else
+        {
+            Buffer[Count - 1] |= (BYTE) Digit;
+        }
+
+        DigitCount++;
+    }
+
+    *Cb = Count;
+
+    return DigitCount % 2 == 0;
+}
+
+BOOL
+GrepAddFiles(
+    IN PCWSTR Pattern
+    )
+
+/*++
+
+Routine Description:
+
+    Adds the files matching a path that may contain wildcards in its last component.
+
+Arguments:
+
+    Pattern - Path of the files.
+
+Return Value:
+
+    TRUE if at least one file matches; otherwise, FALSE.
+
+--*/
+
+{
+    WIN32_FIND_DATAW FindData;
+    HANDLE Find;
+    PCWSTR Name = Pattern + wcslen(Pattern);
+    SIZE_T DirectoryCch;
+    BOOL Found = FALSE;
+
+    while (Name > Pattern && Name[-1] != L'\\' && Name[-1] != L'/' && Name[-1] != L':')
+    {
+        Name--;
+    }
+
+    DirectoryCch = Name - Pattern;
+
+    Find = FindFirstFileW(Pattern, &FindData);
+    if (Find == INVALID_HANDLE_VALUE)
+    {
+        return FALSE;
+    }
+
+    do
+    {
+        if (FindData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            continue;
+        }
+
+        if (GrepFileCount == GrepFileCapacity)
+        {
+            GrepFileCapacity = GrepFileCapacity ? GrepFileCapacity * 2 : 64;
+
+            GrepFiles = GrepAlloc(GrepFiles, GrepFileCapacity * sizeof(GREP_FILE));
+        }
+
+        GrepFiles[GrepFileCount].Path = GrepAlloc(NULL,
+            (DirectoryCch + wcslen(FindData.cFileName) + 1) * sizeof(WCHAR));
+        GrepFiles[GrepFileCount].MatchCount = 0;
+
+        CopyMemory(GrepFiles[GrepFileCount].Path, Pattern, DirectoryCch * sizeof(WCHAR));
+        wcscpy(GrepFiles[GrepFileCount].Path + DirectoryCch, FindData.cFileName);
+
+        GrepFileCount++;
+
+        Found = TRUE;
+    }
+    while (FindNextFileW(Find, &FindData));
+
+    FindClose(Find);
+
+    return Found;
+}
+
+BOOL
+GrepSplitFile(
+    IN PGREP_FILE File,
+    IN ULONGLONG FileCb
+    )
+
+/*++
+
+Routine Description:
+
+    Splits a large file into parts of about GREP_CHUNK_CB bytes. A part always starts with a top
+    level node, so each part can be searched and checked on its own. Only the identifier and
+    length octets of the top level nodes are read, GREP_READ_CB bytes at a time; the file is not
+    mapped, since a view of the whole file may not fit into the address space of the process.
+
+Arguments:
+
+    File - Pointer to the file.
+
+    FileCb - Size, in bytes, of the file.
+
+Return Value:
+
+    TRUE if the routine succeeds; otherwise, FALSE.
+
+--*/
+
+{
+    static BYTE Buffer[GREP_READ_CB];
+    HANDLE FileHandle;
+    LARGE_INTEGER Position;
+    ULONGLONG Offset, ChunkOffset, NodeCb, BufferOffset = 0, HeaderCb;
+    DWORD BufferCb = 0, ReadCb;
+
+    FileHandle = CreateFileW(File->Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (FileHandle == INVALID_HANDLE_VALUE)
+    {
+        fwprintf(stderr, L"BlgAsn1Grep: %ls: cannot open the file (%u)\n", File->Path, GetLastError());
+
+        return FALSE;
+    }
+
+    for (Offset = ChunkOffset = 0; Offset < FileCb; Offset += NodeCb)
+    {
+        HeaderCb = FileCb - Offset < GREP_HEADER_CB ? FileCb - Offset : GREP_HEADER_CB;
+
+        // Read the file from the node on unless the buffer holds its identifier and length octets.
+        if (Offset < BufferOffset || Offset + HeaderCb > BufferOffset + BufferCb)
+        {
+            ReadCb = FileCb - Offset < GREP_READ_CB ? (DWORD) (FileCb - Offset) : GREP_READ_CB;
+            Position.QuadPart = (LONGLONG) Offset;
+
+            if (!SetFilePointerEx(FileHandle, Position, NULL, FILE_BEGIN) ||
+                !ReadFile(FileHandle, Buffer, ReadCb, &BufferCb, NULL) || BufferCb != ReadCb)
+            {
+                fwprintf(stderr, L"BlgAsn1Grep: %ls: cannot read the file (%u)\n", File->Path,
+                    GetLastError());
+
+                CloseHandle(FileHandle);
+
+                return FALSE;
+            }
+
+            BufferOffset = Offset;
+        }
+
+        NodeCb = GrepNodeCb(Buffer + (DWORD) (Offset - BufferOffset), FileCb - Offset);
+
+        // The rest of the file is not made of nodes; it is searched as a single part.
+        if (NodeCb == 0)
+        {
+            break;
+        }
+
+        if (Offset > ChunkOffset && Offset + NodeCb - ChunkOffset > GREP_CHUNK_CB)
+        {
+            GrepAddChunk(File, ChunkOffset, Offset - ChunkOffset);
+
+            ChunkOffset = Offset;
+        }
+    }
+
+    GrepAddChunk(File, ChunkOffset, FileCb - ChunkOffset);
+
+    CloseHandle(FileHandle);
+
+    return TRUE;
+}
+
+VOID
+GrepAddChunk(
+    IN PGREP_FILE File,
+    IN ULONGLONG Offset,
+    IN ULONGLONG Cb
+    )
+{
+    // The library searches at most MAXDWORD bytes at once. A single node cannot be larger, so
+    // only data that is not made of nodes is cut short.
+    if (Cb > MAXDWORD)
+    {
+        fwprintf(stderr, L"BlgAsn1Grep: %ls: only the first 4 GB after offset %I64u are searched\n",
+            File->Path, Offset);
+
+        Cb = MAXDWORD;
+    }
+
+    if (GrepChunkCount == GrepChunkCapacity)
+    {
+        GrepChunkCapacity = GrepChunkCapacity ? GrepChunkCapacity * 2 : 64;
+
+        GrepChunks = GrepAlloc(GrepChunks, GrepChunkCapacity * sizeof(GREP_CHUNK));
+    }
+
+    GrepChunks[GrepChunkCount].File = File;
+    GrepChunks[GrepChunkCount].Offset = Offset;
+    GrepChunks[GrepChunkCount].Cb = (DWORD) Cb;
+
+    GrepChunkCount++;
+}
+
+ULONGLONG
+GrepNodeCb(
+    IN CONST BYTE *Ptr,
+    IN ULONGLONG Available
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the size of the node at the specified position, including its identifier and length
+    octets, or zero if no complete node starts there.
+
+--*/
+
+{
+    ULONGLONG HeaderCb = 1, ValueCb;
+    DWORD LenCb;
+
+    if ((Ptr[0] & 0x1F) == 0x1F)
+    {
+        do
+        {
+            if (HeaderCb == Available || HeaderCb > 5)
+            {
+                return 0;
+            }
+        }
+        while (Ptr[HeaderCb++] & 0x80);
+    }
+
+    if (HeaderCb == Available)
+    {
+        return 0;
+    }
+
+    ValueCb = Ptr[HeaderCb++];
+
+    if (ValueCb & 0x80)
+    {
+        LenCb = (DWORD) ValueCb & 0x7F;
+
+        if (LenCb == 0 || LenCb > 4 || HeaderCb + LenCb > Available)
+        {
+            return 0;
+        }
+
+        for (ValueCb = 0; LenCb > 0; LenCb--)
+        {
+            ValueCb = (ValueCb << 8) | Ptr[HeaderCb++];
+        }
+    }
+
+    return HeaderCb + ValueCb <= Available ? HeaderCb + ValueCb : 0;
+}
+
+DWORD
+WINAPI
+GrepWorker(
+    IN PVOID Parameter
+    )
+
+/*++
+
+Routine Description:
+
+    Searches the parts of the files until none is left. Each part is mapped on its own, so the
+    address space used does not depend on the size of the files.
+
+--*/
+
+{
+    SYSTEM_INFO SystemInfo;
+    PGREP_CHUNK Chunk;
+    HANDLE FileHandle, Mapping;
+    PBYTE View;
+    ULONGLONG MapOffset;
+    DWORD Delta;
+    LONG Index;
+
+    UNREFERENCED_PARAMETER(Parameter);
+
+    GetSystemInfo(&SystemInfo);
+
+    while ((Index = InterlockedIncrement(&GrepNextChunk)) < (LONG) GrepChunkCount)
+    {
+        Chunk = &GrepChunks[Index];
+
+        FileHandle = CreateFileW(Chunk->File->Path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+        if (FileHandle == INVALID_HANDLE_VALUE)
+        {
+            fwprintf(stderr, L"BlgAsn1Grep: %ls: cannot open the file (%u)\n", Chunk->File->Path,
+                GetLastError());
+
+            InterlockedIncrement(&GrepErrors);
+
+            continue;
+        }
+
+        // Views start at a multiple of the allocation granularity.
+        Delta = (DWORD) (Chunk->Offset % SystemInfo.dwAllocationGranularity);
+        MapOffset = Chunk->Offset - Delta;
+
+        Mapping = CreateFileMappingW(FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        View = Mapping ? MapViewOfFile(Mapping, FILE_MAP_READ, (DWORD) (MapOffset >> 32), (DWORD) MapOffset,
+            (SIZE_T) Chunk->Cb + Delta) : NULL;
+
+        if (View)
+        {
+            BlgDerSearch(View + Delta, Chunk->Cb, GrepClass, GrepConstructed, GrepTag, GrepValue, GrepValueCb,
+                GrepFlags, GrepReportMatch, Chunk, NULL);
+
+            UnmapViewOfFile(View);
+        }
+        else
+        {
+            fwprintf(stderr, L"BlgAsn1Grep: %ls: cannot map the file (%u)\n", Chunk->File->Path,
+                GetLastError());
+
+            InterlockedIncrement(&GrepErrors);
+        }
+
+        if (Mapping)
+        {
+            CloseHandle(Mapping);
+        }
+
+        CloseHandle(FileHandle);
+    }
+
+    return 0;
+}
+
+BOOL
+BLGASN1CALL
+GrepReportMatch(
+    IN DWORD Offset,
+    IN DWORD Depth,
+    IN PVOID Context
+    )
+{
+    PGREP_CHUNK Chunk = Context;
+
+    InterlockedIncrement(&Chunk->File->MatchCount);
+
+    if (!GrepCountOnly)
+    {
+        // Matches are rare, so a single lock keeps the lines of the threads apart at no real cost.
+        EnterCriticalSection(&GrepOutputLock);
+
+        wprintf(L"%ls:%I64u:%u\n", Chunk->File->Path, Chunk->Offset + Offset, Depth);
+
+        LeaveCriticalSection(&GrepOutputLock);
+    }
+
+    return TRUE;
+}
+
+PVOID
+GrepAlloc(
+    IN PVOID Memory OPTIONAL,
+    IN SIZE_T Cb
+    )
+
+/*++
+
+Routine Description:
+
+    Allocates or grows a block of memory. The tool is short-lived, so memory is never freed.
+
+--*/
+
+{
+    PVOID Result = Memory ? realloc(Memory, Cb) : malloc(Cb);
+
+    if (!Result)
+    {
+        fwprintf(stderr, L"BlgAsn1Grep: out of memory\n");
+
+        exit(2);
+    }
+
+    return Result;
+}
\ No newline at end of file
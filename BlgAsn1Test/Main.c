@@ -0,0 +1,1218 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+Module Description:
+
+    BlgAsn1Test checks the text, time and Object Identifier routines of the library whose fast
+    paths process several octets at once: the UTF-16 and UTF-8 transcoders and the UTF-8
+    validator, the GeneralizedTime and UTCTime parser, and the subidentifier reader.
+
+    Usage: BlgAsn1Test
+
+    Values are encoded and decoded again through the public interface and compared with the
+    results of simple reference routines in this file, and malformed values are checked to be
+    rejected. The values are placed at every offset within the first blocks, so that each one is
+    seen by the vector code, at its block boundaries and by the scalar code that finishes a value.
+    Random values come from a fixed seed, so every run checks the same values.
+
+    The vector code selected at run time depends on the processor, so the test should be run on
+    processors with and without AVX2.
+
+    Every failed check is printed with its line and the case being checked. The exit code is 0 if
+    all checks pass and 1 otherwise.
+
+--*/
+
+#include <windows.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BlgAsn1.h"
+
+// The largest value the tests encode, including its identifier and length octets.
+#define TEST_BUFFER_CB  4096
+
+// The number of ASCII characters the values are preceded by, which moves them through the first
+// blocks of the vector code.
+#define TEST_OFFSET_COUNT   72
+
+typedef struct _TEST_UTF8_CASE
+{
+    PCSTR Name;
+    PCSTR Value;
+
+    // The code point of a well-formed value; zero for a malformed one.
+    DWORD CodePoint;
+
+} TEST_UTF8_CASE, *PTEST_UTF8_CASE;
+
+typedef struct _TEST_SURROGATE_CASE
+{
+    PCSTR Name;
+    WCHAR Value[4];
+    DWORD ValueCch;
+    PCSTR Expected;
+
+} TEST_SURROGATE_CASE, *PTEST_SURROGATE_CASE;
+
+static BYTE TestEncoded[TEST_BUFFER_CB];
+static CHAR TestCase[128];
+static DWORD TestCheckCount, TestFailureCount;
+static ULONGLONG TestRandomState = 0x9E3779B97F4A7C15ULL;
+
+// Reports a check that fails together with the case being checked.
+#define TEST_CHECK(Condition) TestCheck((Condition) != 0, #Condition, __LINE__)
+
+static
+VOID
+TestCheck(
+    IN BOOL Passed,
+    IN PCSTR Expression,
+    IN INT Line
+    );
+
+static
+ULONGLONG
+TestRandom(
+    VOID
+    );
+
+static
+DWORD
+TestEncodeUtf8(
+    IN DWORD CodePoint,
+    OUT PBYTE Buffer
+    );
+
+static
+DWORD
+TestEncodeNode(
+    IN BYTE Tag,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    OUT PBYTE Buffer
+    );
+
+static
+HBLG_DER_DECODER
+TestOpenNode(
+    IN CONST BYTE *Encoded,
+    IN DWORD EncodedCb
+    );
+
+static
+LONGLONG
+TestDaysFromCivil(
+    IN LONGLONG Year,
+    IN DWORD Month,
+    IN DWORD Day
+    );
+
+static
+BOOL
+TestIsLeapYear(
+    IN LONGLONG Year
+    );
+
+static
+VOID
+TestUtf8RoundTrip(
+    VOID
+    );
+
+static
+VOID
+TestUtf8Malformed(
+    VOID
+    );
+
+static
+VOID
+TestUnpairedSurrogates(
+    VOID
+    );
+
+static
+VOID
+TestGeneralizedTime(
+    VOID
+    );
+
+static
+VOID
+TestMalformedTime(
+    VOID
+    );
+
+static
+VOID
+TestUtcTime(
+    VOID
+    );
+
+static
+VOID
+TestOidArcs(
+    VOID
+    );
+
+static
+VOID
+TestMalformedOid(
+    VOID
+    );
+
+int
+__cdecl
+wmain(
+    int argc,
+    PWSTR *argv
+    )
+{
+    UNREFERENCED_PARAMETER(argc);
+    UNREFERENCED_PARAMETER(argv);
+
+    TestUtf8RoundTrip();
+    TestUtf8Malformed();
+    TestUnpairedSurrogates();
+    TestGeneralizedTime();
+    TestMalformedTime();
+    TestUtcTime();
+    TestOidArcs();
+    TestMalformedOid();
+
+    printf("BlgAsn1Test: %u checks, %u failed\n", TestCheckCount, TestFailureCount);
+
+    return TestFailureCount == 0 ? 0 : 1;
+}
+
+VOID
+TestCheck(
+    IN BOOL Passed,
+    IN PCSTR Expression,
+    IN INT Line
+    )
+
+/*++
+
+Routine Description:
+
+    Counts a check and prints it with the case being checked if it failed.
+
+--*/
+
+{
+    TestCheckCount++;
+
+    if (!Passed)
+    {
+        // A broken kernel fails for most values; the first failures are enough to find it.
+        if (TestFailureCount < 50)
+        {
+            printf("Main.c(%d): %s: check failed: %s\n", Line, TestCase, Expression);
+        }
+
+        TestFailureCount++;
+    }
+}
+
+ULONGLONG
+TestRandom(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the next value of a xorshift generator.
+
+--*/
+
+{
+    TestRandomState ^= TestRandomState << 13;
+    TestRandomState ^= TestRandomState >> 7;
+    TestRandomState ^= TestRandomState << 17;
+
+    return TestRandomState;
+}
+
+DWORD
+TestEncodeUtf8(
+    IN DWORD CodePoint,
+    OUT PBYTE Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes a code point as UTF-8, octet by octet, and returns the number of octets.
+
+--*/
+
+{
+    if (CodePoint < 0x80)
+    {
+        Buffer[0] = (BYTE) CodePoint;
+
+        return 1;
+    }
+
+    if (CodePoint < 0x800)
+    {
+        Buffer[0] = (BYTE) (0xC0 | (CodePoint >> 6));
+        Buffer[1] = (BYTE) (0x80 | (CodePoint & 0x3F));
+
+        return 2;
+    }
+
+    if (CodePoint < 0x10000)
+    {
+        Buffer[0] = (BYTE) (0xE0 | (CodePoint >> 12));
+        Buffer[1] = (BYTE) (0x80 | ((CodePoint >> 6) & 0x3F));
+        Buffer[2] = (BYTE) (0x80 | (CodePoint & 0x3F));
+
+        return 3;
+    }
+
+    Buffer[0] = (BYTE) (0xF0 | (CodePoint >> 18));
+    Buffer[1] = (BYTE) (0x80 | ((CodePoint >> 12) & 0x3F));
+    Buffer[2] = (BYTE) (0x80 | ((CodePoint >> 6) & 0x3F));
+    Buffer[3] = (BYTE) (0x80 | (CodePoint & 0x3F));
+
+    return 4;
+}
+
+DWORD
+TestEncodeNode(
+    IN BYTE Tag,
+    IN CONST BYTE *Value,
+    IN DWORD ValueCb,
+    OUT PBYTE Buffer
+    )
+
+/*++
+
+Routine Description:
+
+    Writes a primitive universal node with the specified content octets, which need not be
+    valid for the tag, and returns its size.
+
+--*/
+
+{
+    DWORD HeaderCb = 0;
+
+    Buffer[HeaderCb++] = Tag;
+
+    if (ValueCb < 0x80)
+    {
+        Buffer[HeaderCb++] = (BYTE) ValueCb;
+    }
+    else if (ValueCb < 0x100)
+    {
+        Buffer[HeaderCb++] = 0x81;
+        Buffer[HeaderCb++] = (BYTE) ValueCb;
+    }
+    else
+    {
+        Buffer[HeaderCb++] = 0x82;
+        Buffer[HeaderCb++] = (BYTE) (ValueCb >> 8);
+        Buffer[HeaderCb++] = (BYTE) ValueCb;
+    }
+
+    memcpy(Buffer + HeaderCb, Value, ValueCb);
+
+    return HeaderCb + ValueCb;
+}
+
+HBLG_DER_DECODER
+TestOpenNode(
+    IN CONST BYTE *Encoded,
+    IN DWORD EncodedCb
+    )
+
+/*++
+
+Routine Description:
+
+    Creates a decoder positioned on the first node of the specified octets.
+
+--*/
+
+{
+    HBLG_DER_DECODER Decoder = BlgDerCreateDecoder(Encoded, EncodedCb, 0);
+
+    TEST_CHECK(Decoder != NULL);
+    TEST_CHECK(BlgDerMoveToFirst(Decoder));
+
+    return Decoder;
+}
+
+LONGLONG
+TestDaysFromCivil(
+    IN LONGLONG Year,
+    IN DWORD Month,
+    IN DWORD Day
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the number of days between 1970-01-01 and the specified date of the proleptic
+    Gregorian calendar by counting the leap years before the specified year.
+
+--*/
+
+{
+    static CONST DWORD DaysBeforeMonth[] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+    LONGLONG Days;
+
+    Days = (Year - 1970) * 365;
+    Days += ((Year - 1) / 4 - (Year - 1) / 100 + (Year - 1) / 400) - (1969 / 4 - 1969 / 100 + 1969 / 400);
+    Days += DaysBeforeMonth[Month - 1];
+
+    if (Month > 2 && TestIsLeapYear(Year))
+    {
+        Days++;
+    }
+
+    return Days + Day - 1;
+}
+
+BOOL
+TestIsLeapYear(
+    IN LONGLONG Year
+    )
+
+/*++
+
+Routine Description:
+
+    Returns whether the specified year of the proleptic Gregorian calendar has 366 days.
+
+--*/
+
+{
+    return Year % 4 == 0 && (Year % 100 != 0 || Year % 400 == 0);
+}
+
+VOID
+TestUtf8RoundTrip(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes random UTF-16 strings as UTF8String values and decodes them again. The strings mix
+    ASCII runs with characters of every UTF-8 size, including surrogate pairs; the encoding is
+    compared with the reference encoder. The decoded value is checked by measuring it, which
+    takes the vector validator, by converting it and by validating it as 8-bit characters.
+
+--*/
+
+{
+    static WCHAR Value[600], Decoded[601];
+    static BYTE Expected[1200], ExpectedNode[1204];
+    HBLG_DER_ENCODER Encoder;
+    HBLG_DER_DECODER Decoder;
+    PCSTR Narrow;
+    DWORD Iteration, Cch, ExpectedCb, ExpectedNodeCb, EncodedCb, DecodedCch, NarrowCb, CodePoint, Kind;
+    DWORD Count, i;
+
+    for (Iteration = 0; Iteration < 20000; Iteration++)
+    {
+        Count = (DWORD) (TestRandom() % (Iteration % 4 == 0 ? 200 : 40));
+        Cch = ExpectedCb = 0;
+
+        for (i = 0; i < Count; i++)
+        {
+            Kind = (DWORD) (TestRandom() % 8);
+
+            if (Kind < 4)
+            {
+                CodePoint = (DWORD) (TestRandom() % 0x80);
+            }
+            else if (Kind < 5)
+            {
+                CodePoint = 0x80 + (DWORD) (TestRandom() % (0x800 - 0x80));
+            }
+            else if (Kind < 7)
+            {
+                // Three octet characters other than surrogates.
+                CodePoint = 0x800 + (DWORD) (TestRandom() % (0x10000 - 0x800 - 0x800));
+                CodePoint += CodePoint >= 0xD800 ? 0x800 : 0;
+            }
+            else
+            {
+                CodePoint = 0x10000 + (DWORD) (TestRandom() % (0x110000 - 0x10000));
+            }
+
+            if (CodePoint < 0x10000)
+            {
+                Value[Cch++] = (WCHAR) CodePoint;
+            }
+            else
+            {
+                Value[Cch++] = (WCHAR) (0xD800 + ((CodePoint - 0x10000) >> 10));
+                Value[Cch++] = (WCHAR) (0xDC00 + ((CodePoint - 0x10000) & 0x3FF));
+            }
+
+            ExpectedCb += TestEncodeUtf8(CodePoint, Expected + ExpectedCb);
+        }
+
+        sprintf(TestCase, "UTF-16 round trip %u (%u code units)", Iteration, Cch);
+
+        Encoder = BlgDerCreateEncoder(TestEncoded, sizeof(TestEncoded), 0);
+        TEST_CHECK(BlgDerEncUtf8String(Encoder, 0, 0, Value, (INT) Cch));
+        TEST_CHECK(BlgDerGetEncoderParam(Encoder, BLG_DER_ENC_PARAM_ENCODED_CB, &EncodedCb));
+        BlgDerDestroyEncoder(Encoder);
+
+        ExpectedNodeCb = TestEncodeNode(BLG_DER_TAG_UTF8_STRING, Expected, ExpectedCb, ExpectedNode);
+        TEST_CHECK(EncodedCb == ExpectedNodeCb && memcmp(TestEncoded, ExpectedNode, EncodedCb) == 0);
+
+        Decoder = TestOpenNode(TestEncoded, EncodedCb);
+
+        DecodedCch = 0;
+        TEST_CHECK(BlgDerDecUtf8String(Decoder, NULL, &DecodedCch) && DecodedCch == Cch + 1);
+
+        DecodedCch = Cch + 1;
+        TEST_CHECK(BlgDerDecUtf8String(Decoder, Decoded, &DecodedCch) && DecodedCch == Cch);
+        TEST_CHECK(memcmp(Decoded, Value, Cch * sizeof(WCHAR)) == 0 && Decoded[Cch] == 0);
+
+        TEST_CHECK(BlgDerDecUtf8StringA(Decoder, &Narrow, &NarrowCb, BLG_DER_STRING_FLAG_VALIDATE));
+        TEST_CHECK(NarrowCb == ExpectedCb && memcmp(Narrow, Expected, ExpectedCb) == 0);
+
+        BlgDerDestroyDecoder(Decoder);
+
+        Encoder = BlgDerCreateEncoder(TestEncoded, sizeof(TestEncoded), 0);
+        TEST_CHECK(BlgDerEncUtf8StringA(Encoder, 0, 0, (PCSTR) Expected, (INT) ExpectedCb,
+            BLG_DER_STRING_FLAG_VALIDATE));
+        BlgDerDestroyEncoder(Encoder);
+    }
+}
+
+VOID
+TestUtf8Malformed(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Places malformed and boundary UTF-8 sequences after every number of ASCII octets up to
+    TEST_OFFSET_COUNT, followed by none, one or a block of ASCII octets. Malformed values must
+    be rejected by every decoding path and by the validating encoder; well-formed ones must
+    decode to their code point.
+
+--*/
+
+{
+    static CONST TEST_UTF8_CASE Cases[] =
+    {
+        { "overlong U+0000", "\xC0\x80", 0 },
+        { "overlong U+007F", "\xC1\xBF", 0 },
+        { "overlong three octet U+0000", "\xE0\x80\x80", 0 },
+        { "overlong U+07FF", "\xE0\x9F\xBF", 0 },
+        { "overlong four octet U+0000", "\xF0\x80\x80\x80", 0 },
+        { "overlong U+FFFF", "\xF0\x8F\xBF\xBF", 0 },
+        { "surrogate U+D800", "\xED\xA0\x80", 0 },
+        { "surrogate U+DBFF", "\xED\xAF\xBF", 0 },
+        { "surrogate U+DC00", "\xED\xB0\x80", 0 },
+        { "surrogate U+DFFF", "\xED\xBF\xBF", 0 },
+        { "U+10FFFF + 1", "\xF4\x90\x80\x80", 0 },
+        { "U+13FFFF", "\xF4\xBF\xBF\xBF", 0 },
+        { "lead F5", "\xF5\x80\x80\x80", 0 },
+        { "lead F8", "\xF8\x88\x80\x80\x80", 0 },
+        { "lead FF", "\xFF", 0 },
+        { "lone continuation", "\x80", 0 },
+        { "continuation after a complete sequence", "\xC2\x80\x80", 0 },
+        { "truncated two octets", "\xC2", 0 },
+        { "truncated three octets", "\xE1\x80", 0 },
+        { "truncated four octets", "\xF1\x80\x80", 0 },
+        { "lead without continuation", "\xE1\x41\x80", 0 },
+        { "lead after lead", "\xF1\xF1\x80\x80\x80", 0 },
+        { "U+0080", "\xC2\x80", 0x80 },
+        { "U+07FF", "\xDF\xBF", 0x7FF },
+        { "U+0800", "\xE0\xA0\x80", 0x800 },
+        { "U+D7FF", "\xED\x9F\xBF", 0xD7FF },
+        { "U+E000", "\xEE\x80\x80", 0xE000 },
+        { "U+FFFF", "\xEF\xBF\xBF", 0xFFFF },
+        { "U+10000", "\xF0\x90\x80\x80", 0x10000 },
+        { "U+10FFFF", "\xF4\x8F\xBF\xBF", 0x10FFFF }
+    };
+
+    static CONST DWORD SuffixCbs[] = { 0, 1, 33 };
+    BYTE Value[TEST_OFFSET_COUNT + 64], Encoded[TEST_OFFSET_COUNT + 64 + 4];
+    WCHAR Decoded[TEST_OFFSET_COUNT + 64];
+    HBLG_DER_ENCODER Encoder;
+    HBLG_DER_DECODER Decoder;
+    PCSTR Narrow;
+    DWORD Case, Offset, Suffix, SequenceCb, ValueCb, EncodedCb, DecodedCch, NarrowCb, Cch, i;
+    BOOL Valid;
+
+    for (Case = 0; Case < ARRAYSIZE(Cases); Case++)
+    {
+        SequenceCb = (DWORD) strlen(Cases[Case].Value);
+        Valid = Cases[Case].CodePoint != 0;
+
+        for (Offset = 0; Offset < TEST_OFFSET_COUNT; Offset++)
+        {
+            for (Suffix = 0; Suffix < ARRAYSIZE(SuffixCbs); Suffix++)
+            {
+                sprintf(TestCase, "UTF-8 %s after %u octets, %u after", Cases[Case].Name, Offset,
+                    SuffixCbs[Suffix]);
+
+                memset(Value, 'a', sizeof(Value));
+                memcpy(Value + Offset, Cases[Case].Value, SequenceCb);
+
+                ValueCb = Offset + SequenceCb + SuffixCbs[Suffix];
+                EncodedCb = TestEncodeNode(BLG_DER_TAG_UTF8_STRING, Value, ValueCb, Encoded);
+                Cch = Offset + SuffixCbs[Suffix] + (Cases[Case].CodePoint >= 0x10000 ? 2 : 1);
+
+                Decoder = TestOpenNode(Encoded, EncodedCb);
+
+                DecodedCch = 0;
+                TEST_CHECK(BlgDerDecUtf8String(Decoder, NULL, &DecodedCch) == Valid);
+                TEST_CHECK(Valid ? DecodedCch == Cch + 1 : GetLastError() == ERROR_BLGASN1_CORRUPT);
+
+                DecodedCch = ARRAYSIZE(Decoded);
+                TEST_CHECK(BlgDerDecUtf8String(Decoder, Decoded, &DecodedCch) == Valid);
+                TEST_CHECK(Valid ? DecodedCch == Cch : GetLastError() == ERROR_BLGASN1_CORRUPT);
+
+                TEST_CHECK(BlgDerDecUtf8StringA(Decoder, &Narrow, &NarrowCb, BLG_DER_STRING_FLAG_VALIDATE) ==
+                    Valid);
+
+                BlgDerDestroyDecoder(Decoder);
+
+                Encoder = BlgDerCreateEncoder(TestEncoded, sizeof(TestEncoded), 0);
+                TEST_CHECK(BlgDerEncUtf8StringA(Encoder, 0, 0, (PCSTR) Value, (INT) ValueCb,
+                    BLG_DER_STRING_FLAG_VALIDATE) == Valid);
+                BlgDerDestroyEncoder(Encoder);
+
+                if (!Valid)
+                {
+                    continue;
+                }
+
+                for (i = 0; i < Offset; i++)
+                {
+                    TEST_CHECK(Decoded[i] == 'a');
+                }
+
+                if (Cases[Case].CodePoint < 0x10000)
+                {
+                    TEST_CHECK(Decoded[Offset] == Cases[Case].CodePoint);
+                }
+                else
+                {
+                    TEST_CHECK(Decoded[Offset] == 0xD800 + ((Cases[Case].CodePoint - 0x10000) >> 10));
+                    TEST_CHECK(Decoded[Offset + 1] == 0xDC00 + ((Cases[Case].CodePoint - 0x10000) & 0x3FF));
+                }
+            }
+        }
+    }
+}
+
+VOID
+TestUnpairedSurrogates(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes UTF-16 strings with unpaired surrogates after every number of ASCII characters up to
+    TEST_OFFSET_COUNT. Each unpaired surrogate must become U+FFFD, while the pairs around it are
+    kept.
+
+--*/
+
+{
+    static CONST TEST_SURROGATE_CASE Cases[] =
+    {
+        { "lone high surrogate", { 0xD800 }, 1, "\xEF\xBF\xBD" },
+        { "lone low surrogate", { 0xDFFF }, 1, "\xEF\xBF\xBD" },
+        { "high surrogate before ASCII", { 0xDBFF, 'b' }, 2, "\xEF\xBF\xBD" "b" },
+        { "reversed pair", { 0xDC00, 0xD800 }, 2, "\xEF\xBF\xBD\xEF\xBF\xBD" },
+        { "high surrogate before a pair", { 0xD800, 0xD800, 0xDC00 }, 3, "\xEF\xBF\xBD\xF0\x90\x80\x80" },
+        { "pair before a low surrogate", { 0xDBFF, 0xDFFF, 0xDC00 }, 3, "\xF4\x8F\xBF\xBF\xEF\xBF\xBD" },
+        { "pair", { 0xD83D, 0xDE00 }, 2, "\xF0\x9F\x98\x80" }
+    };
+
+    WCHAR Value[TEST_OFFSET_COUNT + 8];
+    BYTE Expected[TEST_OFFSET_COUNT + 16], ExpectedNode[TEST_OFFSET_COUNT + 20];
+    HBLG_DER_ENCODER Encoder;
+    DWORD Case, Offset, ExpectedCb, ExpectedNodeCb, EncodedCb, i;
+
+    for (Case = 0; Case < ARRAYSIZE(Cases); Case++)
+    {
+        for (Offset = 0; Offset < TEST_OFFSET_COUNT; Offset++)
+        {
+            sprintf(TestCase, "UTF-16 %s after %u characters", Cases[Case].Name, Offset);
+
+            for (i = 0; i < Offset; i++)
+            {
+                Value[i] = 'a';
+            }
+
+            memcpy(Value + Offset, Cases[Case].Value, Cases[Case].ValueCch * sizeof(WCHAR));
+
+            memset(Expected, 'a', Offset);
+            ExpectedCb = Offset + (DWORD) strlen(Cases[Case].Expected);
+            memcpy(Expected + Offset, Cases[Case].Expected, ExpectedCb - Offset);
+
+            ExpectedNodeCb = TestEncodeNode(BLG_DER_TAG_UTF8_STRING, Expected, ExpectedCb, ExpectedNode);
+
+            Encoder = BlgDerCreateEncoder(TestEncoded, sizeof(TestEncoded), 0);
+            TEST_CHECK(BlgDerEncUtf8String(Encoder, 0, 0, Value, (INT) (Offset + Cases[Case].ValueCch)));
+            TEST_CHECK(BlgDerGetEncoderParam(Encoder, BLG_DER_ENC_PARAM_ENCODED_CB, &EncodedCb));
+            BlgDerDestroyEncoder(Encoder);
+
+            TEST_CHECK(EncodedCb == ExpectedNodeCb && memcmp(TestEncoded, ExpectedNode, EncodedCb) == 0);
+        }
+    }
+}
+
+VOID
+TestGeneralizedTime(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes random times from the years 1000 to 9999 with random fractions of a second as
+    GeneralizedTime values and decodes them again. The encoding is compared with the text of
+    the date the time was made from, and fractions shorter than nine digits, with digits beyond the
+    ninth and in the SYSTEMTIME form are decoded from hand-written values.
+
+--*/
+
+{
+    static CONST struct
+    {
+        PCSTR Value;
+        LONGLONG Seconds;
+        DWORD Nanoseconds;
+
+        // MAXWORD for the values the SYSTEMTIME form rejects.
+        WORD Milliseconds;
+    }
+    Fractions[] =
+    {
+        { "20240229235959.5Z", 1709251199, 500000000, 500 },
+        { "20240229235959.05Z", 1709251199, 50000000, 50 },
+        { "20240229235959.12345678Z", 1709251199, 123456780, 123 },
+        { "20240229235959.123456789Z", 1709251199, 123456789, MAXWORD },
+        { "20240229235959.000000001Z", 1709251199, 1, MAXWORD },
+        { "20240229235959.1234567891Z", 1709251199, 123456789, MAXWORD },
+        { "19700101000000Z", 0, 0, 0 },
+        { "19691231235959.9Z", -1, 900000000, 900 }
+    };
+
+    CHAR Text[32];
+    BYTE Expected[40];
+    HBLG_DER_ENCODER Encoder;
+    HBLG_DER_DECODER Decoder;
+    SYSTEMTIME Time;
+    static CONST DWORD DaysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    LONGLONG Seconds, Decoded;
+    DWORD Iteration, Nanoseconds, DecodedNanoseconds, EncodedCb, ExpectedCb, TextCb, Year, Month, Day;
+    DWORD Second, Fraction, i;
+
+    for (Iteration = 0; Iteration < 100000; Iteration++)
+    {
+        Year = 1000 + (DWORD) (TestRandom() % 9000);
+        Month = 1 + (DWORD) (TestRandom() % 12);
+        Day = 1 + (DWORD) (TestRandom() % (DaysInMonth[Month - 1] + (Month == 2 && TestIsLeapYear(Year))));
+        Second = (DWORD) (TestRandom() % 86400);
+
+        switch (Iteration % 4)
+        {
+        case 0:
+            Nanoseconds = 0;
+            break;
+
+        case 1:
+            Nanoseconds = (DWORD) (TestRandom() % 10) * 100000000;
+            break;
+
+        default:
+            Nanoseconds = (DWORD) (TestRandom() % 1000000000);
+        }
+
+        Seconds = TestDaysFromCivil(Year, Month, Day) * 86400 + Second;
+
+        TextCb = sprintf(Text, "%04u%02u%02u%02u%02u%02u", Year, Month, Day, Second / 3600, Second / 60 % 60,
+            Second % 60);
+
+        if (Nanoseconds != 0)
+        {
+            TextCb += sprintf(Text + TextCb, ".%09u", Nanoseconds);
+
+            while (Text[TextCb - 1] == '0')
+            {
+                TextCb--;
+            }
+        }
+
+        Text[TextCb++] = 'Z';
+
+        sprintf(TestCase, "GeneralizedTime %.*s", (INT) TextCb, Text);
+
+        Encoder = BlgDerCreateEncoder(TestEncoded, sizeof(TestEncoded), 0);
+        TEST_CHECK(BlgDerEncGeneralizedTimeEpoch(Encoder, 0, 0, Seconds, Nanoseconds));
+        TEST_CHECK(BlgDerGetEncoderParam(Encoder, BLG_DER_ENC_PARAM_ENCODED_CB, &EncodedCb));
+        BlgDerDestroyEncoder(Encoder);
+
+        ExpectedCb = TestEncodeNode(BLG_DER_TAG_GENERALIZED_TIME, (CONST BYTE *) Text, TextCb, Expected);
+        TEST_CHECK(EncodedCb == ExpectedCb && memcmp(TestEncoded, Expected, ExpectedCb) == 0);
+
+        Decoder = TestOpenNode(TestEncoded, EncodedCb);
+
+        TEST_CHECK(BlgDerDecGeneralizedTimeEpoch(Decoder, &Decoded, &DecodedNanoseconds));
+        TEST_CHECK(Decoded == Seconds && DecodedNanoseconds == Nanoseconds);
+
+        // The SYSTEMTIME form holds years from 1601 and values of up to 24 characters, and rejects
+        // fractions that round down to zero milliseconds.
+        if (Year >= 1601 && TextCb <= 24 && (Nanoseconds == 0 || Nanoseconds >= 1000000))
+        {
+            TEST_CHECK(BlgDerDecGeneralizedTime(Decoder, &Time));
+            TEST_CHECK(Time.wYear == Year && Time.wMonth == Month && Time.wDay == Day);
+            TEST_CHECK(Time.wMilliseconds == Nanoseconds / 1000000);
+        }
+
+        BlgDerDestroyDecoder(Decoder);
+    }
+
+    for (i = 0; i < ARRAYSIZE(Fractions); i++)
+    {
+        sprintf(TestCase, "GeneralizedTime %s", Fractions[i].Value);
+
+        ExpectedCb = TestEncodeNode(BLG_DER_TAG_GENERALIZED_TIME, (CONST BYTE *) Fractions[i].Value,
+            (DWORD) strlen(Fractions[i].Value), Expected);
+
+        Decoder = TestOpenNode(Expected, ExpectedCb);
+
+        TEST_CHECK(BlgDerDecGeneralizedTimeEpoch(Decoder, &Decoded, &Fraction));
+        TEST_CHECK(Decoded == Fractions[i].Seconds && Fraction == Fractions[i].Nanoseconds);
+
+        if (Fractions[i].Milliseconds != MAXWORD)
+        {
+            TEST_CHECK(BlgDerDecGeneralizedTime(Decoder, &Time));
+            TEST_CHECK(Time.wMilliseconds == Fractions[i].Milliseconds);
+        }
+        else
+        {
+            TEST_CHECK(!BlgDerDecGeneralizedTime(Decoder, &Time));
+        }
+
+        BlgDerDestroyDecoder(Decoder);
+    }
+}
+
+VOID
+TestMalformedTime(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Replaces each digit of valid GeneralizedTime and UTCTime values with the octets next to the
+    digits and with other characters, and decodes values with fields out of range. All of them
+    must be rejected.
+
+--*/
+
+{
+    static CONST CHAR NotDigits[] = { '/', ':', ' ', 'A', '0' + 0x40, '0' - 0x10, '9' + 0x80 };
+
+    static CONST PCSTR Invalid[] =
+    {
+        "20230229000000Z",
+        "21000229000000Z",
+        "20240001000000Z",
+        "20241301000000Z",
+        "20240100000000Z",
+        "20240132000000Z",
+        "20240431000000Z",
+        "20240101240000Z",
+        "20240101006000Z",
+        "20240101000060Z",
+        "20240101000000.Z",
+        "20240101000000.5",
+        "20240101000000"
+    };
+
+    static CONST PCSTR TrailingZeros[] =
+    {
+        "20240101000000.0Z",
+        "20240101000000.50Z",
+        "20240101000000.123456780Z"
+    };
+
+    CHAR Value[32];
+    BYTE Encoded[40];
+    HBLG_DER_DECODER Decoder;
+    SYSTEMTIME Time;
+    LONGLONG Seconds;
+    DWORD EncodedCb, Length, Position, i;
+    BOOL Utc;
+
+    for (Utc = FALSE; Utc <= TRUE; Utc++)
+    {
+        strcpy(Value, Utc ? "240229123456Z" : "20240229123456Z");
+        Length = (DWORD) strlen(Value);
+
+        for (Position = 0; Position < Length - 1; Position++)
+        {
+            for (i = 0; i < ARRAYSIZE(NotDigits); i++)
+            {
+                Value[Position] = NotDigits[i];
+
+                sprintf(TestCase, "%s with 0x%02X at %u", Utc ? "UTCTime" : "GeneralizedTime",
+                    (BYTE) NotDigits[i], Position);
+
+                EncodedCb = TestEncodeNode(Utc ? BLG_DER_TAG_UTC_TIME : BLG_DER_TAG_GENERALIZED_TIME,
+                    (CONST BYTE *) Value, Length, Encoded);
+
+                Decoder = TestOpenNode(Encoded, EncodedCb);
+
+                if (Utc)
+                {
+                    TEST_CHECK(!BlgDerDecUtcTimeEpoch(Decoder, &Seconds));
+                    TEST_CHECK(!BlgDerDecUtcTime(Decoder, &Time));
+                }
+                else
+                {
+                    TEST_CHECK(!BlgDerDecGeneralizedTimeEpoch(Decoder, &Seconds, NULL));
+                    TEST_CHECK(!BlgDerDecGeneralizedTime(Decoder, &Time));
+                }
+
+                BlgDerDestroyDecoder(Decoder);
+            }
+
+            Value[Position] = Utc ? "240229123456Z"[Position] : "20240229123456Z"[Position];
+        }
+    }
+
+    for (i = 0; i < ARRAYSIZE(Invalid); i++)
+    {
+        sprintf(TestCase, "GeneralizedTime %s", Invalid[i]);
+
+        EncodedCb = TestEncodeNode(BLG_DER_TAG_GENERALIZED_TIME, (CONST BYTE *) Invalid[i],
+            (DWORD) strlen(Invalid[i]), Encoded);
+
+        Decoder = TestOpenNode(Encoded, EncodedCb);
+
+        TEST_CHECK(!BlgDerDecGeneralizedTimeEpoch(Decoder, &Seconds, NULL));
+        TEST_CHECK(!BlgDerDecGeneralizedTime(Decoder, &Time));
+
+        BlgDerDestroyDecoder(Decoder);
+    }
+
+    // Only the epoch form enforces that a fraction does not end with a zero.
+    for (i = 0; i < ARRAYSIZE(TrailingZeros); i++)
+    {
+        sprintf(TestCase, "GeneralizedTime %s", TrailingZeros[i]);
+
+        EncodedCb = TestEncodeNode(BLG_DER_TAG_GENERALIZED_TIME, (CONST BYTE *) TrailingZeros[i],
+            (DWORD) strlen(TrailingZeros[i]), Encoded);
+
+        Decoder = TestOpenNode(Encoded, EncodedCb);
+
+        TEST_CHECK(!BlgDerDecGeneralizedTimeEpoch(Decoder, &Seconds, NULL));
+        TEST_CHECK(GetLastError() == ERROR_BLGASN1_CORRUPT);
+
+        BlgDerDestroyDecoder(Decoder);
+    }
+}
+
+VOID
+TestUtcTime(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes UTCTime values around the boundary of the two-digit years, which stand for 1950 to
+    2049.
+
+--*/
+
+{
+    static CONST struct
+    {
+        PCSTR Value;
+        DWORD Year;
+        DWORD Month;
+        DWORD Day;
+        DWORD Second;
+    }
+    Cases[] =
+    {
+        { "500101000000Z", 1950, 1, 1, 0 },
+        { "691231235959Z", 1969, 12, 31, 86399 },
+        { "700101000000Z", 1970, 1, 1, 0 },
+        { "991231235959Z", 1999, 12, 31, 86399 },
+        { "000229120000Z", 2000, 2, 29, 43200 },
+        { "491231235959Z", 2049, 12, 31, 86399 }
+    };
+
+    BYTE Encoded[40];
+    HBLG_DER_DECODER Decoder;
+    SYSTEMTIME Time;
+    LONGLONG Seconds;
+    DWORD EncodedCb, i;
+
+    for (i = 0; i < ARRAYSIZE(Cases); i++)
+    {
+        sprintf(TestCase, "UTCTime %s", Cases[i].Value);
+
+        EncodedCb = TestEncodeNode(BLG_DER_TAG_UTC_TIME, (CONST BYTE *) Cases[i].Value,
+            (DWORD) strlen(Cases[i].Value), Encoded);
+
+        Decoder = TestOpenNode(Encoded, EncodedCb);
+
+        TEST_CHECK(BlgDerDecUtcTimeEpoch(Decoder, &Seconds));
+        TEST_CHECK(Seconds == TestDaysFromCivil(Cases[i].Year, Cases[i].Month, Cases[i].Day) * 86400 +
+            Cases[i].Second);
+
+        TEST_CHECK(BlgDerDecUtcTime(Decoder, &Time));
+        TEST_CHECK(Time.wYear == Cases[i].Year && Time.wMonth == Cases[i].Month && Time.wDay == Cases[i].Day);
+
+        BlgDerDestroyDecoder(Decoder);
+    }
+}
+
+VOID
+TestOidArcs(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Encodes random Object Identifiers whose arcs have every size from one to ten subidentifier
+    octets, mixed with runs of small arcs, and decodes them again. The content octets are
+    compared with a reference base-128 encoder. Decoding into 32 bit arcs must succeed exactly
+    if every arc fits.
+
+--*/
+
+{
+    static ULONGLONG Arcs[40], Decoded64[40];
+    static DWORD Arcs32[40], Decoded32[40];
+    static BYTE Expected[512], ExpectedNode[520];
+    HBLG_DER_ENCODER Encoder;
+    HBLG_DER_DECODER Decoder;
+    ULONGLONG Subidentifier;
+    DWORD Iteration, ArcCount, DecodedCount, ExpectedCb, ExpectedNodeCb, EncodedCb, Bits, Cb, i, j;
+    BOOL Fits;
+
+    for (Iteration = 0; Iteration < 50000; Iteration++)
+    {
+        ArcCount = 2 + (DWORD) (TestRandom() % 30);
+        Fits = TRUE;
+
+        Arcs[0] = TestRandom() % 3;
+        Arcs[1] = Arcs[0] < 2 ? TestRandom() % 40 : TestRandom() % 1000;
+
+        for (i = 2; i < ArcCount; i++)
+        {
+            // Half of the arcs are small, the rest have a random number of bits.
+            Bits = TestRandom() % 2 ? 7 : 1 + (DWORD) (TestRandom() % 64);
+            Arcs[i] = TestRandom() >> (64 - Bits);
+        }
+
+        // The first two arcs share the first subidentifier.
+        for (i = 1, ExpectedCb = 0; i < ArcCount; i++)
+        {
+            Subidentifier = i == 1 ? Arcs[0] * 40 + Arcs[1] : Arcs[i];
+
+            for (Cb = 1; Cb < 10 && (Subidentifier >> (7 * Cb)) != 0; Cb++);
+
+            for (j = Cb; j > 1; j--)
+            {
+                Expected[ExpectedCb++] = (BYTE) (((Subidentifier >> (7 * (j - 1))) & 0x7F) | 0x80);
+            }
+
+            Expected[ExpectedCb++] = (BYTE) (Subidentifier & 0x7F);
+
+            if (Arcs[i] > MAXDWORD)
+            {
+                Fits = FALSE;
+            }
+
+            Arcs32[i] = (DWORD) Arcs[i];
+        }
+
+        Arcs32[0] = (DWORD) Arcs[0];
+
+        sprintf(TestCase, "OBJECT IDENTIFIER %u (%u arcs)", Iteration, ArcCount);
+
+        Encoder = BlgDerCreateEncoder(TestEncoded, sizeof(TestEncoded), 0);
+        TEST_CHECK(BlgDerEncObjectIdentifierArcs64(Encoder, 0, 0, Arcs, ArcCount));
+        TEST_CHECK(BlgDerGetEncoderParam(Encoder, BLG_DER_ENC_PARAM_ENCODED_CB, &EncodedCb));
+        BlgDerDestroyEncoder(Encoder);
+
+        ExpectedNodeCb = TestEncodeNode(BLG_DER_TAG_OBJECT_IDENTIFIER, Expected, ExpectedCb, ExpectedNode);
+        TEST_CHECK(EncodedCb == ExpectedNodeCb && memcmp(TestEncoded, ExpectedNode, EncodedCb) == 0);
+
+        Decoder = TestOpenNode(TestEncoded, EncodedCb);
+
+        DecodedCount = ARRAYSIZE(Decoded64);
+        TEST_CHECK(BlgDerDecObjectIdentifierArcs64(Decoder, Decoded64, &DecodedCount));
+        TEST_CHECK(DecodedCount == ArcCount && memcmp(Decoded64, Arcs, ArcCount * sizeof(ULONGLONG)) == 0);
+
+        DecodedCount = ARRAYSIZE(Decoded32);
+        TEST_CHECK(BlgDerDecObjectIdentifierArcs(Decoder, Decoded32, &DecodedCount) == Fits);
+
+        if (Fits)
+        {
+            TEST_CHECK(DecodedCount == ArcCount && memcmp(Decoded32, Arcs32, ArcCount * sizeof(DWORD)) == 0);
+        }
+        else
+        {
+            TEST_CHECK(GetLastError() == ERROR_BLGASN1_TOO_LARGE);
+        }
+
+        BlgDerDestroyDecoder(Decoder);
+    }
+}
+
+VOID
+TestMalformedOid(
+    VOID
+    )
+
+/*++
+
+Routine Description:
+
+    Decodes Object Identifiers with malformed subidentifiers after every number of small arcs up
+    to TEST_OFFSET_COUNT, followed by none, one or eight small arcs, so that the malformed
+    subidentifier is seen both with and without eight octets after it. Subidentifiers of the
+    largest and the smallest values of each size must decode.
+
+--*/
+
+{
+    static CONST struct
+    {
+        PCSTR Name;
+        BYTE Value[12];
+        DWORD ValueCb;
+        DWORD Error;
+        ULONGLONG Arc;
+    }
+    Cases[] =
+    {
+        { "leading 0x80", { 0x80, 0x01 }, 2, ERROR_BLGASN1_CORRUPT, 0 },
+        { "leading 0x80 of a large arc", { 0x80, 0x81, 0x80, 0x80, 0x00 }, 5, ERROR_BLGASN1_CORRUPT, 0 },
+        {
+            "2^64",
+            { 0x82, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 }, 10,
+            ERROR_BLGASN1_TOO_LARGE, 0
+        },
+        {
+            "eleven octets",
+            { 0x81, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 }, 11,
+            ERROR_BLGASN1_TOO_LARGE, 0
+        },
+        { "2^64 - 1", { 0x81, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F }, 10, 0, MAXULONGLONG },
+        { "2^56 - 1", { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7F }, 8, 0, (1ULL << 56) - 1 },
+        { "2^56", { 0x81, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 }, 9, 0, 1ULL << 56 },
+        { "2^32", { 0x90, 0x80, 0x80, 0x80, 0x00 }, 5, 0, 1ULL << 32 },
+        { "128", { 0x81, 0x00 }, 2, 0, 128 }
+    };
+
+    static CONST DWORD SuffixCounts[] = { 0, 1, 8 };
+    BYTE Value[TEST_OFFSET_COUNT + 32], Encoded[TEST_OFFSET_COUNT + 40];
+    ULONGLONG Decoded[TEST_OFFSET_COUNT + 16];
+    HBLG_DER_DECODER Decoder;
+    DWORD Case, Offset, Suffix, ValueCb, EncodedCb, DecodedCount;
+    BOOL Valid;
+
+    for (Case = 0; Case < ARRAYSIZE(Cases); Case++)
+    {
+        Valid = Cases[Case].Error == 0;
+
+        for (Offset = 0; Offset < TEST_OFFSET_COUNT; Offset++)
+        {
+            for (Suffix = 0; Suffix < ARRAYSIZE(SuffixCounts); Suffix++)
+            {
+                sprintf(TestCase, "OBJECT IDENTIFIER %s after %u arcs, %u after", Cases[Case].Name, Offset,
+                    SuffixCounts[Suffix]);
+
+                // The first subidentifier stands for the arcs 1.2; the others are 5.
+                memset(Value, 0x05, sizeof(Value));
+                Value[0] = 0x2A;
+
+                memcpy(Value + 1 + Offset, Cases[Case].Value, Cases[Case].ValueCb);
+
+                ValueCb = 1 + Offset + Cases[Case].ValueCb + SuffixCounts[Suffix];
+                EncodedCb = TestEncodeNode(BLG_DER_TAG_OBJECT_IDENTIFIER, Value, ValueCb, Encoded);
+
+                Decoder = TestOpenNode(Encoded, EncodedCb);
+
+                DecodedCount = ARRAYSIZE(Decoded);
+                TEST_CHECK(BlgDerDecObjectIdentifierArcs64(Decoder, Decoded, &DecodedCount) == Valid);
+
+                if (Valid)
+                {
+                    TEST_CHECK(DecodedCount == 3 + Offset + SuffixCounts[Suffix]);
+                    TEST_CHECK(Decoded[2 + Offset] == Cases[Case].Arc);
+                }
+                else
+                {
+                    TEST_CHECK(GetLastError() == Cases[Case].Error);
+                }
+
+                BlgDerDestroyDecoder(Decoder);
+            }
+        }
+    }
+
+    sprintf(TestCase, "OBJECT IDENTIFIER with a truncated last subidentifier");
+
+    Value[0] = 0x2A;
+    Value[1] = 0x86;
+    EncodedCb = TestEncodeNode(BLG_DER_TAG_OBJECT_IDENTIFIER, Value, 2, Encoded);
+
+    Decoder = TestOpenNode(Encoded, EncodedCb);
+
+    DecodedCount = ARRAYSIZE(Decoded);
+    TEST_CHECK(!BlgDerDecObjectIdentifierArcs64(Decoder, Decoded, &DecodedCount));
+    TEST_CHECK(GetLastError() == ERROR_BLGASN1_CORRUPT);
+
+    BlgDerDestroyDecoder(Decoder);
+
+    sprintf(TestCase, "empty OBJECT IDENTIFIER");
+
+    EncodedCb = TestEncodeNode(BLG_DER_TAG_OBJECT_IDENTIFIER, Value, 0, Encoded);
+
+    Decoder = TestOpenNode(Encoded, EncodedCb);
+
+    DecodedCount = ARRAYSIZE(Decoded);
+    TEST_CHECK(!BlgDerDecObjectIdentifierArcs64(Decoder, Decoded, &DecodedCount));
+
+    BlgDerDestroyDecoder(Decoder);
+}
\ No newline at end of file
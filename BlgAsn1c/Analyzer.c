@@ -0,0 +1,709 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+Module Description:
+
+    Resolves type references and tagging modes, applies automatic tagging, moves anonymous
+    constructed types into assignments of their own and orders the assignments so that every
+    type is defined before it is embedded into another.
+
+--*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "BlgAsn1c.h"
+
+ASN1C_TYPE *
+Asn1cBaseType(
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the type inside all tags of a type.
+
+--*/
+
+{
+    while (Type->Kind == Asn1cTagged)
+    {
+        Type = Type->Inner;
+    }
+
+    return Type;
+}
+
+ASN1C_TYPE *
+Asn1cCoreType(
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the type inside all tags and references of a type.
+
+--*/
+
+{
+    for (;;)
+    {
+        if (Type->Kind == Asn1cTagged)
+        {
+            Type = Type->Inner;
+        }
+        else if (Type->Kind == Asn1cReference)
+        {
+            Type = Type->Resolved->Type;
+        }
+        else
+        {
+            return Type;
+        }
+    }
+}
+
+int
+Asn1cOuterTag(
+    ASN1C_TYPE *Type,
+    int *Class,
+    unsigned long *Number,
+    int *Constructed
+    )
+
+/*++
+
+Routine Description:
+
+    Determines the outermost tag of a type.
+
+Arguments:
+
+    Type - The type to be examined.
+
+    Class - Receives the class of the tag.
+
+    Number - Receives the number of the tag.
+
+    Constructed - Receives whether the encoding of the type is constructed.
+
+Return Value:
+
+    Nonzero if the type has a tag; zero for an untagged CHOICE type, whose tag is that of the
+    chosen alternative.
+
+--*/
+
+{
+    int InnerClass;
+    unsigned long InnerNumber;
+
+    switch (Type->Kind)
+    {
+    case Asn1cTagged:
+        *Class = Type->TagClass;
+        *Number = Type->TagNumber;
+
+        if (Type->TagMode == ASN1C_TAGS_EXPLICIT)
+        {
+            *Constructed = 1;
+        }
+        else if (!Asn1cOuterTag(Type->Inner, &InnerClass, &InnerNumber, Constructed))
+        {
+            Asn1cError(Type->Line, "a CHOICE type cannot be tagged implicitly");
+        }
+
+        return 1;
+
+    case Asn1cReference:
+        return Asn1cOuterTag(Type->Resolved->Type, Class, Number, Constructed);
+
+    case Asn1cChoice:
+        return 0;
+
+    default:
+        break;
+    }
+
+    *Class = ASN1C_CLASS_UNIVERSAL;
+    *Constructed = 0;
+
+    switch (Type->Kind)
+    {
+    case Asn1cBoolean:
+        *Number = 0x01;
+
+        break;
+
+    case Asn1cInteger:
+        *Number = 0x02;
+
+        break;
+
+    case Asn1cNull:
+        *Number = 0x05;
+
+        break;
+
+    case Asn1cString:
+        *Number = Type->UniversalTag;
+
+        break;
+
+    case Asn1cSet:
+        *Number = 0x11;
+        *Constructed = 1;
+
+        break;
+
+    default:
+        *Number = 0x10;
+        *Constructed = 1;
+
+        break;
+    }
+
+    return 1;
+}
+
+static
+ASN1C_ASSIGNMENT *
+Asn1cFindAssignment(
+    ASN1C_MODULE *Module,
+    const char *Name
+    )
+{
+    ASN1C_ASSIGNMENT *Assignment;
+
+    for (Assignment = Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        if (strcmp(Assignment->Name, Name) == 0)
+        {
+            return Assignment;
+        }
+    }
+
+    return NULL;
+}
+
+
+static
+void
+Asn1cResolveType(
+    ASN1C_MODULE *Module,
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Resolves the type references within a type and applies automatic tagging to its component
+    lists.
+
+--*/
+
+{
+    ASN1C_COMPONENT *Component;
+    ASN1C_TYPE *Tagged;
+    unsigned long Number;
+
+    switch (Type->Kind)
+    {
+    case Asn1cReference:
+        Type->Resolved = Asn1cFindAssignment(Module, Type->Reference);
+
+        if (!Type->Resolved)
+        {
+            Asn1cError(Type->Line, "type '%s' is not defined", Type->Reference);
+        }
+
+        break;
+
+    case Asn1cTagged:
+    case Asn1cSequenceOf:
+        Asn1cResolveType(Module, Type->Inner);
+
+        break;
+
+    case Asn1cSequence:
+    case Asn1cSet:
+    case Asn1cChoice:
+        for (Component = Type->Components; Component; Component = Component->Next)
+        {
+            if (Component->Type->Kind == Asn1cTagged)
+            {
+                break;
+            }
+        }
+
+        // With AUTOMATIC TAGS, the components are numbered unless one of them is tagged.
+        if (Module->TagDefault == ASN1C_TAGS_AUTOMATIC && !Component)
+        {
+            for (Component = Type->Components, Number = 0; Component; Component = Component->Next, Number++)
+            {
+                Tagged = Asn1cAlloc(sizeof(ASN1C_TYPE));
+
+                Tagged->Kind = Asn1cTagged;
+                Tagged->Line = Component->Line;
+                Tagged->TagClass = ASN1C_CLASS_CONTEXT;
+                Tagged->TagNumber = Number;
+                Tagged->TagMode = ASN1C_TAGS_DEFAULT;
+                Tagged->Inner = Component->Type;
+
+                Component->Type = Tagged;
+            }
+        }
+
+        for (Component = Type->Components; Component; Component = Component->Next)
+        {
+            Asn1cResolveType(Module, Component->Type);
+        }
+
+        break;
+
+    default:
+        break;
+    }
+}
+
+static
+void
+Asn1cHoistType(
+    ASN1C_MODULE *Module,
+    ASN1C_TYPE **Slot,
+    const char *ParentName,
+    const char *Name
+    )
+
+/*++
+
+Routine Description:
+
+    Moves an anonymous constructed type used by a component or by the elements of a SEQUENCE
+    OF type into a new assignment named after its parent, and replaces it with a reference to
+    the new assignment. The tags of the type are kept in place.
+
+--*/
+
+{
+    ASN1C_ASSIGNMENT *Assignment;
+    ASN1C_TYPE *Reference;
+
+    while ((*Slot)->Kind == Asn1cTagged)
+    {
+        Slot = &(*Slot)->Inner;
+    }
+
+    switch ((*Slot)->Kind)
+    {
+    case Asn1cSequence:
+    case Asn1cSet:
+    case Asn1cChoice:
+    case Asn1cSequenceOf:
+        break;
+
+    default:
+        return;
+    }
+
+    Assignment = Asn1cAlloc(sizeof(ASN1C_ASSIGNMENT));
+
+    Assignment->Name = Asn1cAlloc(strlen(ParentName) + strlen(Name) + 2);
+
+    sprintf(Assignment->Name, "%s_%s", ParentName, Name);
+
+    if (Asn1cFindAssignment(Module, Assignment->Name))
+    {
+        Asn1cError((*Slot)->Line, "the name '%s' of an anonymous type is already in use", Assignment->Name);
+    }
+
+    Assignment->CName = Asn1cCName(Assignment->Name);
+    Assignment->Type = *Slot;
+    Assignment->Line = (*Slot)->Line;
+    Assignment->Anonymous = 1;
+
+    *Module->Tail = Assignment;
+    Module->Tail = &Assignment->Next;
+
+    Reference = Asn1cAlloc(sizeof(ASN1C_TYPE));
+
+    Reference->Kind = Asn1cReference;
+    Reference->Line = Assignment->Line;
+    Reference->Reference = Assignment->Name;
+    Reference->Resolved = Assignment;
+
+    *Slot = Reference;
+}
+
+static
+int
+Asn1cIsStructType(
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Determines whether the C representation of a type is a structure of its own.
+
+--*/
+
+{
+    switch (Asn1cBaseType(Type)->Kind)
+    {
+    case Asn1cSequence:
+    case Asn1cSet:
+    case Asn1cChoice:
+    case Asn1cSequenceOf:
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+static
+void
+Asn1cVisitAssignment(
+    ASN1C_ASSIGNMENT *Assignment,
+    ASN1C_ASSIGNMENT ***Tail
+    );
+
+static
+void
+Asn1cVisitType(
+    ASN1C_TYPE *Type,
+    ASN1C_ASSIGNMENT ***Tail
+    )
+
+/*++
+
+Routine Description:
+
+    Visits the assignments whose C types are embedded by the C type of a type.
+
+--*/
+
+{
+    ASN1C_COMPONENT *Component;
+
+    Type = Asn1cBaseType(Type);
+
+    switch (Type->Kind)
+    {
+    case Asn1cReference:
+        Asn1cVisitAssignment(Type->Resolved, Tail);
+
+        break;
+
+    case Asn1cSequence:
+    case Asn1cSet:
+    case Asn1cChoice:
+        for (Component = Type->Components; Component; Component = Component->Next)
+        {
+            Asn1cVisitType(Component->Type, Tail);
+        }
+
+        break;
+
+    case Asn1cSequenceOf:
+        // The elements are referenced through a pointer, so a structure needs no definition.
+        Type = Asn1cBaseType(Type->Inner);
+
+        if (Type->Kind == Asn1cReference && !Asn1cIsStructType(Type->Resolved->Type))
+        {
+            Asn1cVisitAssignment(Type->Resolved, Tail);
+        }
+
+        break;
+
+    default:
+        break;
+    }
+}
+
+static
+void
+Asn1cVisitAssignment(
+    ASN1C_ASSIGNMENT *Assignment,
+    ASN1C_ASSIGNMENT ***Tail
+    )
+
+/*++
+
+Routine Description:
+
+    Appends an assignment to the ordered list after the assignments it depends on.
+
+--*/
+
+{
+    if (Assignment->Visit == 2)
+    {
+        return;
+    }
+
+    if (Assignment->Visit == 1)
+    {
+        Asn1cError(Assignment->Line, "type '%s' contains itself; use a SEQUENCE OF type for recursion",
+            Assignment->Name);
+    }
+
+    Assignment->Visit = 1;
+
+    Asn1cVisitType(Assignment->Type, Tail);
+
+    Assignment->Visit = 2;
+    Assignment->Next = NULL;
+
+    **Tail = Assignment;
+    *Tail = &Assignment->Next;
+}
+
+static
+int
+Asn1cIsUntaggedChoice(
+    ASN1C_TYPE *Type
+    )
+{
+    while (Type->Kind == Asn1cReference)
+    {
+        Type = Type->Resolved->Type;
+    }
+
+    return Type->Kind == Asn1cChoice;
+}
+
+static
+void
+Asn1cResolveTagModes(
+    ASN1C_MODULE *Module,
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Replaces the default tagging mode of the tags within a type by the tagging mode of the
+    module. Tags of CHOICE types are always explicit.
+
+--*/
+
+{
+    ASN1C_COMPONENT *Component;
+
+    switch (Type->Kind)
+    {
+    case Asn1cTagged:
+        if (Type->TagMode == ASN1C_TAGS_DEFAULT)
+        {
+            if (Module->TagDefault == ASN1C_TAGS_EXPLICIT || Asn1cIsUntaggedChoice(Type->Inner))
+            {
+                Type->TagMode = ASN1C_TAGS_EXPLICIT;
+            }
+            else
+            {
+                Type->TagMode = ASN1C_TAGS_IMPLICIT;
+            }
+        }
+        else if (Type->TagMode == ASN1C_TAGS_IMPLICIT && Asn1cIsUntaggedChoice(Type->Inner))
+        {
+            Asn1cError(Type->Line, "a CHOICE type cannot be tagged implicitly");
+        }
+
+        Asn1cResolveTagModes(Module, Type->Inner);
+
+        break;
+
+    case Asn1cSequenceOf:
+        Asn1cResolveTagModes(Module, Type->Inner);
+
+        break;
+
+    case Asn1cSequence:
+    case Asn1cSet:
+    case Asn1cChoice:
+        for (Component = Type->Components; Component; Component = Component->Next)
+        {
+            Asn1cResolveTagModes(Module, Component->Type);
+        }
+
+        break;
+
+    default:
+        break;
+    }
+}
+
+static
+void
+Asn1cValidateType(
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Checks the components of a SEQUENCE, SET or CHOICE type for duplicate names, unsupported
+    DEFAULT values and ambiguous tags.
+
+--*/
+
+{
+    ASN1C_COMPONENT *Component, *Other;
+    ASN1C_TYPE *Core;
+    int Class, OtherClass, Constructed;
+    unsigned long Number, OtherNumber;
+
+    Type = Asn1cBaseType(Type);
+
+    if (Type->Kind != Asn1cSequence && Type->Kind != Asn1cSet && Type->Kind != Asn1cChoice)
+    {
+        return;
+    }
+
+    for (Component = Type->Components; Component; Component = Component->Next)
+    {
+        for (Other = Component->Next; Other; Other = Other->Next)
+        {
+            if (strcmp(Component->Name, Other->Name) == 0)
+            {
+                Asn1cError(Other->Line, "duplicate component '%s'", Other->Name);
+            }
+        }
+
+        if (Component->HasDefault)
+        {
+            Core = Asn1cCoreType(Component->Type);
+
+            if (Core->Kind == Asn1cBoolean ? (Component->Default != 0 && Component->Default != 1) :
+                Core->Kind != Asn1cInteger || (Core->HasMin && Component->Default < Core->Min) ||
+                (Core->HasMax && Component->Default > Core->Max))
+            {
+                Asn1cError(Component->Line, "invalid DEFAULT value for component '%s'", Component->Name);
+            }
+        }
+
+        if (Type->Kind == Asn1cSequence)
+        {
+            continue;
+        }
+
+        // The components of a SET and the alternatives of a CHOICE are told apart by their tags.
+        if (!Asn1cOuterTag(Component->Type, &Class, &Number, &Constructed))
+        {
+            if (Type->Kind == Asn1cSet)
+            {
+                Asn1cError(Component->Line, "untagged CHOICE components of a SET type are not supported");
+            }
+
+            continue;
+        }
+
+        for (Other = Component->Next; Other; Other = Other->Next)
+        {
+            if (Asn1cOuterTag(Other->Type, &OtherClass, &OtherNumber, &Constructed) &&
+                OtherClass == Class && OtherNumber == Number)
+            {
+                Asn1cError(Other->Line, "components '%s' and '%s' have the same tag", Component->Name, Other->Name);
+            }
+        }
+    }
+}
+
+void
+Asn1cAnalyze(
+    ASN1C_MODULE *Module
+    )
+
+/*++
+
+Routine Description:
+
+    Prepares a parsed module for code generation.
+
+Arguments:
+
+    Module - The module to be analyzed.
+
+--*/
+
+{
+    ASN1C_ASSIGNMENT *Assignment, *Other, *Ordered = NULL, **Tail = &Ordered, **Unordered;
+    ASN1C_COMPONENT *Component;
+    ASN1C_TYPE *Base;
+    size_t Count, i;
+
+    for (Assignment = Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        for (Other = Assignment->Next; Other; Other = Other->Next)
+        {
+            if (strcmp(Assignment->Name, Other->Name) == 0)
+            {
+                Asn1cError(Other->Line, "type '%s' is already defined", Other->Name);
+            }
+        }
+
+        Asn1cResolveType(Module, Assignment->Type);
+    }
+
+    // Hoisted assignments are appended to the list and processed by the same loop.
+    for (Assignment = Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        Base = Asn1cBaseType(Assignment->Type);
+
+        if (Base->Kind == Asn1cSequenceOf)
+        {
+            Asn1cHoistType(Module, &Base->Inner, Assignment->Name, "Element");
+        }
+        else if (Base->Kind == Asn1cSequence || Base->Kind == Asn1cSet || Base->Kind == Asn1cChoice)
+        {
+            for (Component = Base->Components; Component; Component = Component->Next)
+            {
+                Asn1cHoistType(Module, &Component->Type, Assignment->Name, Component->Name);
+            }
+        }
+    }
+
+    // Visiting relinks the assignments, so the original order is saved first.
+    for (Assignment = Module->Assignments, Count = 0; Assignment; Assignment = Assignment->Next)
+    {
+        Count++;
+    }
+
+    Unordered = Asn1cAlloc(Count * sizeof(ASN1C_ASSIGNMENT *));
+
+    for (Assignment = Module->Assignments, i = 0; Assignment; Assignment = Assignment->Next)
+    {
+        Unordered[i++] = Assignment;
+    }
+
+    for (i = 0; i < Count; i++)
+    {
+        Asn1cVisitAssignment(Unordered[i], &Tail);
+    }
+
+    Module->Assignments = Ordered;
+    Module->Tail = Tail;
+
+    for (Assignment = Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        Asn1cResolveTagModes(Module, Assignment->Type);
+    }
+
+    for (Assignment = Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        Asn1cValidateType(Assignment->Type);
+    }
+}
\ No newline at end of file
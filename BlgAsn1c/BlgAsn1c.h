@@ -0,0 +1,209 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+--*/
+
+#ifndef BLGASN1C_H
+#define BLGASN1C_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stddef.h>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define vsnprintf _vsnprintf
+#endif
+
+// ASN.1 tag classes. The values match the BLG_DER_CLASS_* constants of the library.
+#define ASN1C_CLASS_UNIVERSAL     0
+#define ASN1C_CLASS_APPLICATION   1
+#define ASN1C_CLASS_CONTEXT       2
+#define ASN1C_CLASS_PRIVATE       3
+
+// Tagging modes of tagged types and modules.
+#define ASN1C_TAGS_DEFAULT     0
+#define ASN1C_TAGS_EXPLICIT    1
+#define ASN1C_TAGS_IMPLICIT    2
+#define ASN1C_TAGS_AUTOMATIC   3
+
+typedef enum _ASN1C_KIND
+{
+    Asn1cBoolean,
+    Asn1cInteger,
+    Asn1cNull,
+    Asn1cString,
+    Asn1cSequence,
+    Asn1cSet,
+    Asn1cChoice,
+    Asn1cSequenceOf,
+    Asn1cReference,
+    Asn1cTagged
+
+} ASN1C_KIND;
+
+// Native representation of an INTEGER type, selected from its value range.
+typedef enum _ASN1C_INT_TYPE
+{
+    Asn1cInt32,
+    Asn1cUInt32,
+    Asn1cInt64,
+    Asn1cUInt64
+
+} ASN1C_INT_TYPE;
+
+typedef struct _ASN1C_TYPE ASN1C_TYPE;
+typedef struct _ASN1C_ASSIGNMENT ASN1C_ASSIGNMENT;
+
+typedef struct _ASN1C_COMPONENT
+{
+    char *Name;
+    char *CName;
+    ASN1C_TYPE *Type;
+    int Optional;
+    int HasDefault;
+    long long Default;
+    int Line;
+    struct _ASN1C_COMPONENT *Next;
+
+} ASN1C_COMPONENT;
+
+struct _ASN1C_TYPE
+{
+    ASN1C_KIND Kind;
+    int Line;
+
+    // Universal tag of a string type.
+    unsigned long UniversalTag;
+
+    // Value range of an INTEGER type.
+    int HasMin, HasMax;
+    long long Min, Max;
+
+    // SIZE constraint of a string or SEQUENCE OF type.
+    int HasSize;
+    unsigned long SizeMin, SizeMax;
+
+    // Components of a SEQUENCE, SET or CHOICE type.
+    ASN1C_COMPONENT *Components;
+    unsigned long ComponentCount;
+
+    // Element type of a SEQUENCE OF type or the type inside a tagged type.
+    ASN1C_TYPE *Inner;
+
+    // Tag of a tagged type.
+    int TagClass;
+    unsigned long TagNumber;
+    int TagMode;
+
+    // Referenced type.
+    char *Reference;
+    ASN1C_ASSIGNMENT *Resolved;
+
+    // Assignment whose C structure represents a SEQUENCE, SET, CHOICE or SEQUENCE OF type.
+    ASN1C_ASSIGNMENT *Owner;
+};
+
+struct _ASN1C_ASSIGNMENT
+{
+    char *Name;
+    char *CName;
+    ASN1C_TYPE *Type;
+    int Line;
+    int Visit;
+
+    // Set for an assignment created for an anonymous type; such types get no public routines.
+    int Anonymous;
+
+    struct _ASN1C_ASSIGNMENT *Next;
+};
+
+typedef struct _ASN1C_MODULE
+{
+    char *Name;
+    int TagDefault;
+    ASN1C_ASSIGNMENT *Assignments;
+    ASN1C_ASSIGNMENT **Tail;
+
+} ASN1C_MODULE;
+
+// Growable text buffer used by the code generator.
+typedef struct _ASN1C_BUFFER
+{
+    char *Text;
+    size_t Length;
+    size_t Capacity;
+
+} ASN1C_BUFFER;
+
+extern const char *Asn1cFileName;
+
+void
+Asn1cError(
+    int Line,
+    const char *Format,
+    ...
+    );
+
+void *
+Asn1cAlloc(
+    size_t Size
+    );
+
+char *
+Asn1cStrDup(
+    const char *Text
+    );
+
+char *
+Asn1cCName(
+    const char *Name
+    );
+
+void
+Asn1cAppend(
+    ASN1C_BUFFER *Buffer,
+    const char *Format,
+    ...
+    );
+
+ASN1C_MODULE *
+Asn1cParse(
+    const char *Text
+    );
+
+void
+Asn1cAnalyze(
+    ASN1C_MODULE *Module
+    );
+
+void
+Asn1cGenerate(
+    ASN1C_MODULE *Module,
+    const char *Prefix,
+    const char *HeaderName,
+    ASN1C_BUFFER *Header,
+    ASN1C_BUFFER *Source
+    );
+
+ASN1C_TYPE *
+Asn1cBaseType(
+    ASN1C_TYPE *Type
+    );
+
+ASN1C_TYPE *
+Asn1cCoreType(
+    ASN1C_TYPE *Type
+    );
+
+int
+Asn1cOuterTag(
+    ASN1C_TYPE *Type,
+    int *Class,
+    unsigned long *Number,
+    int *Constructed
+    );
+
+#endif
\ No newline at end of file
@@ -0,0 +1,2294 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+Module Description:
+
+    Generates the C structures and the encoding, sizing and decoding routines of an analyzed
+    module. Tags are emitted as prepared tag constants, integer and boolean nodes are written
+    with a single call, and the size of every value is computed before it is written, so the
+    generated routines never move encoded data. Only the definitions reachable from the public
+    routines are emitted.
+
+--*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "BlgAsn1c.h"
+
+#define ASN1C_SECTION_TAG       0
+#define ASN1C_SECTION_HELPER    1
+#define ASN1C_SECTION_ROUTINE   2
+#define ASN1C_SECTION_PUBLIC    3
+
+typedef struct _ASN1C_TAG
+{
+    int Class;
+    unsigned long Number;
+    int Constructed;
+
+} ASN1C_TAG;
+
+// A tag constant, helper or routine of the generated source, with the names it refers to.
+typedef struct _ASN1C_DEFINITION
+{
+    int Section;
+    const char *Name;
+    ASN1C_BUFFER Prototype;
+    ASN1C_BUFFER Text;
+    const char **Refs;
+    size_t RefCount;
+    size_t RefCapacity;
+    int Used;
+    struct _ASN1C_DEFINITION *Next;
+
+} ASN1C_DEFINITION;
+
+typedef struct _ASN1C_GENERATOR
+{
+    ASN1C_MODULE *Module;
+    const char *Prefix;
+    ASN1C_DEFINITION *Definitions;
+    ASN1C_DEFINITION **Tail;
+    ASN1C_DEFINITION *Current;
+
+    // Whether the decoding routine being generated enters child nodes.
+    int UsesDepth;
+
+} ASN1C_GENERATOR;
+
+// Helper routines of the generated source. Refs lists the helpers each one calls.
+static const struct
+{
+    const char *Name;
+    const char *Refs;
+    const char *Text;
+}
+Asn1cHelpers[] =
+{
+    {
+        "Asn1cLenCb", "",
+        "static\n"
+        "DWORD\n"
+        "Asn1cLenCb(\n"
+        "    ULONGLONG Len\n"
+        "    )\n"
+        "{\n"
+        "    DWORD Cb = 1;\n"
+        "\n"
+        "    if (Len > 127)\n"
+        "    {\n"
+        "        for (; Len; Len >>= 8)\n"
+        "        {\n"
+        "            Cb++;\n"
+        "        }\n"
+        "    }\n"
+        "\n"
+        "    return Cb;\n"
+        "}\n"
+    },
+    {
+        "Asn1cTlvCb", "Asn1cLenCb",
+        "static\n"
+        "ULONGLONG\n"
+        "Asn1cTlvCb(\n"
+        "    DWORD TagCb,\n"
+        "    ULONGLONG ContentCb\n"
+        "    )\n"
+        "{\n"
+        "    return TagCb + Asn1cLenCb(ContentCb) + ContentCb;\n"
+        "}\n"
+    },
+    {
+        "Asn1cIntCb", "",
+        "static\n"
+        "DWORD\n"
+        "Asn1cIntCb(\n"
+        "    LONGLONG Value\n"
+        "    )\n"
+        "{\n"
+        "    DWORD Cb = 1;\n"
+        "\n"
+        "    while (Cb < 8 && (Value < -((LONGLONG) 1 << (8 * Cb - 1)) || Value >= ((LONGLONG) 1 << (8 * Cb - 1))))\n"
+        "    {\n"
+        "        Cb++;\n"
+        "    }\n"
+        "\n"
+        "    return Cb;\n"
+        "}\n"
+    },
+    {
+        "Asn1cUIntCb", "",
+        "static\n"
+        "DWORD\n"
+        "Asn1cUIntCb(\n"
+        "    ULONGLONG Value\n"
+        "    )\n"
+        "{\n"
+        "    DWORD Cb = 1;\n"
+        "\n"
+        "    // A leading zero octet keeps values with the most significant bit set positive.\n"
+        "    while (Cb < 9 && (Value >> (8 * Cb - 1)) != 0)\n"
+        "    {\n"
+        "        Cb++;\n"
+        "    }\n"
+        "\n"
+        "    return Cb;\n"
+        "}\n"
+    },
+    {
+        "Asn1cEncTl", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cEncTl(\n"
+        "    HBLG_DER_ENCODER Encoder,\n"
+        "    PCBLG_DER_PREPARED_TAG Tag,\n"
+        "    ULONGLONG Len\n"
+        "    )\n"
+        "{\n"
+        "    return BlgDerEncPreparedTag(Encoder, Tag) && BlgDerEncLen(Encoder, (DWORD) Len);\n"
+        "}\n"
+    },
+    {
+        "Asn1cEncInt", "Asn1cIntCb",
+        "static\n"
+        "BOOL\n"
+        "Asn1cEncInt(\n"
+        "    HBLG_DER_ENCODER Encoder,\n"
+        "    PCBLG_DER_PREPARED_TAG Tag,\n"
+        "    LONGLONG Value\n"
+        "    )\n"
+        "{\n"
+        "    BYTE Octets[16];\n"
+        "    DWORD Cb = Asn1cIntCb(Value), i;\n"
+        "\n"
+        "    CopyMemory(Octets, Tag->Octets, Tag->OctetCount);\n"
+        "\n"
+        "    Octets[Tag->OctetCount] = (BYTE) Cb;\n"
+        "\n"
+        "    for (i = 0; i < Cb; i++)\n"
+        "    {\n"
+        "        Octets[Tag->OctetCount + 1 + i] = (BYTE) ((ULONGLONG) Value >> (8 * (Cb - 1 - i)));\n"
+        "    }\n"
+        "\n"
+        "    return BlgDerWriteRaw(Encoder, Octets, Tag->OctetCount + 1 + Cb);\n"
+        "}\n"
+    },
+    {
+        "Asn1cEncUInt", "Asn1cUIntCb",
+        "static\n"
+        "BOOL\n"
+        "Asn1cEncUInt(\n"
+        "    HBLG_DER_ENCODER Encoder,\n"
+        "    PCBLG_DER_PREPARED_TAG Tag,\n"
+        "    ULONGLONG Value\n"
+        "    )\n"
+        "{\n"
+        "    BYTE Octets[16];\n"
+        "    DWORD Cb = Asn1cUIntCb(Value), i;\n"
+        "\n"
+        "    CopyMemory(Octets, Tag->Octets, Tag->OctetCount);\n"
+        "\n"
+        "    Octets[Tag->OctetCount] = (BYTE) Cb;\n"
+        "\n"
+        "    for (i = 0; i < Cb; i++)\n"
+        "    {\n"
+        "        Octets[Tag->OctetCount + 1 + i] = Cb - 1 - i < 8 ? (BYTE) (Value >> (8 * (Cb - 1 - i))) : 0;\n"
+        "    }\n"
+        "\n"
+        "    return BlgDerWriteRaw(Encoder, Octets, Tag->OctetCount + 1 + Cb);\n"
+        "}\n"
+    },
+    {
+        "Asn1cEncBool", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cEncBool(\n"
+        "    HBLG_DER_ENCODER Encoder,\n"
+        "    PCBLG_DER_PREPARED_TAG Tag,\n"
+        "    BOOLEAN Value\n"
+        "    )\n"
+        "{\n"
+        "    BYTE Octets[8];\n"
+        "\n"
+        "    CopyMemory(Octets, Tag->Octets, Tag->OctetCount);\n"
+        "\n"
+        "    Octets[Tag->OctetCount] = 1;\n"
+        "    Octets[Tag->OctetCount + 1] = Value ? 0xFF : 0x00;\n"
+        "\n"
+        "    return BlgDerWriteRaw(Encoder, Octets, Tag->OctetCount + 2);\n"
+        "}\n"
+    },
+    {
+        "Asn1cEncOctets", "Asn1cEncTl",
+        "static\n"
+        "BOOL\n"
+        "Asn1cEncOctets(\n"
+        "    HBLG_DER_ENCODER Encoder,\n"
+        "    PCBLG_DER_PREPARED_TAG Tag,\n"
+        "    CONST BLG_ASN1C_OCTETS *Value\n"
+        "    )\n"
+        "{\n"
+        "    if (!Asn1cEncTl(Encoder, Tag, Value->Cb))\n"
+        "    {\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    return Value->Cb == 0 || BlgDerWriteRaw(Encoder, Value->Value, Value->Cb);\n"
+        "}\n"
+    },
+    {
+        "Asn1cIsTag", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cIsTag(\n"
+        "    HBLG_DER_DECODER Decoder,\n"
+        "    PCBLG_DER_PREPARED_TAG Tag\n"
+        "    )\n"
+        "{\n"
+        "    BOOL IsEqual;\n"
+        "\n"
+        "    return BlgDerComparePreparedTag(Decoder, Tag, &IsEqual) && IsEqual;\n"
+        "}\n"
+    },
+    {
+        "Asn1cEnter", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cEnter(\n"
+        "    HBLG_DER_DECODER Decoder,\n"
+        "    PBOOL HasNode,\n"
+        "    PDWORD Depth\n"
+        "    )\n"
+        "{\n"
+        "    DWORD ValueCb;\n"
+        "\n"
+        "    *HasNode = FALSE;\n"
+        "\n"
+        "    if (!BlgDerGetDecoderParam(Decoder, BLG_DER_DEC_PARAM_VALUE_CB, &ValueCb))\n"
+        "    {\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    if (ValueCb == 0)\n"
+        "    {\n"
+        "        return TRUE;\n"
+        "    }\n"
+        "\n"
+        "    if (!BlgDerMoveToChild(Decoder))\n"
+        "    {\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    (*Depth)++;\n"
+        "\n"
+        "    *HasNode = TRUE;\n"
+        "\n"
+        "    return TRUE;\n"
+        "}\n"
+    },
+    {
+        "Asn1cEnterExplicit", "Asn1cEnter",
+        "static\n"
+        "BOOL\n"
+        "Asn1cEnterExplicit(\n"
+        "    HBLG_DER_DECODER Decoder,\n"
+        "    PDWORD Depth\n"
+        "    )\n"
+        "{\n"
+        "    BOOL HasNode;\n"
+        "\n"
+        "    if (!Asn1cEnter(Decoder, &HasNode, Depth))\n"
+        "    {\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    if (!HasNode)\n"
+        "    {\n"
+        "        SetLastError(ERROR_BLGASN1_UNEXP_EOD);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    return TRUE;\n"
+        "}\n"
+    },
+    {
+        "Asn1cLeaveExplicit", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cLeaveExplicit(\n"
+        "    HBLG_DER_DECODER Decoder,\n"
+        "    PDWORD Depth\n"
+        "    )\n"
+        "{\n"
+        "    if (BlgDerMoveToNext(Decoder))\n"
+        "    {\n"
+        "        SetLastError(ERROR_BLGASN1_BADTAG);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    if (GetLastError() != ERROR_BLGASN1_EOD || !BlgDerMoveToParent(Decoder))\n"
+        "    {\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    (*Depth)--;\n"
+        "\n"
+        "    return TRUE;\n"
+        "}\n"
+    },
+    {
+        "Asn1cNext", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cNext(\n"
+        "    HBLG_DER_DECODER Decoder,\n"
+        "    PBOOL HasNode\n"
+        "    )\n"
+        "{\n"
+        "    *HasNode = BlgDerMoveToNext(Decoder);\n"
+        "\n"
+        "    return *HasNode || GetLastError() == ERROR_BLGASN1_EOD;\n"
+        "}\n"
+    },
+    {
+        "Asn1cDecBool", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cDecBool(\n"
+        "    HBLG_DER_DECODER Decoder,\n"
+        "    PBOOLEAN Value\n"
+        "    )\n"
+        "{\n"
+        "    BOOL Bool;\n"
+        "\n"
+        "    if (!BlgDerDecBool(Decoder, &Bool))\n"
+        "    {\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    *Value = Bool ? TRUE : FALSE;\n"
+        "\n"
+        "    return TRUE;\n"
+        "}\n"
+    },
+    {
+        "Asn1cDecNull", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cDecNull(\n"
+        "    HBLG_DER_DECODER Decoder\n"
+        "    )\n"
+        "{\n"
+        "    DWORD ValueCb;\n"
+        "\n"
+        "    if (!BlgDerGetDecoderParam(Decoder, BLG_DER_DEC_PARAM_VALUE_CB, &ValueCb))\n"
+        "    {\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    if (ValueCb != 0)\n"
+        "    {\n"
+        "        SetLastError(ERROR_BLGASN1_CORRUPT);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    return TRUE;\n"
+        "}\n"
+    },
+    {
+        "Asn1cDecOctets", "",
+        "static\n"
+        "BOOL\n"
+        "Asn1cDecOctets(\n"
+        "    HBLG_DER_DECODER Decoder,\n"
+        "    BLG_ASN1C_OCTETS *Value\n"
+        "    )\n"
+        "{\n"
+        "    // The octets are not copied; they point into the encoded data.\n"
+        "    return BlgDerGetDecoderParam(Decoder, BLG_DER_DEC_PARAM_VALUE, (PVOID) &Value->Value) &&\n"
+        "        BlgDerGetDecoderParam(Decoder, BLG_DER_DEC_PARAM_VALUE_CB, &Value->Cb);\n"
+        "}\n"
+    },
+    { NULL, NULL, NULL }
+};
+
+static
+char *
+Asn1cFormat(
+    const char *Format,
+    ...
+    )
+
+/*++
+
+Routine Description:
+
+    Returns a newly allocated formatted string.
+
+--*/
+
+{
+    ASN1C_BUFFER Buffer = { 0 };
+    va_list Arguments;
+    char Text[1024];
+    int Length;
+
+    va_start(Arguments, Format);
+    Length = vsnprintf(Text, sizeof(Text), Format, Arguments);
+    va_end(Arguments);
+
+    if (Length < 0 || (size_t) Length >= sizeof(Text))
+    {
+        Asn1cError(0, "generated expression too long");
+    }
+
+    Asn1cAppend(&Buffer, "%s", Text);
+
+    return Buffer.Text;
+}
+
+static
+ASN1C_DEFINITION *
+Asn1cFindDefinition(
+    ASN1C_GENERATOR *Generator,
+    const char *Name
+    )
+{
+    ASN1C_DEFINITION *Definition;
+
+    for (Definition = Generator->Definitions; Definition; Definition = Definition->Next)
+    {
+        if (strcmp(Definition->Name, Name) == 0)
+        {
+            return Definition;
+        }
+    }
+
+    return NULL;
+}
+
+static
+ASN1C_DEFINITION *
+Asn1cAddDefinition(
+    ASN1C_GENERATOR *Generator,
+    int Section,
+    const char *Name
+    )
+{
+    ASN1C_DEFINITION *Definition = Asn1cAlloc(sizeof(ASN1C_DEFINITION));
+
+    Definition->Section = Section;
+    Definition->Name = Name;
+
+    *Generator->Tail = Definition;
+    Generator->Tail = &Definition->Next;
+
+    return Definition;
+}
+
+static
+const char *
+Asn1cUse(
+    ASN1C_GENERATOR *Generator,
+    const char *Name
+    )
+
+/*++
+
+Routine Description:
+
+    Records that the definition being generated refers to the specified name.
+
+--*/
+
+{
+    ASN1C_DEFINITION *Current = Generator->Current;
+
+    if (Current->RefCount == Current->RefCapacity)
+    {
+        Current->RefCapacity = Current->RefCapacity ? Current->RefCapacity * 2 : 8;
+        Current->Refs = realloc((void *) Current->Refs, Current->RefCapacity * sizeof(const char *));
+
+        if (!Current->Refs)
+        {
+            Asn1cError(0, "out of memory");
+        }
+    }
+
+    Current->Refs[Current->RefCount++] = Name;
+
+    return Name;
+}
+
+static
+const char *
+Asn1cRoutine(
+    ASN1C_GENERATOR *Generator,
+    const char *Kind,
+    const ASN1C_ASSIGNMENT *Assignment
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the name of an internal routine of an assignment and records its use.
+
+--*/
+
+{
+    return Asn1cUse(Generator, Asn1cFormat("Asn1c%s_%s", Kind, Assignment->CName));
+}
+
+static
+unsigned long
+Asn1cTagOctetCount(
+    unsigned long Number
+    )
+{
+    unsigned long Count = 1;
+
+    if (Number > 30)
+    {
+        for (; Number; Number >>= 7)
+        {
+            Count++;
+        }
+    }
+
+    return Count;
+}
+
+static
+const char *
+Asn1cTagName(
+    ASN1C_GENERATOR *Generator,
+    const ASN1C_TAG *Tag
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the name of the prepared tag constant of a tag, defining the constant on first use.
+    The identifier octets are computed here, so the generated code never encodes a tag.
+
+--*/
+
+{
+    static const char *ClassNames[] = { "Universal", "Application", "Context", "Private" };
+    ASN1C_DEFINITION *Definition;
+    unsigned long Count, i;
+    char *Name;
+
+    Name = Asn1cFormat("Asn1cTag%s%c%lu", ClassNames[Tag->Class], Tag->Constructed ? 'C' : 'P', Tag->Number);
+
+    if (!Asn1cFindDefinition(Generator, Name))
+    {
+        Definition = Asn1cAddDefinition(Generator, ASN1C_SECTION_TAG, Name);
+
+        Count = Asn1cTagOctetCount(Tag->Number);
+
+        Asn1cAppend(&Definition->Text, "static CONST BLG_DER_PREPARED_TAG %s = { { 0x%02X", Name,
+            (Tag->Class << 6) | (Tag->Constructed ? 0x20 : 0x00) | (Count == 1 ? Tag->Number : 0x1F));
+
+        for (i = 1; i < Count; i++)
+        {
+            Asn1cAppend(&Definition->Text, ", 0x%02lX",
+                ((Tag->Number >> (7 * (Count - 1 - i))) & 0x7F) | (i < Count - 1 ? 0x80 : 0x00));
+        }
+
+        Asn1cAppend(&Definition->Text, " }, %lu };\n", Count);
+    }
+
+    return Asn1cUse(Generator, Name);
+}
+
+static
+int
+Asn1cEffectiveTag(
+    ASN1C_TYPE *Type,
+    const ASN1C_TAG *Override,
+    ASN1C_TAG *Tag
+    )
+
+/*++
+
+Routine Description:
+
+    Determines the outermost tag of a type, replacing its class and number by an implicit tag
+    applied to the type, if any.
+
+--*/
+
+{
+    if (!Asn1cOuterTag(Type, &Tag->Class, &Tag->Number, &Tag->Constructed))
+    {
+        return 0;
+    }
+
+    if (Override)
+    {
+        Tag->Class = Override->Class;
+        Tag->Number = Override->Number;
+    }
+
+    return 1;
+}
+
+static
+ASN1C_INT_TYPE
+Asn1cIntType(
+    const ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Selects the smallest native type that holds every value of an INTEGER type.
+
+--*/
+
+{
+    if (Type->HasMin && Type->Min >= 0)
+    {
+        return Type->HasMax && Type->Max <= 0xFFFFFFFFLL ? Asn1cUInt32 : Asn1cUInt64;
+    }
+
+    if (Type->HasMin && Type->HasMax && Type->Min >= -0x7FFFFFFFLL - 1 && Type->Max <= 0x7FFFFFFFLL)
+    {
+        return Asn1cInt32;
+    }
+
+    return Asn1cInt64;
+}
+
+static
+const char *
+Asn1cTypeName(
+    ASN1C_GENERATOR *Generator,
+    const ASN1C_ASSIGNMENT *Assignment
+    )
+{
+    return Asn1cFormat("%s%s", Generator->Prefix, Assignment->CName);
+}
+
+static
+const char *
+Asn1cFieldType(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the C type of a component, a SEQUENCE OF element or a type assignment.
+
+--*/
+
+{
+    static const char *IntTypes[] = { "INT", "DWORD", "LONGLONG", "ULONGLONG" };
+
+    Type = Asn1cBaseType(Type);
+
+    switch (Type->Kind)
+    {
+    case Asn1cReference:
+        return Asn1cTypeName(Generator, Type->Resolved);
+
+    case Asn1cBoolean:
+        return "BOOLEAN";
+
+    case Asn1cInteger:
+        return IntTypes[Asn1cIntType(Type)];
+
+    case Asn1cNull:
+        return "BYTE";
+
+    case Asn1cString:
+        return "BLG_ASN1C_OCTETS";
+
+    default:
+        return Asn1cTypeName(Generator, Type->Owner);
+    }
+}
+
+static
+const char *
+Asn1cAddressOf(
+    const char *Value
+    )
+{
+    size_t Length = strlen(Value);
+
+    if (Length > 3 && strncmp(Value, "(*", 2) == 0 && Value[Length - 1] == ')')
+    {
+        return Asn1cFormat("%.*s", (int) (Length - 3), Value + 2);
+    }
+
+    return Asn1cFormat("&%s", Value);
+}
+
+static
+const char *
+Asn1cConstant(
+    long long Value,
+    int Unsigned
+    )
+{
+    if (Value >= -0x7FFFFFFFLL && Value <= 0x7FFFFFFFLL)
+    {
+        return Asn1cFormat("%lld", Value);
+    }
+
+    return Asn1cFormat(Unsigned ? "%lldULL" : "%lldLL", Value);
+}
+
+static
+const char *
+Asn1cRangeCheck(
+    const ASN1C_TYPE *Type,
+    const char *Value
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the condition that detects a value outside the value range or the SIZE constraint
+    of a type, or NULL if every value of the C type satisfies the constraint.
+
+--*/
+
+{
+    long long Min = 0, Max = 0;
+    int HasMin = 0, HasMax = 0, Unsigned = 0;
+
+    if (Type->Kind == Asn1cInteger)
+    {
+        switch (Asn1cIntType(Type))
+        {
+        case Asn1cInt32:
+            HasMin = Type->Min > -0x7FFFFFFFLL - 1;
+            HasMax = Type->Max < 0x7FFFFFFFLL;
+
+            break;
+
+        case Asn1cUInt32:
+            HasMin = Type->Min > 0;
+            HasMax = Type->Max < 0xFFFFFFFFLL;
+            Unsigned = 1;
+
+            break;
+
+        case Asn1cInt64:
+            HasMin = Type->HasMin;
+            HasMax = Type->HasMax;
+
+            break;
+
+        default:
+            HasMin = Type->Min > 0;
+            HasMax = Type->HasMax;
+            Unsigned = 1;
+
+            break;
+        }
+
+        Min = Type->Min;
+        Max = Type->Max;
+    }
+    else if (Type->HasSize)
+    {
+        HasMin = Type->SizeMin > 0;
+        HasMax = Type->SizeMax < 0xFFFFFFFFUL;
+        Min = Type->SizeMin;
+        Max = Type->SizeMax;
+        Unsigned = 1;
+    }
+
+    if (HasMin && HasMax)
+    {
+        return Asn1cFormat("%s < %s || %s > %s", Value, Asn1cConstant(Min, Unsigned), Value,
+            Asn1cConstant(Max, Unsigned));
+    }
+
+    if (HasMin)
+    {
+        return Asn1cFormat("%s < %s", Value, Asn1cConstant(Min, Unsigned));
+    }
+
+    if (HasMax)
+    {
+        return Asn1cFormat("%s > %s", Value, Asn1cConstant(Max, Unsigned));
+    }
+
+    return NULL;
+}
+
+static
+void
+Asn1cEmitCall(
+    ASN1C_BUFFER *Out,
+    int Indent,
+    const char *Call,
+    const char *Fail
+    )
+{
+    Asn1cAppend(Out, "%*sif (!%s)\n%*s{\n%*s    %s\n%*s}\n\n", Indent, "", Call, Indent, "", Indent, "", Fail,
+        Indent, "");
+}
+
+static
+void
+Asn1cEmitError(
+    ASN1C_BUFFER *Out,
+    int Indent,
+    const char *Condition,
+    const char *Error,
+    const char *Fail
+    )
+{
+    Asn1cAppend(Out, "%*sif (%s)\n%*s{\n%*s    SetLastError(%s);\n\n%*s    %s\n%*s}\n\n", Indent, "", Condition,
+        Indent, "", Indent, "", Error, Indent, "", Fail, Indent, "");
+}
+
+static
+void
+Asn1cEmitClose(
+    ASN1C_BUFFER *Out,
+    int Indent
+    )
+
+/*++
+
+Routine Description:
+
+    Closes a block, dropping the blank line that follows its last statement.
+
+--*/
+
+{
+    if (Out->Length >= 2 && Out->Text[Out->Length - 1] == '\n' && Out->Text[Out->Length - 2] == '\n')
+    {
+        Out->Length--;
+    }
+
+    Asn1cAppend(Out, "%*s}\n", Indent, "");
+}
+
+static
+const char *
+Asn1cChoiceKind(
+    const ASN1C_TYPE *Type,
+    const char *Kind
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the kind of a routine of a CHOICE type. The routines of a tagged CHOICE type are
+    prefixed with "Alt", since the routines of its assignment handle the tag.
+
+--*/
+
+{
+    return Type == Type->Owner->Type ? Kind : Asn1cFormat("Alt%s", Kind);
+}
+
+static
+const char *
+Asn1cGenCb(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_TYPE *Type,
+    const char *Value,
+    const ASN1C_TAG *Override
+    )
+
+/*++
+
+Routine Description:
+
+    Returns an expression that computes the encoded size of a value.
+
+Arguments:
+
+    Generator - The generator.
+
+    Type - Type of the value.
+
+    Value - Expression of the value.
+
+    Override - Implicit tag applied to the type, or NULL.
+
+--*/
+
+{
+    ASN1C_TAG Tag;
+    unsigned long TagCb;
+
+    if (Type->Kind == Asn1cTagged)
+    {
+        Tag.Class = Type->TagClass;
+        Tag.Number = Type->TagNumber;
+
+        if (Type->TagMode == ASN1C_TAGS_IMPLICIT)
+        {
+            return Asn1cGenCb(Generator, Type->Inner, Value, Override ? Override : &Tag);
+        }
+
+        return Asn1cFormat("%s(%lu, %s)", Asn1cUse(Generator, "Asn1cTlvCb"),
+            Asn1cTagOctetCount(Override ? Override->Number : Tag.Number), Asn1cGenCb(Generator, Type->Inner, Value, NULL));
+    }
+
+    if (Type->Kind == Asn1cReference)
+    {
+        if (!Override)
+        {
+            return Asn1cFormat("%s(%s)", Asn1cRoutine(Generator, "Cb", Type->Resolved), Asn1cAddressOf(Value));
+        }
+
+        // An implicitly tagged reference is expanded in place with the new tag.
+        return Asn1cGenCb(Generator, Type->Resolved->Type, Value, Override);
+    }
+
+    if (Type->Kind == Asn1cChoice)
+    {
+        return Asn1cFormat("%s(%s)", Asn1cRoutine(Generator, Asn1cChoiceKind(Type, "Cb"), Type->Owner), Asn1cAddressOf(Value));
+    }
+
+    Asn1cEffectiveTag(Type, Override, &Tag);
+
+    TagCb = Asn1cTagOctetCount(Tag.Number);
+
+    switch (Type->Kind)
+    {
+    case Asn1cBoolean:
+        return Asn1cFormat("%lu", TagCb + 2);
+
+    case Asn1cNull:
+        return Asn1cFormat("%lu", TagCb + 1);
+
+    case Asn1cInteger:
+        return Asn1cFormat("(%lu + %s(%s))", TagCb + 1,
+            Asn1cUse(Generator, Asn1cIntType(Type) == Asn1cInt32 || Asn1cIntType(Type) == Asn1cInt64 ?
+                "Asn1cIntCb" : "Asn1cUIntCb"), Value);
+
+    case Asn1cString:
+        return Asn1cFormat("%s(%lu, %s.Cb)", Asn1cUse(Generator, "Asn1cTlvCb"), TagCb, Value);
+
+    default:
+        return Asn1cFormat("%s(%lu, %s(%s))", Asn1cUse(Generator, "Asn1cTlvCb"), TagCb,
+            Asn1cRoutine(Generator, "BodyCb", Type->Owner), Asn1cAddressOf(Value));
+    }
+}
+
+static
+void
+Asn1cGenEnc(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_BUFFER *Out,
+    int Indent,
+    ASN1C_TYPE *Type,
+    const char *Value,
+    const ASN1C_TAG *Override
+    )
+
+/*++
+
+Routine Description:
+
+    Emits the statements that encode a value.
+
+--*/
+
+{
+    const char *Fail = "return FALSE;", *TagName, *Check;
+    ASN1C_TAG Tag;
+
+    if (Type->Kind == Asn1cTagged)
+    {
+        Tag.Class = Type->TagClass;
+        Tag.Number = Type->TagNumber;
+
+        if (Type->TagMode == ASN1C_TAGS_IMPLICIT)
+        {
+            Asn1cGenEnc(Generator, Out, Indent, Type->Inner, Value, Override ? Override : &Tag);
+
+            return;
+        }
+
+        Asn1cEffectiveTag(Type, Override, &Tag);
+
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, &%s, %s)", Asn1cUse(Generator, "Asn1cEncTl"),
+            Asn1cTagName(Generator, &Tag), Asn1cGenCb(Generator, Type->Inner, Value, NULL)), Fail);
+
+        Asn1cGenEnc(Generator, Out, Indent, Type->Inner, Value, NULL);
+
+        return;
+    }
+
+    if (Type->Kind == Asn1cReference)
+    {
+        if (!Override)
+        {
+            Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, %s)", Asn1cRoutine(Generator, "Enc", Type->Resolved),
+                Asn1cAddressOf(Value)), Fail);
+        }
+        else
+        {
+            Asn1cGenEnc(Generator, Out, Indent, Type->Resolved->Type, Value, Override);
+        }
+
+        return;
+    }
+
+    if (Type->Kind == Asn1cChoice)
+    {
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, %s)", Asn1cRoutine(Generator, Asn1cChoiceKind(Type, "Enc"), Type->Owner),
+            Asn1cAddressOf(Value)), Fail);
+
+        return;
+    }
+
+    Asn1cEffectiveTag(Type, Override, &Tag);
+
+    TagName = Asn1cTagName(Generator, &Tag);
+
+    switch (Type->Kind)
+    {
+    case Asn1cBoolean:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, &%s, %s)", Asn1cUse(Generator, "Asn1cEncBool"), TagName,
+            Value), Fail);
+
+        break;
+
+    case Asn1cNull:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, &%s, 0)", Asn1cUse(Generator, "Asn1cEncTl"), TagName),
+            Fail);
+
+        break;
+
+    case Asn1cInteger:
+        if ((Check = Asn1cRangeCheck(Type, Value)))
+        {
+            Asn1cEmitError(Out, Indent, Check, "ERROR_BLGASN1_CONSTRAINT", Fail);
+        }
+
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, &%s, %s)",
+            Asn1cUse(Generator, Asn1cIntType(Type) == Asn1cInt32 || Asn1cIntType(Type) == Asn1cInt64 ?
+                "Asn1cEncInt" : "Asn1cEncUInt"), TagName, Value), Fail);
+
+        break;
+
+    case Asn1cString:
+        if ((Check = Asn1cRangeCheck(Type, Asn1cFormat("%s.Cb", Value))))
+        {
+            Asn1cEmitError(Out, Indent, Check, "ERROR_BLGASN1_CONSTRAINT", Fail);
+        }
+
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, &%s, %s)", Asn1cUse(Generator, "Asn1cEncOctets"),
+            TagName, Asn1cAddressOf(Value)), Fail);
+
+        break;
+
+    default:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, &%s, %s(%s))", Asn1cUse(Generator, "Asn1cEncTl"),
+            TagName, Asn1cRoutine(Generator, "BodyCb", Type->Owner), Asn1cAddressOf(Value)), Fail);
+
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Encoder, %s)", Asn1cRoutine(Generator, "BodyEnc", Type->Owner),
+            Asn1cAddressOf(Value)), Fail);
+
+        break;
+    }
+}
+
+static
+const char *
+Asn1cGenIsTag(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_TYPE *Type,
+    const ASN1C_TAG *Override
+    )
+
+/*++
+
+Routine Description:
+
+    Returns an expression that determines whether the current node has the tag of a type.
+
+--*/
+
+{
+    ASN1C_TAG Tag;
+
+    if (Type->Kind == Asn1cTagged && Type->TagMode == ASN1C_TAGS_IMPLICIT && !Override)
+    {
+        Tag.Class = Type->TagClass;
+        Tag.Number = Type->TagNumber;
+
+        return Asn1cGenIsTag(Generator, Type->Inner, &Tag);
+    }
+
+    if (Asn1cEffectiveTag(Type, Override, &Tag))
+    {
+        return Asn1cFormat("%s(Decoder, &%s)", Asn1cUse(Generator, "Asn1cIsTag"), Asn1cTagName(Generator, &Tag));
+    }
+
+    if (Type->Kind == Asn1cReference)
+    {
+        return Asn1cFormat("%s(Decoder)", Asn1cRoutine(Generator, "IsTag", Type->Resolved));
+    }
+
+    return Asn1cFormat("%s(Decoder)", Asn1cRoutine(Generator, Asn1cChoiceKind(Type, "IsTag"), Type->Owner));
+}
+
+static
+void
+Asn1cGenDec(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_BUFFER *Out,
+    int Indent,
+    ASN1C_TYPE *Type,
+    const char *Value,
+    int Implicit
+    )
+
+/*++
+
+Routine Description:
+
+    Emits the statements that decode the current node into a value. The tag of the node has
+    already been checked; failures jump to the Leave label of the routine.
+
+Arguments:
+
+    Generator - The generator.
+
+    Out - Receives the statements.
+
+    Indent - Indentation of the statements.
+
+    Type - Type of the value.
+
+    Value - Expression of the value.
+
+    Implicit - Nonzero if an implicit tag is applied to the type.
+
+--*/
+
+{
+    static const char *IntDecoders[] = { "BlgDerDecInt32", "BlgDerDecUInt32", "BlgDerDecInt64", "BlgDerDecUInt64" };
+    const char *Fail = "goto Leave;", *Check;
+
+    switch (Type->Kind)
+    {
+    case Asn1cTagged:
+        if (Type->TagMode == ASN1C_TAGS_EXPLICIT)
+        {
+            Generator->UsesDepth = 1;
+
+            Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder, &Depth)", Asn1cUse(Generator, "Asn1cEnterExplicit")),
+                Fail);
+
+            Asn1cEmitError(Out, Indent, Asn1cFormat("!%s", Asn1cGenIsTag(Generator, Type->Inner, NULL)),
+                "ERROR_BLGASN1_BADTAG", Fail);
+
+            Asn1cGenDec(Generator, Out, Indent, Type->Inner, Value, 0);
+
+            Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder, &Depth)", Asn1cUse(Generator, "Asn1cLeaveExplicit")),
+                Fail);
+        }
+        else
+        {
+            Asn1cGenDec(Generator, Out, Indent, Type->Inner, Value, 1);
+        }
+
+        break;
+
+    case Asn1cReference:
+        if (Implicit)
+        {
+            Asn1cGenDec(Generator, Out, Indent, Type->Resolved->Type, Value, 1);
+
+            break;
+        }
+
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder, %s)", Asn1cRoutine(Generator, "Dec", Type->Resolved),
+            Asn1cAddressOf(Value)), Fail);
+
+        break;
+
+    case Asn1cBoolean:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder, %s)", Asn1cUse(Generator, "Asn1cDecBool"),
+            Asn1cAddressOf(Value)), Fail);
+
+        break;
+
+    case Asn1cNull:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder)", Asn1cUse(Generator, "Asn1cDecNull")), Fail);
+
+        break;
+
+    case Asn1cInteger:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder, %s)", IntDecoders[Asn1cIntType(Type)],
+            Asn1cAddressOf(Value)), Fail);
+
+        if ((Check = Asn1cRangeCheck(Type, Value)))
+        {
+            Asn1cEmitError(Out, Indent, Check, "ERROR_BLGASN1_CONSTRAINT", Fail);
+        }
+
+        break;
+
+    case Asn1cString:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder, %s)", Asn1cUse(Generator, "Asn1cDecOctets"),
+            Asn1cAddressOf(Value)), Fail);
+
+        if ((Check = Asn1cRangeCheck(Type, Asn1cFormat("%s.Cb", Value))))
+        {
+            Asn1cEmitError(Out, Indent, Check, "ERROR_BLGASN1_CONSTRAINT", Fail);
+        }
+
+        break;
+
+    case Asn1cChoice:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder, %s)", Asn1cRoutine(Generator, Asn1cChoiceKind(Type, "Dec"), Type->Owner),
+            Asn1cAddressOf(Value)), Fail);
+
+        break;
+
+    default:
+        Asn1cEmitCall(Out, Indent, Asn1cFormat("%s(Decoder, %s)", Asn1cRoutine(Generator, "BodyDec", Type->Owner),
+            Asn1cAddressOf(Value)), Fail);
+
+        break;
+    }
+}
+
+static
+ASN1C_DEFINITION *
+Asn1cBeginRoutine(
+    ASN1C_GENERATOR *Generator,
+    const char *Kind,
+    const ASN1C_ASSIGNMENT *Assignment,
+    const char *ReturnType,
+    const char *Parameters
+    )
+
+/*++
+
+Routine Description:
+
+    Adds an internal routine of an assignment and emits its prototype and signature.
+
+--*/
+
+{
+    ASN1C_DEFINITION *Routine;
+    const char *Name = Asn1cFormat("Asn1c%s_%s", Kind, Assignment->CName);
+
+    Routine = Asn1cAddDefinition(Generator, ASN1C_SECTION_ROUTINE, Name);
+
+    Asn1cAppend(&Routine->Prototype, "static\n%s\n%s(\n%s    );\n", ReturnType, Name, Parameters);
+    Asn1cAppend(&Routine->Text, "static\n%s\n%s(\n%s    )\n{\n", ReturnType, Name, Parameters);
+
+    Generator->Current = Routine;
+    Generator->UsesDepth = 0;
+
+    return Routine;
+}
+
+static
+const char *
+Asn1cCbParameters(
+    ASN1C_GENERATOR *Generator,
+    const ASN1C_ASSIGNMENT *Assignment
+    )
+{
+    return Asn1cFormat("    CONST %s *Value\n", Asn1cTypeName(Generator, Assignment));
+}
+
+static
+const char *
+Asn1cEncParameters(
+    ASN1C_GENERATOR *Generator,
+    const ASN1C_ASSIGNMENT *Assignment
+    )
+{
+    return Asn1cFormat("    HBLG_DER_ENCODER Encoder,\n    CONST %s *Value\n", Asn1cTypeName(Generator, Assignment));
+}
+
+static
+const char *
+Asn1cDecParameters(
+    ASN1C_GENERATOR *Generator,
+    const ASN1C_ASSIGNMENT *Assignment
+    )
+{
+    return Asn1cFormat("    HBLG_DER_DECODER Decoder,\n    %s *Value\n", Asn1cTypeName(Generator, Assignment));
+}
+
+static
+void
+Asn1cEndDecRoutine(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_DEFINITION *Routine,
+    const ASN1C_BUFFER *Body,
+    const char *Locals
+    )
+
+/*++
+
+Routine Description:
+
+    Completes a decoding routine whose statements jump to the Leave label on failure. The
+    routine returns to the node it started at, however many child nodes it has entered.
+
+--*/
+
+{
+    Asn1cAppend(&Routine->Text, "    BOOL IsOk = FALSE%s;\n", Locals);
+
+    if (Generator->UsesDepth)
+    {
+        Asn1cAppend(&Routine->Text, "    DWORD Depth = 0;\n");
+    }
+
+    Asn1cAppend(&Routine->Text, "\n%.*s    IsOk = TRUE;\n\nLeave:\n", (int) Body->Length, Body->Text);
+
+    if (Generator->UsesDepth)
+    {
+        Asn1cAppend(&Routine->Text, "    while (Depth-- > 0)\n    {\n        BlgDerMoveToParent(Decoder);\n    }\n\n");
+    }
+
+    Asn1cAppend(&Routine->Text, "    return IsOk;\n}\n");
+}
+
+static
+ASN1C_COMPONENT **
+Asn1cSortComponents(
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the components of a type in encoding order. DER encodes the components of a SET in
+    the ascending order of their tags.
+
+--*/
+
+{
+    ASN1C_COMPONENT **Components = Asn1cAlloc((Type->ComponentCount + 1) * sizeof(ASN1C_COMPONENT *));
+    ASN1C_COMPONENT *Component, *Swap;
+    ASN1C_TAG Tag, OtherTag;
+    unsigned long Count = 0, i, j;
+
+    for (Component = Type->Components; Component; Component = Component->Next)
+    {
+        Components[Count++] = Component;
+    }
+
+    if (Type->Kind == Asn1cSet)
+    {
+        for (i = 1; i < Count; i++)
+        {
+            for (j = i; j > 0; j--)
+            {
+                Asn1cEffectiveTag(Components[j]->Type, NULL, &Tag);
+                Asn1cEffectiveTag(Components[j - 1]->Type, NULL, &OtherTag);
+
+                if (OtherTag.Class < Tag.Class || (OtherTag.Class == Tag.Class && OtherTag.Number < Tag.Number))
+                {
+                    break;
+                }
+
+                Swap = Components[j];
+                Components[j] = Components[j - 1];
+                Components[j - 1] = Swap;
+            }
+        }
+    }
+
+    return Components;
+}
+
+static
+const char *
+Asn1cOmitCondition(
+    const ASN1C_COMPONENT *Component
+    )
+
+/*++
+
+Routine Description:
+
+    Returns the condition under which a component is encoded, or NULL if it always is.
+
+--*/
+
+{
+    if (Component->Optional)
+    {
+        return Asn1cFormat("Value->%sPresent", Component->CName);
+    }
+
+    if (Component->HasDefault)
+    {
+        return Asn1cFormat("Value->%s != %s", Component->CName, Asn1cConstant(Component->Default, 0));
+    }
+
+    return NULL;
+}
+
+static
+void
+Asn1cGenSequence(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_ASSIGNMENT *Assignment,
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Generates the routines that size, encode and decode the content of a SEQUENCE or SET.
+
+--*/
+
+{
+    ASN1C_COMPONENT **Components = Asn1cSortComponents(Type), *Component;
+    ASN1C_DEFINITION *Routine;
+    ASN1C_BUFFER Body = { 0 };
+    const char *Condition, *Value;
+    unsigned long i;
+
+    // Size
+    Routine = Asn1cBeginRoutine(Generator, "BodyCb", Assignment, "ULONGLONG", Asn1cCbParameters(Generator, Assignment));
+
+    Asn1cAppend(&Routine->Text, "    ULONGLONG Cb = 0;\n\n");
+
+    for (i = 0; (Component = Components[i]); i++)
+    {
+        Value = Asn1cFormat("Value->%s", Component->CName);
+
+        if ((Condition = Asn1cOmitCondition(Component)))
+        {
+            Asn1cAppend(&Routine->Text, "    if (%s)\n    {\n        Cb += %s;\n    }\n\n", Condition,
+                Asn1cGenCb(Generator, Component->Type, Value, NULL));
+        }
+        else
+        {
+            Asn1cAppend(&Routine->Text, "    Cb += %s;\n\n", Asn1cGenCb(Generator, Component->Type, Value, NULL));
+        }
+    }
+
+    Asn1cAppend(&Routine->Text, "    return Cb;\n}\n");
+
+    // Encoding
+    Routine = Asn1cBeginRoutine(Generator, "BodyEnc", Assignment, "BOOL", Asn1cEncParameters(Generator, Assignment));
+
+    for (i = 0; (Component = Components[i]); i++)
+    {
+        Value = Asn1cFormat("Value->%s", Component->CName);
+
+        if ((Condition = Asn1cOmitCondition(Component)))
+        {
+            Asn1cAppend(&Routine->Text, "    if (%s)\n    {\n", Condition);
+
+            Asn1cGenEnc(Generator, &Routine->Text, 8, Component->Type, Value, NULL);
+
+            Asn1cEmitClose(&Routine->Text, 4);
+            Asn1cAppend(&Routine->Text, "\n");
+        }
+        else
+        {
+            Asn1cGenEnc(Generator, &Routine->Text, 4, Component->Type, Value, NULL);
+        }
+    }
+
+    Asn1cAppend(&Routine->Text, "    return TRUE;\n}\n");
+
+    // Decoding
+    Routine = Asn1cBeginRoutine(Generator, "BodyDec", Assignment, "BOOL", Asn1cDecParameters(Generator, Assignment));
+
+    Generator->UsesDepth = 1;
+
+    Asn1cEmitCall(&Body, 4, Asn1cFormat("%s(Decoder, &HasNode, &Depth)", Asn1cUse(Generator, "Asn1cEnter")),
+        "goto Leave;");
+
+    for (i = 0; (Component = Components[i]); i++)
+    {
+        Value = Asn1cFormat("Value->%s", Component->CName);
+
+        Asn1cAppend(&Body, "    if (HasNode && %s)\n    {\n", Asn1cGenIsTag(Generator, Component->Type, NULL));
+
+        Asn1cGenDec(Generator, &Body, 8, Component->Type, Value, 0);
+
+        if (Component->Optional)
+        {
+            Asn1cAppend(&Body, "        Value->%sPresent = TRUE;\n\n", Component->CName);
+        }
+        else if (Component->HasDefault)
+        {
+            // DER does not allow a component to be encoded with its DEFAULT value.
+            Asn1cEmitError(&Body, 8, Asn1cFormat("%s == %s", Value, Asn1cConstant(Component->Default, 0)),
+                "ERROR_BLGASN1_CORRUPT", "goto Leave;");
+        }
+
+        Asn1cEmitCall(&Body, 8, Asn1cFormat("%s(Decoder, &HasNode)", Asn1cUse(Generator, "Asn1cNext")), "goto Leave;");
+
+        Asn1cEmitClose(&Body, 4);
+        Asn1cAppend(&Body, "    else\n    {\n");
+
+        if (Component->Optional)
+        {
+            Asn1cAppend(&Body, "        Value->%sPresent = FALSE;\n", Component->CName);
+        }
+        else if (Component->HasDefault)
+        {
+            Asn1cAppend(&Body, "        %s = %s;\n", Value, Asn1cConstant(Component->Default, 0));
+        }
+        else
+        {
+            Asn1cAppend(&Body, "        SetLastError(HasNode ? ERROR_BLGASN1_CONSTRAINT : ERROR_BLGASN1_UNEXP_EOD);\n\n"
+                "        goto Leave;\n");
+        }
+
+        Asn1cAppend(&Body, "    }\n\n");
+    }
+
+    Asn1cEmitError(&Body, 4, "HasNode", "ERROR_BLGASN1_BADTAG", "goto Leave;");
+
+    Asn1cEndDecRoutine(Generator, Routine, &Body, ", HasNode");
+}
+
+static
+void
+Asn1cGenSequenceOf(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_ASSIGNMENT *Assignment,
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Generates the routines that size, encode and decode the content of a SEQUENCE OF.
+
+--*/
+
+{
+    ASN1C_DEFINITION *Routine;
+    ASN1C_BUFFER Body = { 0 };
+    const char *Check = Asn1cRangeCheck(Type, "Value->Count");
+
+    // Size
+    Routine = Asn1cBeginRoutine(Generator, "BodyCb", Assignment, "ULONGLONG", Asn1cCbParameters(Generator, Assignment));
+
+    Asn1cAppend(&Routine->Text,
+        "    ULONGLONG Cb = 0;\n"
+        "    DWORD i;\n"
+        "\n"
+        "    for (i = 0; i < Value->Count; i++)\n"
+        "    {\n"
+        "        Cb += %s;\n"
+        "    }\n"
+        "\n"
+        "    return Cb;\n"
+        "}\n", Asn1cGenCb(Generator, Type->Inner, "Value->Elements[i]", NULL));
+
+    // Encoding
+    Routine = Asn1cBeginRoutine(Generator, "BodyEnc", Assignment, "BOOL", Asn1cEncParameters(Generator, Assignment));
+
+    Asn1cAppend(&Routine->Text, "    DWORD i;\n\n");
+
+    if (Check)
+    {
+        Asn1cEmitError(&Routine->Text, 4, Check, "ERROR_BLGASN1_CONSTRAINT", "return FALSE;");
+    }
+
+    Asn1cAppend(&Routine->Text, "    for (i = 0; i < Value->Count; i++)\n    {\n");
+
+    Asn1cGenEnc(Generator, &Routine->Text, 8, Type->Inner, "Value->Elements[i]", NULL);
+
+    Asn1cEmitClose(&Routine->Text, 4);
+    Asn1cAppend(&Routine->Text, "\n    return TRUE;\n}\n");
+
+    // Decoding
+    Routine = Asn1cBeginRoutine(Generator, "BodyDec", Assignment, "BOOL", Asn1cDecParameters(Generator, Assignment));
+
+    Generator->UsesDepth = 1;
+
+    Asn1cEmitCall(&Body, 4, Asn1cFormat("%s(Decoder, &HasNode, &Depth)", Asn1cUse(Generator, "Asn1cEnter")),
+        "goto Leave;");
+
+    Asn1cAppend(&Body, "    while (HasNode)\n    {\n");
+
+    Asn1cEmitError(&Body, 8, Asn1cFormat("!%s", Asn1cGenIsTag(Generator, Type->Inner, NULL)), "ERROR_BLGASN1_BADTAG",
+        "goto Leave;");
+
+    Asn1cAppend(&Body, "        // Elements that do not fit into the array are only counted.\n"
+        "        if (Count < Capacity)\n        {\n");
+
+    Asn1cGenDec(Generator, &Body, 12, Type->Inner, "Value->Elements[Count]", 0);
+
+    Asn1cEmitClose(&Body, 8);
+    Asn1cAppend(&Body, "\n        Count++;\n\n");
+
+    Asn1cEmitCall(&Body, 8, Asn1cFormat("%s(Decoder, &HasNode)", Asn1cUse(Generator, "Asn1cNext")), "goto Leave;");
+
+    Asn1cEmitClose(&Body, 4);
+    Asn1cAppend(&Body, "\n    Value->Count = Count;\n\n");
+
+    Asn1cEmitError(&Body, 4, "Count > Capacity", "ERROR_INSUFFICIENT_BUFFER", "goto Leave;");
+
+    if (Check)
+    {
+        Asn1cEmitError(&Body, 4, Check, "ERROR_BLGASN1_CONSTRAINT", "goto Leave;");
+    }
+
+    Asn1cEndDecRoutine(Generator, Routine, &Body, ", HasNode;\n    DWORD Capacity = Value->Count, Count = 0");
+}
+
+static
+void
+Asn1cGenChoice(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_ASSIGNMENT *Assignment,
+    ASN1C_TYPE *Type,
+    const char *Prefix
+    )
+
+/*++
+
+Routine Description:
+
+    Generates the routines that size, encode, decode and recognize a CHOICE value, which is
+    encoded as its chosen alternative.
+
+Arguments:
+
+    Generator - The generator.
+
+    Assignment - Assignment that owns the CHOICE type.
+
+    Type - The CHOICE type.
+
+    Prefix - Prefix of the routine names: "Alt" if the CHOICE type is tagged, in which case the
+        routines of the assignment handle the tag; otherwise, an empty string.
+
+--*/
+
+{
+    ASN1C_COMPONENT *Component;
+    ASN1C_DEFINITION *Routine;
+    ASN1C_BUFFER Body = { 0 };
+    const char *TypeName = Asn1cTypeName(Generator, Assignment), *Value;
+    int First;
+
+    // Size
+    Routine = Asn1cBeginRoutine(Generator, Asn1cFormat("%sCb", Prefix), Assignment, "ULONGLONG",
+        Asn1cCbParameters(Generator, Assignment));
+
+    Asn1cAppend(&Routine->Text, "    switch (Value->Choice)\n    {\n");
+
+    for (Component = Type->Components; Component; Component = Component->Next)
+    {
+        Asn1cAppend(&Routine->Text, "    case %s_%sChoice:\n        return %s;\n\n", TypeName, Component->CName,
+            Asn1cGenCb(Generator, Component->Type, Asn1cFormat("Value->u.%s", Component->CName), NULL));
+    }
+
+    Asn1cAppend(&Routine->Text, "    default:\n        return 0;\n    }\n}\n");
+
+    // Encoding
+    Routine = Asn1cBeginRoutine(Generator, Asn1cFormat("%sEnc", Prefix), Assignment, "BOOL",
+        Asn1cEncParameters(Generator, Assignment));
+
+    Asn1cAppend(&Routine->Text, "    switch (Value->Choice)\n    {\n");
+
+    for (Component = Type->Components; Component; Component = Component->Next)
+    {
+        Asn1cAppend(&Routine->Text, "    case %s_%sChoice:\n", TypeName, Component->CName);
+
+        Asn1cGenEnc(Generator, &Routine->Text, 8, Component->Type, Asn1cFormat("Value->u.%s", Component->CName), NULL);
+
+        Asn1cAppend(&Routine->Text, "        break;\n\n");
+    }
+
+    Asn1cAppend(&Routine->Text,
+        "    default:\n"
+        "        SetLastError(ERROR_INVALID_PARAMETER);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    return TRUE;\n"
+        "}\n");
+
+    // Decoding
+    Routine = Asn1cBeginRoutine(Generator, Asn1cFormat("%sDec", Prefix), Assignment, "BOOL",
+        Asn1cDecParameters(Generator, Assignment));
+
+    for (Component = Type->Components, First = 1; Component; Component = Component->Next, First = 0)
+    {
+        Value = Asn1cFormat("Value->u.%s", Component->CName);
+
+        Asn1cAppend(&Body, "    %sif (%s)\n    {\n        Value->Choice = %s_%sChoice;\n\n", First ? "" : "else ",
+            Asn1cGenIsTag(Generator, Component->Type, NULL), TypeName, Component->CName);
+
+        Asn1cGenDec(Generator, &Body, 8, Component->Type, Value, 0);
+
+        Asn1cEmitClose(&Body, 4);
+    }
+
+    Asn1cAppend(&Body,
+        "    else\n"
+        "    {\n"
+        "        SetLastError(ERROR_BLGASN1_BADTAG);\n"
+        "\n"
+        "        goto Leave;\n"
+        "    }\n"
+        "\n");
+
+    Asn1cEndDecRoutine(Generator, Routine, &Body, "");
+
+    // Tag recognition
+    Routine = Asn1cBeginRoutine(Generator, Asn1cFormat("%sIsTag", Prefix), Assignment, "BOOL",
+        "    HBLG_DER_DECODER Decoder\n");
+
+    Asn1cAppend(&Routine->Text, "    return ");
+
+    for (Component = Type->Components, First = 1; Component; Component = Component->Next, First = 0)
+    {
+        Asn1cAppend(&Routine->Text, "%s%s", First ? "" : " ||\n        ", Asn1cGenIsTag(Generator, Component->Type, NULL));
+    }
+
+    Asn1cAppend(&Routine->Text, "%s;\n}\n", First ? "FALSE" : "");
+}
+
+static
+void
+Asn1cGenAssignment(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_ASSIGNMENT *Assignment
+    )
+
+/*++
+
+Routine Description:
+
+    Generates the internal and public routines of a type assignment.
+
+--*/
+
+{
+    ASN1C_TYPE *Base = Asn1cBaseType(Assignment->Type);
+    const char *TypeName = Asn1cTypeName(Generator, Assignment);
+    ASN1C_DEFINITION *Routine;
+    ASN1C_BUFFER Body = { 0 };
+    ASN1C_TAG Tag;
+    int IsTagged = Asn1cEffectiveTag(Assignment->Type, NULL, &Tag);
+
+    switch (Base->Kind)
+    {
+    case Asn1cSequence:
+    case Asn1cSet:
+        Asn1cGenSequence(Generator, Assignment, Base);
+
+        break;
+
+    case Asn1cSequenceOf:
+        Asn1cGenSequenceOf(Generator, Assignment, Base);
+
+        break;
+
+    case Asn1cChoice:
+        Asn1cGenChoice(Generator, Assignment, Base, Base == Assignment->Type ? "" : "Alt");
+
+        break;
+
+    default:
+        break;
+    }
+
+    if (Base != Assignment->Type || Base->Kind != Asn1cChoice)
+    {
+        Routine = Asn1cBeginRoutine(Generator, "Cb", Assignment, "ULONGLONG", Asn1cCbParameters(Generator, Assignment));
+
+        Asn1cAppend(&Routine->Text, "    return %s;\n}\n", Asn1cGenCb(Generator, Assignment->Type, "(*Value)", NULL));
+
+        Routine = Asn1cBeginRoutine(Generator, "Enc", Assignment, "BOOL", Asn1cEncParameters(Generator, Assignment));
+
+        Asn1cGenEnc(Generator, &Routine->Text, 4, Assignment->Type, "(*Value)", NULL);
+
+        Asn1cAppend(&Routine->Text, "    return TRUE;\n}\n");
+
+        Routine = Asn1cBeginRoutine(Generator, "Dec", Assignment, "BOOL", Asn1cDecParameters(Generator, Assignment));
+
+        Asn1cGenDec(Generator, &Body, 4, Assignment->Type, "(*Value)", 0);
+
+        Asn1cEndDecRoutine(Generator, Routine, &Body, "");
+
+        // Only an alias of an untagged CHOICE type has no tag of its own.
+        if (!IsTagged)
+        {
+            Routine = Asn1cBeginRoutine(Generator, "IsTag", Assignment, "BOOL", "    HBLG_DER_DECODER Decoder\n");
+
+            Asn1cAppend(&Routine->Text, "    return %s;\n}\n", Asn1cGenIsTag(Generator, Assignment->Type, NULL));
+        }
+    }
+
+    if (Assignment->Anonymous)
+    {
+        return;
+    }
+
+    // Public routines
+    Routine = Asn1cAddDefinition(Generator, ASN1C_SECTION_PUBLIC, Asn1cFormat("%sEncode%s", Generator->Prefix,
+        Assignment->CName));
+
+    Generator->Current = Routine;
+
+    Asn1cAppend(&Routine->Text,
+        "BOOL\n"
+        "%s(\n"
+        "    IN HBLG_DER_ENCODER Encoder,\n"
+        "    IN CONST %s *Value\n"
+        "    )\n"
+        "{\n"
+        "    DWORD BufferCb, EncodedCb;\n"
+        "    ULONGLONG Cb;\n"
+        "    PBYTE Buffer;\n"
+        "\n"
+        "    if (!Encoder || !Value)\n"
+        "    {\n"
+        "        SetLastError(ERROR_INVALID_PARAMETER);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    Cb = %s(Value);\n"
+        "\n"
+        "    if (Cb > MAXDWORD)\n"
+        "    {\n"
+        "        SetLastError(ERROR_BLGASN1_TOO_LARGE);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    if (!BlgDerGetEncoderParam(Encoder, BLG_DER_ENC_PARAM_BUFFER, &Buffer) ||\n"
+        "        !BlgDerGetEncoderParam(Encoder, BLG_DER_ENC_PARAM_BUFFER_CB, &BufferCb) ||\n"
+        "        !BlgDerGetEncoderParam(Encoder, BLG_DER_ENC_PARAM_ENCODED_CB, &EncodedCb))\n"
+        "    {\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    // The whole value is checked against the buffer before any octet is written.\n"
+        "    if (Buffer && EncodedCb + Cb > BufferCb)\n"
+        "    {\n"
+        "        SetLastError(ERROR_INSUFFICIENT_BUFFER);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    return %s(Encoder, Value);\n"
+        "}\n", Routine->Name, TypeName, Asn1cRoutine(Generator, "Cb", Assignment),
+        Asn1cRoutine(Generator, "Enc", Assignment));
+
+    Routine = Asn1cAddDefinition(Generator, ASN1C_SECTION_PUBLIC, Asn1cFormat("%sSize%s", Generator->Prefix,
+        Assignment->CName));
+
+    Generator->Current = Routine;
+
+    Asn1cAppend(&Routine->Text,
+        "BOOL\n"
+        "%s(\n"
+        "    IN CONST %s *Value,\n"
+        "    OUT PDWORD Size\n"
+        "    )\n"
+        "{\n"
+        "    ULONGLONG Cb;\n"
+        "\n"
+        "    if (!Value || !Size)\n"
+        "    {\n"
+        "        SetLastError(ERROR_INVALID_PARAMETER);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    Cb = %s(Value);\n"
+        "\n"
+        "    if (Cb > MAXDWORD)\n"
+        "    {\n"
+        "        SetLastError(ERROR_BLGASN1_TOO_LARGE);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    *Size = (DWORD) Cb;\n"
+        "\n"
+        "    return TRUE;\n"
+        "}\n", Routine->Name, TypeName, Asn1cRoutine(Generator, "Cb", Assignment));
+
+    Routine = Asn1cAddDefinition(Generator, ASN1C_SECTION_PUBLIC, Asn1cFormat("%sDecode%s", Generator->Prefix,
+        Assignment->CName));
+
+    Generator->Current = Routine;
+
+    Asn1cAppend(&Routine->Text,
+        "BOOL\n"
+        "%s(\n"
+        "    IN HBLG_DER_DECODER Decoder,\n"
+        "    OUT %s *Value\n"
+        "    )\n"
+        "{\n"
+        "    if (!Decoder || !Value)\n"
+        "    {\n"
+        "        SetLastError(ERROR_INVALID_PARAMETER);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    if (!%s)\n"
+        "    {\n"
+        "        SetLastError(ERROR_BLGASN1_BADTAG);\n"
+        "\n"
+        "        return FALSE;\n"
+        "    }\n"
+        "\n"
+        "    return %s(Decoder, Value);\n"
+        "}\n", Routine->Name, TypeName, Asn1cGenIsTag(Generator, Assignment->Type, NULL),
+        Asn1cRoutine(Generator, "Dec", Assignment));
+}
+
+static
+void
+Asn1cMarkUsed(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_DEFINITION *Definition
+    )
+{
+    ASN1C_DEFINITION *Referenced;
+    size_t i;
+
+    if (Definition->Used)
+    {
+        return;
+    }
+
+    Definition->Used = 1;
+
+    for (i = 0; i < Definition->RefCount; i++)
+    {
+        Referenced = Asn1cFindDefinition(Generator, Definition->Refs[i]);
+
+        if (!Referenced)
+        {
+            Asn1cError(0, "internal error: '%s' is not defined", Definition->Refs[i]);
+        }
+
+        Asn1cMarkUsed(Generator, Referenced);
+    }
+}
+
+static
+void
+Asn1cGenTypes(
+    ASN1C_GENERATOR *Generator,
+    ASN1C_BUFFER *Header
+    )
+
+/*++
+
+Routine Description:
+
+    Emits the C types of the assignments. Structures are declared in advance so that SEQUENCE
+    OF types can refer to any of them; the assignments are already ordered by embedding.
+
+--*/
+
+{
+    ASN1C_ASSIGNMENT *Assignment;
+    ASN1C_COMPONENT *Component;
+    const char *TypeName;
+    ASN1C_TYPE *Base;
+    unsigned long Number;
+
+    for (Assignment = Generator->Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        Base = Asn1cBaseType(Assignment->Type);
+
+        if (Base->Owner)
+        {
+            TypeName = Asn1cTypeName(Generator, Assignment);
+
+            Asn1cAppend(Header, "typedef struct _%s %s;\n", TypeName, TypeName);
+        }
+    }
+
+    for (Assignment = Generator->Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        Base = Asn1cBaseType(Assignment->Type);
+        TypeName = Asn1cTypeName(Generator, Assignment);
+
+        Asn1cAppend(Header, "\n// %s\n", Assignment->Name);
+
+        switch (Base->Kind)
+        {
+        case Asn1cSequence:
+        case Asn1cSet:
+            Asn1cAppend(Header, "struct _%s\n{\n", TypeName);
+
+            for (Component = Base->Components; Component; Component = Component->Next)
+            {
+                Asn1cAppend(Header, "    %s %s;\n", Asn1cFieldType(Generator, Component->Type), Component->CName);
+
+                if (Component->Optional)
+                {
+                    Asn1cAppend(Header, "    BOOLEAN %sPresent;\n", Component->CName);
+                }
+            }
+
+            Asn1cAppend(Header, "};\n");
+
+            break;
+
+        case Asn1cChoice:
+            for (Component = Base->Components, Number = 1; Component; Component = Component->Next, Number++)
+            {
+                Asn1cAppend(Header, "#define %s_%sChoice %lu\n", TypeName, Component->CName, Number);
+            }
+
+            Asn1cAppend(Header, "\nstruct _%s\n{\n    DWORD Choice;\n\n    union\n    {\n", TypeName);
+
+            for (Component = Base->Components; Component; Component = Component->Next)
+            {
+                Asn1cAppend(Header, "        %s %s;\n", Asn1cFieldType(Generator, Component->Type), Component->CName);
+            }
+
+            Asn1cAppend(Header, "    } u;\n};\n");
+
+            break;
+
+        case Asn1cSequenceOf:
+            Asn1cAppend(Header, "struct _%s\n{\n    %s *Elements;\n    DWORD Count;\n};\n", TypeName,
+                Asn1cFieldType(Generator, Base->Inner));
+
+            break;
+
+        default:
+            Asn1cAppend(Header, "typedef %s %s;\n", Asn1cFieldType(Generator, Base), TypeName);
+
+            break;
+        }
+    }
+}
+
+void
+Asn1cGenerate(
+    ASN1C_MODULE *Module,
+    const char *Prefix,
+    const char *HeaderName,
+    ASN1C_BUFFER *Header,
+    ASN1C_BUFFER *Source
+    )
+
+/*++
+
+Routine Description:
+
+    Generates the header and the source of an analyzed module.
+
+Arguments:
+
+    Module - The analyzed module.
+
+    Prefix - Prefix of the generated type and routine names.
+
+    HeaderName - File name of the header, as included by the source.
+
+    Header - Receives the header.
+
+    Source - Receives the source.
+
+--*/
+
+{
+    ASN1C_GENERATOR Generator = { 0 };
+    ASN1C_ASSIGNMENT *Assignment;
+    ASN1C_DEFINITION *Definition, *Helper;
+    char *Guard, *Ptr;
+    const char *Refs, *End;
+    int Section, i;
+
+    Generator.Module = Module;
+    Generator.Prefix = Prefix;
+    Generator.Tail = &Generator.Definitions;
+
+    for (Assignment = Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        ASN1C_TYPE *Base = Asn1cBaseType(Assignment->Type);
+
+        if (Base->Kind == Asn1cSequence || Base->Kind == Asn1cSet || Base->Kind == Asn1cChoice ||
+            Base->Kind == Asn1cSequenceOf)
+        {
+            Base->Owner = Assignment;
+        }
+    }
+
+    for (i = 0; Asn1cHelpers[i].Name; i++)
+    {
+        Helper = Asn1cAddDefinition(&Generator, ASN1C_SECTION_HELPER, Asn1cHelpers[i].Name);
+
+        Asn1cAppend(&Helper->Text, "%s", Asn1cHelpers[i].Text);
+
+        Generator.Current = Helper;
+
+        for (Refs = Asn1cHelpers[i].Refs; *Refs; Refs = *End ? End + 1 : End)
+        {
+            End = strchr(Refs, ' ');
+            End = End ? End : Refs + strlen(Refs);
+
+            Asn1cUse(&Generator, Asn1cFormat("%.*s", (int) (End - Refs), Refs));
+        }
+    }
+
+    for (Assignment = Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        Asn1cGenAssignment(&Generator, Assignment);
+    }
+
+    for (Definition = Generator.Definitions; Definition; Definition = Definition->Next)
+    {
+        if (Definition->Section == ASN1C_SECTION_PUBLIC)
+        {
+            Asn1cMarkUsed(&Generator, Definition);
+        }
+    }
+
+    // Header
+    Guard = Asn1cFormat("%s", HeaderName);
+
+    for (Ptr = Guard; *Ptr; Ptr++)
+    {
+        *Ptr = isalnum((unsigned char) *Ptr) ? (char) toupper((unsigned char) *Ptr) : '_';
+    }
+
+    Asn1cAppend(Header,
+        "/*++\n"
+        "\n"
+        "    Generated by BlgAsn1c from %s (module %s). Do not edit.\n"
+        "\n"
+        "--*/\n"
+        "\n"
+        "#pragma once\n"
+        "\n"
+        "#ifndef %s\n"
+        "#define %s\n"
+        "\n"
+        "#include \"BlgAsn1.h\"\n"
+        "\n"
+        "#ifdef __cplusplus\n"
+        "extern \"C\" {\n"
+        "#endif\n"
+        "\n"
+        "#ifndef BLG_ASN1C_OCTETS_DEFINED\n"
+        "#define BLG_ASN1C_OCTETS_DEFINED\n"
+        "\n"
+        "// Octets of a string value. Decoded octets point into the encoded data.\n"
+        "typedef struct _BLG_ASN1C_OCTETS\n"
+        "{\n"
+        "    CONST BYTE *Value;\n"
+        "    DWORD Cb;\n"
+        "\n"
+        "} BLG_ASN1C_OCTETS;\n"
+        "\n"
+        "#endif\n"
+        "\n", Asn1cFileName, Module->Name, Guard, Guard);
+
+    Asn1cGenTypes(&Generator, Header);
+
+    for (Assignment = Module->Assignments; Assignment; Assignment = Assignment->Next)
+    {
+        if (Assignment->Anonymous)
+        {
+            continue;
+        }
+
+        Asn1cAppend(Header,
+            "\n"
+            "BOOL\n"
+            "%sEncode%s(\n"
+            "    IN HBLG_DER_ENCODER Encoder,\n"
+            "    IN CONST %s%s *Value\n"
+            "    );\n"
+            "\n"
+            "BOOL\n"
+            "%sSize%s(\n"
+            "    IN CONST %s%s *Value,\n"
+            "    OUT PDWORD Size\n"
+            "    );\n"
+            "\n"
+            "BOOL\n"
+            "%sDecode%s(\n"
+            "    IN HBLG_DER_DECODER Decoder,\n"
+            "    OUT %s%s *Value\n"
+            "    );\n", Prefix, Assignment->CName, Prefix, Assignment->CName, Prefix, Assignment->CName, Prefix,
+            Assignment->CName, Prefix, Assignment->CName, Prefix, Assignment->CName);
+    }
+
+    Asn1cAppend(Header, "\n#ifdef __cplusplus\n}\n#endif\n\n#endif\n");
+
+    // Source
+    Asn1cAppend(Source,
+        "/*++\n"
+        "\n"
+        "    Generated by BlgAsn1c from %s (module %s). Do not edit.\n"
+        "\n"
+        "--*/\n"
+        "\n"
+        "#include \"%s\"\n", Asn1cFileName, Module->Name, HeaderName);
+
+    for (Section = ASN1C_SECTION_TAG; Section <= ASN1C_SECTION_PUBLIC; Section++)
+    {
+        Asn1cAppend(Source, "\n");
+
+        // Routines may call each other, so all of them are declared first.
+        if (Section == ASN1C_SECTION_ROUTINE)
+        {
+            for (Definition = Generator.Definitions; Definition; Definition = Definition->Next)
+            {
+                if (Definition->Section == Section && Definition->Used)
+                {
+                    Asn1cAppend(Source, "%.*s\n", (int) Definition->Prototype.Length, Definition->Prototype.Text);
+                }
+            }
+        }
+
+        for (Definition = Generator.Definitions; Definition; Definition = Definition->Next)
+        {
+            if (Definition->Section == Section && Definition->Used)
+            {
+                Asn1cAppend(Source, "%.*s%s", (int) Definition->Text.Length, Definition->Text.Text,
+                    Section == ASN1C_SECTION_TAG ? "" : "\n");
+            }
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,309 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+Module Description:
+
+    BlgAsn1c compiles an ASN.1 module into C structures and specialized encoding, sizing and
+    decoding routines built on the ASN.1 DER Library.
+
+    Usage: BlgAsn1c [-p Prefix] -o OutputBase Module.asn
+
+    The routines are written to OutputBase.h and OutputBase.c.
+
+--*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "BlgAsn1c.h"
+
+const char *Asn1cFileName = "";
+
+static
+char *
+Asn1cReadFile(
+    const char *FileName
+    );
+
+static
+void
+Asn1cWriteFile(
+    const char *FileName,
+    const ASN1C_BUFFER *Buffer
+    );
+
+int
+main(
+    int argc,
+    char **argv
+    )
+{
+    const char *Prefix = "", *OutputBase = NULL, *InputName = NULL, *HeaderName;
+    ASN1C_BUFFER Header = { 0 }, Source = { 0 };
+    ASN1C_MODULE *Module;
+    char *Text, *FileName;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            Prefix = argv[++i];
+        }
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            OutputBase = argv[++i];
+        }
+        else if (argv[i][0] != '-' && !InputName)
+        {
+            InputName = argv[i];
+        }
+        else
+        {
+            InputName = NULL;
+
+            break;
+        }
+    }
+
+    if (!InputName || !OutputBase)
+    {
+        fprintf(stderr, "Usage: BlgAsn1c [-p Prefix] -o OutputBase Module.asn\n");
+
+        return 2;
+    }
+
+    Asn1cFileName = InputName;
+
+    Text = Asn1cReadFile(InputName);
+
+    Module = Asn1cParse(Text);
+
+    Asn1cAnalyze(Module);
+
+    // The generated source includes the header by its file name, without the directory.
+    HeaderName = OutputBase + strlen(OutputBase);
+
+    while (HeaderName > OutputBase && HeaderName[-1] != '/' && HeaderName[-1] != '\\')
+    {
+        HeaderName--;
+    }
+
+    FileName = Asn1cAlloc(strlen(OutputBase) + 3);
+
+    sprintf(FileName, "%s.h", HeaderName);
+
+    Asn1cGenerate(Module, Prefix, FileName, &Header, &Source);
+
+    sprintf(FileName, "%s.h", OutputBase);
+    Asn1cWriteFile(FileName, &Header);
+
+    sprintf(FileName, "%s.c", OutputBase);
+    Asn1cWriteFile(FileName, &Source);
+
+    return 0;
+}
+
+void
+Asn1cError(
+    int Line,
+    const char *Format,
+    ...
+    )
+
+/*++
+
+Routine Description:
+
+    Reports an error in the input module and terminates the compiler.
+
+Arguments:
+
+    Line - Line number of the input the error refers to, or zero.
+
+    Format - printf style format of the message.
+
+--*/
+
+{
+    va_list Arguments;
+
+    if (Line > 0)
+    {
+        fprintf(stderr, "%s(%d): error: ", Asn1cFileName, Line);
+    }
+    else
+    {
+        fprintf(stderr, "%s: error: ", Asn1cFileName);
+    }
+
+    va_start(Arguments, Format);
+    vfprintf(stderr, Format, Arguments);
+    va_end(Arguments);
+
+    fputc('\n', stderr);
+
+    exit(1);
+}
+
+void *
+Asn1cAlloc(
+    size_t Size
+    )
+
+/*++
+
+Routine Description:
+
+    Allocates zero initialized memory. The compiler is short-lived, so memory is never freed.
+
+--*/
+
+{
+    void *Memory = calloc(1, Size ? Size : 1);
+
+    if (!Memory)
+    {
+        fprintf(stderr, "BlgAsn1c: out of memory\n");
+
+        exit(1);
+    }
+
+    return Memory;
+}
+
+char *
+Asn1cStrDup(
+    const char *Text
+    )
+{
+    return strcpy(Asn1cAlloc(strlen(Text) + 1), Text);
+}
+
+char *
+Asn1cCName(
+    const char *Name
+    )
+
+/*++
+
+Routine Description:
+
+    Converts an ASN.1 reference or identifier to a C identifier by replacing hyphens with
+    underscores.
+
+--*/
+
+{
+    char *CName = Asn1cStrDup(Name), *Ptr;
+
+    for (Ptr = CName; *Ptr; Ptr++)
+    {
+        if (*Ptr == '-')
+        {
+            *Ptr = '_';
+        }
+    }
+
+    return CName;
+}
+
+void
+Asn1cAppend(
+    ASN1C_BUFFER *Buffer,
+    const char *Format,
+    ...
+    )
+
+/*++
+
+Routine Description:
+
+    Appends formatted text to a buffer, growing it as needed.
+
+--*/
+
+{
+    va_list Arguments;
+    int Length;
+
+    for (;;)
+    {
+        size_t Available = Buffer->Capacity - Buffer->Length;
+
+        va_start(Arguments, Format);
+        Length = vsnprintf(Buffer->Text + Buffer->Length, Available, Format, Arguments);
+        va_end(Arguments);
+
+        if (Length >= 0 && (size_t) Length < Available)
+        {
+            Buffer->Length += Length;
+
+            return;
+        }
+
+        Buffer->Capacity = Buffer->Capacity ? Buffer->Capacity * 2 : 4096;
+
+        if (Length >= 0 && Buffer->Capacity < Buffer->Length + Length + 1)
+        {
+            Buffer->Capacity = Buffer->Length + Length + 1;
+        }
+
+        Buffer->Text = realloc(Buffer->Text, Buffer->Capacity);
+
+        if (!Buffer->Text)
+        {
+            fprintf(stderr, "BlgAsn1c: out of memory\n");
+
+            exit(1);
+        }
+    }
+}
+
+static
+char *
+Asn1cReadFile(
+    const char *FileName
+    )
+{
+    FILE *File = fopen(FileName, "rb");
+    char *Text;
+    long Size;
+
+    if (!File || fseek(File, 0, SEEK_END) != 0 || (Size = ftell(File)) < 0 || fseek(File, 0, SEEK_SET) != 0)
+    {
+        Asn1cError(0, "cannot read the input file");
+    }
+
+    Text = Asn1cAlloc((size_t) Size + 1);
+
+    if (fread(Text, 1, (size_t) Size, File) != (size_t) Size)
+    {
+        Asn1cError(0, "cannot read the input file");
+    }
+
+    fclose(File);
+
+    return Text;
+}
+
+static
+void
+Asn1cWriteFile(
+    const char *FileName,
+    const ASN1C_BUFFER *Buffer
+    )
+{
+    FILE *File = fopen(FileName, "wb");
+
+    if (!File || fwrite(Buffer->Text, 1, Buffer->Length, File) != Buffer->Length || fclose(File) != 0)
+    {
+        fprintf(stderr, "%s: error: cannot write the output file\n", FileName);
+
+        exit(1);
+    }
+}
\ No newline at end of file
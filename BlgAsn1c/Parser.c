@@ -0,0 +1,847 @@
+/*++
+
+Copyright (c) 2006 Can Balioglu. All rights reserved.
+
+See License.txt in the project root for license information.
+
+Module Description:
+
+    Tokenizes and parses the supported subset of ASN.1 module definitions: type assignments
+    using BOOLEAN, INTEGER, NULL, OCTET STRING, the character string types, SEQUENCE, SET,
+    CHOICE and SEQUENCE OF, with tags, OPTIONAL, DEFAULT, value range and SIZE constraints.
+
+--*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "BlgAsn1c.h"
+
+#define ASN1C_TOKEN_EOF          0
+#define ASN1C_TOKEN_WORD         1
+#define ASN1C_TOKEN_NUMBER       2
+#define ASN1C_TOKEN_ASSIGN       3 // ::=
+#define ASN1C_TOKEN_RANGE        4 // ..
+#define ASN1C_TOKEN_ELLIPSIS     5 // ...
+#define ASN1C_TOKEN_PUNCTUATION  6
+
+typedef struct _ASN1C_PARSER
+{
+    const char *Ptr;
+    int Line;
+
+    // Current token.
+    int Type;
+    int TokenLine;
+    char Text[256];
+    long long Number;
+
+} ASN1C_PARSER;
+
+// Universal tags of the supported character string types.
+static const struct
+{
+    const char *Name;
+    unsigned long Tag;
+}
+Asn1cStringTypes[] =
+{
+    { "UTF8String",      0x0C },
+    { "NumericString",   0x12 },
+    { "PrintableString", 0x13 },
+    { "IA5String",       0x16 },
+    { "VisibleString",   0x1A },
+    { NULL,              0 }
+};
+
+static
+ASN1C_TYPE *
+Asn1cParseType(
+    ASN1C_PARSER *Parser
+    );
+
+static
+void
+Asn1cNextToken(
+    ASN1C_PARSER *Parser
+    )
+
+/*++
+
+Routine Description:
+
+    Reads the next token, skipping white space and comments.
+
+--*/
+
+{
+    const char *Ptr = Parser->Ptr;
+    size_t Length;
+
+    for (;;)
+    {
+        while (isspace((unsigned char) *Ptr))
+        {
+            if (*Ptr++ == '\n')
+            {
+                Parser->Line++;
+            }
+        }
+
+        // A comment starts with "--" and ends with "--" or at the end of the line.
+        if (Ptr[0] == '-' && Ptr[1] == '-')
+        {
+            for (Ptr += 2; *Ptr && *Ptr != '\n'; Ptr++)
+            {
+                if (Ptr[0] == '-' && Ptr[1] == '-')
+                {
+                    Ptr += 2;
+
+                    break;
+                }
+            }
+
+            continue;
+        }
+
+        if (Ptr[0] == '/' && Ptr[1] == '*')
+        {
+            for (Ptr += 2; *Ptr && !(Ptr[0] == '*' && Ptr[1] == '/'); Ptr++)
+            {
+                if (*Ptr == '\n')
+                {
+                    Parser->Line++;
+                }
+            }
+
+            Ptr += *Ptr ? 2 : 0;
+
+            continue;
+        }
+
+        break;
+    }
+
+    Parser->TokenLine = Parser->Line;
+    Parser->Text[0] = 0;
+
+    if (!*Ptr)
+    {
+        Parser->Type = ASN1C_TOKEN_EOF;
+    }
+    else if (isalpha((unsigned char) *Ptr))
+    {
+        for (Length = 0; isalnum((unsigned char) Ptr[Length]) ||
+            (Ptr[Length] == '-' && isalnum((unsigned char) Ptr[Length + 1])); Length++)
+        {
+            if (Length == sizeof(Parser->Text) - 1)
+            {
+                Asn1cError(Parser->Line, "identifier too long");
+            }
+        }
+
+        memcpy(Parser->Text, Ptr, Length);
+        Parser->Text[Length] = 0;
+
+        Parser->Type = ASN1C_TOKEN_WORD;
+        Ptr += Length;
+    }
+    else if (isdigit((unsigned char) *Ptr) || (*Ptr == '-' && isdigit((unsigned char) Ptr[1])))
+    {
+        char *End;
+
+        Parser->Number = strtoll(Ptr, &End, 10);
+        Parser->Type = ASN1C_TOKEN_NUMBER;
+
+        memcpy(Parser->Text, Ptr, (size_t) (End - Ptr) < sizeof(Parser->Text) ? (size_t) (End - Ptr) : 0);
+        Parser->Text[(size_t) (End - Ptr) < sizeof(Parser->Text) ? (End - Ptr) : 0] = 0;
+
+        Ptr = End;
+    }
+    else if (strncmp(Ptr, "::=", 3) == 0)
+    {
+        strcpy(Parser->Text, "::=");
+
+        Parser->Type = ASN1C_TOKEN_ASSIGN;
+        Ptr += 3;
+    }
+    else if (strncmp(Ptr, "...", 3) == 0)
+    {
+        strcpy(Parser->Text, "...");
+
+        Parser->Type = ASN1C_TOKEN_ELLIPSIS;
+        Ptr += 3;
+    }
+    else if (strncmp(Ptr, "..", 2) == 0)
+    {
+        strcpy(Parser->Text, "..");
+
+        Parser->Type = ASN1C_TOKEN_RANGE;
+        Ptr += 2;
+    }
+    else
+    {
+        Parser->Text[0] = *Ptr++;
+        Parser->Text[1] = 0;
+
+        Parser->Type = ASN1C_TOKEN_PUNCTUATION;
+    }
+
+    Parser->Ptr = Ptr;
+}
+
+static
+int
+Asn1cIsToken(
+    ASN1C_PARSER *Parser,
+    const char *Text
+    )
+{
+    return Parser->Type != ASN1C_TOKEN_EOF && strcmp(Parser->Text, Text) == 0;
+}
+
+static
+int
+Asn1cAccept(
+    ASN1C_PARSER *Parser,
+    const char *Text
+    )
+{
+    if (Asn1cIsToken(Parser, Text))
+    {
+        Asn1cNextToken(Parser);
+
+        return 1;
+    }
+
+    return 0;
+}
+
+static
+void
+Asn1cExpect(
+    ASN1C_PARSER *Parser,
+    const char *Text
+    )
+{
+    if (!Asn1cAccept(Parser, Text))
+    {
+        Asn1cError(Parser->TokenLine, "expected '%s' but found '%s'", Text,
+            Parser->Type == ASN1C_TOKEN_EOF ? "end of file" : Parser->Text);
+    }
+}
+
+static
+char *
+Asn1cExpectWord(
+    ASN1C_PARSER *Parser,
+    const char *What
+    )
+{
+    char *Word;
+
+    if (Parser->Type != ASN1C_TOKEN_WORD)
+    {
+        Asn1cError(Parser->TokenLine, "expected %s but found '%s'", What,
+            Parser->Type == ASN1C_TOKEN_EOF ? "end of file" : Parser->Text);
+    }
+
+    Word = Asn1cStrDup(Parser->Text);
+
+    Asn1cNextToken(Parser);
+
+    return Word;
+}
+
+static
+void
+Asn1cSkipBraces(
+    ASN1C_PARSER *Parser
+    )
+
+/*++
+
+Routine Description:
+
+    Skips a balanced {...} block, such as a module identifier or a list of named numbers.
+
+--*/
+
+{
+    int Depth = 0;
+
+    do
+    {
+        if (Parser->Type == ASN1C_TOKEN_EOF)
+        {
+            Asn1cError(Parser->TokenLine, "unbalanced braces");
+        }
+
+        if (Asn1cIsToken(Parser, "{"))
+        {
+            Depth++;
+        }
+        else if (Asn1cIsToken(Parser, "}"))
+        {
+            Depth--;
+        }
+
+        Asn1cNextToken(Parser);
+
+    } while (Depth > 0);
+}
+
+static
+ASN1C_TYPE *
+Asn1cNewType(
+    ASN1C_PARSER *Parser,
+    ASN1C_KIND Kind
+    )
+{
+    ASN1C_TYPE *Type = Asn1cAlloc(sizeof(ASN1C_TYPE));
+
+    Type->Kind = Kind;
+    Type->Line = Parser->TokenLine;
+
+    return Type;
+}
+
+static
+int
+Asn1cParseBound(
+    ASN1C_PARSER *Parser,
+    long long *Value
+    )
+
+/*++
+
+Routine Description:
+
+    Parses a bound of a range constraint. Returns zero for MIN or MAX.
+
+--*/
+
+{
+    if (Asn1cAccept(Parser, "MIN") || Asn1cAccept(Parser, "MAX"))
+    {
+        return 0;
+    }
+
+    if (Parser->Type != ASN1C_TOKEN_NUMBER)
+    {
+        Asn1cError(Parser->TokenLine, "expected a number but found '%s'", Parser->Text);
+    }
+
+    *Value = Parser->Number;
+
+    Asn1cNextToken(Parser);
+
+    return 1;
+}
+
+static
+void
+Asn1cParseRange(
+    ASN1C_PARSER *Parser,
+    int *HasMin,
+    long long *Min,
+    int *HasMax,
+    long long *Max
+    )
+
+/*++
+
+Routine Description:
+
+    Parses "Value" or "Lower..Upper", optionally followed by an extension marker, which is
+    ignored.
+
+--*/
+
+{
+    *HasMin = Asn1cParseBound(Parser, Min);
+
+    if (Asn1cAccept(Parser, ".."))
+    {
+        *HasMax = Asn1cParseBound(Parser, Max);
+    }
+    else
+    {
+        *HasMax = *HasMin;
+        *Max = *Min;
+    }
+
+    if (Asn1cAccept(Parser, ","))
+    {
+        Asn1cExpect(Parser, "...");
+    }
+}
+
+static
+void
+Asn1cParseSize(
+    ASN1C_PARSER *Parser,
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Parses the parenthesized range following the SIZE keyword.
+
+--*/
+
+{
+    int HasMin, HasMax;
+    long long Min = 0, Max = 0;
+
+    Asn1cExpect(Parser, "(");
+
+    Asn1cParseRange(Parser, &HasMin, &Min, &HasMax, &Max);
+
+    Asn1cExpect(Parser, ")");
+
+    if ((HasMin && (Min < 0 || Min > 0xFFFFFFFFLL)) || (HasMax && (Max < 0 || Max > 0xFFFFFFFFLL)) ||
+        (HasMin && HasMax && Min > Max))
+    {
+        Asn1cError(Type->Line, "invalid SIZE constraint");
+    }
+
+    Type->HasSize = 1;
+    Type->SizeMin = HasMin ? (unsigned long) Min : 0;
+    Type->SizeMax = HasMax ? (unsigned long) Max : 0xFFFFFFFFUL;
+}
+
+static
+void
+Asn1cParseConstraint(
+    ASN1C_PARSER *Parser,
+    ASN1C_TYPE *Type
+    )
+
+/*++
+
+Routine Description:
+
+    Parses a parenthesized constraint: a value range for INTEGER types, or a SIZE constraint
+    for string and SEQUENCE OF types.
+
+--*/
+
+{
+    ASN1C_TYPE *Base = Asn1cBaseType(Type);
+
+    Asn1cExpect(Parser, "(");
+
+    if (Base->Kind == Asn1cReference)
+    {
+        Asn1cError(Type->Line, "constraints on type references are not supported");
+    }
+
+    if (Asn1cAccept(Parser, "SIZE"))
+    {
+        if (Base->Kind != Asn1cString && Base->Kind != Asn1cSequenceOf)
+        {
+            Asn1cError(Type->Line, "SIZE constraints apply to string and SEQUENCE OF types only");
+        }
+
+        Asn1cParseSize(Parser, Base);
+    }
+    else
+    {
+        if (Base->Kind != Asn1cInteger)
+        {
+            Asn1cError(Type->Line, "value constraints apply to INTEGER types only");
+        }
+
+        Asn1cParseRange(Parser, &Base->HasMin, &Base->Min, &Base->HasMax, &Base->Max);
+
+        if (Base->HasMin && Base->HasMax && Base->Min > Base->Max)
+        {
+            Asn1cError(Type->Line, "invalid value range");
+        }
+    }
+
+    Asn1cExpect(Parser, ")");
+}
+
+static
+ASN1C_COMPONENT *
+Asn1cParseComponents(
+    ASN1C_PARSER *Parser,
+    ASN1C_TYPE *Type,
+    int AllowOptional
+    )
+
+/*++
+
+Routine Description:
+
+    Parses the braced component list of a SEQUENCE, SET or CHOICE type. Extension markers are
+    accepted and ignored.
+
+--*/
+
+{
+    ASN1C_COMPONENT *Head = NULL, **Tail = &Head, *Component;
+
+    Asn1cExpect(Parser, "{");
+
+    while (!Asn1cIsToken(Parser, "}"))
+    {
+        if (Asn1cAccept(Parser, "..."))
+        {
+            if (!Asn1cAccept(Parser, ","))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        if (Parser->Type != ASN1C_TOKEN_WORD || !islower((unsigned char) Parser->Text[0]))
+        {
+            Asn1cError(Parser->TokenLine, "expected a component identifier but found '%s'", Parser->Text);
+        }
+
+        Component = Asn1cAlloc(sizeof(ASN1C_COMPONENT));
+
+        Component->Line = Parser->TokenLine;
+        Component->Name = Asn1cExpectWord(Parser, "a component identifier");
+        Component->CName = Asn1cCName(Component->Name);
+        Component->Type = Asn1cParseType(Parser);
+
+        if (AllowOptional && Asn1cAccept(Parser, "OPTIONAL"))
+        {
+            Component->Optional = 1;
+        }
+        else if (AllowOptional && Asn1cAccept(Parser, "DEFAULT"))
+        {
+            Component->HasDefault = 1;
+
+            if (Asn1cAccept(Parser, "TRUE"))
+            {
+                Component->Default = 1;
+            }
+            else if (Asn1cAccept(Parser, "FALSE"))
+            {
+                Component->Default = 0;
+            }
+            else if (Parser->Type == ASN1C_TOKEN_NUMBER)
+            {
+                Component->Default = Parser->Number;
+
+                Asn1cNextToken(Parser);
+            }
+            else
+            {
+                Asn1cError(Parser->TokenLine, "only BOOLEAN and INTEGER DEFAULT values are supported");
+            }
+        }
+
+        *Tail = Component;
+        Tail = &Component->Next;
+
+        Type->ComponentCount++;
+
+        if (!Asn1cAccept(Parser, ","))
+        {
+            break;
+        }
+    }
+
+    Asn1cExpect(Parser, "}");
+
+    return Head;
+}
+
+static
+ASN1C_TYPE *
+Asn1cParseType(
+    ASN1C_PARSER *Parser
+    )
+
+/*++
+
+Routine Description:
+
+    Parses a type, including its tag and constraint.
+
+--*/
+
+{
+    ASN1C_TYPE *Type;
+    int i;
+
+    if (Asn1cAccept(Parser, "["))
+    {
+        Type = Asn1cNewType(Parser, Asn1cTagged);
+
+        Type->TagClass = ASN1C_CLASS_CONTEXT;
+
+        if (Asn1cAccept(Parser, "UNIVERSAL"))
+        {
+            Type->TagClass = ASN1C_CLASS_UNIVERSAL;
+        }
+        else if (Asn1cAccept(Parser, "APPLICATION"))
+        {
+            Type->TagClass = ASN1C_CLASS_APPLICATION;
+        }
+        else if (Asn1cAccept(Parser, "PRIVATE"))
+        {
+            Type->TagClass = ASN1C_CLASS_PRIVATE;
+        }
+
+        if (Parser->Type != ASN1C_TOKEN_NUMBER || Parser->Number < 0 || Parser->Number > 0xFFFFFFFFLL)
+        {
+            Asn1cError(Parser->TokenLine, "invalid tag number '%s'", Parser->Text);
+        }
+
+        Type->TagNumber = (unsigned long) Parser->Number;
+
+        Asn1cNextToken(Parser);
+        Asn1cExpect(Parser, "]");
+
+        if (Asn1cAccept(Parser, "IMPLICIT"))
+        {
+            Type->TagMode = ASN1C_TAGS_IMPLICIT;
+        }
+        else if (Asn1cAccept(Parser, "EXPLICIT"))
+        {
+            Type->TagMode = ASN1C_TAGS_EXPLICIT;
+        }
+
+        Type->Inner = Asn1cParseType(Parser);
+
+        return Type;
+    }
+
+    if (Parser->Type != ASN1C_TOKEN_WORD)
+    {
+        Asn1cError(Parser->TokenLine, "expected a type but found '%s'", Parser->Text);
+    }
+
+    if (Asn1cAccept(Parser, "BOOLEAN"))
+    {
+        Type = Asn1cNewType(Parser, Asn1cBoolean);
+    }
+    else if (Asn1cAccept(Parser, "INTEGER"))
+    {
+        Type = Asn1cNewType(Parser, Asn1cInteger);
+
+        // Named numbers do not affect the encoding.
+        if (Asn1cIsToken(Parser, "{"))
+        {
+            Asn1cSkipBraces(Parser);
+        }
+    }
+    else if (Asn1cAccept(Parser, "NULL"))
+    {
+        Type = Asn1cNewType(Parser, Asn1cNull);
+    }
+    else if (Asn1cAccept(Parser, "OCTET"))
+    {
+        Asn1cExpect(Parser, "STRING");
+
+        Type = Asn1cNewType(Parser, Asn1cString);
+        Type->UniversalTag = 0x04;
+    }
+    else if (Asn1cAccept(Parser, "CHOICE"))
+    {
+        Type = Asn1cNewType(Parser, Asn1cChoice);
+        Type->Components = Asn1cParseComponents(Parser, Type, 0);
+    }
+    else if (Asn1cAccept(Parser, "SEQUENCE") || Asn1cIsToken(Parser, "SET"))
+    {
+        int IsSet = Asn1cAccept(Parser, "SET");
+
+        Type = Asn1cNewType(Parser, Asn1cSequenceOf);
+
+        if (Asn1cAccept(Parser, "SIZE"))
+        {
+            Asn1cParseSize(Parser, Type);
+        }
+        else if (Asn1cAccept(Parser, "("))
+        {
+            Asn1cExpect(Parser, "SIZE");
+            Asn1cParseSize(Parser, Type);
+            Asn1cExpect(Parser, ")");
+        }
+
+        if (Asn1cAccept(Parser, "OF"))
+        {
+            if (IsSet)
+            {
+                Asn1cError(Type->Line, "SET OF is not supported");
+            }
+
+            // A named element type ("SEQUENCE OF item Type") is allowed.
+            if (Parser->Type == ASN1C_TOKEN_WORD && islower((unsigned char) Parser->Text[0]))
+            {
+                Asn1cNextToken(Parser);
+            }
+
+            Type->Inner = Asn1cParseType(Parser);
+        }
+        else
+        {
+            if (Type->HasSize)
+            {
+                Asn1cError(Type->Line, "expected 'OF'");
+            }
+
+            Type->Kind = IsSet ? Asn1cSet : Asn1cSequence;
+            Type->Components = Asn1cParseComponents(Parser, Type, 1);
+        }
+    }
+    else
+    {
+        Type = NULL;
+
+        for (i = 0; Asn1cStringTypes[i].Name; i++)
+        {
+            if (Asn1cAccept(Parser, Asn1cStringTypes[i].Name))
+            {
+                Type = Asn1cNewType(Parser, Asn1cString);
+                Type->UniversalTag = Asn1cStringTypes[i].Tag;
+
+                break;
+            }
+        }
+
+        if (!Type)
+        {
+            if (!isupper((unsigned char) Parser->Text[0]) || strcmp(Parser->Text, "ENUMERATED") == 0 ||
+                strcmp(Parser->Text, "BIT") == 0 || strcmp(Parser->Text, "OBJECT") == 0 ||
+                strcmp(Parser->Text, "REAL") == 0 || strcmp(Parser->Text, "ANY") == 0)
+            {
+                Asn1cError(Parser->TokenLine, "type '%s' is not supported", Parser->Text);
+            }
+
+            Type = Asn1cNewType(Parser, Asn1cReference);
+            Type->Reference = Asn1cExpectWord(Parser, "a type reference");
+        }
+    }
+
+    while (Asn1cIsToken(Parser, "("))
+    {
+        Asn1cParseConstraint(Parser, Type);
+    }
+
+    return Type;
+}
+
+ASN1C_MODULE *
+Asn1cParse(
+    const char *Text
+    )
+
+/*++
+
+Routine Description:
+
+    Parses an ASN.1 module definition.
+
+Arguments:
+
+    Text - Zero terminated text of the module.
+
+Return Value:
+
+    The parsed module. Errors terminate the compiler.
+
+--*/
+
+{
+    ASN1C_PARSER Parser = { 0 };
+    ASN1C_MODULE *Module = Asn1cAlloc(sizeof(ASN1C_MODULE));
+    ASN1C_ASSIGNMENT *Assignment;
+
+    Parser.Ptr = Text;
+    Parser.Line = 1;
+
+    Module->Tail = &Module->Assignments;
+
+    Asn1cNextToken(&Parser);
+
+    Module->Name = Asn1cExpectWord(&Parser, "a module name");
+
+    if (Asn1cIsToken(&Parser, "{"))
+    {
+        Asn1cSkipBraces(&Parser);
+    }
+
+    Asn1cExpect(&Parser, "DEFINITIONS");
+
+    if (Asn1cAccept(&Parser, "EXPLICIT"))
+    {
+        Module->TagDefault = ASN1C_TAGS_EXPLICIT;
+        Asn1cExpect(&Parser, "TAGS");
+    }
+    else if (Asn1cAccept(&Parser, "IMPLICIT"))
+    {
+        Module->TagDefault = ASN1C_TAGS_IMPLICIT;
+        Asn1cExpect(&Parser, "TAGS");
+    }
+    else if (Asn1cAccept(&Parser, "AUTOMATIC"))
+    {
+        Module->TagDefault = ASN1C_TAGS_AUTOMATIC;
+        Asn1cExpect(&Parser, "TAGS");
+    }
+    else
+    {
+        Module->TagDefault = ASN1C_TAGS_EXPLICIT;
+    }
+
+    if (Asn1cAccept(&Parser, "EXTENSIBILITY"))
+    {
+        Asn1cExpect(&Parser, "IMPLIED");
+    }
+
+    Asn1cExpect(&Parser, "::=");
+    Asn1cExpect(&Parser, "BEGIN");
+
+    if (Asn1cIsToken(&Parser, "IMPORTS"))
+    {
+        Asn1cError(Parser.TokenLine, "IMPORTS is not supported");
+    }
+
+    if (Asn1cAccept(&Parser, "EXPORTS"))
+    {
+        while (!Asn1cAccept(&Parser, ";"))
+        {
+            if (Parser.Type == ASN1C_TOKEN_EOF)
+            {
+                Asn1cError(Parser.TokenLine, "expected ';'");
+            }
+
+            Asn1cNextToken(&Parser);
+        }
+    }
+
+    while (!Asn1cAccept(&Parser, "END"))
+    {
+        if (Parser.Type != ASN1C_TOKEN_WORD || !isupper((unsigned char) Parser.Text[0]))
+        {
+            Asn1cError(Parser.TokenLine, "expected a type assignment but found '%s'",
+                Parser.Type == ASN1C_TOKEN_EOF ? "end of file" : Parser.Text);
+        }
+
+        Assignment = Asn1cAlloc(sizeof(ASN1C_ASSIGNMENT));
+
+        Assignment->Line = Parser.TokenLine;
+        Assignment->Name = Asn1cExpectWord(&Parser, "a type reference");
+        Assignment->CName = Asn1cCName(Assignment->Name);
+
+        Asn1cExpect(&Parser, "::=");
+
+        Assignment->Type = Asn1cParseType(&Parser);
+
+        *Module->Tail = Assignment;
+        Module->Tail = &Assignment->Next;
+    }
+
+    return Module;
+}
\ No newline at end of file